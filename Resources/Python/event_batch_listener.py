@@ -0,0 +1,82 @@
+from __future__ import print_function, unicode_literals
+import struct
+import time
+
+import zmq
+
+
+# Event types
+TTL = 3
+SPIKE = 4
+MESSAGE = 5
+BINARY_MSG = 6
+
+
+# EventBatchHeader and EventBatchRecord in EventBroadcaster.h
+batch_header = struct.Struct('<4sHHIIQd')
+event_record = struct.Struct('<dIB3x')
+
+
+def unpack_batch(data):
+    (magic, version, header_size, num_events, num_dropped,
+     sequence, sample_rate) = batch_header.unpack_from(data)
+    assert magic == b'OEEB'
+
+    events = []
+    offset = header_size
+
+    for _ in range(num_events):
+        timestamp, size, etype = event_record.unpack_from(data, offset)
+        offset += event_record.size
+        events.append((etype, timestamp, data[offset:offset + size]))
+        offset += (size + 7) & ~7
+
+    # Check that all data was consumed
+    assert offset == len(data)
+
+    return sequence, num_dropped, events
+
+
+def run(hostname='localhost', port=5557):
+    """Receives the batches of an Event Broadcaster in batch mode and prints
+    the event rate and any lost batches once per second."""
+    with zmq.Context() as ctx:
+        with ctx.socket(zmq.SUB) as sock:
+            sock.connect('tcp://%s:%d' % (hostname, port))
+            sock.setsockopt(zmq.SUBSCRIBE, b'OEEB')
+
+            next_sequence = None
+            num_events = num_batches = num_dropped = num_missed = 0
+            last_report = time.time()
+
+            while True:
+                try:
+                    sequence, dropped, events = unpack_batch(sock.recv())
+
+                    # a gap in the sequence counts batches lost anywhere: in
+                    # the broadcaster's queue (their events are also reported
+                    # in the next header) or at the socket's high-water mark
+                    if next_sequence is not None and sequence > next_sequence:
+                        num_missed += sequence - next_sequence
+                    next_sequence = sequence + 1
+
+                    num_events += len(events)
+                    num_batches += 1
+                    num_dropped += dropped
+
+                    now = time.time()
+                    if now - last_report >= 1.0:
+                        print('%.0f events/s in %d batches, %d events dropped '
+                              'by the broadcaster, %d batches missed' %
+                              (num_events / (now - last_report), num_batches,
+                               num_dropped, num_missed))
+                        num_events = num_batches = 0
+                        last_report = now
+
+                except KeyboardInterrupt:
+                    print()  # Add final newline
+                    break
+
+
+if __name__ == '__main__':
+    run()
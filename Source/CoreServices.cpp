@@ -134,6 +134,11 @@ void writeSpike(SpikeObject& spike, int electrodeIndex)
     getProcessorGraph()->getRecordNode()->writeSpike(spike, electrodeIndex);
 }
 
+void writeSpike(const SpikeRecord& spike, int electrodeIndex)
+{
+    getProcessorGraph()->getRecordNode()->writeSpike(spike, electrodeIndex);
+}
+
 void registerSpikeSource(GenericProcessor* processor)
 {
     getProcessorGraph()->getRecordNode()->registerSpikeSource(processor);
@@ -143,6 +148,11 @@ int addSpikeElectrode(SpikeRecordInfo* elec)
 {
     return getProcessorGraph()->getRecordNode()->addSpikeElectrode(elec);
 }
+
+void setTriggeredRecording(int eventChannel, int edge, float preTriggerSeconds, float postTriggerSeconds)
+{
+    getProcessorGraph()->getRecordNode()->setTriggeredRecording(eventChannel, edge, preTriggerSeconds, postTriggerSeconds);
+}
 };
 
 PLUGIN_API const char* getApplicationResource(const char* name, int& size)
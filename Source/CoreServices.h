@@ -29,6 +29,7 @@
 
 class GenericEditor;
 struct SpikeObject;
+struct SpikeRecord;
 class GenericProcessor;
 struct SpikeRecordInfo;
 
@@ -91,8 +92,13 @@ PLUGIN_API int getExperimentNumber();
 /* Spike related methods. See record engine documentation */
 
 PLUGIN_API void writeSpike(SpikeObject& spike, int electrodeIndex);
+PLUGIN_API void writeSpike(const SpikeRecord& spike, int electrodeIndex);
 PLUGIN_API void registerSpikeSource(GenericProcessor* processor);
 PLUGIN_API int addSpikeElectrode(SpikeRecordInfo* elec);
+
+/** Records only windows around TTL edges during the next acquisition.
+See RecordNode::setTriggeredRecording. Must be called from a processor's enable method */
+PLUGIN_API void setTriggeredRecording(int eventChannel, int edge, float preTriggerSeconds, float postTriggerSeconds);
 };
 
 PLUGIN_API const char* getApplicationResource(const char* name, int& size);
@@ -26,13 +26,23 @@
 
 #include <stdio.h>
 
+void ArduinoOutputDevice::sendCommands(const OutputCommand* commands, int numCommands)
+{
+    for (int i = 0; i < numCommands; i++)
+        arduino.sendDigital(commands[i].channel, commands[i].value);
+}
+
 ArduinoOutput::ArduinoOutput()
-	: GenericProcessor("Arduino Output"), outputChannel(13), inputChannel(-1), state(true), deviceSelected(false), acquisitionIsActive(false)
+	: GenericProcessor("Arduino Output"), outputChannel(13), inputChannel(-1), outputDevice(arduino),
+	  state(true), acquisitionIsActive(false), deviceSelected(false)
 {
+    dispatcher = new OutputDispatcher("Arduino Output", &outputDevice);
 }
 
 ArduinoOutput::~ArduinoOutput()
 {
+    dispatcher = nullptr;
+
 	if (arduino.isInitialized())
 		arduino.disconnect();
 }
@@ -122,11 +132,11 @@ void ArduinoOutput::handleEvent(int eventType, MidiMessage& event, int sampleNum
             {
                 if (eventId == 0)
                 {
-                    arduino.sendDigital(outputChannel, ARD_LOW);
+                    dispatcher->addCommand(outputChannel, ARD_LOW, 0.0, getEventAcquisitionTicks(event));
                 }
                 else
                 {
-                    arduino.sendDigital(outputChannel, ARD_HIGH);
+                    dispatcher->addCommand(outputChannel, ARD_HIGH, 0.0, getEventAcquisitionTicks(event));
                 }
             }
         }
@@ -140,7 +150,7 @@ void ArduinoOutput::handleEvent(int eventType, MidiMessage& event, int sampleNum
 void ArduinoOutput::setParameter(int parameterIndex, float newValue)
 {
     // make sure current output channel is off:
-    arduino.sendDigital(outputChannel, ARD_LOW);
+    dispatcher->addControlCommand(outputChannel, ARD_LOW);
 
     if (parameterIndex == 0)
     {
@@ -176,14 +186,26 @@ void ArduinoOutput::setGateChannel(int chan)
 bool ArduinoOutput::enable()
 {
     acquisitionIsActive = true;
+
+    if (deviceSelected)
+    {
+        dispatcher->resetLatencyStats();
+        dispatcher->start();
+    }
+
 	return deviceSelected;
 }
 
 bool ArduinoOutput::disable()
 {
+    dispatcher->stop();
     arduino.sendDigital(outputChannel, ARD_LOW);
     acquisitionIsActive = false;
-	return true;
+
+    if (deviceSelected)
+        std::cout << "Arduino output: " << dispatcher->getLatencyReport() << std::endl;
+
+    return true;
 }
 
 void ArduinoOutput::process(AudioSampleBuffer& buffer,
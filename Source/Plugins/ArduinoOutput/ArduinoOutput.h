@@ -28,7 +28,22 @@
 #include <ProcessorHeaders.h>
 #include "serial/ofArduino.h"
 
+/**
+
+  Sets the digital pins of an Arduino from the OutputDispatcher thread.
+
+*/
 
+class ArduinoOutputDevice : public OutputDevice
+{
+public:
+    ArduinoOutputDevice(ofArduino& arduino_) : arduino(arduino_) {}
+
+    void sendCommands(const OutputCommand* commands, int numCommands);
+
+private:
+    ofArduino& arduino;
+};
 
 /**
 
@@ -36,9 +51,10 @@
 
 	Provides a serial interface to an Arduino board.
 
-	Based on Open Frameworks ofArduino class.
+	Based on Open Frameworks ofArduino class. Pin changes are sent by an
+	OutputDispatcher, so serial writes never block the audio thread.
 
-	@see GenericProcessor
+	@see GenericProcessor, OutputDispatcher
 
 */
 
@@ -88,6 +104,9 @@ private:
     /** An open-frameworks Arduino object. */
     ofArduino arduino;
 
+    ArduinoOutputDevice outputDevice;
+    ScopedPointer<OutputDispatcher> dispatcher;
+
     bool state;
     bool acquisitionIsActive;
     bool deviceSelected;
@@ -62,14 +62,14 @@ SpikeDetector::SpikeDetector()
         electrodeCounter.add(0);
     }
 
-    //spikeBuffer = new uint8_t[MAX_SPIKE_BUFFER_LEN]; // MAX_SPIKE_BUFFER_LEN defined in SpikeObject.h
-	spikeBuffer.malloc(MAX_SPIKE_BUFFER_LEN);
+    spikePool = new SpikeRecordPool();
 
 }
 
 SpikeDetector::~SpikeDetector()
 {
-
+    // the events of the last buffer hold references to the pool
+    spikePool->releaseSentRecords();
 }
 
 
@@ -318,14 +318,24 @@ bool SpikeDetector::enable()
     useOverflowBuffer.clear();
 
     for (int i = 0; i < electrodes.size(); i++)
+    {
         useOverflowBuffer.add(false);
 
+        // enough spikes to fill the display queue of every electrode without
+        // allocating during acquisition
+        spikePool->reserve(SPIKE_DISPLAY_QUEUE_SIZE, electrodes[i]->numChannels,
+                           electrodes[i]->prePeakSamples + electrodes[i]->postPeakSamples);
+    }
+
     return true;
 }
 
 bool SpikeDetector::disable()
 {
 
+    spikePool->releaseSentRecords();
+    spikePool->resetReservations();
+
     for (int n = 0; n < electrodes.size(); n++)
     {
         resetElectrode(electrodes[n]);
@@ -334,24 +344,21 @@ bool SpikeDetector::disable()
     return true;
 }
 
-void SpikeDetector::addSpikeEvent(SpikeObject* s, MidiBuffer& eventBuffer, int peakIndex)
+void SpikeDetector::addSpikeEvent(SpikeRecord* s, MidiBuffer& eventBuffer, int peakIndex)
 {
 
     // std::cout << "Adding spike event for index " << peakIndex << std::endl;
 
     s->eventType = SPIKE_EVENT_CODE;
 
-    int numBytes = packSpike(s,                        // SpikeObject
-                             spikeBuffer,              // uint8_t*
-                             MAX_SPIKE_BUFFER_LEN);    // int
-
-    if (numBytes > 0)
-        eventBuffer.addEvent(spikeBuffer, numBytes, peakIndex);
+    // the event only carries a handle, the waveform stays in the pool;
+    // past the reserved number of events in flight the spike is dropped
+    spikePool->addEvent(s, eventBuffer, peakIndex);
 
     //std::cout << "Adding spike" << std::endl;
 }
 
-void SpikeDetector::addWaveformToSpikeObject(SpikeObject* s,
+void SpikeDetector::addWaveformToSpikeRecord(SpikeRecord* s,
                                              int& peakIndex,
                                              int& electrodeNumber,
                                              int& currentChannel)
@@ -377,8 +384,6 @@ void SpikeDetector::addWaveformToSpikeObject(SpikeObject* s,
     
     s->timestamp = getTimestamp(currentChannel) + peakIndex;
 
-    s->nSamples = spikeLength;
-
     int chan = *(electrodes[electrodeNumber]->channels+currentChannel);
 
     s->gain[currentChannel] = (int)(1.0f / channels[chan]->bitVolts)*1000;
@@ -444,6 +449,9 @@ void SpikeDetector::process(AudioSampleBuffer& buffer,
     SimpleElectrode* electrode;
     dataBuffer = &buffer;
 
+    // downstream processors are done with the spikes sent in the previous buffer
+    spikePool->releaseSentRecords();
+
     checkForEvents(events); // need to find any timestamp events before extracting spikes
 
     //std::cout << dataBuffer.getMagnitude(0,nSamples) << std::endl;
@@ -506,15 +514,16 @@ void SpikeDetector::process(AudioSampleBuffer& buffer,
 //                        float       gain[MAX_NUMBER_OF_SPIKE_CHANNELS];
 //                        uint16_t    threshold[MAX_NUMBER_OF_SPIKE_CHANNELS];
 
-                        SpikeObject newSpike;
-                        newSpike.timestamp = 0; //getTimestamp(currentChannel) + peakIndex;
-                        newSpike.timestamp_software = -1;
-                        newSpike.source = i;
-                        newSpike.nChannels = electrode->numChannels;
-                        newSpike.sortedId = 0;
-                        newSpike.electrodeID = electrode->electrodeID;
-                        newSpike.channel = 0;
-                        newSpike.samplingFrequencyHz = sampleRateForElectrode;
+                        SpikeRecordPtr newSpike = spikePool->allocate(electrode->numChannels,
+                                                                      electrode->prePeakSamples + electrode->postPeakSamples);
+                        newSpike->timestamp = 0; //getTimestamp(currentChannel) + peakIndex;
+                        newSpike->timestamp_software = -1;
+                        newSpike->source = i;
+                        newSpike->sortedId = 0;
+                        newSpike->matchScore = 0;
+                        newSpike->electrodeID = electrode->electrodeID;
+                        newSpike->channel = 0;
+                        newSpike->samplingFrequencyHz = sampleRateForElectrode;
 
                         currentIndex = 0;
 
@@ -522,7 +531,7 @@ void SpikeDetector::process(AudioSampleBuffer& buffer,
                         for (int channel = 0; channel < electrode->numChannels; channel++)
                         {
 
-                            addWaveformToSpikeObject(&newSpike,
+                            addWaveformToSpikeRecord(newSpike,
                                                      peakIndex,
                                                      i,
                                                      channel);
@@ -541,7 +550,7 @@ void SpikeDetector::process(AudioSampleBuffer& buffer,
                         }
 
                         //for (int xxx = 0; xxx < 1000; xxx++) // overload with spikes for testing purposes
-                        addSpikeEvent(&newSpike, events, peakIndex);
+                        addSpikeEvent(newSpike, events, peakIndex);
 
                         // advance the sample index
                         sampleIndex = peakIndex + electrode->postPeakSamples;
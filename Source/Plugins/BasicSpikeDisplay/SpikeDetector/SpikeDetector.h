@@ -176,8 +176,8 @@ private:
     int currentChannelIndex;
     int currentIndex;
 
-   // uint8_t* spikeBuffer;///[256];
-	HeapBlock<uint8_t> spikeBuffer;
+    /** Spikes are sent downstream as handles to records from this pool */
+    SpikeRecordPool::Ptr spikePool;
     int64 timestamp;
 
     OwnedArray<SimpleElectrode> electrodes;
@@ -190,8 +190,8 @@ private:
 
     void handleEvent(int eventType, MidiMessage& event, int sampleNum);
 
-    void addSpikeEvent(SpikeObject* s, MidiBuffer& eventBuffer, int peakIndex);
-    void addWaveformToSpikeObject(SpikeObject* s,
+    void addSpikeEvent(SpikeRecord* s, MidiBuffer& eventBuffer, int peakIndex);
+    void addWaveformToSpikeRecord(SpikeRecord* s,
                                   int& peakIndex,
                                   int& electrodeNumber,
                                   int& currentChannel);
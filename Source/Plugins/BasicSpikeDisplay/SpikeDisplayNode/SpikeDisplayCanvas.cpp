@@ -66,13 +66,14 @@ SpikeDisplayCanvas::SpikeDisplayCanvas(SpikeDisplayNode* n) :
 
 SpikeDisplayCanvas::~SpikeDisplayCanvas()
 {
-    processor->removeSpikePlots();
+    processor->setDisplayActive(false);
 }
 
 void SpikeDisplayCanvas::beginAnimation()
 {
     std::cout << "SpikeDisplayCanvas beginning animation." << std::endl;
 
+    processor->setDisplayActive(true);
     startCallbacks();
 }
 
@@ -81,6 +82,7 @@ void SpikeDisplayCanvas::endAnimation()
     std::cout << "SpikeDisplayCanvas ending animation." << std::endl;
 
     stopCallbacks();
+    processor->setDisplayActive(false);
 }
 
 void SpikeDisplayCanvas::update()
@@ -89,7 +91,6 @@ void SpikeDisplayCanvas::update()
     //std::cout << "Updating SpikeDisplayCanvas" << std::endl;
 
     int nPlots = processor->getNumElectrodes();
-    processor->removeSpikePlots();
 
     if (nPlots != spikeDisplay->getNumPlots())
     {
@@ -97,16 +98,8 @@ void SpikeDisplayCanvas::update()
 
         for (int i = 0; i < nPlots; i++)
         {
-            SpikePlot* sp = spikeDisplay->addSpikePlot(processor->getNumberOfChannelsForElectrode(i), i,
-                                                       processor->getNameForElectrode(i));
-            processor->addSpikePlotForElectrode(sp, i);
-        }
-    }
-    else
-    {
-        for (int i = 0; i < nPlots; i++)
-        {
-            processor->addSpikePlotForElectrode(spikeDisplay->getSpikePlot(i), i);
+            spikeDisplay->addSpikePlot(processor->getNumberOfChannelsForElectrode(i), i,
+                                       processor->getNameForElectrode(i));
         }
     }
 
@@ -152,9 +145,32 @@ void SpikeDisplayCanvas::refresh()
 
 void SpikeDisplayCanvas::processSpikeEvents()
 {
+    // drain the spikes queued by the processor since the last refresh
+    SpikeRecordPtr spike;
+    SpikeObject s;
 
-    processor->setParameter(2, 0.0f); // request redraw
+    int nPlots = jmin(spikeDisplay->getNumPlots(), processor->getNumElectrodes());
 
+    for (int i = 0; i < nPlots; i++)
+    {
+        SpikePlot* plot = spikeDisplay->getSpikePlot(i);
+
+        int nChannels = jmin(plot->nChannels, processor->getNumberOfChannelsForElectrode(i));
+
+        for (int j = 0; j < nChannels; j++)
+        {
+            processor->setDisplayThreshold(i, j, plot->getDisplayThresholdForChannel(j));
+            plot->setDetectorThresholdForChannel(j, processor->getDetectorThreshold(i, j));
+        }
+
+        while (processor->getNextSpike(i, spike))
+        {
+            spike->toSpikeObject(s);
+            plot->processSpikeObject(s);
+        }
+
+        plot->setNumDroppedSpikes(processor->getNumDroppedSpikes(i));
+    }
 }
 
 bool SpikeDisplayCanvas::keyPressed(const KeyPress& key)
@@ -500,7 +516,7 @@ void SpikeDisplay::setRangeForWaveAxis(int plotNum, int axisNum, float range)
 
 SpikePlot::SpikePlot(SpikeDisplayCanvas* sdc, int elecNum, int p, String name_) :
     canvas(sdc), isSelected(false), electrodeNumber(elecNum),  plotType(p),
-    limitsChanged(true), name(name_)
+    limitsChanged(true), name(name_), numDroppedSpikes(0)
 
 {
 
@@ -579,6 +595,21 @@ void SpikePlot::paint(Graphics& g)
 
     g.drawText(name,10,0,200,20,Justification::left,false);
 
+    if (numDroppedSpikes > 0)
+    {
+        g.setColour(Colours::orange);
+        g.drawText(String(numDroppedSpikes) + " dropped",getWidth()-160,0,150,20,Justification::right,false);
+    }
+
+}
+
+void SpikePlot::setNumDroppedSpikes(int n)
+{
+    if (n != numDroppedSpikes)
+    {
+        numDroppedSpikes = n;
+        repaint();
+    }
 }
 
 void SpikePlot::processSpikeObject(const SpikeObject& s)
@@ -207,6 +207,9 @@ public:
 
     void processSpikeObject(const SpikeObject& s);
 
+    /** Shown next to the name when the node had to drop spikes */
+    void setNumDroppedSpikes(int n);
+
     SpikeDisplayCanvas* canvas;
 
     bool isSelected;
@@ -258,6 +261,7 @@ private:
     void updateAxesPositions();
 
     String name;
+    int numDroppedSpikes;
 
     Font font;
 
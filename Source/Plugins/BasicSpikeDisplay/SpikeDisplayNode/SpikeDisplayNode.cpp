@@ -28,10 +28,9 @@
 
 
 SpikeDisplayNode::SpikeDisplayNode()
-    : GenericProcessor("Spike Viewer"), displayBufferSize(5),  redrawRequested(false),
-	isRecording(false)
+    : GenericProcessor("Spike Viewer"), isRecording(false)
 {
-
+    fallbackPool = new SpikeRecordPool();
 
 }
 
@@ -40,6 +39,25 @@ SpikeDisplayNode::~SpikeDisplayNode()
 
 }
 
+SpikeDisplayNode::Electrode::Electrode(const String& name_, int numChannels_, int queueSize)
+    : name(name_), numChannels(numChannels_), fifo(queueSize), recordIndex(-1)
+{
+    queue.calloc(queueSize);
+
+    for (int j = 0; j < numChannels; j++)
+    {
+        displayThresholds.add(Atomic<float>(0));
+        detectorThresholds.add(Atomic<float>(0));
+    }
+}
+
+SpikeDisplayNode::Electrode::~Electrode()
+{
+    // HeapBlock doesn't run destructors, so release the spikes still queued
+    for (int i = 0; i < fifo.getTotalSize(); i++)
+        queue[i] = nullptr;
+}
+
 AudioProcessorEditor* SpikeDisplayNode::createEditor()
 {
     //std::cout<<"Creating SpikeDisplayCanvas."<<std::endl;
@@ -61,20 +79,10 @@ void SpikeDisplayNode::updateSettings()
         if (type == ELECTRODE_CHANNEL)
         {
 
-            Electrode elec;
-			elec.numChannels = static_cast<SpikeChannel*>(eventChannels[i]->extraData.get())->numChannels;
-
-            elec.name = eventChannels[i]->getName();
-            elec.currentSpikeIndex = 0;
-            elec.mostRecentSpikes.ensureStorageAllocated(displayBufferSize);
-
-            for (int j = 0; j < elec.numChannels; j++)
-            {
-                elec.displayThresholds.add(0);
-                elec.detectorThresholds.add(0);
-            }
+            int numChannels = static_cast<SpikeChannel*>(eventChannels[i]->extraData.get())->numChannels;
 
-            electrodes.add(elec);
+            electrodes.add(new Electrode(eventChannels[i]->getName(), numChannels,
+                                         SPIKE_DISPLAY_QUEUE_SIZE));
 
         }
     }
@@ -91,15 +99,22 @@ bool SpikeDisplayNode::enable()
     std::cout << "SpikeDisplayNode::enable()" << std::endl;
     SpikeDisplayEditor* editor = (SpikeDisplayEditor*) getEditor();
 
+	fallbackPool->resetReservations();
+
 	CoreServices::RecordNode::registerSpikeSource(this);
 	for (int i = 0; i < electrodes.size(); i ++)
 	{
-		Electrode& elec = electrodes.getReference(i);
+		Electrode* elec = electrodes[i];
+
+		// packed spikes never have more samples than a SpikeObject holds
+		fallbackPool->reserve(SPIKE_DISPLAY_QUEUE_SIZE, elec->numChannels,
+		                      MAX_NUMBER_OF_SPIKE_CHANNEL_SAMPLES);
+
 		SpikeRecordInfo *recElec = new SpikeRecordInfo();
-		recElec->name = elec.name;
-		recElec->numChannels = elec.numChannels;
+		recElec->name = elec->name;
+		recElec->numChannels = elec->numChannels;
 		recElec->sampleRate = settings.sampleRate;
-		elec.recordIndex = CoreServices::RecordNode::addSpikeElectrode(recElec);
+		elec->recordIndex = CoreServices::RecordNode::addSpikeElectrode(recElec);
 	}
 
     editor->enable();
@@ -119,7 +134,7 @@ int SpikeDisplayNode::getNumberOfChannelsForElectrode(int i)
 {
     if (i > -1 && i < electrodes.size())
     {
-        return electrodes[i].numChannels;
+        return electrodes[i]->numChannels;
     }
     else
     {
@@ -132,7 +147,7 @@ String SpikeDisplayNode::getNameForElectrode(int i)
 
     if (i > -1 && i < electrodes.size())
     {
-        return electrodes[i].name;
+        return electrodes[i]->name;
     }
     else
     {
@@ -140,20 +155,72 @@ String SpikeDisplayNode::getNameForElectrode(int i)
     }
 }
 
-void SpikeDisplayNode::addSpikePlotForElectrode(SpikePlot* sp, int i)
+void SpikeDisplayNode::setDisplayActive(bool active)
+{
+    displayActive = active ? 1 : 0;
+}
+
+bool SpikeDisplayNode::getNextSpike(int electrode, SpikeRecordPtr& spike)
+{
+    if (electrode < 0 || electrode >= electrodes.size())
+        return false;
+
+    Electrode* e = electrodes[electrode];
+
+    int start1, size1, start2, size2;
+    e->fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return false;
+
+    // leave the slot empty, so the record goes back to its pool from here
+    spike = e->queue[start1];
+    e->queue[start1] = nullptr;
+
+    e->fifo.finishedRead(1);
+    return true;
+}
+
+int SpikeDisplayNode::getNumDroppedSpikes(int electrode) const
 {
-    Electrode& e = electrodes.getReference(i);
-    e.spikePlot = sp;
+    if (electrode < 0 || electrode >= electrodes.size())
+        return 0;
 
+    return electrodes[electrode]->numDropped.get();
 }
 
-void SpikeDisplayNode::removeSpikePlots()
+float SpikeDisplayNode::getDetectorThreshold(int electrode, int channel) const
 {
-    for (int i = 0; i < getNumElectrodes(); i++)
+    if (electrode < 0 || electrode >= electrodes.size()
+        || channel < 0 || channel >= electrodes[electrode]->numChannels)
+        return 0;
+
+    return electrodes[electrode]->detectorThresholds.getReference(channel).get();
+}
+
+void SpikeDisplayNode::setDisplayThreshold(int electrode, int channel, float threshold)
+{
+    if (electrode < 0 || electrode >= electrodes.size()
+        || channel < 0 || channel >= electrodes[electrode]->numChannels)
+        return;
+
+    electrodes[electrode]->displayThresholds.getReference(channel).set(threshold);
+}
+
+void SpikeDisplayNode::pushSpike(Electrode* e, SpikeRecord* spike)
+{
+    int start1, size1, start2, size2;
+    e->fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
     {
-        Electrode& e = electrodes.getReference(i);
-        e.spikePlot = nullptr;
+        // the canvas isn't keeping up
+        ++e->numDropped;
+        return;
     }
+
+    e->queue[start1] = spike;
+    e->fifo.finishedWrite(1);
 }
 
 int SpikeDisplayNode::getNumElectrodes()
@@ -188,11 +255,6 @@ void SpikeDisplayNode::setParameter(int param, float val)
         isRecording = true;
 
     }
-    else if (param == 2)   // redraw
-    {
-        redrawRequested = true;
-
-    }
 
 }
 
@@ -203,36 +265,6 @@ void SpikeDisplayNode::process(AudioSampleBuffer& buffer, MidiBuffer& events)
 
     checkForEvents(events); // automatically calls 'handleEvent
 
-    if (redrawRequested)
-    {
-        // update incoming thresholds
-        for (int i = 0; i < getNumElectrodes(); i++)
-        {
-
-            Electrode& e = electrodes.getReference(i);
-
-            // update thresholds
-            for (int j = 0; j < e.numChannels; j++)
-            {
-                e.displayThresholds.set(j,
-                                        e.spikePlot->getDisplayThresholdForChannel(j));
-
-                e.spikePlot->setDetectorThresholdForChannel(j, e.detectorThresholds[j]);
-            }
-
-            // transfer buffered spikes to spike plot
-            for (int j = 0; j < e.currentSpikeIndex; j++)
-            {
-                //std::cout << "Transferring spikes." << std::endl;
-                e.spikePlot->processSpikeObject(e.mostRecentSpikes[j]);
-                e.currentSpikeIndex = 0;
-            }
-
-        }
-
-        redrawRequested = false;
-    }
-
 }
 
 void SpikeDisplayNode::handleEvent(int eventType, MidiMessage& event, int samplePosition)
@@ -243,48 +275,44 @@ void SpikeDisplayNode::handleEvent(int eventType, MidiMessage& event, int sample
     if (eventType == SPIKE)
     {
 
-        const uint8_t* dataptr = event.getRawData();
         int bufferSize = event.getRawDataSize();
 
         if (bufferSize > 0)
         {
 
-            SpikeObject newSpike;
-
-            bool isValid = unpackSpike(&newSpike, dataptr, bufferSize);
+            SpikeRecordPtr newSpike = getSpikeRecord(event, fallbackPool);
 
-            if (isValid)
+            if (newSpike != nullptr)
             {
-                int electrodeNum = newSpike.source;
+                int electrodeNum = newSpike->source;
 
-                Electrode& e = electrodes.getReference(electrodeNum);
+                if (electrodeNum >= electrodes.size())
+                    return;
+
+                Electrode* e = electrodes[electrodeNum];
                 // std::cout << electrodeNum << std::endl;
 
                 bool aboveThreshold = false;
 
                 // update threshold / check threshold
-                for (int i = 0; i < e.numChannels; i++)
+                for (int i = 0; i < e->numChannels && i < newSpike->nChannels; i++)
                 {
-                    e.detectorThresholds.set(i, float(newSpike.threshold[i])); // / float(newSpike.gain[i]));
+                    e->detectorThresholds.getReference(i).set(float(newSpike->threshold[i])); // / float(newSpike->gain[i]));
 
-                    aboveThreshold = aboveThreshold | checkThreshold(i, e.displayThresholds[i], newSpike);
+                    aboveThreshold = aboveThreshold | checkThreshold(i, e->displayThresholds.getReference(i).get(), *newSpike);
                 }
 
                 if (aboveThreshold)
                 {
 
-                    // add to buffer
-                    if (e.currentSpikeIndex < displayBufferSize)
-                    {
-                        //  std::cout << "Adding spike " << e.currentSpikeIndex + 1 << std::endl;
-                        e.mostRecentSpikes.set(e.currentSpikeIndex, newSpike);
-                        e.currentSpikeIndex++;
-                    }
+                    // hand over to the canvas
+                    if (displayActive.get())
+                        pushSpike(e, newSpike);
 
                     // save spike
                     if (isRecording)
                     {
-						CoreServices::RecordNode::writeSpike(newSpike,e.recordIndex);
+						CoreServices::RecordNode::writeSpike(*newSpike,e->recordIndex);
                     }
                 }
 
@@ -296,7 +324,7 @@ void SpikeDisplayNode::handleEvent(int eventType, MidiMessage& event, int sample
 
 }
 
-bool SpikeDisplayNode::checkThreshold(int chan, float thresh, SpikeObject& s)
+bool SpikeDisplayNode::checkThreshold(int chan, float thresh, const SpikeRecord& s)
 {
     int sampIdx = s.nSamples*chan;
 
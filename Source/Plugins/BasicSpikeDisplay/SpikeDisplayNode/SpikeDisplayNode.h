@@ -33,8 +33,14 @@ class SpikePlot;
 
 /**
 
- Takes in MidiEvents and extracts SpikeObjects from the MidiEvent buffers.
- Those Events are then held in a queue until they are pulled by the SpikeDisplayCanvas.
+ Takes in MidiEvents and extracts SpikeRecords from the MidiEvent buffers.
+ Spikes above the display thresholds go into a lock-free queue per electrode,
+ which the SpikeDisplayCanvas drains on the message thread at its own refresh
+ rate. The audio thread never touches the spike plots; spikes that find a
+ full queue are dropped and counted.
+
+ Spikes sent as handles are shared with the processor that detected them;
+ packed spikes from older processors are copied into records from a local pool.
 
   @see GenericProcessor, SpikeDisplayEditor, SpikeDisplayCanvas
 
@@ -72,35 +78,57 @@ public:
     int getNumberOfChannelsForElectrode(int i);
     int getNumElectrodes();
 
-    void addSpikePlotForElectrode(SpikePlot* sp, int i);
-    void removeSpikePlots();
+    /** Starts or stops queueing spikes for the canvas */
+    void setDisplayActive(bool active);
+
+    /** Takes the oldest queued spike of an electrode. Message thread only;
+        returns false when the queue is empty. */
+    bool getNextSpike(int electrode, SpikeRecordPtr& spike);
+
+    /** Number of spikes dropped because the electrode's queue was full */
+    int getNumDroppedSpikes(int electrode) const;
+
+    /** Last threshold reported by the spike source */
+    float getDetectorThreshold(int electrode, int channel) const;
+
+    /** Threshold above which spikes are displayed and recorded */
+    void setDisplayThreshold(int electrode, int channel, float threshold);
 
-    bool checkThreshold(int, float, SpikeObject&);
+    bool checkThreshold(int, float, const SpikeRecord&);
 
 private:
 
     struct Electrode
     {
+        Electrode(const String& name, int numChannels, int queueSize);
+        ~Electrode();
+
         String name;
 
         int numChannels;
 
-        Array<float> displayThresholds;
-        Array<float> detectorThresholds;
-
-        Array<SpikeObject> mostRecentSpikes;
-        int currentSpikeIndex;
+        /** Shared with the canvas, one value per channel */
+        Array<Atomic<float> > displayThresholds;
+        Array<Atomic<float> > detectorThresholds;
 
-        SpikePlot* spikePlot;
+        /** Single producer (audio thread), single consumer (message thread) */
+        AbstractFifo fifo;
+        HeapBlock<SpikeRecordPtr> queue;
+        Atomic<int> numDropped;
 
         int recordIndex;
 
+        JUCE_DECLARE_NON_COPYABLE(Electrode);
     };
 
-    Array<Electrode> electrodes;
+    void pushSpike(Electrode* e, SpikeRecord* spike);
+
+    OwnedArray<Electrode> electrodes;
+
+    /** Holds spikes that arrive packed rather than as handles */
+    SpikeRecordPool::Ptr fallbackPool;
 
-    int displayBufferSize;
-    bool redrawRequested;
+    Atomic<int> displayActive;
 
     // members for recording
     bool isRecording;
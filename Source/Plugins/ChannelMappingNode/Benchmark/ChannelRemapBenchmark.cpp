@@ -0,0 +1,173 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2014 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Times ChannelRemapper against the previous path of ChannelMappingNode,
+    which copied the whole buffer to a second buffer every block, copied
+    each mapped channel back and subtracted its reference in a second pass.
+    Checks that both give bit-identical outputs.
+
+        make benchmark            (in Source/Plugins/ChannelMappingNode)
+        ./ChannelRemapBenchmark [numChannels] [numSamples]
+
+    The defaults are 384 channels x 1024 samples.
+*/
+
+#include "../ChannelRemapper.h"
+
+#include <algorithm>
+#include <random>
+
+#define NUM_REFERENCES 4
+#define NUM_BLOCKS 200
+
+namespace
+{
+struct Mapping
+{
+    const char* name;
+    Array<int> sources;
+    Array<int> references;
+};
+
+/** The previous process(): a full copy, then a copy back and a reference pass per channel */
+void copyRemap(AudioSampleBuffer& buffer, AudioSampleBuffer& channelBuffer, const Mapping& mapping)
+{
+    channelBuffer = buffer;
+
+    for (int j = 0; j < mapping.sources.size(); j++)
+    {
+        buffer.copyFrom(j, 0, channelBuffer.getReadPointer(mapping.sources[j]), buffer.getNumSamples(), 1.0f);
+
+        if (mapping.references[j] >= 0)
+            buffer.addFrom(j, 0, channelBuffer, mapping.references[j], 0, buffer.getNumSamples(), -1.0f);
+    }
+}
+
+void inPlaceRemap(AudioSampleBuffer& buffer, ChannelRemapper& remapper, const Mapping& mapping)
+{
+    remapper.clear();
+
+    for (int j = 0; j < mapping.sources.size(); j++)
+        remapper.addMove(j, mapping.sources[j], mapping.references[j], buffer.getNumSamples());
+
+    remapper.remap(buffer);
+}
+
+void fill(AudioSampleBuffer& buffer, int block)
+{
+    for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+    {
+        float* data = buffer.getWritePointer(ch);
+
+        for (int n = 0; n < buffer.getNumSamples(); n++)
+            data[n] = float((ch * 7919 + n * 31 + block * 131) % 2001) - 1000.0f;
+    }
+}
+
+bool isIdentical(const AudioSampleBuffer& a, const AudioSampleBuffer& b)
+{
+    for (int ch = 0; ch < a.getNumChannels(); ch++)
+    {
+        if (memcmp(a.getReadPointer(ch), b.getReadPointer(ch), sizeof(float) * a.getNumSamples()) != 0)
+            return false;
+    }
+
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int numChannels = (argc > 1) ? atoi(argv[1]) : 384;
+    const int numSamples = (argc > 2) ? atoi(argv[2]) : 1024;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pickReference(0, numChannels - 1);
+
+    Array<int> referenceChannels;
+    for (int r = 0; r < NUM_REFERENCES; r++)
+        referenceChannels.add(pickReference(rng));
+
+    Mapping mappings[3];
+    mappings[0].name = "identity mapping";
+    mappings[1].name = "random permutation";
+    mappings[2].name = "permutation + refs";
+
+    std::vector<int> permutation(numChannels);
+    for (int ch = 0; ch < numChannels; ch++)
+        permutation[ch] = ch;
+    std::shuffle(permutation.begin(), permutation.end(), rng);
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        mappings[0].sources.add(ch);
+        mappings[0].references.add(-1);
+        mappings[1].sources.add(permutation[ch]);
+        mappings[1].references.add(-1);
+        mappings[2].sources.add(permutation[ch]);
+        mappings[2].references.add((ch % 2 == 0) ? referenceChannels[ch % NUM_REFERENCES] : -1);
+    }
+
+    AudioSampleBuffer copied(numChannels, numSamples);
+    AudioSampleBuffer inPlace(numChannels, numSamples);
+    AudioSampleBuffer channelBuffer(numChannels, numSamples);
+
+    ChannelRemapper remapper(NUM_REFERENCES);
+    remapper.prepare(numChannels, numSamples);
+
+    bool allIdentical = true;
+
+    printf("%d channels x %d samples, %d blocks\n", numChannels, numSamples, NUM_BLOCKS);
+
+    for (int m = 0; m < 3; m++)
+    {
+        double copySeconds = 0;
+        double inPlaceSeconds = 0;
+        bool identical = true;
+
+        for (int block = 0; block < NUM_BLOCKS; block++)
+        {
+            fill(copied, block);
+            fill(inPlace, block);
+
+            int64 start = Time::getHighResolutionTicks();
+            copyRemap(copied, channelBuffer, mappings[m]);
+            copySeconds += Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+            start = Time::getHighResolutionTicks();
+            inPlaceRemap(inPlace, remapper, mappings[m]);
+            inPlaceSeconds += Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+            identical = identical && isIdentical(copied, inPlace);
+        }
+
+        allIdentical = allIdentical && identical;
+
+        printf("%-20s %8.1f us -> %8.1f us per block, outputs %s\n", mappings[m].name,
+               copySeconds * 1e6 / NUM_BLOCKS, inPlaceSeconds * 1e6 / NUM_BLOCKS,
+               identical ? "identical" : "DIFFER");
+    }
+
+    return allIdentical ? 0 : 1;
+}
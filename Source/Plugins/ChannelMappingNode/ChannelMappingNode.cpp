@@ -28,7 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 ChannelMappingNode::ChannelMappingNode()
-    : GenericProcessor("Channel Map"), channelBuffer(1,10000)
+    : GenericProcessor("Channel Map"), remapper(NUM_REFERENCES)
 {
     referenceArray.resize(1024); // make room for 1024 channels
     channelArray.resize(1024);
@@ -62,10 +62,14 @@ AudioProcessorEditor* ChannelMappingNode::createEditor()
 
 
 
+void ChannelMappingNode::prepareToPlay(double sampleRate, int estimatedSamplesPerBlock)
+{
+    remapper.prepare(getNumInputs(), estimatedSamplesPerBlock);
+}
+
 void ChannelMappingNode::updateSettings()
 {
-    if (getNumInputs() > 0)
-        channelBuffer.setSize(getNumInputs(), 10000);
+    remapper.prepare(getNumInputs(), getBlockSize());
 
 	if (editorIsConfigured)
 	{
@@ -129,42 +133,34 @@ void ChannelMappingNode::process(AudioSampleBuffer& buffer,
     int i=0;
     int realChan;
 
-    // use copy constructor to set the data to refer to
-    channelBuffer = buffer;
+    // normally sized in prepareToPlay(), this only catches a larger block than announced
+    if (buffer.getNumChannels() > remapper.getNumChannels() || buffer.getNumSamples() > remapper.getNumSamples())
+        remapper.prepare(buffer.getNumChannels(), buffer.getNumSamples());
 
-   // buffer.clear();
+    remapper.clear();
 
     while (j < settings.numOutputs)
     {
         realChan = channelArray[i];
-        if ((realChan < channelBuffer.getNumChannels()) && (enabledChannelArray[realChan]))
+        if ((realChan < buffer.getNumChannels()) && (enabledChannelArray[realChan]))
         {
-            // copy it back into the buffer according to the channel mapping
-            buffer.copyFrom(j, // destChannel
-                           0, // destStartSample
-                           channelBuffer.getReadPointer(realChan), // source
-                           getNumSamples(j), // numSamples
-                           1.0f // gain to apply to source (positive for original signal)
-                          );
+            int referenceChan = -1;
 
             // now do the referencing
             if ((referenceArray[realChan] > -1) && (referenceChannels[referenceArray[realChan]] > -1)
-                && (referenceChannels[referenceArray[realChan]] < channelBuffer.getNumChannels()))
+                && (referenceChannels[referenceArray[realChan]] < buffer.getNumChannels()))
             {
-                buffer.addFrom(j, // destChannel
-                               0, // destStartSample
-                               channelBuffer, // source
-							   channels[referenceChannels[referenceArray[realChan]]]->index-1, // sourceChannel
-                               0, // sourceStartSample
-                               getNumSamples(j), // numSamples
-                               -1.0f // gain to apply to source (negative for reference)
-                              );
+                referenceChan = channels[referenceChannels[referenceArray[realChan]]]->index-1;
             }
+
+            remapper.addMove(j, realChan, referenceChan, getNumSamples(j));
+
             j++;
         }
         i++;
 
     }
 
-}
+    remapper.remap(buffer);
 
+}
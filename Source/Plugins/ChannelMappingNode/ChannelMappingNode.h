@@ -26,6 +26,7 @@
 
 
 #include <ProcessorHeaders.h>
+#include "ChannelRemapper.h"
 
 
 /**
@@ -35,7 +36,11 @@
   Allows the user to select a subset of channels, remap their order, and reference them against
   any other channel.
 
-  @see GenericProcessor
+  The remapping is done in place by a ChannelRemapper: channels that keep
+  their position are not touched, moved channels are copied once, and
+  referenced channels are copied and referenced in the same pass.
+
+  @see GenericProcessor, ChannelRemapper
 
 */
 
@@ -48,6 +53,7 @@ public:
     ~ChannelMappingNode();
 
     void process(AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
+    void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
     void setParameter(int parameterIndex, float newValue);
 
     AudioProcessorEditor* createEditor();
@@ -68,7 +74,7 @@ private:
 
     bool editorIsConfigured;
 
-    AudioSampleBuffer channelBuffer;
+    ChannelRemapper remapper;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelMappingNode);
 
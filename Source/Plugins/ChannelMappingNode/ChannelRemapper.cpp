@@ -0,0 +1,208 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2014 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelRemapper.h"
+
+ChannelRemapper::ChannelRemapper(int maxReferences_)
+    : maxReferences(maxReferences_), referenceSamples(0), numChannels(0), numSamples(0)
+{
+}
+
+ChannelRemapper::~ChannelRemapper()
+{
+}
+
+void ChannelRemapper::prepare(int channels, int samples)
+{
+    if (channels > numChannels)
+    {
+        pendingReads.calloc(channels);
+        moveForDest.malloc(channels);
+
+        for (int n = 0; n < channels; n++)
+            moveForDest[n] = -1;
+
+        moves.ensureStorageAllocated(channels);
+        readyMoves.ensureStorageAllocated(channels);
+        savedReferences.ensureStorageAllocated(maxReferences);
+
+        numChannels = channels;
+    }
+
+    if (samples > numSamples)
+    {
+        scratchBuffer.setSize(maxReferences + 1, samples);
+        numSamples = samples;
+    }
+}
+
+int ChannelRemapper::getNumChannels() const
+{
+    return numChannels;
+}
+
+int ChannelRemapper::getNumSamples() const
+{
+    return numSamples;
+}
+
+void ChannelRemapper::clear()
+{
+    moves.clearQuick();
+    savedReferences.clearQuick();
+    referenceSamples = 0;
+}
+
+void ChannelRemapper::addMove(int dest, int source, int referenceChannel, int samples)
+{
+    ChannelMove move;
+    move.dest = dest;
+    move.source = source;
+    move.referenceSlot = -1;
+    move.numSamples = samples;
+    move.fromScratch = false;
+
+    if (referenceChannel >= 0)
+    {
+        int slot = savedReferences.indexOf(referenceChannel);
+
+        if (slot < 0)
+        {
+            jassert(savedReferences.size() < maxReferences);
+
+            slot = savedReferences.size();
+            savedReferences.add(referenceChannel);
+        }
+
+        move.referenceSlot = slot + 1;
+        referenceSamples = jmax(referenceSamples, samples);
+    }
+
+    // a channel that keeps its place and isn't referenced needs no work at all
+    if (move.dest != move.source || move.referenceSlot > 0)
+        moves.add(move);
+}
+
+void ChannelRemapper::remap(AudioSampleBuffer& buffer)
+{
+    // the references must be read before any channel is overwritten
+    for (int n = 0; n < savedReferences.size(); n++)
+        scratchBuffer.copyFrom(n + 1, 0, buffer, savedReferences[n], 0, referenceSamples);
+
+    remapInPlace(buffer);
+}
+
+void ChannelRemapper::remapInPlace(AudioSampleBuffer& buffer)
+{
+    // readers still waiting for each channel, and the move that overwrites it
+    for (int n = 0; n < moves.size(); n++)
+    {
+        pendingReads[moves[n].source]++;
+        moveForDest[moves[n].dest] = n;
+    }
+
+    readyMoves.clearQuick();
+
+    for (int n = 0; n < moves.size(); n++)
+    {
+        if (isMoveReady(moves.getReference(n)))
+            readyMoves.add(n);
+    }
+
+    int numDone = 0;
+    int firstPending = 0;
+
+    while (numDone < moves.size())
+    {
+        if (readyMoves.size() == 0)
+        {
+            // only cycles are left: park one destination in the scratch
+            // channel and let its reader take it from there
+            while (moveForDest[moves[firstPending].dest] != firstPending)
+                firstPending++;
+
+            int parked = moves[firstPending].dest;
+
+            for (int n = 0; n < moves.size(); n++)
+            {
+                ChannelMove& reader = moves.getReference(n);
+
+                if (moveForDest[reader.dest] == n && reader.source == parked && ! reader.fromScratch)
+                {
+                    scratchBuffer.copyFrom(0, 0, buffer, parked, 0, reader.numSamples);
+                    reader.fromScratch = true;
+                    break;
+                }
+            }
+
+            pendingReads[parked] = 0;
+            readyMoves.add(firstPending);
+        }
+
+        int n = readyMoves.getLast();
+        readyMoves.removeLast();
+        const ChannelMove& move = moves.getReference(n);
+
+        performMove(buffer, move);
+        moveForDest[move.dest] = -1;
+        numDone++;
+
+        if (! move.fromScratch)
+        {
+            pendingReads[move.source]--;
+
+            int waiting = moveForDest[move.source];
+
+            if (waiting >= 0 && isMoveReady(moves.getReference(waiting)))
+                readyMoves.add(waiting);
+        }
+    }
+}
+
+bool ChannelRemapper::isMoveReady(const ChannelMove& move) const
+{
+    // a move may run once nobody else needs the channel it overwrites
+    int ownRead = (move.source == move.dest && ! move.fromScratch) ? 1 : 0;
+
+    return pendingReads[move.dest] == ownRead;
+}
+
+void ChannelRemapper::performMove(AudioSampleBuffer& buffer, const ChannelMove& move)
+{
+    float* dest = buffer.getWritePointer(move.dest);
+    const float* source = move.fromScratch ? scratchBuffer.getReadPointer(0)
+                                           : buffer.getReadPointer(move.source);
+
+    if (move.referenceSlot > 0)
+    {
+        // copy and reference in a single pass
+        const float* reference = scratchBuffer.getReadPointer(move.referenceSlot);
+
+        for (int n = 0; n < move.numSamples; n++)
+            dest[n] = source[n] - reference[n];
+    }
+    else
+    {
+        FloatVectorOperations::copy(dest, source, move.numSamples);
+    }
+}
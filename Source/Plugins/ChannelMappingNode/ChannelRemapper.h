@@ -0,0 +1,103 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CHANNELREMAPPER_H_INCLUDED
+#define CHANNELREMAPPER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+
+  Reorders and references the channels of a buffer in place.
+
+  Each block, the caller adds one move per output channel and calls remap().
+  Channels that keep their position are not touched, moved channels are
+  copied once, and a single scratch channel breaks cycles of the
+  permutation. References are saved to scratch before any channel is
+  overwritten, so referenced channels are copied and referenced in the same
+  pass.
+
+  All storage is sized by prepare(); remap() doesn't allocate.
+
+  @see ChannelMappingNode
+
+*/
+
+class ChannelRemapper
+{
+public:
+    ChannelRemapper(int maxReferences);
+    ~ChannelRemapper();
+
+    /** Sizes the move lists and the scratch buffer; only grows them */
+    void prepare(int numChannels, int numSamples);
+
+    int getNumChannels() const;
+    int getNumSamples() const;
+
+    /** Forgets the moves of the previous block */
+    void clear();
+
+    /** Output channel dest takes numSamples of input channel source, minus
+        input channel referenceChannel if it is >= 0 */
+    void addMove(int dest, int source, int referenceChannel, int numSamples);
+
+    /** Performs the moves added since clear() */
+    void remap(AudioSampleBuffer& buffer);
+
+private:
+    /** Output channel 'dest' takes input channel 'source', minus the
+        reference stored in scratch channel 'referenceSlot' if it is >= 0 */
+    struct ChannelMove
+    {
+        int dest;
+        int source;
+        int referenceSlot;
+        int numSamples;
+        bool fromScratch;
+    };
+
+    /** Performs the moves in an order that never overwrites a channel that
+        is still to be read */
+    void remapInPlace(AudioSampleBuffer& buffer);
+    void performMove(AudioSampleBuffer& buffer, const ChannelMove& move);
+    bool isMoveReady(const ChannelMove& move) const;
+
+    const int maxReferences;
+
+    Array<ChannelMove> moves;
+    HeapBlock<int> pendingReads;
+    HeapBlock<int> moveForDest;
+    Array<int> readyMoves;
+    Array<int> savedReferences;
+    int referenceSamples;
+    int numChannels;
+    int numSamples;
+
+    /** Channel 0 breaks permutation cycles, the others hold the references */
+    AudioSampleBuffer scratchBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelRemapper);
+};
+
+#endif  // CHANNELREMAPPER_H_INCLUDED
@@ -0,0 +1,239 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Writes synthetic neural data through CompressedFileWriter, the way
+    CompressedRecording does from the audio thread, reads it back with
+    CompressedFileSource and checks every sample. Reports the compression
+    ratio and the write and read rates for a few noise levels.
+
+        make benchmark            (in Source/Plugins/CompressedFormat)
+        ./CompressedBenchmark [numChannels] [seconds]
+
+    The write rate covers the audio thread's calls and the final flush;
+    the encoders and the writer thread run alongside, as in a recording.
+    Files go to the temporary directory and are deleted afterwards.
+*/
+
+#include "../RecordEngine/CompressedFileWriter.h"
+#include "../FileSource/CompressedFileSource.h"
+
+#define SAMPLE_RATE 30000.0f
+#define BIT_VOLTS 0.195f
+#define BUFFER_SIZE 1024
+#define BLOCK_LENGTH 1024
+#define ENCODER_THREADS 4
+
+// the generated signal repeats after this many buffers, about 10 s
+#define BUFFERS_PER_PERIOD 300
+
+namespace
+{
+double secondsSince(int64 start)
+{
+    return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+}
+
+/** Slow oscillations, gaussian noise and an occasional spike on every channel */
+void generate(HeapBlock<int16>& samples, HeapBlock<float>& values, int numChannels, int length, float noiseMicroVolts)
+{
+    Random rng(42);
+
+    samples.malloc(numChannels * length);
+    values.malloc(numChannels * length);
+
+    for (int c = 0; c < numChannels; c++)
+    {
+        const double lfpFreq = 4.0 + c % 8;
+        int spikeIn = rng.nextInt(3000);
+
+        for (int i = 0; i < length; i++)
+        {
+            const double t = i / SAMPLE_RATE;
+
+            // Box-Muller
+            const double u = jmax(1e-12, rng.nextDouble());
+            const double noise = std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * double_Pi * rng.nextDouble());
+
+            double uV = 150.0 * std::sin(2.0 * double_Pi * lfpFreq * t) + noiseMicroVolts * noise;
+
+            if (--spikeIn < 30)
+            {
+                const int s = 29 - spikeIn;
+                uV += (s < 10) ? -100.0 * s / 10.0 : -100.0 + 130.0 * (s - 10) / 20.0;
+                if (spikeIn == 0)
+                    spikeIn = 1000 + rng.nextInt(5000);
+            }
+
+            const int16 k = int16(jlimit(-32767.0, 32767.0, std::floor(uV / BIT_VOLTS + 0.5)));
+            samples[c * length + i] = k;
+            values[c * length + i] = k * BIT_VOLTS;
+        }
+    }
+}
+
+class WriterThread : public Thread
+{
+public:
+    WriterThread() : Thread("Compressed benchmark writer"), writer(nullptr) {}
+
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            writer->writeEncodedBlocks();
+            wait(50);
+        }
+    }
+
+    CompressedFileWriter* writer;
+};
+}
+
+int main(int argc, char* argv[])
+{
+    const int numChannels = (argc > 1) ? atoi(argv[1]) : 32;
+    const double seconds = (argc > 2) ? atof(argv[2]) : 30.0;
+    const float noiseLevels[] = {5.0f, 10.0f, 20.0f};
+    const File dir(File::getSpecialLocation(File::tempDirectory).getChildFile("CompressedBenchmark"));
+    bool allCorrect = true;
+
+    const int period = BUFFERS_PER_PERIOD * BUFFER_SIZE;
+    const int numBuffers = jmax(1, int(seconds * SAMPLE_RATE / BUFFER_SIZE));
+    const int64 numSamples = int64(numBuffers) * BUFFER_SIZE;
+    const double rawMB = double(numSamples) * numChannels * sizeof(int16) / (1024.0 * 1024.0);
+
+    dir.createDirectory();
+
+    StringArray names;
+    Array<float> bitVolts;
+    for (int c = 0; c < numChannels; c++)
+    {
+        names.add("CH" + String(c + 1));
+        bitVolts.add(BIT_VOLTS);
+    }
+
+    printf("%d channels, %.1f s at %.0f Hz (%.1f MB of samples), %d encoder threads\n",
+           numChannels, numSamples / SAMPLE_RATE, SAMPLE_RATE, rawMB, ENCODER_THREADS);
+
+    HeapBlock<const float*> channelData(numChannels);
+    HeapBlock<int16> readBuffer(numChannels * BUFFER_SIZE);
+
+    for (int n = 0; n < int(sizeof(noiseLevels) / sizeof(noiseLevels[0])); n++)
+    {
+        HeapBlock<int16> samples;
+        HeapBlock<float> values;
+        generate(samples, values, numChannels, period, noiseLevels[n]);
+
+        const File file(dir.getChildFile("noise" + String(int(noiseLevels[n])) + ".oec"));
+
+        ThreadPool encoderPool(ENCODER_THREADS);
+        WriterThread writerThread;
+        ScopedPointer<CompressedFileWriter> writer = new CompressedFileWriter(&encoderPool, &writerThread, BLOCK_LENGTH);
+        writerThread.writer = writer;
+
+        if (! writer->open(file, SAMPLE_RATE, names, bitVolts))
+        {
+            printf("Can't create %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        writerThread.startThread();
+
+        int64 start = Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBuffers; b++)
+        {
+            const int offset = (b % BUFFERS_PER_PERIOD) * BUFFER_SIZE;
+            for (int c = 0; c < numChannels; c++)
+                channelData[c] = values + c * period + offset;
+
+            writer->write(channelData, BUFFER_SIZE, int64(b) * BUFFER_SIZE);
+        }
+
+        writer->flush();
+        const double writeSeconds = secondsSince(start);
+
+        writerThread.stopThread(-1);
+        encoderPool.removeAllJobs(true, 5000);
+        writer = nullptr;
+
+        const double fileMB = file.getSize() / (1024.0 * 1024.0);
+
+        CompressedFileSource source;
+        int64 errors = 0;
+
+        start = Time::getHighResolutionTicks();
+
+        if (! source.OpenFile(file) || source.getNumRecords() != 1)
+        {
+            printf("Can't read %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        source.setActiveRecord(0);
+
+        if (source.getActiveNumSamples() != numSamples || source.getActiveNumChannels() != numChannels
+            || source.getActiveSampleRate() != SAMPLE_RATE)
+            errors = numSamples;
+
+        for (int64 pos = 0; pos < numSamples && errors == 0; pos += BUFFER_SIZE)
+        {
+            if (source.readData(readBuffer, BUFFER_SIZE) != BUFFER_SIZE)
+            {
+                errors += BUFFER_SIZE;
+                break;
+            }
+
+            const int offset = int(pos % period);
+            for (int i = 0; i < BUFFER_SIZE; i++)
+            {
+                for (int c = 0; c < numChannels; c++)
+                {
+                    if (readBuffer[i * numChannels + c] != samples[c * period + offset + i])
+                        errors++;
+                }
+            }
+        }
+
+        const double readSeconds = secondsSince(start);
+
+        for (int c = 0; c < numChannels && errors == 0; c++)
+        {
+            if (source.getChannelInfo(c).name != names[c] || source.getChannelInfo(c).bitVolts != BIT_VOLTS)
+                errors++;
+        }
+
+        allCorrect = allCorrect && errors == 0;
+
+        printf("noise %4.1f uV: ratio %5.2f, written at %7.1f MB/s (%5.0fx real time), read at %7.1f MB/s, %lld bad samples\n",
+               noiseLevels[n], rawMB / fileMB, rawMB / writeSeconds, numSamples / SAMPLE_RATE / writeSeconds,
+               rawMB / readSeconds, (long long) errors);
+    }
+
+    dir.deleteRecursively();
+
+    printf("%s\n", allCorrect ? "All samples read back correctly" : "Some samples did not read back");
+
+    return allCorrect ? 0 : 1;
+}
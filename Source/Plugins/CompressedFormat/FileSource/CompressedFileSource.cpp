@@ -0,0 +1,282 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedFileSource.h"
+#include "../RecordEngine/RiceCodec.h"
+
+CompressedFileSource::CompressedFileSource() : numChannels(0), sampleRate(0), blockLength(0),
+    dataStart(0), encodedSize(0), loadedBlock(-1), loadedSamples(0), samplePos(0)
+{
+}
+
+CompressedFileSource::~CompressedFileSource()
+{
+}
+
+bool CompressedFileSource::Open(File file)
+{
+    ScopedPointer<FileInputStream> tmpStream = new FileInputStream(file);
+
+    if (tmpStream->failedToOpen())
+        return false;
+
+    char magic[4];
+    if (tmpStream->read(magic, 4) != 4 || memcmp(magic, OEC_FILE_MAGIC, 4) != 0)
+        return false;
+
+    int version = tmpStream->readShort();
+    if (version != OEC_VERSION)
+    {
+        std::cerr << "Unsupported compressed file version " << version << std::endl;
+        return false;
+    }
+
+    numChannels = (uint16) tmpStream->readShort();
+    sampleRate = tmpStream->readFloat();
+    blockLength = tmpStream->readInt();
+    dataStart = (uint32) tmpStream->readInt();
+
+    if (numChannels <= 0 || blockLength <= 0)
+        return false;
+
+    channelNames.clear();
+    channelBitVolts.clear();
+    for (int c = 0; c < numChannels; c++)
+    {
+        channelBitVolts.add(tmpStream->readFloat());
+        int nameLength = (uint8) tmpStream->readByte();
+        HeapBlock<char> name(nameLength + 1, true);
+        tmpStream->read(name, nameLength);
+        channelNames.add(String::fromUTF8(name, nameLength));
+    }
+
+    if (tmpStream->isExhausted() || tmpStream->getPosition() > dataStart)
+        return false;
+
+    stream = tmpStream;
+    return true;
+}
+
+void CompressedFileSource::fillRecordInfo()
+{
+    if (! readIndex())
+    {
+        std::cout << "Compressed file has no valid block index, scanning blocks" << std::endl;
+        scanBlocks();
+    }
+
+    blockStarts.clear();
+    int64 total = 0;
+    for (int i = 0; i < blockOffsets.size(); i++)
+    {
+        blockStarts.add(total);
+        stream->setPosition(blockOffsets[i] + 4);
+        total += (uint32) stream->readInt();
+    }
+    blockStarts.add(total);
+
+    RecordInfo info;
+    info.name = "Record 0";
+    info.numSamples = total;
+    info.sampleRate = sampleRate;
+
+    for (int c = 0; c < numChannels; c++)
+    {
+        RecordedChannelInfo ch;
+        ch.name = channelNames[c];
+        ch.bitVolts = channelBitVolts[c];
+        info.channels.add(ch);
+    }
+
+    infoArray.add(info);
+    numRecords++;
+}
+
+bool CompressedFileSource::readIndex()
+{
+    int64 length = stream->getTotalLength();
+
+    if (length < dataStart + 8)
+        return false;
+
+    char magic[4];
+    stream->setPosition(length - 4);
+    if (stream->read(magic, 4) != 4 || memcmp(magic, OEC_INDEX_MAGIC, 4) != 0)
+        return false;
+
+    stream->setPosition(length - 8);
+    int64 numBlocks = (uint32) stream->readInt();
+    int64 indexStart = length - 8 - 8*numBlocks;
+
+    if (indexStart < dataStart)
+        return false;
+
+    blockOffsets.clear();
+    stream->setPosition(indexStart);
+    for (int64 i = 0; i < numBlocks; i++)
+    {
+        int64 offset = stream->readInt64();
+        if (offset < dataStart || offset + OEC_BLOCK_HEADER_SIZE > indexStart)
+            return false;
+        blockOffsets.add(offset);
+    }
+
+    return true;
+}
+
+void CompressedFileSource::scanBlocks()
+{
+    int64 length = stream->getTotalLength();
+    int64 pos = dataStart;
+
+    blockOffsets.clear();
+
+    while (pos + OEC_BLOCK_HEADER_SIZE <= length)
+    {
+        char magic[4];
+        stream->setPosition(pos);
+        if (stream->read(magic, 4) != 4 || memcmp(magic, OEC_BLOCK_MAGIC, 4) != 0)
+            break;
+
+        stream->readInt();   // numSamples
+        stream->readInt64(); // timestamp
+        int64 payloadSize = (uint32) stream->readInt();
+
+        // a block cut short by a crash is dropped
+        if (pos + OEC_BLOCK_HEADER_SIZE + payloadSize > length)
+            break;
+
+        blockOffsets.add(pos);
+        pos += OEC_BLOCK_HEADER_SIZE + payloadSize;
+    }
+}
+
+void CompressedFileSource::updateActiveRecord()
+{
+    samplePos = 0;
+    loadedBlock = -1;
+    decodedBlock.malloc(numChannels * blockLength);
+}
+
+bool CompressedFileSource::loadBlock(int block)
+{
+    if (block == loadedBlock)
+        return true;
+
+    loadedBlock = -1;
+
+    stream->setPosition(blockOffsets[block] + 4);
+    int numSamples = stream->readInt();
+    stream->readInt64(); // timestamp
+    int payloadSize = stream->readInt();
+
+    if (numSamples < 0 || numSamples > blockLength || payloadSize < 4*numChannels)
+        return false;
+
+    if (encodedSize < payloadSize)
+    {
+        encodedBlock.malloc(payloadSize);
+        encodedSize = payloadSize;
+    }
+
+    if (stream->read(encodedBlock, payloadSize) != payloadSize)
+        return false;
+
+    int pos = 4*numChannels;
+    for (int c = 0; c < numChannels; c++)
+    {
+        int size = (int) ByteOrder::littleEndianInt(encodedBlock + 4*c);
+        if (size < 0 || pos + size > payloadSize)
+            return false;
+
+        if (! RiceCodec::decode(encodedBlock + pos, size, decodedBlock + c*blockLength, numSamples))
+        {
+            std::cerr << "Corrupt compressed block " << block << ", channel " << c << std::endl;
+            return false;
+        }
+        pos += size;
+    }
+
+    loadedBlock = block;
+    loadedSamples = numSamples;
+    return true;
+}
+
+int CompressedFileSource::findBlock(int64 sample)
+{
+    if (loadedBlock >= 0 && sample >= blockStarts[loadedBlock] && sample < blockStarts[loadedBlock + 1])
+        return loadedBlock;
+
+    // last block start that is not past the sample
+    const int64* first = blockStarts.begin();
+    const int64* last = blockStarts.end() - 1;
+    return int(std::upper_bound(first, last, sample) - first) - 1;
+}
+
+void CompressedFileSource::seekTo(int64 sample)
+{
+    samplePos = sample % getActiveNumSamples();
+}
+
+int CompressedFileSource::readData(int16* buffer, int nSamples)
+{
+    int64 samplesToRead = jmin((int64) nSamples, getActiveNumSamples() - samplePos);
+    int samplesRead = 0;
+
+    while (samplesRead < samplesToRead)
+    {
+        int block = findBlock(samplePos);
+        if (block < 0 || ! loadBlock(block))
+            break;
+
+        int offset = int(samplePos - blockStarts[block]);
+        int count = jmin(int(samplesToRead - samplesRead), loadedSamples - offset);
+        if (count <= 0)
+            break;
+
+        // blocks are stored channel-major; the reader expects interleaved samples
+        int16* dest = buffer + samplesRead*numChannels;
+        for (int c = 0; c < numChannels; c++)
+        {
+            const int16* src = decodedBlock + c*blockLength + offset;
+            for (int i = 0; i < count; i++)
+                dest[i*numChannels + c] = src[i];
+        }
+
+        samplesRead += count;
+        samplePos += count;
+    }
+
+    return samplesRead;
+}
+
+void CompressedFileSource::processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples)
+{
+    int n = getActiveNumChannels();
+    float bitVolts = getChannelInfo(channel).bitVolts;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        *(outBuffer+i) = *(inBuffer+(n*i)+channel) * bitVolts;
+    }
+}
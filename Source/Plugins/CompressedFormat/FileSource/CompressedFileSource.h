@@ -0,0 +1,85 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDFILESOURCE_H_INCLUDED
+#define COMPRESSEDFILESOURCE_H_INCLUDED
+
+#include <FileSourceHeaders.h>
+
+/**
+
+  Reads the .oec files written by CompressedRecording.
+
+  Blocks are located through the index stored at the end of the file, or by
+  scanning the block headers if the recording was not closed cleanly. One
+  block is decoded at a time and kept until the read position leaves it.
+
+  @see CompressedRecording, RiceCodec
+
+*/
+
+class CompressedFileSource : public FileSource
+{
+public:
+    CompressedFileSource();
+    ~CompressedFileSource();
+
+    int readData(int16* buffer, int nSamples);
+
+    void seekTo(int64 sample);
+
+    void processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples);
+
+private:
+    bool Open(File file);
+    void fillRecordInfo();
+    void updateActiveRecord();
+
+    bool readIndex();
+    void scanBlocks();
+    bool loadBlock(int block);
+    int findBlock(int64 sample);
+
+    ScopedPointer<FileInputStream> stream;
+
+    int numChannels;
+    float sampleRate;
+    int blockLength;
+    int64 dataStart;
+    StringArray channelNames;
+    Array<float> channelBitVolts;
+
+    Array<int64> blockOffsets;
+    /** First sample of every block, plus the total number of samples at the end */
+    Array<int64> blockStarts;
+
+    HeapBlock<int16> decodedBlock;
+    HeapBlock<uint8> encodedBlock;
+    int encodedSize;
+    int loadedBlock;
+    int loadedSamples;
+
+    int64 samplePos;
+};
+
+#endif  // COMPRESSEDFILESOURCE_H_INCLUDED
@@ -0,0 +1,241 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "CompressedFileWriter.h"
+
+// number of blocks per file that can be in flight between the audio thread and the disk
+#define JOBS_PER_FILE 8
+
+BlockEncoderJob::BlockEncoderJob(CompressedFileWriter* o, int nChans, int length)
+    : ThreadPoolJob("Block encoder"), encodedSize(0), numChannels(nChans),
+      blockLength(length), numSamples(0), timestamp(0), owner(o)
+{
+    samples.malloc(numChannels * blockLength);
+    encoded.malloc(numChannels * RiceCodec::getMaxEncodedSize(blockLength));
+    channelSizes.malloc(numChannels);
+    state.set(FREE);
+}
+
+ThreadPoolJob::JobStatus BlockEncoderJob::runJob()
+{
+    int pos = 0;
+    for (int c = 0; c < numChannels; c++)
+    {
+        int size = RiceCodec::encode(samples + c*blockLength, numSamples, encoded + pos);
+        channelSizes[c] = size;
+        pos += size;
+    }
+    encodedSize = pos;
+
+    state.set(ENCODED);
+    owner->blockEncoded();
+
+    return jobHasFinished;
+}
+
+CompressedFileWriter::CompressedFileWriter(ThreadPool* pool, Thread* writer, int length)
+    : encoderPool(pool), writerThread(writer), fillIndex(0), writeIndex(0),
+      scaledSize(0), blockLength(length)
+{
+}
+
+CompressedFileWriter::~CompressedFileWriter()
+{
+    close();
+}
+
+bool CompressedFileWriter::open(const File& file, float sampleRate, const StringArray& channelNames, const Array<float>& bitVolts)
+{
+    File f(file);
+    f.deleteFile();
+    stream = new FileOutputStream(f, 1 << 20);
+
+    if (stream->failedToOpen())
+    {
+        stream = nullptr;
+        return false;
+    }
+
+    int numChannels = channelNames.size();
+
+    int headerSize = 20;
+    for (int c = 0; c < numChannels; c++)
+        headerSize += 5 + jmin(255, (int) channelNames[c].getNumBytesAsUTF8());
+
+    stream->write(OEC_FILE_MAGIC, 4);
+    stream->writeShort(OEC_VERSION);
+    stream->writeShort((short) numChannels);
+    stream->writeFloat(sampleRate);
+    stream->writeInt(blockLength);
+    stream->writeInt(headerSize);
+    for (int c = 0; c < numChannels; c++)
+    {
+        int nameLength = jmin(255, (int) channelNames[c].getNumBytesAsUTF8());
+        stream->writeFloat(bitVolts[c]);
+        stream->writeByte((char) nameLength);
+        stream->write(channelNames[c].toUTF8(), nameLength);
+    }
+
+    scaleFactors.clear();
+    for (int c = 0; c < numChannels; c++)
+        scaleFactors.add(1.0f / (float(0x7fff) * bitVolts[c]));
+
+    blockOffsets.clear();
+    jobs.clear();
+    for (int j = 0; j < JOBS_PER_FILE; j++)
+        jobs.add(new BlockEncoderJob(this, numChannels, blockLength));
+    fillIndex = 0;
+    writeIndex = 0;
+
+    return true;
+}
+
+void CompressedFileWriter::close()
+{
+    if (stream == nullptr)
+        return;
+
+    // block index, so readers can seek without scanning the whole file
+    for (int i = 0; i < blockOffsets.size(); i++)
+        stream->writeInt64(blockOffsets[i]);
+    stream->writeInt(blockOffsets.size());
+    stream->write(OEC_INDEX_MAGIC, 4);
+
+    stream = nullptr;
+    jobs.clear();
+}
+
+void CompressedFileWriter::flush()
+{
+    if (stream == nullptr)
+        return;
+
+    BlockEncoderJob* job = jobs[fillIndex];
+    if (job->state.get() == BlockEncoderJob::FILLING)
+    {
+        if (job->numSamples > 0)
+            queueJob();
+        else
+            job->state.set(BlockEncoderJob::FREE);
+    }
+
+    // wait for the encoders and the writer to catch up
+    for (int j = 0; j < jobs.size(); j++)
+    {
+        while (writerThread->isThreadRunning() && jobs[j]->state.get() != BlockEncoderJob::FREE)
+            jobFreed.wait(20);
+    }
+}
+
+void CompressedFileWriter::queueJob()
+{
+    BlockEncoderJob* job = jobs[fillIndex];
+    job->state.set(BlockEncoderJob::QUEUED);
+    encoderPool->addJob(job, false);
+    fillIndex = (fillIndex + 1) % jobs.size();
+}
+
+void CompressedFileWriter::blockEncoded()
+{
+    writerThread->notify();
+}
+
+bool CompressedFileWriter::writeEncodedBlocks()
+{
+    bool wroteAny = false;
+
+    if (stream == nullptr)
+        return false;
+
+    while (jobs[writeIndex]->state.get() == BlockEncoderJob::ENCODED)
+    {
+        BlockEncoderJob* job = jobs[writeIndex];
+
+        blockOffsets.add(stream->getPosition());
+        stream->write(OEC_BLOCK_MAGIC, 4);
+        stream->writeInt(job->numSamples);
+        stream->writeInt64(job->timestamp);
+        stream->writeInt(job->numChannels * 4 + job->encodedSize);
+        for (int c = 0; c < job->numChannels; c++)
+            stream->writeInt(job->channelSizes[c]);
+        stream->write(job->encoded, job->encodedSize);
+
+        job->state.set(BlockEncoderJob::FREE);
+        writeIndex = (writeIndex + 1) % jobs.size();
+        jobFreed.signal();
+        wroteAny = true;
+    }
+
+    return wroteAny;
+}
+
+void CompressedFileWriter::write(const float* const* channelData, int numSamples, int64 timestamp)
+{
+    if (stream == nullptr)
+        return;
+
+    int numChannels = scaleFactors.size();
+
+    if (scaledSize < numSamples)
+    {
+        scaledBuffer.malloc(numSamples);
+        scaledSize = numSamples;
+    }
+
+    int samplesWritten = 0;
+
+    while (samplesWritten < numSamples)
+    {
+        BlockEncoderJob* job = jobs[fillIndex];
+
+        // only blocks if the encoders have fallen a whole ring of blocks behind
+        while (job->state.get() != BlockEncoderJob::FREE && job->state.get() != BlockEncoderJob::FILLING)
+            jobFreed.wait(10);
+
+        if (job->state.get() == BlockEncoderJob::FREE)
+        {
+            job->numSamples = 0;
+            job->timestamp = timestamp + samplesWritten;
+            job->state.set(BlockEncoderJob::FILLING);
+        }
+
+        int numToCopy = jmin(numSamples - samplesWritten, blockLength - job->numSamples);
+
+        for (int c = 0; c < numChannels; c++)
+        {
+            FloatVectorOperations::copyWithMultiply(scaledBuffer,
+                                                    channelData[c] + samplesWritten,
+                                                    scaleFactors[c],
+                                                    numToCopy);
+            AudioDataConverters::convertFloatToInt16LE(scaledBuffer,
+                                                       job->samples + c*blockLength + job->numSamples,
+                                                       numToCopy);
+        }
+
+        job->numSamples += numToCopy;
+        samplesWritten += numToCopy;
+
+        if (job->numSamples == blockLength)
+            queueJob();
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef COMPRESSEDFILEWRITER_H_INCLUDED
+#define COMPRESSEDFILEWRITER_H_INCLUDED
+
+#include "RiceCodec.h"
+
+class CompressedFileWriter;
+
+/**
+
+  Encodes one block of every channel of a .oec file on the encoder pool.
+
+  The audio thread fills the raw samples, queues the job and moves on to
+  the next one; the writer thread stores encoded blocks in the order in
+  which they were queued.
+
+*/
+
+class BlockEncoderJob : public ThreadPoolJob
+{
+public:
+    enum State {FREE, FILLING, QUEUED, ENCODED};
+
+    BlockEncoderJob(CompressedFileWriter* owner, int numChannels, int blockLength);
+
+    JobStatus runJob();
+
+    HeapBlock<int16> samples;
+    HeapBlock<uint8> encoded;
+    HeapBlock<uint32> channelSizes;
+    int encodedSize;
+
+    int numChannels;
+    int blockLength;
+    int numSamples;
+    int64 timestamp;
+
+    Atomic<int> state;
+
+private:
+    CompressedFileWriter* owner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockEncoderJob);
+};
+
+/**
+
+  Writes one compressed continuous file (.oec).
+
+  write() converts the samples into blocks and queues full blocks on a
+  shared encoder pool; it is cheap enough for the audio thread. A writer
+  thread, notified every time a block is encoded, calls
+  writeEncodedBlocks() to store them. Keeping this apart from the record
+  engine lets the format be exercised on its own.
+
+  @see CompressedRecording, CompressedFileSource
+
+*/
+
+class CompressedFileWriter
+{
+public:
+    CompressedFileWriter(ThreadPool* encoderPool, Thread* writerThread, int blockLength);
+    ~CompressedFileWriter();
+
+    /** Creates the file and writes its header. Returns false if it can't be created */
+    bool open(const File& file, float sampleRate, const StringArray& channelNames, const Array<float>& bitVolts);
+
+    /** Adds numSamples samples of every channel, the first of them at timestamp */
+    void write(const float* const* channelData, int numSamples, int64 timestamp);
+
+    /** Queues the last, partially filled block and waits until every block has been written
+        or the writer thread stops */
+    void flush();
+
+    /** Writer thread: stores the blocks that are encoded, in order. Returns true if it wrote any */
+    bool writeEncodedBlocks();
+
+    /** Appends the block index and closes the file. No job may be left on the encoder pool */
+    void close();
+
+    /** Called by the encoder jobs when a block is ready */
+    void blockEncoded();
+
+private:
+    void queueJob();
+
+    ThreadPool* encoderPool;
+    Thread* writerThread;
+    WaitableEvent jobFreed;
+
+    ScopedPointer<FileOutputStream> stream;
+    Array<int64> blockOffsets;
+
+    /** Ring of reusable jobs, filled and written in order */
+    OwnedArray<BlockEncoderJob> jobs;
+    int fillIndex;
+    int writeIndex;
+
+    Array<float> scaleFactors;
+    HeapBlock<float> scaledBuffer;
+    int scaledSize;
+
+    int blockLength;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedFileWriter);
+};
+
+#endif  // COMPRESSEDFILEWRITER_H_INCLUDED
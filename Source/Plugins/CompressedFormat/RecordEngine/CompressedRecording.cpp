@@ -0,0 +1,218 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "CompressedRecording.h"
+
+CompressedRecording::CompressedRecording() : Thread("Compressed Recording Writer"),
+    recordingNumber(0),
+    experimentNumber(0), numEncoderThreads(4), blockLength(1024)
+{
+}
+
+CompressedRecording::~CompressedRecording()
+{
+    closeFiles();
+}
+
+String CompressedRecording::getEngineID()
+{
+    return "COMPRESSED";
+}
+
+void CompressedRecording::registerProcessor(GenericProcessor* processor)
+{
+    CompressedFile* file = new CompressedFile();
+    file->nodeId = processor->getNodeId();
+    file->sampleRate = processor->getSampleRate();
+    files.add(file);
+}
+
+void CompressedRecording::addChannel(int index, Channel* chan)
+{
+    processorMap.add(files.size() - 1);
+}
+
+void CompressedRecording::addSpikeElectrode(int index, SpikeRecordInfo* elec)
+{
+    eventSpikeFiles.addSpikeElectrode();
+}
+
+void CompressedRecording::resetChannels()
+{
+    files.clear();
+    processorMap.clear();
+    eventSpikeFiles.resetSpikeElectrodes();
+}
+
+void CompressedRecording::openFiles(File rootFolder, int experimentNumber, int recordingNumber)
+{
+    this->recordingNumber = recordingNumber;
+    this->experimentNumber = experimentNumber;
+
+    String suffix = "_experiment" + String(experimentNumber) + "_recording" + String(recordingNumber);
+    String basePath = rootFolder.getFullPathName() + rootFolder.separatorString;
+
+    for (int i = 0; i < files.size(); i++)
+        files[i]->channels.clear();
+
+    for (int i = 0; i < processorMap.size(); i++)
+    {
+        if (getChannel(i)->getRecordState())
+            files[processorMap[i]]->channels.add(i);
+    }
+
+    encoderPool = new ThreadPool(numEncoderThreads);
+
+    for (int i = 0; i < files.size(); i++)
+    {
+        if (files[i]->channels.size() > 0)
+            openCompressedFile(basePath + String(files[i]->nodeId) + suffix + ".oec", files[i]);
+    }
+
+    eventSpikeFiles.openFiles(basePath, suffix, recordingNumber);
+
+    for (int i = 0; i < eventSpikeFiles.getNumSpikeElectrodes(); i++)
+    {
+        SpikeRecordInfo* elec = getSpikeElectrode(i);
+        String path = basePath + elec->name.removeCharacters(" ") + suffix + ".spikes";
+        eventSpikeFiles.openSpikeFile(elec->recordIndex, path);
+    }
+
+    startThread();
+}
+
+void CompressedRecording::openCompressedFile(const String& fileName, CompressedFile* file)
+{
+    std::cout << "OPENING FILE: " << fileName << std::endl;
+
+    StringArray channelNames;
+    Array<float> bitVolts;
+    for (int c = 0; c < file->channels.size(); c++)
+    {
+        Channel* ch = getChannel(file->channels[c]);
+        channelNames.add(ch->name);
+        bitVolts.add(ch->bitVolts);
+    }
+
+    file->writer = new CompressedFileWriter(encoderPool, this, blockLength);
+
+    if (! file->writer->open(File(fileName), file->sampleRate, channelNames, bitVolts))
+    {
+        std::cout << "Could not open " << fileName << std::endl;
+        file->writer = nullptr;
+        return;
+    }
+
+    file->channelData.malloc(file->channels.size());
+}
+
+void CompressedRecording::closeFiles()
+{
+    // queue the last, partially filled blocks and wait for them to be written
+    for (int i = 0; i < files.size(); i++)
+    {
+        if (files[i]->writer != nullptr)
+            files[i]->writer->flush();
+    }
+
+    signalThreadShouldExit();
+    notify();
+    stopThread(-1);
+
+    if (encoderPool != nullptr)
+        encoderPool->removeAllJobs(true, 5000);
+
+    for (int i = 0; i < files.size(); i++)
+        files[i]->writer = nullptr;
+
+    encoderPool = nullptr;
+
+    eventSpikeFiles.closeFiles();
+}
+
+void CompressedRecording::run()
+{
+    while (! threadShouldExit())
+    {
+        for (int i = 0; i < files.size(); i++)
+        {
+            if (files[i]->writer != nullptr)
+                files[i]->writer->writeEncodedBlocks();
+        }
+
+        wait(50);
+    }
+}
+
+void CompressedRecording::writeData(AudioSampleBuffer& buffer)
+{
+    for (int i = 0; i < files.size(); i++)
+    {
+        CompressedFile* file = files[i];
+
+        if (file->writer == nullptr)
+            continue;
+
+        int sourceNodeId = getChannel(file->channels[0])->sourceNodeId;
+
+        for (int c = 0; c < file->channels.size(); c++)
+            file->channelData[c] = buffer.getReadPointer(file->channels[c]);
+
+        file->writer->write(file->channelData, (*numSamples)[sourceNodeId], (*timestamps)[sourceNodeId]);
+    }
+}
+
+void CompressedRecording::writeEvent(int eventType, MidiMessage& event, int samplePosition)
+{
+    uint8 sourceNodeId = event.getNoteNumber();
+    int64 eventTimestamp = (*timestamps)[sourceNodeId] + samplePosition;
+
+    eventSpikeFiles.writeEvent(eventType, event, eventTimestamp, samplePosition);
+}
+
+void CompressedRecording::writeSpike(const SpikeObject& spike, int electrodeIndex)
+{
+    eventSpikeFiles.writeSpike(spike, electrodeIndex);
+}
+
+void CompressedRecording::writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex)
+{
+    eventSpikeFiles.writeSpikeRecord(spike, electrodeIndex);
+}
+
+void CompressedRecording::setParameter(EngineParameter& parameter)
+{
+    intParameter(0, numEncoderThreads);
+    intParameter(1, blockLength);
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager("COMPRESSED", "Compressed", &(engineFactory<CompressedRecording>));
+    EngineParameter* param;
+    param = new EngineParameter(EngineParameter::INT, 0, "Encoder threads", 4, 1, 32);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 1, "Block length (samples)", 1024, 128, 16384);
+    man->addParameter(param);
+    return man;
+}
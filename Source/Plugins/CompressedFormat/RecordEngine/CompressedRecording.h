@@ -0,0 +1,104 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef COMPRESSEDRECORDING_H_INCLUDED
+#define COMPRESSEDRECORDING_H_INCLUDED
+
+#include <RecordingLib.h>
+#include "CompressedFileWriter.h"
+
+/**
+
+  Lossless compressed continuous recording.
+
+  Every recorded processor gets a .oec file holding blocks of all its
+  channels, compressed with RiceCodec by a CompressedFileWriter.
+  Compression runs on a pool of encoder threads and blocks are written to
+  disk by this engine's writer thread, so the audio thread only converts
+  and copies samples. A block index appended on close lets
+  CompressedFileSource seek directly to any block.
+
+  Events and spikes are stored uncompressed using the Open Ephys record
+  layouts, by the same EventSpikeFiles as BinaryRecording.
+
+  @see RiceCodec, CompressedFileWriter, CompressedFileSource, EventSpikeFiles
+
+*/
+
+class CompressedRecording : public RecordEngine,
+    public Thread
+{
+public:
+    CompressedRecording();
+    ~CompressedRecording();
+
+    void setParameter(EngineParameter& parameter);
+    String getEngineID();
+    void openFiles(File rootFolder, int experimentNumber, int recordingNumber);
+    void closeFiles();
+    void writeData(AudioSampleBuffer& buffer);
+    void writeEvent(int eventType, MidiMessage& event, int samplePosition);
+    void registerProcessor(GenericProcessor* processor);
+    void addChannel(int index, Channel* chan);
+    void resetChannels();
+    void addSpikeElectrode(int index, SpikeRecordInfo* elec);
+    void writeSpike(const SpikeObject& spike, int electrodeIndex);
+    void writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex);
+
+    /** Writer thread: stores encoded blocks in order */
+    void run();
+
+    static RecordEngineManager* getEngineManager();
+
+private:
+
+    struct CompressedFile
+    {
+        int nodeId;
+        float sampleRate;
+
+        Array<int> channels;
+        HeapBlock<const float*> channelData;
+
+        ScopedPointer<CompressedFileWriter> writer;
+    };
+
+    void openCompressedFile(const String& fileName, CompressedFile* file);
+
+    OwnedArray<CompressedFile> files;
+    Array<int> processorMap;
+
+    ScopedPointer<ThreadPool> encoderPool;
+
+    EventSpikeFiles eventSpikeFiles;
+
+    int recordingNumber;
+    int experimentNumber;
+
+    int numEncoderThreads;
+    int blockLength;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedRecording);
+};
+
+#endif  // COMPRESSEDRECORDING_H_INCLUDED
@@ -0,0 +1,296 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RiceCodec.h"
+
+#define MAX_ORDER 3
+#define VERBATIM 0xFF
+#define MAX_RICE_PARAMETER 30
+
+// quotients of this size or larger are escaped and stored as a raw 32-bit value
+#define ESCAPE_QUOTIENT 24
+
+namespace
+{
+inline int32 residual(const int16* x, int i, int order)
+{
+    switch (order)
+    {
+        case 0:
+            return x[i];
+        case 1:
+            return int32(x[i]) - x[i-1];
+        case 2:
+            return int32(x[i]) - 2*int32(x[i-1]) + x[i-2];
+        default:
+            return int32(x[i]) - 3*int32(x[i-1]) + 3*int32(x[i-2]) - x[i-3];
+    }
+}
+
+inline int32 prediction(const int16* x, int i, int order)
+{
+    switch (order)
+    {
+        case 0:
+            return 0;
+        case 1:
+            return x[i-1];
+        case 2:
+            return 2*int32(x[i-1]) - x[i-2];
+        default:
+            return 3*int32(x[i-1]) - 3*int32(x[i-2]) + x[i-3];
+    }
+}
+
+inline uint32 zigzag(int32 e)
+{
+    return (uint32(e) << 1) ^ uint32(e >> 31);
+}
+
+inline int32 unzigzag(uint32 u)
+{
+    return int32(u >> 1) ^ -int32(u & 1);
+}
+
+class BitWriter
+{
+public:
+    BitWriter(uint8* d) : dest(d), acc(0), count(0), pos(0) {}
+
+    inline void put(uint32 value, int numBits)
+    {
+        acc = (acc << numBits) | value;
+        count += numBits;
+        while (count >= 8)
+        {
+            count -= 8;
+            dest[pos++] = uint8(acc >> count);
+        }
+    }
+
+    int finish()
+    {
+        if (count > 0)
+            dest[pos++] = uint8(acc << (8 - count));
+        count = 0;
+        return pos;
+    }
+
+private:
+    uint8* dest;
+    uint64 acc;
+    int count;
+    int pos;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8* s, int n) : source(s), size(n), pos(0), acc(0), count(0), failed(false) {}
+
+    inline uint32 get(int numBits)
+    {
+        if (numBits == 0)
+            return 0;
+
+        while (count < numBits)
+        {
+            if (pos >= size)
+            {
+                failed = true;
+                return 0;
+            }
+            acc = (acc << 8) | source[pos++];
+            count += 8;
+        }
+        count -= numBits;
+        return uint32((acc >> count) & ((uint64(1) << numBits) - 1));
+    }
+
+    bool hasFailed() const { return failed; }
+
+private:
+    const uint8* source;
+    int size;
+    int pos;
+    uint64 acc;
+    int count;
+    bool failed;
+};
+
+inline void writeInt16LE(uint8* d, int16 v)
+{
+    d[0] = uint8(v & 0xFF);
+    d[1] = uint8((uint16(v) >> 8) & 0xFF);
+}
+
+inline int16 readInt16LE(const uint8* s)
+{
+    return int16(uint16(s[0]) | (uint16(s[1]) << 8));
+}
+
+int encodeVerbatim(const int16* samples, int numSamples, uint8* dest)
+{
+    dest[0] = VERBATIM;
+    dest[1] = 0;
+    for (int i = 0; i < numSamples; i++)
+        writeInt16LE(dest + 2 + 2*i, samples[i]);
+    return 2 + 2*numSamples;
+}
+}
+
+int RiceCodec::getMaxEncodedSize(int numSamples)
+{
+    // anything bigger than the verbatim representation is stored verbatim
+    return 2 + 2*numSamples;
+}
+
+int RiceCodec::encode(const int16* samples, int numSamples, uint8* dest)
+{
+    if (numSamples <= MAX_ORDER)
+        return encodeVerbatim(samples, numSamples, dest);
+
+    // pick the fixed predictor with the smallest absolute residual sum
+    uint64 sums[MAX_ORDER + 1] = {0, 0, 0, 0};
+    for (int i = MAX_ORDER; i < numSamples; i++)
+    {
+        int32 x0 = samples[i], x1 = samples[i-1], x2 = samples[i-2], x3 = samples[i-3];
+        int32 e0 = x0;
+        int32 e1 = x0 - x1;
+        int32 e2 = e1 - (x1 - x2);
+        int32 e3 = e2 - ((x1 - x2) - (x2 - x3));
+        sums[0] += std::abs(e0);
+        sums[1] += std::abs(e1);
+        sums[2] += std::abs(e2);
+        sums[3] += std::abs(e3);
+    }
+
+    int order = 0;
+    for (int p = 1; p <= MAX_ORDER; p++)
+    {
+        if (sums[p] < sums[order])
+            order = p;
+    }
+
+    // Rice parameter from the mean of the zigzagged residuals
+    uint64 sumU = 0;
+    int count = numSamples - order;
+    for (int i = order; i < numSamples; i++)
+        sumU += zigzag(residual(samples, i, order));
+
+    int k = 0;
+    while (k < MAX_RICE_PARAMETER && (uint64(count) << (k + 1)) <= sumU)
+        k++;
+
+    // exact size of the bitstream, to fall back to verbatim when it doesn't pay off
+    uint64 totalBits = 0;
+    for (int i = order; i < numSamples; i++)
+    {
+        uint32 q = zigzag(residual(samples, i, order)) >> k;
+        totalBits += (q < ESCAPE_QUOTIENT) ? (q + 1 + k) : (ESCAPE_QUOTIENT + 32);
+    }
+
+    uint64 totalBytes = 2 + 2*order + (totalBits + 7) / 8;
+    if (totalBytes >= uint64(getMaxEncodedSize(numSamples)))
+        return encodeVerbatim(samples, numSamples, dest);
+
+    dest[0] = uint8(order);
+    dest[1] = uint8(k);
+    for (int i = 0; i < order; i++)
+        writeInt16LE(dest + 2 + 2*i, samples[i]);
+
+    BitWriter writer(dest + 2 + 2*order);
+    uint32 lowMask = (k > 0) ? ((uint32(1) << k) - 1) : 0;
+
+    for (int i = order; i < numSamples; i++)
+    {
+        uint32 u = zigzag(residual(samples, i, order));
+        uint32 q = u >> k;
+        if (q < ESCAPE_QUOTIENT)
+        {
+            // q ones terminated by a zero, followed by the k low bits
+            writer.put(((uint32(1) << q) - 1) << 1, q + 1);
+            if (k > 0)
+                writer.put(u & lowMask, k);
+        }
+        else
+        {
+            writer.put((uint32(1) << ESCAPE_QUOTIENT) - 1, ESCAPE_QUOTIENT);
+            writer.put(u >> 16, 16);
+            writer.put(u & 0xFFFF, 16);
+        }
+    }
+
+    return 2 + 2*order + writer.finish();
+}
+
+bool RiceCodec::decode(const uint8* source, int numBytes, int16* samples, int numSamples)
+{
+    if (numBytes < 2)
+        return false;
+
+    int order = source[0];
+    int k = source[1];
+
+    if (order == VERBATIM)
+    {
+        if (numBytes < 2 + 2*numSamples)
+            return false;
+        for (int i = 0; i < numSamples; i++)
+            samples[i] = readInt16LE(source + 2 + 2*i);
+        return true;
+    }
+
+    if (order > MAX_ORDER || k > MAX_RICE_PARAMETER || numBytes < 2 + 2*order || numSamples < order)
+        return false;
+
+    for (int i = 0; i < order; i++)
+        samples[i] = readInt16LE(source + 2 + 2*i);
+
+    BitReader reader(source + 2 + 2*order, numBytes - 2 - 2*order);
+
+    for (int i = order; i < numSamples; i++)
+    {
+        uint32 q = 0;
+        while (q < ESCAPE_QUOTIENT && reader.get(1))
+            q++;
+
+        uint32 u;
+        if (q < ESCAPE_QUOTIENT)
+        {
+            u = (q << k) | reader.get(k);
+        }
+        else
+        {
+            u = reader.get(16) << 16;
+            u |= reader.get(16);
+        }
+
+        if (reader.hasFailed())
+            return false;
+
+        samples[i] = int16(unzigzag(u) + prediction(samples, i, order));
+    }
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef RICECODEC_H_INCLUDED
+#define RICECODEC_H_INCLUDED
+
+#include "../../../../JuceLibraryCode/JuceHeader.h"
+
+/** Magic numbers and layout of the compressed continuous file (.oec)
+
+    File header (little-endian):
+        char[4]  "OECF"
+        uint16   version
+        uint16   numChannels
+        float32  sampleRate
+        uint32   blockLength (samples per channel in a full block)
+        uint32   header size in bytes
+        per channel: float32 bitVolts, uint8 name length, name bytes
+
+    Each block:
+        char[4]  "OEBK"
+        uint32   numSamples
+        int64    timestamp of the first sample
+        uint32   payload size in bytes
+        uint32   encoded size of every channel (numChannels entries)
+        channel streams, one after the other
+
+    Trailer, written when the file is closed:
+        int64    file offset of every block
+        uint32   number of blocks
+        char[4]  "OEIX"
+*/
+#define OEC_VERSION 1
+#define OEC_FILE_MAGIC "OECF"
+#define OEC_BLOCK_MAGIC "OEBK"
+#define OEC_INDEX_MAGIC "OEIX"
+#define OEC_BLOCK_HEADER_SIZE 20
+
+/**
+
+  Lossless codec for one block of one int16 channel.
+
+  Each sample is predicted with the best of the FLAC fixed polynomial
+  predictors (order 0 to 3) and the residuals are Rice coded with a single
+  parameter per block. Blocks that would not shrink are stored verbatim.
+
+  Stream layout: uint8 predictor order (0xFF = verbatim), uint8 Rice
+  parameter, the warm-up samples as int16, then the residual bitstream.
+
+*/
+
+class RiceCodec
+{
+public:
+    /** Upper bound of the encoded size of a block of numSamples samples */
+    static int getMaxEncodedSize(int numSamples);
+
+    /** Encodes numSamples samples into dest, which must hold at least
+        getMaxEncodedSize(numSamples) bytes. Returns the number of bytes used.
+    */
+    static int encode(const int16* samples, int numSamples, uint8* dest);
+
+    /** Decodes a stream produced by encode. Returns false if the stream is
+        malformed or shorter than expected.
+    */
+    static bool decode(const uint8* source, int numBytes, int16* samples, int numSamples);
+
+private:
+    RiceCodec();
+};
+
+#endif  // RICECODEC_H_INCLUDED
@@ -0,0 +1,285 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include <stdio.h>
+#include "Decimator.h"
+
+// the filter spans this many output samples on either side of its centre
+#define HALF_WIDTH 6
+
+// 60 dB stopband attenuation
+#define KAISER_BETA 5.65
+
+namespace
+{
+/** Zeroth-order modified Bessel function of the first kind, for the Kaiser window */
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+
+        if (term < sum * 1e-12)
+            break;
+    }
+
+    return sum;
+}
+}
+
+Decimator::Decimator()
+    : GenericProcessor("Decimator"), factor(30), inputSourceId(0), mixedSources(false),
+      numTaps(0), historyIndex(0), eventDataSize(0)
+
+{
+
+    parameters.add(Parameter("Factor", 2.0, 100.0, float(factor), 0));
+
+}
+
+Decimator::~Decimator()
+{
+
+}
+
+int Decimator::getDecimationFactor() const
+{
+    return factor;
+}
+
+void Decimator::setParameter(int parameterIndex, float newValue)
+{
+    editor->updateParameterButtons(parameterIndex);
+
+    if (parameterIndex == 0)
+    {
+        int newFactor = jlimit(2, 100, roundToInt(newValue));
+
+        if (newFactor == factor)
+            return;
+
+        if (CoreServices::getAcquisitionStatus())
+        {
+            CoreServices::sendStatusMessage("The decimation factor can't change during acquisition.");
+            return;
+        }
+
+        Parameter& p =  parameters.getReference(parameterIndex);
+        p.setValue(float(newFactor), 0);
+
+        factor = newFactor;
+
+        // the channels further down need to learn about the new rate
+        CoreServices::updateSignalChain(getEditor());
+    }
+}
+
+void Decimator::updateSettings()
+{
+    mixedSources = false;
+
+    if (channels.size() > 0)
+        inputSourceId = channels[0]->sourceNodeId;
+
+    // the output channels come from this processor now
+    for (int i = 0; i < channels.size(); i++)
+    {
+        if (channels[i]->sourceNodeId != inputSourceId)
+            mixedSources = true;
+
+        channels[i]->sampleRate /= float(factor);
+        channels[i]->sourceNodeId = nodeId;
+    }
+
+    for (int i = 0; i < eventChannels.size(); i++)
+    {
+        if (eventChannels[i]->sourceNodeId == inputSourceId)
+        {
+            eventChannels[i]->sampleRate /= float(factor);
+            eventChannels[i]->sourceNodeId = nodeId;
+        }
+    }
+
+    settings.sampleRate /= float(factor);
+
+    prepareFilter();
+}
+
+bool Decimator::isReady()
+{
+    if (mixedSources)
+    {
+        CoreServices::sendStatusMessage("Decimator inputs must all come from the same source.");
+        return false;
+    }
+
+    return true;
+}
+
+bool Decimator::enable()
+{
+    prepareFilter();
+
+    std::cout << "Decimator: " << settings.sampleRate * factor << " Hz to " << settings.sampleRate
+              << " Hz, " << numTaps << " taps, delay of " << HALF_WIDTH << " output samples" << std::endl;
+
+    return true;
+}
+
+void Decimator::prepareFilter()
+{
+    const int length = 2 * HALF_WIDTH * factor + 1;
+
+    numTaps = (length + 7) & ~7;
+    taps.calloc(numTaps);
+
+    // windowed sinc with its cutoff at half the output rate; symmetric,
+    // so the taps don't need to be reversed
+    const double cutoff = 0.5 / double(factor);
+    const double centre = 0.5 * (length - 1);
+    const double norm = besselI0(KAISER_BETA);
+    const int offset = numTaps - length;
+    double sum = 0.0;
+
+    for (int i = 0; i < length; i++)
+    {
+        double m = i - centre;
+        double sinc = (m == 0.0) ? 2.0 * cutoff : std::sin(2.0 * double_Pi * cutoff * m) / (double_Pi * m);
+        double r = m / centre;
+        double w = besselI0(KAISER_BETA * std::sqrt(jmax(0.0, 1.0 - r * r))) / norm;
+
+        taps[offset + i] = float(sinc * w);
+        sum += sinc * w;
+    }
+
+    // unity gain at DC
+    FloatVectorOperations::multiply(taps, float(1.0 / sum), numTaps);
+
+    history.calloc(size_t(jmax(1, channels.size())) * 2 * numTaps);
+    historyIndex = 0;
+}
+
+void Decimator::process(AudioSampleBuffer& buffer, MidiBuffer& events)
+{
+    const int numChannels = jmin(channels.size(), buffer.getNumChannels());
+
+    if (numChannels == 0 || numTaps == 0)
+        return;
+
+    const int nSamples = numSamples[inputSourceId];
+    const int64 inputTimestamp = timestamps[inputSourceId];
+
+    // keep the input samples whose timestamps are multiples of the factor, so
+    // that the output timestamps are the input timestamps divided by it
+    const int first = int(((-inputTimestamp) % factor + factor) % factor);
+    const int nOut = (nSamples > first) ? (nSamples - first - 1) / factor + 1 : 0;
+    const int L = numTaps;
+
+    for (int c = 0; c < numChannels; c++)
+    {
+        float* x = buffer.getWritePointer(c);
+        float* h = history + size_t(c) * 2 * L;
+        int index = historyIndex;
+        int out = 0;
+        int next = first;
+
+        for (int i = 0; i < nSamples; i++)
+        {
+            h[index] = x[i];
+            h[index + L] = x[i];
+
+            if (++index == L)
+                index = 0;
+
+            if (i == next)
+            {
+                // the window runs from the oldest sample at h[index] to the newest
+                const float* w = h + index;
+                float acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+                for (int k = 0; k < L; k += 8)
+                {
+                    for (int j = 0; j < 8; j++)
+                        acc[j] += taps[k + j] * w[k + j];
+                }
+
+                // earlier output samples never overlap input that is still unread
+                x[out++] = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+                next += factor;
+            }
+        }
+    }
+
+    historyIndex = (historyIndex + nSamples) % L;
+
+    remapEvents(events, inputTimestamp, nOut);
+
+    setNumSamples(events, nOut);
+    numSamples[nodeId] = nOut;
+
+    setTimestamp(events, (inputTimestamp + first) / factor, acquisitionTicks[inputSourceId]);
+}
+
+void Decimator::remapEvents(MidiBuffer& events, int64 inputTimestamp, int numOutputSamples)
+{
+    remappedEvents.clear();
+
+    MidiBuffer::Iterator i(events);
+    const uint8* dataptr;
+    int dataSize;
+    int samplePosition;
+
+    const int64 firstOutput = (inputTimestamp + factor - 1) / factor;
+
+    while (i.getNextEvent(dataptr, dataSize, samplePosition))
+    {
+        if (dataSize >= 6 && isWritableEvent(*dataptr) && *(dataptr+5) == inputSourceId)
+        {
+            if (eventDataSize < dataSize)
+            {
+                eventData.malloc(dataSize);
+                eventDataSize = dataSize;
+            }
+
+            memcpy(eventData, dataptr, dataSize);
+            eventData[5] = nodeId;
+
+            // first output sample at or after the event
+            int64 t = inputTimestamp + samplePosition;
+            int outputPosition = int((t + factor - 1) / factor - firstOutput);
+
+            remappedEvents.addEvent(eventData, dataSize, jmin(outputPosition, jmax(0, numOutputSamples - 1)));
+        }
+        else
+        {
+            remappedEvents.addEvent(dataptr, dataSize, samplePosition);
+        }
+    }
+
+    events.swapWith(remappedEvents);
+}
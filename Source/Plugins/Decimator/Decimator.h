@@ -0,0 +1,124 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DECIMATOR_H_INCLUDED
+#define DECIMATOR_H_INCLUDED
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <ProcessorHeaders.h>
+
+/**
+
+    Lowers the sample rate of all incoming channels by an integer factor,
+    e.g. to run an LFP branch at 1 kHz instead of 30 kHz.
+
+    The Decimator becomes the source of its output channels: it sends its own
+    sample count and timestamp every buffer, so processors further down the
+    chain (displays, detectors, the RecordNode) see a stream at the lower rate
+    and only touch the samples that are left. Timestamps count samples at the
+    lower rate, in step with the input timestamps (input timestamp / factor).
+
+    Each output sample is computed by a linear-phase, Kaiser-windowed low-pass
+    FIR that is only evaluated at the kept samples. Its cutoff is half the
+    output rate and everything above 0.65 times the output rate is attenuated
+    by 60 dB, so aliases only land in the top 30% of the output band. The
+    filter delays the signal by 6 output samples.
+
+    Events from the decimated source are moved to the matching output sample.
+
+    All input channels must come from the same source.
+
+*/
+
+class Decimator : public GenericProcessor
+
+{
+public:
+
+    Decimator();
+    ~Decimator();
+
+    bool isSource()
+    {
+        return false;
+    }
+
+    bool isSink()
+    {
+        return false;
+    }
+
+    /** The Decimator sends its own timestamps for the decimated stream */
+    bool generatesTimestamps()
+    {
+        return true;
+    }
+
+    void process(AudioSampleBuffer& buffer, MidiBuffer& events);
+
+    /** parameterIndex = 0: decimation factor */
+    void setParameter(int parameterIndex, float newValue);
+
+    void updateSettings();
+
+    bool isReady();
+    bool enable();
+
+    int getDecimationFactor() const;
+
+private:
+
+    /** Designs the anti-aliasing filter and clears the channel histories */
+    void prepareFilter();
+
+    /** Moves the events of the decimated source to the output sample positions */
+    void remapEvents(MidiBuffer& events, int64 inputTimestamp, int numOutputSamples);
+
+    int factor;
+
+    /** Source of the input channels, whose sample counts and timestamps are read */
+    int inputSourceId;
+    bool mixedSources;
+
+    /** Filter taps, zero-padded at the front to a multiple of 8 */
+    HeapBlock<float> taps;
+    int numTaps;
+
+    /** Last numTaps input samples of every channel, stored twice so that
+        every window is contiguous */
+    HeapBlock<float> history;
+    int historyIndex;
+
+    MidiBuffer remappedEvents;
+    HeapBlock<uint8> eventData;
+    int eventDataSize;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Decimator);
+
+};
+
+#endif  // DECIMATOR_H_INCLUDED
@@ -0,0 +1,263 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Sends batches of TTL events through an EventBatchSender and a ZeroMQ PUB
+    socket on the loopback interface to a local subscriber, at a steady
+    event rate. Fails if a batch is dropped or the subscriber sees a gap in
+    the batch sequence numbers.
+
+        make test                 (in Source/Plugins/EventBroadcaster)
+        ./EventBatchSenderTest [eventsPerSecond] [seconds]
+
+    The defaults are 100000 events/s for 5 seconds, in 10 ms buffers.
+*/
+
+#include "../EventBroadcaster.h"
+
+#define BUFFER_INTERVAL 10 // ms
+#define TTL_DATA_SIZE 8
+
+namespace
+{
+/** A PUB socket bound to an ephemeral port on the loopback interface */
+class PublisherDestination : public EventBatchSender::Destination
+{
+public:
+    PublisherDestination(void* context) : socket(zmq_socket(context, ZMQ_PUB))
+    {
+        int linger = 0;
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_bind(socket, "tcp://127.0.0.1:*");
+
+        size_t size = sizeof(endpoint);
+        zmq_getsockopt(socket, ZMQ_LAST_ENDPOINT, endpoint, &size);
+    }
+
+    ~PublisherDestination()
+    {
+        zmq_close(socket);
+    }
+
+    bool sendBatch(const void* data, size_t size) override
+    {
+        return zmq_send(socket, data, size, ZMQ_DONTWAIT) != -1;
+    }
+
+    const char* getEndpoint() const { return endpoint; }
+
+private:
+    void* socket;
+    char endpoint[256];
+};
+
+/** Receives batches and checks their sequence numbers */
+class Subscriber : public Thread
+{
+public:
+    Subscriber(void* context, const char* endpoint)
+        : Thread("Subscriber"), socket(zmq_socket(context, ZMQ_SUB)),
+          batches(0), events(0), gaps(0), reportedDrops(0), nextSequence(0)
+    {
+        int timeout = 100;
+        int linger = 0;
+        zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_setsockopt(socket, ZMQ_SUBSCRIBE, EVENT_BATCH_MAGIC, 4);
+        zmq_connect(socket, endpoint);
+    }
+
+    ~Subscriber()
+    {
+        stopThread(1000);
+        zmq_close(socket);
+    }
+
+    void run() override
+    {
+        HeapBlock<uint8> message(EVENT_BATCH_MAX_BYTES);
+
+        while (! threadShouldExit())
+        {
+            const int size = zmq_recv(socket, message, EVENT_BATCH_MAX_BYTES, 0);
+
+            if (size < int(sizeof(EventBatchHeader)))
+                continue;
+
+            EventBatchHeader header;
+            memcpy(&header, message, sizeof(header));
+
+            if (header.sequence != nextSequence)
+                gaps++;
+
+            nextSequence = header.sequence + 1;
+            reportedDrops += header.numDropped;
+            events += header.numEvents;
+            batches++;
+        }
+    }
+
+    /** Waits until a probe message gets through, so no batch is lost to the
+        connection. Probes are shorter than a batch header, so run() skips
+        those still queued. */
+    bool waitForConnection(PublisherDestination& destination)
+    {
+        const char probe[] = EVENT_BATCH_MAGIC "probe";
+
+        for (int i = 0; i < 100; i++)
+        {
+            destination.sendBatch(probe, sizeof(probe));
+
+            char reply[sizeof(probe)];
+            if (zmq_recv(socket, reply, sizeof(reply), 0) == int(sizeof(probe)))
+                return true;
+        }
+
+        return false;
+    }
+
+    void* socket;
+    int64 batches;
+    int64 events;
+    int gaps;
+    int64 reportedDrops;
+    uint64 nextSequence;
+};
+
+bool runTest(void* context, int eventsPerSecond, int seconds)
+{
+    const int eventsPerBuffer = eventsPerSecond * BUFFER_INTERVAL / 1000;
+    const int numBuffers = seconds * 1000 / BUFFER_INTERVAL;
+    const int recordSize = int(sizeof(EventBatchRecord)) + TTL_DATA_SIZE;
+    const int eventsPerBatch = (EVENT_BATCH_MAX_BYTES - int(sizeof(EventBatchHeader))) / recordSize;
+
+    PublisherDestination destination(context);
+    Subscriber subscriber(context, destination.getEndpoint());
+
+    // the PUB socket drops everything sent before the subscription arrives
+    if (! subscriber.waitForConnection(destination))
+    {
+        printf("The subscriber didn't connect to %s\n", destination.getEndpoint());
+        return false;
+    }
+
+    subscriber.startThread();
+
+    EventBatchSender sender(&destination);
+    sender.start();
+
+    HeapBlock<uint8> batch(EVENT_BATCH_MAX_BYTES);
+    uint64 sequence = 0;
+    int64 eventsQueued = 0;
+
+    const int64 start = Time::getHighResolutionTicks();
+
+    // the audio thread: one buffer every BUFFER_INTERVAL ms, split into
+    // batches of EVENT_BATCH_MAX_BYTES like EventBroadcaster::process
+    for (int b = 0; b < numBuffers; b++)
+    {
+        for (int first = 0; first < eventsPerBuffer; first += eventsPerBatch)
+        {
+            const int numEvents = jmin(eventsPerBatch, eventsPerBuffer - first);
+
+            EventBatchHeader header;
+            memcpy(header.magic, EVENT_BATCH_MAGIC, sizeof(header.magic));
+            header.version = EVENT_BATCH_VERSION;
+            header.headerSize = sizeof(EventBatchHeader);
+            header.numEvents = uint32(numEvents);
+            header.numDropped = 0;
+            header.sequence = sequence++;
+            header.sampleRate = 30000.0;
+            memcpy(batch, &header, sizeof(header));
+
+            uint8* dest = batch + sizeof(header);
+
+            for (int i = 0; i < numEvents; i++)
+            {
+                EventBatchRecord record;
+                record.timestamp = double(eventsQueued + i) / eventsPerSecond;
+                record.size = TTL_DATA_SIZE;
+                record.type = TTL;
+                memset(record.reserved, 0, sizeof(record.reserved));
+
+                memcpy(dest, &record, sizeof(record));
+                memset(dest + sizeof(record), i & 0xff, TTL_DATA_SIZE);
+                dest += recordSize;
+            }
+
+            sender.push(batch, int(dest - batch), numEvents);
+            eventsQueued += numEvents;
+        }
+
+        const int64 due = start + Time::secondsToHighResolutionTicks((b + 1) * BUFFER_INTERVAL / 1000.0);
+        const int64 now = Time::getHighResolutionTicks();
+
+        if (due > now)
+            Thread::sleep(int(Time::highResolutionTicksToSeconds(due - now) * 1000.0));
+    }
+
+    const double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+    sender.stop();
+
+    // let the subscriber take what is still in flight
+    for (int i = 0; i < 100 && subscriber.events < eventsQueued; i++)
+        Thread::sleep(10);
+
+    subscriber.signalThreadShouldExit();
+    subscriber.stopThread(1000);
+
+    EventBatchSender::Stats stats = sender.getStats();
+    const double rate = eventsQueued / elapsed;
+
+    printf("%lld events in %lld batches queued in %.2f s (%.0f events/s)\n",
+           (long long) eventsQueued, (long long) sequence, elapsed, rate);
+    printf("sender: %lld batches sent, %d dropped, %d send errors, queue peak %d bytes\n",
+           (long long) stats.batchesSent, stats.batchesDropped, stats.sendErrors, stats.peakQueueBytes);
+    printf("subscriber: %lld events in %lld batches, %d sequence gaps, %lld events reported dropped\n",
+           (long long) subscriber.events, (long long) subscriber.batches, subscriber.gaps,
+           (long long) subscriber.reportedDrops);
+
+    const bool pass = stats.batchesDropped == 0 && stats.sendErrors == 0 && subscriber.gaps == 0
+                      && subscriber.reportedDrops == 0 && subscriber.events == eventsQueued
+                      && rate >= 0.95 * eventsPerSecond;
+
+    return pass;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int eventsPerSecond = (argc > 1) ? atoi(argv[1]) : 100000;
+    const int seconds = (argc > 2) ? atoi(argv[2]) : 5;
+
+    void* context = zmq_ctx_new();
+
+    // the sockets are closed when runTest returns, before the context
+    const bool pass = runTest(context, eventsPerSecond, seconds);
+
+    zmq_ctx_term(context);
+
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
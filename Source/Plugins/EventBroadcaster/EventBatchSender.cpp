@@ -0,0 +1,196 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "EventBatchSender.h"
+
+// upper bound of the sender thread sleep, in ms; push() doesn't wake the
+// sender thread, so this is also the longest a new batch waits
+#define FIFO_POLL_INTERVAL 1
+
+namespace
+{
+/** Each batch in the FIFO is preceded by its size and number of events */
+struct QueuedBatchHeader
+{
+    int32 size;
+    int32 numEvents;
+};
+
+/** Copies n bytes to offset within the region returned by prepareToWrite */
+void copyToRegion(uint8* queue, int offset, int start1, int size1, int start2,
+                  const uint8* source, int n)
+{
+    if (offset < size1)
+    {
+        int first = jmin(n, size1 - offset);
+        memcpy(queue + start1 + offset, source, first);
+        source += first;
+        n -= first;
+        offset = size1;
+    }
+
+    if (n > 0)
+        memcpy(queue + start2 + (offset - size1), source, n);
+}
+}
+
+EventBatchSender::EventBatchSender(Destination* d, int queueBytes)
+    : Thread("Event Broadcaster"), destination(d), fifo(queueBytes),
+      batchesSent(0), eventsSent(0), sendErrors(0)
+{
+    queue.malloc(queueBytes);
+}
+
+EventBatchSender::~EventBatchSender()
+{
+    stop();
+}
+
+void EventBatchSender::start()
+{
+    if (! isThreadRunning())
+        startThread();
+}
+
+void EventBatchSender::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+
+    sendQueuedBatches();
+}
+
+bool EventBatchSender::push(const uint8* data, int size, int numEvents)
+{
+    const int total = int(sizeof(QueuedBatchHeader)) + size;
+
+    if (fifo.getFreeSpace() < total)
+    {
+        ++batchesDropped;
+        eventsDropped += numEvents;
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(total, start1, size1, start2, size2);
+
+    QueuedBatchHeader header;
+    header.size = size;
+    header.numEvents = numEvents;
+
+    copyToRegion(queue, 0, start1, size1, start2, reinterpret_cast<const uint8*>(&header), sizeof(header));
+    copyToRegion(queue, sizeof(header), start1, size1, start2, data, size);
+
+    fifo.finishedWrite(total);
+
+    const int used = fifo.getNumReady();
+    if (used > peakQueueBytes.get())
+        peakQueueBytes = used;
+
+    // no notify(): signalling the thread takes a lock, and the sender
+    // thread polls the FIFO every FIFO_POLL_INTERVAL ms anyway
+    return true;
+}
+
+void EventBatchSender::read(uint8* dest, int size)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(size, start1, size1, start2, size2);
+
+    memcpy(dest, queue + start1, size1);
+
+    if (size2 > 0)
+        memcpy(dest + size1, queue + start2, size2);
+
+    fifo.finishedRead(size1 + size2);
+}
+
+bool EventBatchSender::sendQueuedBatches()
+{
+    bool sentAny = false;
+
+    // push() makes a batch ready all at once, so a ready header means a ready batch
+    while (fifo.getNumReady() >= int(sizeof(QueuedBatchHeader)))
+    {
+        QueuedBatchHeader header;
+        read(reinterpret_cast<uint8*>(&header), sizeof(header));
+
+        batch.ensureSize(header.size);
+        read(static_cast<uint8*>(batch.getData()), header.size);
+
+        bool ok = destination->sendBatch(batch.getData(), header.size);
+
+        const ScopedLock sl(statsLock);
+
+        if (ok)
+        {
+            batchesSent++;
+            eventsSent += header.numEvents;
+        }
+        else
+        {
+            sendErrors++;
+        }
+
+        sentAny = true;
+    }
+
+    return sentAny;
+}
+
+void EventBatchSender::run()
+{
+    while (! threadShouldExit())
+    {
+        if (! sendQueuedBatches())
+            wait(FIFO_POLL_INTERVAL);
+    }
+}
+
+EventBatchSender::Stats EventBatchSender::getStats() const
+{
+    const ScopedLock sl(statsLock);
+
+    Stats stats;
+    stats.batchesSent = batchesSent;
+    stats.eventsSent = eventsSent;
+    stats.batchesDropped = batchesDropped.get();
+    stats.eventsDropped = eventsDropped.get();
+    stats.sendErrors = sendErrors;
+    stats.peakQueueBytes = peakQueueBytes.get();
+    return stats;
+}
+
+void EventBatchSender::resetStats()
+{
+    const ScopedLock sl(statsLock);
+
+    batchesSent = 0;
+    eventsSent = 0;
+    sendErrors = 0;
+    batchesDropped.set(0);
+    eventsDropped.set(0);
+    peakQueueBytes.set(0);
+}
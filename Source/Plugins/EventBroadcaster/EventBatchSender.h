@@ -0,0 +1,112 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef EVENTBATCHSENDER_H_INCLUDED
+#define EVENTBATCHSENDER_H_INCLUDED
+
+#include <ProcessorHeaders.h>
+
+/**
+
+    Takes batched event messages off the audio thread.
+
+    The audio thread queues each encoded batch with push(), which copies it
+    into a lock-free byte FIFO and never blocks or wakes another thread. A
+    background thread polls the FIFO every millisecond and hands the batches
+    to its Destination, the EventBroadcaster socket in the GUI. When the
+    FIFO is full the batch is dropped and counted, rather than waiting for
+    a slow network or subscriber.
+
+    @see EventBroadcaster
+
+*/
+
+class EventBatchSender : public Thread
+{
+public:
+    /** Where the batches go; sendBatch() is called on the sender thread */
+    class Destination
+    {
+    public:
+        virtual ~Destination() {}
+        virtual bool sendBatch(const void* data, size_t size) = 0;
+    };
+
+    EventBatchSender(Destination* destination, int queueBytes = 4 << 20);
+    ~EventBatchSender();
+
+    /** Starts the sender thread */
+    void start();
+
+    /** Stops the sender thread once the batches still queued are sent */
+    void stop();
+
+    /** Queues a batch of numEvents events from the audio thread. Returns
+        false if it was dropped because the queue is full. */
+    bool push(const uint8* data, int size, int numEvents);
+
+    struct Stats
+    {
+        int64 batchesSent;
+        int64 eventsSent;
+        int batchesDropped;
+        int eventsDropped;
+        int sendErrors;
+        /** Most bytes waiting in the queue at any time */
+        int peakQueueBytes;
+    };
+
+    Stats getStats() const;
+    void resetStats();
+
+    void run();
+
+private:
+    /** Copies size bytes out of the FIFO, wrapping around its end */
+    void read(uint8* dest, int size);
+
+    /** Sends every batch in the queue; returns false if it was empty */
+    bool sendQueuedBatches();
+
+    Destination* destination;
+
+    AbstractFifo fifo;
+    HeapBlock<uint8> queue;
+
+    /** Batch being sent; only used by the sender thread */
+    MemoryBlock batch;
+
+    Atomic<int> batchesDropped;
+    Atomic<int> eventsDropped;
+    Atomic<int> peakQueueBytes;
+
+    CriticalSection statsLock;
+    int64 batchesSent;
+    int64 eventsSent;
+    int sendErrors;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EventBatchSender);
+};
+
+#endif  // EVENTBATCHSENDER_H_INCLUDED
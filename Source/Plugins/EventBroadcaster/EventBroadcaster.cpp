@@ -36,9 +36,23 @@ EventBroadcaster::EventBroadcaster()
       zmqContext(getZMQContext()),
       zmqSocket(nullptr, &closeZMQSocket),
       listeningPort(0),
-      currentSampleRate(0)
+      currentSampleRate(0),
+      batchMode(false),
+      sendingBatches(false),
+      batchNumEvents(0),
+      batchSequence(0),
+      eventsDroppedSinceLastBatch(0)
 {
     setListeningPort(5557);
+
+    batchSender = new EventBatchSender(this);
+}
+
+
+EventBroadcaster::~EventBroadcaster()
+{
+    // the sender thread uses the socket
+    batchSender = nullptr;
 }
 
 
@@ -60,6 +74,8 @@ void EventBroadcaster::setListeningPort(int port, bool forceRestart)
     if ((listeningPort != port) || forceRestart)
     {
 #ifdef ZEROMQ
+        const ScopedLock sl(socketLock);
+
         zmqSocket.reset(zmq_socket(zmqContext.get(), ZMQ_PUB));
         if (!zmqSocket)
         {
@@ -80,10 +96,161 @@ void EventBroadcaster::setListeningPort(int port, bool forceRestart)
 }
 
 
+void EventBroadcaster::setBatchMode(bool batched)
+{
+    batchMode = batched;
+}
+
+
+bool EventBroadcaster::getBatchMode() const
+{
+    return batchMode;
+}
+
+
+bool EventBroadcaster::sendBatch(const void* data, size_t size)
+{
+#ifdef ZEROMQ
+    const ScopedLock sl(socketLock);
+
+    // a PUB socket drops messages for subscribers that are past their
+    // high-water mark, so this only fails if the socket itself is unusable
+    if (!zmqSocket || -1 == zmq_send(zmqSocket.get(), data, size, ZMQ_DONTWAIT))
+    {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+
+EventBatchSender::Stats EventBroadcaster::getBatchStats() const
+{
+    return batchSender->getStats();
+}
+
+
+bool EventBroadcaster::enable()
+{
+    sendingBatches = batchMode;
+
+    // neither buffer grows during acquisition
+    spikeBuffer.reserve(EVENT_BATCH_MAX_BYTES);
+
+    if (sendingBatches)
+    {
+        batchBuffer.reserve(EVENT_BATCH_MAX_BYTES);
+        batchSequence = 0;
+        eventsDroppedSinceLastBatch = 0;
+
+        batchSender->resetStats();
+        batchSender->start();
+    }
+
+    return true;
+}
+
+
+bool EventBroadcaster::disable()
+{
+    if (sendingBatches)
+    {
+        batchSender->stop();
+        sendingBatches = false;
+
+        EventBatchSender::Stats stats = batchSender->getStats();
+
+        std::cout << "Event Broadcaster: " << stats.eventsSent << " events in " << stats.batchesSent
+                  << " batches sent, " << stats.eventsDropped << " events in " << stats.batchesDropped
+                  << " batches dropped, " << stats.sendErrors << " send errors, queue peak "
+                  << stats.peakQueueBytes << " bytes" << std::endl;
+
+        if (stats.batchesDropped > 0 || stats.sendErrors > 0)
+            CoreServices::sendStatusMessage("Event Broadcaster dropped " + String(stats.batchesDropped + stats.sendErrors) + " batches");
+    }
+
+    return true;
+}
+
+
 void EventBroadcaster::process(AudioSampleBuffer& continuousBuffer, MidiBuffer& eventBuffer)
 {
     currentSampleRate = getSampleRate();
+
+    if (!sendingBatches)
+    {
+        checkForEvents(eventBuffer);
+        return;
+    }
+
+    batchBuffer.resize(sizeof(EventBatchHeader));
+    batchNumEvents = 0;
+
     checkForEvents(eventBuffer);
+
+    pushBatch();
+}
+
+
+void EventBroadcaster::pushBatch()
+{
+    if (batchNumEvents == 0)
+        return;
+
+    EventBatchHeader header;
+    memcpy(header.magic, EVENT_BATCH_MAGIC, sizeof(header.magic));
+    header.version = EVENT_BATCH_VERSION;
+    header.headerSize = sizeof(EventBatchHeader);
+    header.numEvents = uint32(batchNumEvents);
+    header.numDropped = uint32(eventsDroppedSinceLastBatch);
+    header.sequence = batchSequence++;
+    header.sampleRate = currentSampleRate;
+
+    memcpy(batchBuffer.data(), &header, sizeof(header));
+
+    if (batchSender->push(batchBuffer.data(), int(batchBuffer.size()), batchNumEvents))
+        eventsDroppedSinceLastBatch = 0;
+    else
+        eventsDroppedSinceLastBatch += batchNumEvents;
+
+    batchBuffer.resize(sizeof(EventBatchHeader));
+    batchNumEvents = 0;
+}
+
+
+void EventBroadcaster::appendToBatch(uint8_t type, double timestampSeconds, const uint8_t* data, int size)
+{
+    EventBatchRecord record;
+    record.timestamp = timestampSeconds;
+    record.size = uint32(size);
+    record.type = type;
+    memset(record.reserved, 0, sizeof(record.reserved));
+
+    const size_t paddedSize = (size_t(size) + 7) & ~size_t(7);
+    const size_t recordSize = sizeof(record) + paddedSize;
+
+    // staying within the reserved size keeps the audio thread off the heap
+    if (batchBuffer.size() + recordSize > EVENT_BATCH_MAX_BYTES)
+    {
+        pushBatch();
+
+        if (batchBuffer.size() + recordSize > EVENT_BATCH_MAX_BYTES)
+        {
+            eventsDroppedSinceLastBatch++;
+            return;
+        }
+    }
+
+    const size_t offset = batchBuffer.size();
+    batchBuffer.resize(offset + recordSize);
+
+    uint8_t* dest = batchBuffer.data() + offset;
+    memcpy(dest, &record, sizeof(record));
+    memcpy(dest + sizeof(record), data, size);
+    memset(dest + sizeof(record) + size, 0, paddedSize - size);
+
+    batchNumEvents++;
 }
 
 
@@ -96,6 +263,7 @@ bool EventBroadcaster::isSink()
 void EventBroadcaster::handleEvent(int eventType, MidiMessage& event, int samplePosition)
 {
     const uint8_t* buffer = event.getRawData();
+    int bufferSize = event.getRawDataSize();
     uint8_t type = buffer[0];
     int64_t timestamp;
     
@@ -109,6 +277,23 @@ void EventBroadcaster::handleEvent(int eventType, MidiMessage& event, int sample
         }
             
         case SPIKE:
+            if (const SpikeRecord* record = getSpikeRecord(buffer, bufferSize))
+            {
+                const int packedSize = getPackedSpikeRecordSize(*record);
+
+                // spikes larger than the storage reserved in enable() are dropped
+                if (packedSize > int(spikeBuffer.capacity()))
+                {
+                    if (sendingBatches)
+                        eventsDroppedSinceLastBatch++;
+                    return;
+                }
+
+                // subscribers get the packed layout, whatever the size of the spike
+                spikeBuffer.resize(packedSize);
+                bufferSize = packSpikeRecord(*record, spikeBuffer.data(), int(spikeBuffer.size()));
+                buffer = spikeBuffer.data();
+            }
             std::copy_n(buffer + 1, sizeof(timestamp), reinterpret_cast<uint8_t *>(&timestamp));
             break;
             
@@ -119,10 +304,16 @@ void EventBroadcaster::handleEvent(int eventType, MidiMessage& event, int sample
     
     double timestampSeconds = double(timestamp) / currentSampleRate;
 
+    if (sendingBatches)
+    {
+        appendToBatch(type, timestampSeconds, buffer + 1, bufferSize - 1);
+        return;
+    }
+
 #ifdef ZEROMQ
     if (-1 == zmq_send(zmqSocket.get(), &type, sizeof(type), ZMQ_SNDMORE) ||
         -1 == zmq_send(zmqSocket.get(), &timestampSeconds, sizeof(timestampSeconds), ZMQ_SNDMORE) ||
-        -1 == zmq_send(zmqSocket.get(), buffer + 1, event.getRawDataSize() - 1, 0) /* Omit event type */)
+        -1 == zmq_send(zmqSocket.get(), buffer + 1, bufferSize - 1, 0) /* Omit event type */)
     {
         std::cout << "Failed to send message: " << zmq_strerror(zmq_errno()) << std::endl;
     }
@@ -134,6 +325,7 @@ void EventBroadcaster::saveCustomParametersToXml(XmlElement* parentElement)
 {
     XmlElement* mainNode = parentElement->createNewChildElement("EVENTBROADCASTER");
     mainNode->setAttribute("port", listeningPort);
+    mainNode->setAttribute("batched", batchMode);
 }
 
 
@@ -146,6 +338,7 @@ void EventBroadcaster::loadCustomParametersFromXml()
             if (mainNode->hasTagName("EVENTBROADCASTER"))
             {
                 setListeningPort(mainNode->getIntAttribute("port"));
+                setBatchMode(mainNode->getBoolAttribute("batched", false));
             }
         }
     }
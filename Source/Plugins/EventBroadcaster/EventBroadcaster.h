@@ -12,6 +12,7 @@
 #define EVENTBROADCASTER_H_INCLUDED
 
 #include <ProcessorHeaders.h>
+#include <SpikeLib.h>
 
 #ifdef ZEROMQ
 
@@ -24,21 +25,86 @@
 
 #endif
 #include <memory>
+#include <vector>
 
-class EventBroadcaster : public GenericProcessor
+#include "EventBatchSender.h"
+
+#define EVENT_BATCH_MAGIC "OEEB"
+#define EVENT_BATCH_VERSION 1
+#define EVENT_BATCH_MAX_BYTES (1 << 16) // larger buffers go out in several batches
+
+/** First 32 bytes of a batch message. All fields are little-endian. */
+struct EventBatchHeader
+{
+    char magic[4];          // "OEEB", the prefix to subscribe to
+    uint16 version;
+    uint16 headerSize;      // sizeof(EventBatchHeader)
+    uint32 numEvents;
+    uint32 numDropped;      // events in batches dropped since the last batch sent
+    uint64 sequence;        // batch number since the start of acquisition, dropped ones included
+    double sampleRate;
+};
+
+/** Precedes every event of a batch. The event data follows, padded to a multiple of 8 bytes. */
+struct EventBatchRecord
+{
+    double timestamp;       // seconds
+    uint32 size;            // bytes of event data
+    uint8 type;             // TTL, SPIKE, MESSAGE or BINARY_MSG
+    uint8 reserved[3];
+};
+
+/**
+
+    Publishes events on a ZeroMQ PUB socket.
+
+    By default every event is sent as a three-part message (event type,
+    timestamp in seconds, event data without its type byte) from the audio
+    thread.
+
+    In batch mode all the events of a buffer go out as a single message: an
+    EventBatchHeader followed by an EventBatchRecord and the event data for
+    each event, in the same order and with the same data as the three-part
+    messages. Batches are queued and sent by an EventBatchSender thread, so
+    the audio thread makes no system calls; batches that don't fit in the
+    queue are dropped and counted, and the next batch reports how many
+    events were lost. A batch holds up to EVENT_BATCH_MAX_BYTES, so a buffer
+    with more events is split in several batches; the storage is reserved
+    in enable() and events that would not fit in an empty batch are dropped.
+    Subscribe to "OEEB" to receive batches.
+
+    @see EventBatchSender
+
+*/
+
+class EventBroadcaster : public GenericProcessor, public EventBatchSender::Destination
 {
 public:
     EventBroadcaster();
+    ~EventBroadcaster();
 
     AudioProcessorEditor* createEditor() override;
 
     int getListeningPort() const;
     void setListeningPort(int port, bool forceRestart = false);
 
+    /** Selects batch mode from the next acquisition on */
+    void setBatchMode(bool batched);
+    bool getBatchMode() const;
+
+    /** Sends one batch message; called by the EventBatchSender thread */
+    bool sendBatch(const void* data, size_t size) override;
+
+    /** Batches sent and dropped since the start of the last acquisition */
+    EventBatchSender::Stats getBatchStats() const;
+
     void process(AudioSampleBuffer& continuousBuffer, MidiBuffer& eventBuffer) override;
     bool isSink() override;
     void handleEvent(int eventType, MidiMessage& event, int samplePosition = 0) override;
 
+    bool enable() override;
+    bool disable() override;
+
     void saveCustomParametersToXml(XmlElement* parentElement) override;
     void loadCustomParametersFromXml() override;
 
@@ -49,9 +115,33 @@ private:
     const std::shared_ptr<void> zmqContext;
     std::unique_ptr<void, decltype(&closeZMQSocket)> zmqSocket;
     int listeningPort;
+
+    // held while the socket is replaced or used by the sender thread
+    CriticalSection socketLock;
     
     float currentSampleRate;
 
+    // spikes passed by handle are packed here before sending
+    std::vector<uint8_t> spikeBuffer;
+
+    void appendToBatch(uint8_t type, double timestampSeconds, const uint8_t* data, int size);
+
+    /** Queues the batch being built, if it has events, and starts the next one */
+    void pushBatch();
+
+    bool batchMode;
+
+    // batch mode of the current acquisition
+    bool sendingBatches;
+
+    ScopedPointer<EventBatchSender> batchSender;
+
+    // the batch of the current buffer
+    std::vector<uint8_t> batchBuffer;
+    int batchNumEvents;
+    uint64 batchSequence;
+    int eventsDroppedSinceLastBatch;
+
 };
 
 
@@ -37,6 +37,14 @@ EventBroadcasterEditor::EventBroadcasterEditor(GenericProcessor* parentNode, boo
     portLabel->addListener(this);
     addAndMakeVisible(portLabel);
 
+    batchButton = new UtilityButton("Batch events", Font("Default", 15, Font::plain));
+    batchButton->setBounds(20,110,150,18);
+    batchButton->setClickingTogglesState(true);
+    batchButton->setToggleState(p->getBatchMode(), dontSendNotification);
+    batchButton->setTooltip("Send all events of a buffer in one message from a background thread");
+    batchButton->addListener(this);
+    addAndMakeVisible(batchButton);
+
     setEnabledState(false);
 }
 
@@ -48,6 +56,22 @@ void EventBroadcasterEditor::buttonEvent(Button* button)
         EventBroadcaster* p = (EventBroadcaster*)getProcessor();
         p->setListeningPort(p->getListeningPort(), true);
     }
+    else if (button == batchButton)
+    {
+        EventBroadcaster* p = (EventBroadcaster*)getProcessor();
+        p->setBatchMode(batchButton->getToggleState());
+
+        if (CoreServices::getAcquisitionStatus())
+            CoreServices::sendStatusMessage("Batch mode applies from the next acquisition.");
+    }
+}
+
+
+void EventBroadcasterEditor::updateSettings()
+{
+    // the mode may have been loaded from a saved signal chain
+    EventBroadcaster* p = (EventBroadcaster*)getProcessor();
+    batchButton->setToggleState(p->getBatchMode(), dontSendNotification);
 }
 
 
@@ -30,8 +30,11 @@ public:
     void buttonEvent(Button* button) override;
     void labelTextChanged(juce::Label* label) override;
 
+    void updateSettings() override;
+
 private:
     ScopedPointer<UtilityButton> restartConnection;
+    ScopedPointer<UtilityButton> batchButton;
     ScopedPointer<Label> urlLabel;
     ScopedPointer<Label> portLabel;
 
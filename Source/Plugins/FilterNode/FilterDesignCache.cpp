@@ -0,0 +1,113 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FilterDesignCache.h"
+
+bool FilterDesignKey::operator== (const FilterDesignKey& other) const
+{
+    return type == other.type
+           && order == other.order
+           && sampleRate == other.sampleRate
+           && lowCut == other.lowCut
+           && highCut == other.highCut;
+}
+
+FilterDesignCache::FilterDesignCache()
+{
+}
+
+FilterDesignCache::~FilterDesignCache()
+{
+}
+
+BandpassDesign* FilterDesignCache::getBandpass(int order, double sampleRate, double lowCut, double highCut)
+{
+    FilterDesignKey key;
+    key.type = FilterDesignKey::BUTTERWORTH_BANDPASS;
+    key.order = order;
+    key.sampleRate = sampleRate;
+    key.lowCut = lowCut;
+    key.highCut = highCut;
+
+    const ScopedLock sl(lock);
+
+    for (int i = 0; i < entries.size(); i++)
+    {
+        if (entries[i]->key == key)
+            return &entries[i]->design;
+    }
+
+    Entry* entry = new Entry();
+    entry->key = key;
+    entry->design.setup(order,
+                        sampleRate,
+                        (highCut + lowCut)/2, // center frequency
+                        highCut - lowCut);    // bandwidth
+    entries.add(entry);
+
+    return &entry->design;
+}
+
+void FilterDesignCache::removeUnused(const Array<BandpassDesign*>& inUse)
+{
+    const ScopedLock sl(lock);
+
+    for (int i = entries.size(); --i >= 0;)
+    {
+        if (! inUse.contains(&entries[i]->design))
+            entries.remove(i);
+    }
+}
+
+int FilterDesignCache::getNumDesigns() const
+{
+    const ScopedLock sl(lock);
+    return entries.size();
+}
+
+ChannelFilter::ChannelFilter() : design(nullptr)
+{
+}
+
+void ChannelFilter::process(int numSamples, float* samples)
+{
+    BandpassDesign* current = design.get();
+
+    if (current != nullptr)
+        current->process(numSamples, samples, state);
+}
+
+void ChannelFilter::setDesign(BandpassDesign* newDesign)
+{
+    design.set(newDesign);
+}
+
+BandpassDesign* ChannelFilter::getDesign() const
+{
+    return design.get();
+}
+
+void ChannelFilter::reset()
+{
+    state.reset();
+}
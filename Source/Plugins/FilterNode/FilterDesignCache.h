@@ -0,0 +1,130 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef FILTERDESIGNCACHE_H_INCLUDED
+#define FILTERDESIGNCACHE_H_INCLUDED
+
+#include <ProcessorHeaders.h>
+#include "Dsp/Dsp.h"
+
+/** Raw Butterworth bandpass used by the FilterNode. Only holds coefficients;
+    the filter memory of every channel lives in a separate BandpassState. */
+typedef Dsp::Butterworth::BandPass<2> BandpassDesign;
+typedef BandpassDesign::State<Dsp::DirectFormII> BandpassState;
+
+/**
+
+  Identifies one set of filter coefficients.
+
+*/
+
+struct FilterDesignKey
+{
+    enum FilterType {BUTTERWORTH_BANDPASS = 0};
+
+    FilterType type;
+    int order;
+    double sampleRate;
+    double lowCut;
+    double highCut;
+
+    bool operator== (const FilterDesignKey& other) const;
+};
+
+/**
+
+  Shares filter coefficients between channels.
+
+  Channels with the same type, order, sample rate and cutoffs point to the
+  same design, so a 256-channel probe with uniform settings computes and
+  stores a single set of coefficients. Designs are immutable once created:
+  the audio thread can keep using a design while the message thread
+  publishes a new one, and designs are only freed by removeUnused(), which
+  must not be called while acquisition is running.
+
+  @see FilterNode
+
+*/
+
+class FilterDesignCache
+{
+public:
+    FilterDesignCache();
+    ~FilterDesignCache();
+
+    /** Returns the design for the given settings, computing it on the first request. */
+    BandpassDesign* getBandpass(int order, double sampleRate, double lowCut, double highCut);
+
+    /** Frees every design that is not in the given list. */
+    void removeUnused(const Array<BandpassDesign*>& inUse);
+
+    int getNumDesigns() const;
+
+private:
+    struct Entry
+    {
+        FilterDesignKey key;
+        BandpassDesign design;
+    };
+
+    OwnedArray<Entry> entries;
+    CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FilterDesignCache);
+};
+
+/**
+
+  Filter of a single channel.
+
+  The coefficients are published through an atomic pointer, which acts as a
+  double buffer: the message thread prepares the new design off to the side
+  and swaps it in with a single store, while the audio thread reads the
+  pointer once per buffer and never blocks.
+
+*/
+
+class ChannelFilter
+{
+public:
+    ChannelFilter();
+
+    /** Audio thread: filters numSamples samples in place. */
+    void process(int numSamples, float* samples);
+
+    /** Message thread: makes the given design active from the next buffer on. */
+    void setDesign(BandpassDesign* design);
+
+    BandpassDesign* getDesign() const;
+
+    /** Clears the filter memory. */
+    void reset();
+
+private:
+    Atomic<BandpassDesign*> design;
+    BandpassState state;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelFilter);
+};
+
+#endif  // FILTERDESIGNCACHE_H_INCLUDED
@@ -146,12 +146,7 @@ void FilterNode::updateSettings()
 
             // std::cout << "Creating filter number " << n << std::endl;
 
-            filters.add(new Dsp::SmoothedFilterDesign
-                        <Dsp::Butterworth::Design::BandPass 	// design type
-                        <2>,								 	// order
-                        1,										// number of channels (must be const)
-                        Dsp::DirectFormII>						// realization
-                        (1));
+            filters.add(new ChannelFilter());
 
 
             //Parameter& p1 =  parameters.getReference(0);
@@ -178,12 +173,22 @@ void FilterNode::updateSettings()
 
             lowCuts.add(lc);
             highCuts.add(hc);
-
-            setFilterParameters(lc, hc, n);
         }
 
     }
 
+    // the sample rate may have changed even if the channel count didn't
+    Array<BandpassDesign*> designsInUse;
+
+    for (int n = 0; n < filters.size(); n++)
+    {
+        setFilterParameters(lowCuts[n], highCuts[n], n);
+        designsInUse.addIfNotAlreadyThere(filters[n]->getDesign());
+    }
+
+    // acquisition is stopped here, so designs no channel points to can go
+    designCache.removeUnused(designsInUse);
+
     setApplyOnADC(applyOnADC);
 
 }
@@ -207,14 +212,13 @@ void FilterNode::setFilterParameters(double lowCut, double highCut, int chan)
 {
 	if (channels.size()-1 < chan)
 		return;
-    Dsp::Params params;
-    params[0] = channels[chan]->sampleRate; // sample rate
-    params[1] = 2; // order
-    params[2] = (highCut + lowCut)/2; // center frequency
-    params[3] = highCut - lowCut; // bandwidth
 
     if (filters.size() > chan)
-        filters[chan]->setParams(params);
+    {
+        // designing happens here, on the message thread; process() only sees the pointer swap
+        BandpassDesign* design = designCache.getBandpass(2, channels[chan]->sampleRate, lowCut, highCut);
+        filters[chan]->setDesign(design);
+    }
 
 }
 
@@ -269,8 +273,7 @@ void FilterNode::process(AudioSampleBuffer& buffer,
     {
         if (shouldFilterChannel[n])
         {
-            float* ptr = buffer.getWritePointer(n);
-            filters[n]->process(getNumSamples(n), &ptr);
+            filters[n]->process(getNumSamples(n), buffer.getWritePointer(n));
         }
     }
 
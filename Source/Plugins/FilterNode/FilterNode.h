@@ -25,13 +25,14 @@
 #define __FILTERNODE_H_CED428E__
 
 #include <ProcessorHeaders.h>
-#include "Dsp/Dsp.h"
+#include "FilterDesignCache.h"
 
 /**
 
   Filters data using a filter from the DSP library.
 
-  The user can select the low- and high-frequency cutoffs.
+  The user can select the low- and high-frequency cutoffs. Channels with
+  identical settings share one set of coefficients from a FilterDesignCache.
 
   @see GenericProcessor, FilterEditor
 
@@ -69,7 +70,8 @@ public:
 private:
 
     Array<double> lowCuts, highCuts;
-    OwnedArray<Dsp::Filter> filters;
+    OwnedArray<ChannelFilter> filters;
+    FilterDesignCache designCache;
     Array<bool> shouldFilterChannel;
 
     bool applyOnADC;
@@ -28,4 +28,5 @@ data from external hardware.
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../../Processors/DataThreads/DataThread.h"
+#include "../../Processors/DataThreads/TTLEdgeDetector.h"
 #include "../../Processors/SourceNode/SourceNode.h"
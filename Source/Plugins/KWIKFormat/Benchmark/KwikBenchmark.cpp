@@ -0,0 +1,253 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Writes synthetic TTL events and tetrode spikes through KWEFile and
+    KWXFile, reads them back with the HDF5 library and checks every record.
+    Reports records per second for a range of chunk sizes; the chunk size is
+    also the number of records written at once.
+
+        make benchmark            (in Source/Plugins/KWIKFormat)
+        ./KwikBenchmark [numRecords]
+
+    Files go to the temporary directory and are deleted afterwards.
+*/
+
+#include "../RecordEngine/HDF5FileFormat.h"
+
+#include <H5Cpp.h>
+
+#define NUM_ELECTRODES 4
+#define NUM_CHANNELS 4
+#define WAVEFORM_LENGTH 40
+#define RECORDING_NUMBER 0
+
+namespace
+{
+uint16 sampleValue(int spike, int index)
+{
+    return uint16((spike * 31 + index * 7) & 0xffff);
+}
+
+double secondsSince(int64 start)
+{
+    return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+}
+
+template <typename T>
+bool readDataSet(H5::H5File& file, const String& path, H5::PredType type, HeapBlock<T>& data, hsize_t* dims)
+{
+    try
+    {
+        H5::DataSet dSet = file.openDataSet(path.toUTF8());
+        H5::DataSpace space = dSet.getSpace();
+        const int rank = space.getSimpleExtentDims(dims);
+
+        hsize_t numValues = 1;
+        for (int i = 0; i < rank; i++)
+            numValues *= dims[i];
+
+        data.malloc(size_t(jmax<hsize_t>(1, numValues)));
+        dSet.read(data.getData(), type);
+        return true;
+    }
+    catch (H5::Exception error)
+    {
+        std::cerr << error.getCDetailMsg() << std::endl;
+        return false;
+    }
+}
+
+/** Returns the number of mismatching events */
+int checkEvents(const File& kweFile, int numEvents)
+{
+    H5::H5File file(kweFile.getFullPathName().toUTF8(), H5F_ACC_RDONLY);
+    const String path("/event_types/TTL/events");
+    HeapBlock<uint64> timestamps;
+    HeapBlock<uint16> recordings;
+    HeapBlock<uint8> ids, nodes, channels;
+    hsize_t dims[3];
+
+    if (!readDataSet(file, path + "/time_samples", H5::PredType::NATIVE_UINT64, timestamps, dims) || int(dims[0]) != numEvents
+        || !readDataSet(file, path + "/recording", H5::PredType::NATIVE_UINT16, recordings, dims) || int(dims[0]) != numEvents
+        || !readDataSet(file, path + "/user_data/eventID", H5::PredType::NATIVE_UINT8, ids, dims) || int(dims[0]) != numEvents
+        || !readDataSet(file, path + "/user_data/nodeID", H5::PredType::NATIVE_UINT8, nodes, dims) || int(dims[0]) != numEvents
+        || !readDataSet(file, path + "/user_data/event_channels", H5::PredType::NATIVE_UINT8, channels, dims) || int(dims[0]) != numEvents)
+        return numEvents;
+
+    int errors = 0;
+
+    for (int i = 0; i < numEvents; i++)
+    {
+        if (timestamps[i] != uint64(i) * 10 || recordings[i] != RECORDING_NUMBER
+            || ids[i] != (i & 1) || nodes[i] != 100 || channels[i] != (i % 8))
+            errors++;
+    }
+
+    return errors;
+}
+
+/** Returns the number of mismatching spikes */
+int checkSpikes(const File& kwxFile, int numSpikes)
+{
+    H5::H5File file(kwxFile.getFullPathName().toUTF8(), H5F_ACC_RDONLY);
+    int errors = 0;
+
+    for (int e = 0; e < NUM_ELECTRODES; e++)
+    {
+        const String path("/channel_groups/" + String(e));
+        const int numInGroup = numSpikes / NUM_ELECTRODES + ((e < numSpikes % NUM_ELECTRODES) ? 1 : 0);
+        HeapBlock<int16> waveforms;
+        HeapBlock<uint64> timestamps;
+        HeapBlock<uint16> recordings;
+        hsize_t dims[3];
+
+        if (!readDataSet(file, path + "/waveforms_filtered", H5::PredType::NATIVE_INT16, waveforms, dims)
+            || int(dims[0]) != numInGroup || dims[1] != WAVEFORM_LENGTH || dims[2] != NUM_CHANNELS
+            || !readDataSet(file, path + "/time_samples", H5::PredType::NATIVE_UINT64, timestamps, dims) || int(dims[0]) != numInGroup
+            || !readDataSet(file, path + "/recordings", H5::PredType::NATIVE_UINT16, recordings, dims) || int(dims[0]) != numInGroup)
+        {
+            errors += numInGroup;
+            continue;
+        }
+
+        for (int n = 0; n < numInGroup; n++)
+        {
+            const int spike = n * NUM_ELECTRODES + e;
+            bool ok = timestamps[n] == uint64(spike) * 30 && recordings[n] == RECORDING_NUMBER;
+
+            // stored as spikes x samples x channels, in signed samples
+            for (int s = 0; s < WAVEFORM_LENGTH && ok; s++)
+            {
+                for (int ch = 0; ch < NUM_CHANNELS && ok; ch++)
+                {
+                    const int16 expected = int16(sampleValue(spike, ch * WAVEFORM_LENGTH + s) - 32768);
+                    ok = waveforms[(n * WAVEFORM_LENGTH + s) * NUM_CHANNELS + ch] == expected;
+                }
+            }
+
+            if (!ok)
+                errors++;
+        }
+    }
+
+    return errors;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int numRecords = (argc > 1) ? atoi(argv[1]) : 100000;
+    const int chunkSizes[] = {1, 8, 64, 256, 1024};
+    const File dir(File::getSpecialLocation(File::tempDirectory).getChildFile("KwikBenchmark"));
+    bool allCorrect = true;
+
+    dir.createDirectory();
+    H5::Exception::dontPrint();
+
+    uint16 waveform[NUM_CHANNELS * WAVEFORM_LENGTH];
+    HDF5RecordingInfo info;
+    info.name = "KwikBenchmark";
+    info.start_time = 0;
+    info.start_sample = 0;
+    info.sample_rate = 30000.0f;
+    info.bit_depth = 16;
+    info.multiSample = false;
+
+    printf("%d events, %d spikes of %d channels x %d samples on %d electrodes\n",
+           numRecords, numRecords, NUM_CHANNELS, WAVEFORM_LENGTH, NUM_ELECTRODES);
+
+    for (int n = 0; n < int(sizeof(chunkSizes) / sizeof(chunkSizes[0])); n++)
+    {
+        const int chunkSize = chunkSizes[n];
+        const String basename(dir.getChildFile("chunk" + String(chunkSize)).getFullPathName());
+
+        KWEFile eventFile(basename);
+        eventFile.setChunkSize(chunkSize);
+        eventFile.addEventType("TTL", HDF5FileBase::U8, "event_channels");
+
+        int64 start = Time::getHighResolutionTicks();
+
+        if (eventFile.open())
+        {
+            printf("Can't create %s\n", eventFile.getFileName().toRawUTF8());
+            return 1;
+        }
+
+        eventFile.startNewRecording(RECORDING_NUMBER, &info);
+
+        for (int i = 0; i < numRecords; i++)
+        {
+            uint8 channel = uint8(i % 8);
+            eventFile.writeEvent(0, uint8(i & 1), 100, &channel, uint64(i) * 10);
+        }
+
+        eventFile.stopRecording();
+        eventFile.close();
+        const double eventSeconds = secondsSince(start);
+
+        KWXFile spikeFile(basename);
+        spikeFile.setChunkSize(chunkSize);
+
+        for (int e = 0; e < NUM_ELECTRODES; e++)
+            spikeFile.addChannelGroup(NUM_CHANNELS);
+
+        start = Time::getHighResolutionTicks();
+
+        if (spikeFile.open())
+        {
+            printf("Can't create %s\n", spikeFile.getFileName().toRawUTF8());
+            return 1;
+        }
+
+        spikeFile.startNewRecording(RECORDING_NUMBER);
+
+        for (int i = 0; i < numRecords; i++)
+        {
+            for (int j = 0; j < NUM_CHANNELS * WAVEFORM_LENGTH; j++)
+                waveform[j] = sampleValue(i, j);
+
+            spikeFile.writeSpike(i % NUM_ELECTRODES, WAVEFORM_LENGTH, waveform, uint64(i) * 30);
+        }
+
+        spikeFile.stopRecording();
+        spikeFile.close();
+        const double spikeSeconds = secondsSince(start);
+
+        start = Time::getHighResolutionTicks();
+        const int eventErrors = checkEvents(File(eventFile.getFileName()), numRecords);
+        const int spikeErrors = checkSpikes(File(spikeFile.getFileName()), numRecords);
+        const double readSeconds = secondsSince(start);
+
+        allCorrect = allCorrect && eventErrors == 0 && spikeErrors == 0;
+
+        printf("chunk %4d: %10.0f events/s, %10.0f spikes/s written, read back in %6.3f s, %d bad events, %d bad spikes\n",
+               chunkSize, numRecords / eventSeconds, numRecords / spikeSeconds, readSeconds, eventErrors, spikeErrors);
+    }
+
+    dir.deleteRecursively();
+
+    printf("%s\n", allCorrect ? "All records read back correctly" : "Some records did not read back");
+
+    return allCorrect ? 0 : 1;
+}
@@ -29,19 +29,17 @@
 #endif
 
 #ifndef EVENT_CHUNK_SIZE
-#define EVENT_CHUNK_SIZE 8
+#define EVENT_CHUNK_SIZE 256
 #endif
 
 #ifndef SPIKE_CHUNK_XSIZE
-#define SPIKE_CHUNK_XSIZE 8
+#define SPIKE_CHUNK_XSIZE 64
 #endif
 
 #ifndef SPIKE_CHUNK_YSIZE
 #define SPIKE_CHUNK_YSIZE 40
 #endif
 
-#define MAX_TRANSFORM_SIZE 512
-
 #define MAX_STR_SIZE 256
 
 #define PROCESS_ERROR std::cerr << error.getCDetailMsg() << std::endl; return -1
@@ -629,6 +627,54 @@ void HDF5RecordingData::getRowXPositions(Array<uint32>& rows)
     rows.addArray(rowXPos);
 }
 
+//HDF5RecordBuffer
+
+HDF5RecordBuffer::HDF5RecordBuffer(HDF5RecordingData* data, HDF5FileBase::DataTypes type, int capacity, int ySize, int elementsPerRecord)
+    : dataSet(data), type(type), capacity(jmax(1, capacity)), numRecords(0), ySize(0), recordBytes(0)
+{
+    setRecordShape(ySize, elementsPerRecord);
+}
+
+HDF5RecordBuffer::~HDF5RecordBuffer()
+{
+}
+
+void HDF5RecordBuffer::setRecordShape(int ySize, int elementsPerRecord)
+{
+    flush();
+    this->ySize = ySize;
+    recordBytes = elementsPerRecord * (int) HDF5FileBase::getNativeType(type).getSize();
+    buffer.malloc(capacity * recordBytes);
+}
+
+void* HDF5RecordBuffer::getNextRecord()
+{
+    if (numRecords >= capacity)
+        CHECK_ERROR(flush());
+
+    return buffer + (numRecords++) * recordBytes;
+}
+
+int HDF5RecordBuffer::flush()
+{
+    if (numRecords == 0 || dataSet == nullptr)
+        return 0;
+
+    int res = dataSet->writeDataBlock(numRecords, ySize, type, buffer);
+    numRecords = 0;
+    return res;
+}
+
+int HDF5RecordBuffer::getYSize() const
+{
+    return ySize;
+}
+
+int HDF5RecordBuffer::getRecordBytes() const
+{
+    return recordBytes;
+}
+
 //KWD File
 
 KWDFile::KWDFile(int processorNumber, String basename) : HDF5FileBase()
@@ -714,12 +760,12 @@ void KWDFile::writeRowData(int16* data, int nSamples)
 
 //KWE File
 
-KWEFile::KWEFile(String basename) : HDF5FileBase()
+KWEFile::KWEFile(String basename) : HDF5FileBase(), chunkSize(EVENT_CHUNK_SIZE)
 {
     initFile(basename);
 }
 
-KWEFile::KWEFile() : HDF5FileBase()
+KWEFile::KWEFile() : HDF5FileBase(), chunkSize(EVENT_CHUNK_SIZE)
 {
 
 }
@@ -750,17 +796,17 @@ int KWEFile::createFileStructure()
         if (createGroup(path)) return -1;
         path += "/events";
         if (createGroup(path)) return -1;
-        dSet = createDataSet(U64,0,EVENT_CHUNK_SIZE,path + "/time_samples");
+        dSet = createDataSet(U64,0,chunkSize,path + "/time_samples");
         if (!dSet) return -1;
-        dSet = createDataSet(U16,0,EVENT_CHUNK_SIZE,path + "/recording");
+        dSet = createDataSet(U16,0,chunkSize,path + "/recording");
         if (!dSet) return -1;
         path += "/user_data";
         if (createGroup(path)) return -1;
-        dSet = createDataSet(U8,0,EVENT_CHUNK_SIZE,path + "/eventID");
+        dSet = createDataSet(U8,0,chunkSize,path + "/eventID");
         if (!dSet) return -1;
-        dSet = createDataSet(U8,0,EVENT_CHUNK_SIZE,path + "/nodeID");
+        dSet = createDataSet(U8,0,chunkSize,path + "/nodeID");
         if (!dSet) return -1;
-        dSet = createDataSet(eventTypes[i],0,EVENT_CHUNK_SIZE,path + "/" + eventDataNames[i]);
+        dSet = createDataSet(eventTypes[i],0,chunkSize,path + "/" + eventDataNames[i]);
         if (!dSet) return -1;
     }
     if (setAttribute(U16,(void*)&ver,"/","kwik_version")) return -1;
@@ -805,11 +851,31 @@ void KWEFile::startNewRecording(int recordingNumber, HDF5RecordingInfo* info)
         if (!dSet)
             std::cerr << "Error loading event channel dataset for type " << i << std::endl;
         eventData.add(dSet);
+
+        timeStampBuffers.add(new HDF5RecordBuffer(timeStamps[i],U64,chunkSize));
+        recordingBuffers.add(new HDF5RecordBuffer(recordings[i],I32,chunkSize));
+        eventIDBuffers.add(new HDF5RecordBuffer(eventID[i],U8,chunkSize));
+        nodeIDBuffers.add(new HDF5RecordBuffer(nodeID[i],U8,chunkSize));
+        eventDataBuffers.add(new HDF5RecordBuffer(eventData[i],eventTypes[i],chunkSize));
     }
 }
 
 void KWEFile::stopRecording()
 {
+    for (int i = 0; i < timeStampBuffers.size(); i++)
+    {
+        CHECK_ERROR(timeStampBuffers[i]->flush());
+        CHECK_ERROR(recordingBuffers[i]->flush());
+        CHECK_ERROR(eventIDBuffers[i]->flush());
+        CHECK_ERROR(nodeIDBuffers[i]->flush());
+        CHECK_ERROR(eventDataBuffers[i]->flush());
+    }
+    timeStampBuffers.clear();
+    recordingBuffers.clear();
+    eventIDBuffers.clear();
+    nodeIDBuffers.clear();
+    eventDataBuffers.clear();
+
     timeStamps.clear();
     recordings.clear();
     eventID.clear();
@@ -819,16 +885,31 @@ void KWEFile::stopRecording()
 
 void KWEFile::writeEvent(int type, uint8 id, uint8 processor, void* data, uint64 timestamp)
 {
-    if (type > eventNames.size() || type < 0)
+    if (type >= timeStampBuffers.size() || type < 0)
     {
         std::cerr << "HDF5::writeEvent Invalid event type " << type << std::endl;
         return;
     }
-    CHECK_ERROR(timeStamps[type]->writeDataBlock(1,U64,&timestamp));
-    CHECK_ERROR(recordings[type]->writeDataBlock(1,I32,&recordingNumber));
-    CHECK_ERROR(eventID[type]->writeDataBlock(1,U8,&id));
-    CHECK_ERROR(nodeID[type]->writeDataBlock(1,U8,&processor));
-    CHECK_ERROR(eventData[type]->writeDataBlock(1,eventTypes[type],data));
+    *static_cast<uint64*>(timeStampBuffers[type]->getNextRecord()) = timestamp;
+    *static_cast<int32*>(recordingBuffers[type]->getNextRecord()) = recordingNumber;
+    *static_cast<uint8*>(eventIDBuffers[type]->getNextRecord()) = id;
+    *static_cast<uint8*>(nodeIDBuffers[type]->getNextRecord()) = processor;
+
+    char* dst = static_cast<char*>(eventDataBuffers[type]->getNextRecord());
+    if (eventTypes[type] == STR)
+    {
+        //fixed-size strings: copy up to the terminator and pad with zeros
+        strncpy(dst,static_cast<const char*>(data),MAX_STR_SIZE);
+    }
+    else
+    {
+        memcpy(dst,data,eventDataBuffers[type]->getRecordBytes());
+    }
+}
+
+void KWEFile::setChunkSize(int events)
+{
+    chunkSize = jmax(1,events);
 }
 
 /*void KWEFile::addKwdFile(String filename)
@@ -852,22 +933,19 @@ void KWEFile::addEventType(String name, DataTypes type, String dataName)
 
 //KWX File
 
-KWXFile::KWXFile(String basename) : HDF5FileBase()
+KWXFile::KWXFile(String basename) : HDF5FileBase(), chunkSize(SPIKE_CHUNK_XSIZE)
 {
     initFile(basename);
     numElectrodes=0;
-    transformVector = new int16[MAX_TRANSFORM_SIZE];
 }
 
-KWXFile::KWXFile() : HDF5FileBase()
+KWXFile::KWXFile() : HDF5FileBase(), chunkSize(SPIKE_CHUNK_XSIZE)
 {
     numElectrodes=0;
-    transformVector = new int16[MAX_TRANSFORM_SIZE];
 }
 
 KWXFile::~KWXFile()
 {
-    delete transformVector;
 }
 
 String KWXFile::getFileName()
@@ -907,11 +985,11 @@ int KWXFile::createChannelGroup(int index)
     int nChannels = channelArray[index];
     String path("/channel_groups/"+String(index));
     CHECK_ERROR(createGroup(path));
-    dSet = createDataSet(I16,0,0,nChannels,SPIKE_CHUNK_XSIZE,SPIKE_CHUNK_YSIZE,path+"/waveforms_filtered");
+    dSet = createDataSet(I16,0,0,nChannels,chunkSize,SPIKE_CHUNK_YSIZE,path+"/waveforms_filtered");
     if (!dSet) return -1;
-    dSet = createDataSet(U64,0,SPIKE_CHUNK_XSIZE,path+"/time_samples");
+    dSet = createDataSet(U64,0,chunkSize,path+"/time_samples");
     if (!dSet) return -1;
-    dSet = createDataSet(U16,0,SPIKE_CHUNK_XSIZE,path+"/recordings");
+    dSet = createDataSet(U16,0,chunkSize,path+"/recordings");
     if (!dSet) return -1;
     return 0;
 }
@@ -937,11 +1015,26 @@ void KWXFile::startNewRecording(int recordingNumber)
         if (!dSet)
             std::cerr << "Error loading spike recordings dataset for group " << i << std::endl;
         recordingArray.add(dSet);
+
+        //the waveform length is set by the first spike written
+        spikeBuffers.add(new HDF5RecordBuffer(spikeArray[i],I16,chunkSize,0,0));
+        recordingBuffers.add(new HDF5RecordBuffer(recordingArray[i],I32,chunkSize));
+        timeStampBuffers.add(new HDF5RecordBuffer(timeStamps[i],U64,chunkSize));
     }
 }
 
 void KWXFile::stopRecording()
 {
+    for (int i = 0; i < spikeBuffers.size(); i++)
+    {
+        CHECK_ERROR(spikeBuffers[i]->flush());
+        CHECK_ERROR(recordingBuffers[i]->flush());
+        CHECK_ERROR(timeStampBuffers[i]->flush());
+    }
+    spikeBuffers.clear();
+    recordingBuffers.clear();
+    timeStampBuffers.clear();
+
     spikeArray.clear();
     timeStamps.clear();
     recordingArray.clear();
@@ -961,7 +1054,13 @@ void KWXFile::writeSpike(int groupIndex, int nSamples, const uint16* data, uint6
         return;
     }
     int nChans= channelArray[groupIndex];
-    int16* dst=transformVector;
+    HDF5RecordBuffer* spikeBuffer = spikeBuffers[groupIndex];
+
+    //a batch must share the waveform length, so a change of length writes out what is staged
+    if (spikeBuffer->getYSize() != nSamples)
+        spikeBuffer->setRecordShape(nSamples,nSamples*nChans);
+
+    int16* dst = static_cast<int16*>(spikeBuffer->getNextRecord());
 
     //Given the way we store spike data, we need to transpose it to store in
     //N x NSAMPLES x NCHANNELS as well as convert from u16 to i16
@@ -973,7 +1072,11 @@ void KWXFile::writeSpike(int groupIndex, int nSamples, const uint16* data, uint6
         }
     }
 
-    CHECK_ERROR(spikeArray[groupIndex]->writeDataBlock(1,nSamples,I16,transformVector));
-    CHECK_ERROR(recordingArray[groupIndex]->writeDataBlock(1,I32,&recordingNumber));
-    CHECK_ERROR(timeStamps[groupIndex]->writeDataBlock(1,U64,&timestamp));
+    *static_cast<int32*>(recordingBuffers[groupIndex]->getNextRecord()) = recordingNumber;
+    *static_cast<uint64*>(timeStampBuffers[groupIndex]->getNextRecord()) = timestamp;
+}
+
+void KWXFile::setChunkSize(int spikes)
+{
+    chunkSize = jmax(1,spikes);
 }
@@ -116,6 +116,39 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HDF5RecordingData);
 };
 
+/** Stages records appended to a dataset and writes them in a single call once
+    the buffer is full, instead of extending the dataset one record at a time.
+    Records are written on flush(); the dataset is not owned.
+*/
+class HDF5RecordBuffer
+{
+public:
+    HDF5RecordBuffer(HDF5RecordingData* data, HDF5FileBase::DataTypes type, int capacity, int ySize = 1, int elementsPerRecord = 1);
+    ~HDF5RecordBuffer();
+
+    /** Returns storage for the next record, flushing first if the buffer is full */
+    void* getNextRecord();
+
+    /** Changes the shape of the records. Staged records are flushed first. */
+    void setRecordShape(int ySize, int elementsPerRecord);
+
+    int flush();
+
+    int getYSize() const;
+    int getRecordBytes() const;
+
+private:
+    HDF5RecordingData* dataSet;
+    HDF5FileBase::DataTypes type;
+    HeapBlock<char> buffer;
+    int capacity;
+    int numRecords;
+    int ySize;
+    int recordBytes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HDF5RecordBuffer);
+};
+
 class KWDFile : public HDF5FileBase
 {
 public:
@@ -155,6 +188,8 @@ public:
     void writeEvent(int type, uint8 id, uint8 processor, void* data, uint64 timestamp);
   //  void addKwdFile(String filename);
     void addEventType(String name, DataTypes type, String dataName);
+    /** Sets the chunk size of new event datasets and the number of events written at once */
+    void setChunkSize(int events);
     String getFileName();
 
 protected:
@@ -171,6 +206,12 @@ private:
     Array<String> eventNames;
     Array<DataTypes> eventTypes;
     Array<String> eventDataNames;
+    OwnedArray<HDF5RecordBuffer> timeStampBuffers;
+    OwnedArray<HDF5RecordBuffer> recordingBuffers;
+    OwnedArray<HDF5RecordBuffer> eventIDBuffers;
+    OwnedArray<HDF5RecordBuffer> nodeIDBuffers;
+    OwnedArray<HDF5RecordBuffer> eventDataBuffers;
+    int chunkSize;
     int kwdIndex;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KWEFile);
@@ -188,6 +229,8 @@ public:
     void addChannelGroup(int nChannels);
     void resetChannels();
     void writeSpike(int groupIndex, int nSamples, const uint16* data, uint64 timestamp);
+    /** Sets the chunk size of new spike datasets and the number of spikes written at once */
+    void setChunkSize(int spikes);
     String getFileName();
 
 protected:
@@ -200,9 +243,12 @@ private:
     OwnedArray<HDF5RecordingData> spikeArray;
     OwnedArray<HDF5RecordingData> recordingArray;
     OwnedArray<HDF5RecordingData> timeStamps;
+    OwnedArray<HDF5RecordBuffer> spikeBuffers;
+    OwnedArray<HDF5RecordBuffer> recordingBuffers;
+    OwnedArray<HDF5RecordBuffer> timeStampBuffers;
     Array<int> channelArray;
     int numElectrodes;
-    int16* transformVector;
+    int chunkSize;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KWXFile);
 };
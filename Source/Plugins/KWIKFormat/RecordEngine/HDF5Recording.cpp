@@ -24,7 +24,7 @@
 #include "HDF5Recording.h"
 #define MAX_BUFFER_SIZE 10000
 
-HDF5Recording::HDF5Recording() : processorIndex(-1), hasAcquired(false)
+HDF5Recording::HDF5Recording() : processorIndex(-1), hasAcquired(false), eventChunkSize(256), spikeChunkSize(64)
 {
     //timestamp = 0;
     scaledBuffer = new float[MAX_BUFFER_SIZE];
@@ -215,10 +215,23 @@ void HDF5Recording::startAcquisition()
     eventFile->addEventType("TTL",HDF5FileBase::U8,"event_channels");
     eventFile->addEventType("Messages",HDF5FileBase::STR,"Text");
     spikesFile = new KWXFile();
+    eventFile->setChunkSize(eventChunkSize);
+    spikesFile->setChunkSize(spikeChunkSize);
+}
+
+void HDF5Recording::setParameter(EngineParameter& parameter)
+{
+    intParameter(0, eventChunkSize);
+    intParameter(1, spikeChunkSize);
 }
 
 RecordEngineManager* HDF5Recording::getEngineManager()
 {
     RecordEngineManager* man = new RecordEngineManager("KWIK","Kwik",&(engineFactory<HDF5Recording>));
+    EngineParameter* param;
+    param = new EngineParameter(EngineParameter::INT,0,"Event chunk size (events)",256,1,65536);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT,1,"Spike chunk size (spikes)",64,1,16384);
+    man->addParameter(param);
     return man;
 }
\ No newline at end of file
@@ -32,6 +32,7 @@ class HDF5Recording : public RecordEngine
 public:
     HDF5Recording();
     ~HDF5Recording();
+    void setParameter(EngineParameter& parameter);
     String getEngineID();
     void openFiles(File rootFolder, int experimentNumber, int recordingNumber);
     void closeFiles();
@@ -63,6 +64,9 @@ private:
 
     bool hasAcquired;
 
+    int eventChunkSize;
+    int spikeChunkSize;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HDF5Recording);
 };
 
@@ -0,0 +1,258 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Loopback check of the closed-loop latency measurement, without the GUI
+    or any hardware.
+
+    A writer thread stands in for an acquisition board: it puts 30 kHz
+    samples into a DataBuffer about once per millisecond, alternating
+    between single samples and whole chunks, with a 10 ms TTL pulse every
+    100 ms. The main thread stands in for the SourceNode: it reads blocks of
+    varying size every few milliseconds, so reads don't line up with
+    writes, and sends every rising edge through an OutputDispatcher to a
+    LoopbackOutputDevice, tagged with the arrival time of the block.
+
+    Fails (exit code 1) if
+    - a read returns an arrival time that wasn't stamped by the write of
+      that sample,
+    - the end-to-end histogram is missing pulses,
+    - its median is below the simulated write time, or its 99th percentile
+      is more than a read interval and a safety margin above it.
+
+        make test                 (in the LatencyProbe directory)
+        ./LoopbackLatencyTest [seconds]
+*/
+
+#include "../LoopbackOutputDevice.h"
+#include "../../../Processors/DataThreads/DataBuffer.h"
+
+#include <random>
+
+#define NUM_CHANNELS 8
+#define SAMPLE_RATE 30000.0
+#define PULSE_PERIOD 3000
+#define PULSE_WIDTH 300
+#define WRITE_TIME_US 250
+#define READ_INTERVAL_MS 10
+#define MARGIN_MS 10.0
+
+namespace
+{
+/** Paced writer, like LoopbackThread but alternating single samples and chunks */
+class WriterThread : public Thread
+{
+public:
+    explicit WriterThread(DataBuffer& b)
+        : Thread("Loopback writer"), buffer(b), chunk(NUM_CHANNELS, 1000),
+          timestamps(1000), eventCodes(1000), samplesWritten(0)
+    {
+    }
+
+    void run()
+    {
+        const int64 startTicks = Time::getHighResolutionTicks();
+        float sample[NUM_CHANNELS] = {0};
+        bool singleSamples = true;
+
+        while (! threadShouldExit())
+        {
+            const double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+            const int numDue = jmin(1000, int(int64(elapsed * SAMPLE_RATE) - samplesWritten));
+
+            for (int i = 0; i < numDue; i++)
+            {
+                const int64 n = samplesWritten + i;
+
+                for (int chan = 0; chan < NUM_CHANNELS; chan++)
+                    chunk.setSample(chan, i, float(chan));
+
+                timestamps[i] = n;
+                eventCodes[i] = ((n % PULSE_PERIOD) < PULSE_WIDTH) ? 1 : 0;
+            }
+
+            if (singleSamples)
+            {
+                for (int i = 0; i < numDue; i++)
+                {
+                    for (int chan = 0; chan < NUM_CHANNELS; chan++)
+                        sample[chan] = chunk.getSample(chan, i);
+
+                    buffer.addToBuffer(sample, &timestamps[i], &eventCodes[i], 1);
+                }
+            }
+            else if (numDue > 0)
+            {
+                buffer.addBlockToBuffer(chunk, timestamps, eventCodes, numDue);
+            }
+
+            samplesWritten += numDue;
+            singleSamples = ! singleSamples;
+
+            wait(1);
+        }
+    }
+
+private:
+    DataBuffer& buffer;
+    AudioSampleBuffer chunk;
+    HeapBlock<int64> timestamps;
+    HeapBlock<uint64> eventCodes;
+    int64 samplesWritten;
+};
+
+/** A multi-item addToBuffer must stamp every slot, wherever a read starts */
+bool checkMultiItemStamps()
+{
+    DataBuffer buffer(1, 16);
+    AudioSampleBuffer data(1, 16);
+    float sample[1] = {0};
+    int64 timestamp = 0;
+    uint64 eventCode = 0;
+    bool ok = true;
+
+    // wrap around the end of the ring so both regions get written
+    for (int round = 0; round < 4; round++)
+    {
+        const int64 before = Time::getHighResolutionTicks();
+        buffer.addToBuffer(sample, &timestamp, &eventCode, 5);
+        const int64 after = Time::getHighResolutionTicks();
+
+        for (int read = 0; read < 5; read++)
+        {
+            uint64 ts, codes[16];
+            int64 arrival = 0;
+            buffer.readAllFromBuffer(data, &ts, codes, 1, &arrival);
+
+            if (arrival < before || arrival > after)
+                ok = false;
+        }
+    }
+
+    return ok;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+    bool ok = true;
+
+    if (! checkMultiItemStamps())
+    {
+        printf("FAIL: a multi-sample write left slots without an arrival time\n");
+        ok = false;
+    }
+
+    DataBuffer buffer(NUM_CHANNELS, 10000);
+    LoopbackOutputDevice device;
+    device.writeTimeUs = WRITE_TIME_US;
+
+    OutputDispatcher dispatcher("Loopback test", &device);
+    dispatcher.resetLatencyStats();
+    dispatcher.start();
+
+    WriterThread writer(buffer);
+    writer.startThread(8);
+
+    AudioSampleBuffer block(NUM_CHANNELS, 1024);
+    HeapBlock<uint64> eventCodes(1024);
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> blockSizes(400, 1024);
+
+    int numPulses = 0, numReads = 0, numBadStamps = 0;
+    uint64 lastCode = 0;
+    int64 lastArrival = 0;
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    while (Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) < seconds)
+    {
+        Thread::sleep(READ_INTERVAL_MS);
+
+        uint64 timestamp;
+        int64 arrival = 0;
+        const int numRead = buffer.readAllFromBuffer(block, &timestamp, eventCodes, blockSizes(generator), &arrival);
+        const int64 now = Time::getHighResolutionTicks();
+
+        if (numRead == 0)
+            continue;
+
+        numReads++;
+
+        // stamps only move forward, and the oldest sample can't be older than a
+        // buffer's worth of data
+        if (arrival < lastArrival || arrival > now
+            || now - arrival > Time::secondsToHighResolutionTicks(10000 / SAMPLE_RATE))
+            numBadStamps++;
+
+        lastArrival = arrival;
+
+        for (int i = 0; i < numRead; i++)
+        {
+            if ((eventCodes[i] & 1) && ! (lastCode & 1))
+            {
+                dispatcher.addCommand(0, 1, 0.0, arrival);
+                numPulses++;
+            }
+
+            lastCode = eventCodes[i];
+        }
+    }
+
+    writer.stopThread(1000);
+    dispatcher.stop();
+
+    const LatencyHistogram histogram = dispatcher.getEndToEndLatency();
+    const double writeTimeMs = WRITE_TIME_US / 1000.0;
+
+    printf("%d reads, %d pulses; end-to-end latency %s\n", numReads, numPulses,
+           histogram.getSummary().toRawUTF8());
+
+    if (numBadStamps > 0)
+    {
+        printf("FAIL: %d reads returned an arrival time that wasn't stamped for them\n", numBadStamps);
+        ok = false;
+    }
+
+    if (numPulses == 0 || histogram.getCount() != numPulses)
+    {
+        printf("FAIL: %d pulses detected, %d in the histogram\n", numPulses, histogram.getCount());
+        ok = false;
+    }
+
+    if (histogram.getPercentile(50) < writeTimeMs)
+    {
+        printf("FAIL: median below the %.2f ms write time\n", writeTimeMs);
+        ok = false;
+    }
+
+    if (histogram.getPercentile(99) > writeTimeMs + READ_INTERVAL_MS + MARGIN_MS)
+    {
+        printf("FAIL: 99th percentile above %.2f ms\n", writeTimeMs + READ_INTERVAL_MS + MARGIN_MS);
+        ok = false;
+    }
+
+    printf(ok ? "PASS\n" : "FAIL\n");
+
+    return ok ? 0 : 1;
+}
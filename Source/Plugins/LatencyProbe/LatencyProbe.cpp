@@ -0,0 +1,118 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyProbe.h"
+
+LatencyProbe::LatencyProbe()
+    : GenericProcessor("Latency Probe"), ttlChannel(0)
+{
+    Array<var> channelNumbers;
+    for (int i = 1; i <= 8; i++)
+        channelNumbers.add(i);
+
+    parameters.add(Parameter("TTL channel", channelNumbers, 0, 0));
+
+    Array<var> writeTimes;
+    writeTimes.add(0);
+    writeTimes.add(100);
+    writeTimes.add(250);
+    writeTimes.add(1000);
+
+    parameters.add(Parameter("Write time (us)", writeTimes, 0, 1));
+
+    dispatcher = new OutputDispatcher("Latency Probe", &outputDevice);
+}
+
+LatencyProbe::~LatencyProbe()
+{
+    dispatcher = nullptr;
+}
+
+void LatencyProbe::setParameter(int parameterIndex, float newValue)
+{
+    editor->updateParameterButtons(parameterIndex);
+
+    if (parameterIndex == 0)
+    {
+        ttlChannel = int(newValue) - 1;
+    }
+    else if (parameterIndex == 1)
+    {
+        outputDevice.writeTimeUs = int(newValue);
+    }
+}
+
+void LatencyProbe::handleEvent(int eventType, MidiMessage& event, int sampleNum)
+{
+    if (eventType == TTL)
+    {
+        const uint8* dataptr = event.getRawData();
+
+        int eventId = *(dataptr+2);
+        int eventChannel = *(dataptr+3);
+
+        if (eventId == 1 && eventChannel == ttlChannel)
+            dispatcher->addCommand(eventChannel, 1, 0.0, getEventAcquisitionTicks(event));
+    }
+}
+
+bool LatencyProbe::enable()
+{
+    dispatcher->resetLatencyStats();
+    dispatcher->start();
+    return true;
+}
+
+bool LatencyProbe::disable()
+{
+    dispatcher->stop();
+
+    LatencyHistogram histogram = dispatcher->getEndToEndLatency();
+
+    std::cout << "Latency probe: " << dispatcher->getLatencyReport() << std::endl;
+
+    for (int i = 0; i <= histogram.getNumBins(); i++)
+    {
+        if (histogram.getBinCount(i) > 0)
+        {
+            if (i < histogram.getNumBins())
+                std::cout << "  " << i * histogram.getBinWidth() << "-" << (i + 1) * histogram.getBinWidth() << " ms: ";
+            else
+                std::cout << "  >" << i * histogram.getBinWidth() << " ms: ";
+
+            std::cout << histogram.getBinCount(i) << std::endl;
+        }
+    }
+
+    return true;
+}
+
+LatencyHistogram LatencyProbe::getLatencyHistogram() const
+{
+    return dispatcher->getEndToEndLatency();
+}
+
+void LatencyProbe::process(AudioSampleBuffer& buffer, MidiBuffer& events)
+{
+    checkForEvents(events);
+}
@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __LATENCYPROBE_H__
+#define __LATENCYPROBE_H__
+
+#include <ProcessorHeaders.h>
+#include "LoopbackOutputDevice.h"
+
+/**
+
+  Measures closed-loop latency.
+
+  Every rising edge on the selected TTL channel is sent through an
+  OutputDispatcher to a simulated output device. The time from the
+  acquisition of the data that produced the edge to the completed write is
+  collected in a histogram, which is printed when acquisition stops.
+
+  Placed after detectors (e.g. a phase or spike detector), it reports the
+  latency of the whole chain; with the Loopback source it runs without any
+  hardware.
+
+  @see LoopbackThread, OutputDispatcher, LatencyHistogram
+
+*/
+
+class LatencyProbe : public GenericProcessor
+{
+public:
+    LatencyProbe();
+    ~LatencyProbe();
+
+    void process(AudioSampleBuffer& buffer, MidiBuffer& events);
+    void setParameter(int parameterIndex, float newValue);
+
+    void handleEvent(int eventType, MidiMessage& event, int sampleNum);
+
+    bool enable();
+    bool disable();
+
+    bool isSink()
+    {
+        return true;
+    }
+
+    /** Latencies collected during the last acquisition */
+    LatencyHistogram getLatencyHistogram() const;
+
+private:
+    int ttlChannel;
+
+    LoopbackOutputDevice outputDevice;
+    ScopedPointer<OutputDispatcher> dispatcher;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyProbe);
+};
+
+#endif  // __LATENCYPROBE_H__
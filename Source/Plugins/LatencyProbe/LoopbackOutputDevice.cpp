@@ -0,0 +1,36 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LoopbackOutputDevice.h"
+
+void LoopbackOutputDevice::sendCommands(const OutputCommand* commands, int numCommands)
+{
+    int us = writeTimeUs.get();
+
+    if (us <= 0)
+        return;
+
+    // busy-wait, since sleeping would add the scheduler's granularity
+    int64 end = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks(us / 1.0e6);
+    while (Time::getHighResolutionTicks() < end) {}
+}
@@ -0,0 +1,49 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __LOOPBACKOUTPUTDEVICE_H__
+#define __LOOPBACKOUTPUTDEVICE_H__
+
+#include <SerialLib.h>
+
+/**
+
+  Simulated output device. Each batch of commands takes a fixed time to
+  "write", standing in for the serial transfer of a real stimulator.
+
+  @see LatencyProbe
+
+*/
+
+class LoopbackOutputDevice : public OutputDevice
+{
+public:
+    LoopbackOutputDevice() : writeTimeUs(0) {}
+
+    void sendCommands(const OutputCommand* commands, int numCommands);
+
+    /** Simulated duration of a write, in microseconds */
+    Atomic<int> writeTimeUs;
+};
+
+#endif  // __LOOPBACKOUTPUTDEVICE_H__
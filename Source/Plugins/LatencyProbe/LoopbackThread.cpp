@@ -0,0 +1,120 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LoopbackThread.h"
+
+#define NUM_CHANNELS 8
+#define NUM_EVENT_CHANNELS 8
+#define SAMPLE_RATE 30000.0f
+
+// one 10 ms pulse on event channel 1 every 100 ms
+#define PULSE_PERIOD 3000
+#define PULSE_WIDTH 300
+
+// samples are handed over roughly once per millisecond, like USB acquisition boards
+#define CHUNK_INTERVAL 1
+
+LoopbackThread::LoopbackThread(SourceNode* sn)
+    : DataThread(sn), startTicks(0), samplesGenerated(0)
+{
+    dataBuffer = new DataBuffer(NUM_CHANNELS, 10000);
+    sample.calloc(NUM_CHANNELS);
+
+    eventCode = 0;
+}
+
+LoopbackThread::~LoopbackThread()
+{
+}
+
+bool LoopbackThread::foundInputSource()
+{
+    return true;
+}
+
+int LoopbackThread::getNumHeadstageOutputs()
+{
+    return NUM_CHANNELS;
+}
+
+int LoopbackThread::getNumEventChannels()
+{
+    return NUM_EVENT_CHANNELS;
+}
+
+float LoopbackThread::getSampleRate()
+{
+    return SAMPLE_RATE;
+}
+
+float LoopbackThread::getBitVolts(Channel* chan)
+{
+    return 0.195f;
+}
+
+bool LoopbackThread::startAcquisition()
+{
+    dataBuffer->clear();
+
+    timestamp = 0;
+    samplesGenerated = 0;
+    startTicks = Time::getHighResolutionTicks();
+
+    startThread();
+    return true;
+}
+
+bool LoopbackThread::stopAcquisition()
+{
+    if (isThreadRunning())
+    {
+        signalThreadShouldExit();
+    }
+
+    return true;
+}
+
+bool LoopbackThread::updateBuffer()
+{
+    double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+    int64 target = int64(elapsed * SAMPLE_RATE);
+
+    while (samplesGenerated < target)
+    {
+        double t = samplesGenerated / SAMPLE_RATE;
+
+        for (int chan = 0; chan < NUM_CHANNELS; chan++)
+            sample[chan] = 50.0f * (float) std::sin(2.0 * double_Pi * (10.0 * (chan + 1)) * t);
+
+        eventCode = ((samplesGenerated % PULSE_PERIOD) < PULSE_WIDTH) ? 1 : 0;
+
+        dataBuffer->addToBuffer(sample, &timestamp, &eventCode, 1);
+
+        timestamp++;
+        samplesGenerated++;
+    }
+
+    wait(CHUNK_INTERVAL);
+
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __LOOPBACKTHREAD_H__
+#define __LOOPBACKTHREAD_H__
+
+#include <DataThreadHeaders.h>
+
+/**
+
+  Simulated data source for closed-loop latency measurements.
+
+  Generates sine waves on every continuous channel and a periodic TTL pulse
+  on the first event channel, paced by the wall clock and delivered in small
+  chunks like a hardware source. Used together with a LatencyProbe, it
+  measures the end-to-end latency of a signal chain without any hardware.
+
+  @see LatencyProbe
+
+*/
+
+class LoopbackThread : public DataThread
+{
+public:
+    LoopbackThread(SourceNode* sn);
+    ~LoopbackThread();
+
+    bool updateBuffer();
+
+    bool foundInputSource();
+    bool startAcquisition();
+    bool stopAcquisition();
+
+    int getNumHeadstageOutputs();
+    int getNumEventChannels();
+    float getSampleRate();
+    float getBitVolts(Channel* chan);
+
+private:
+    int64 startTicks;
+    int64 samplesGenerated;
+
+    HeapBlock<float> sample;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopbackThread);
+};
+
+#endif  // __LOOPBACKTHREAD_H__
@@ -0,0 +1,307 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2013 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "LfpBitmapRenderer.h"
+#include "LfpDisplayCanvas.h"
+
+#define MAX_RENDER_THREADS 8
+
+// vertical runs longer than these are thinned out, as in the component painter
+#define THIN_RUN 200
+#define SPARSE_RUN 400
+
+LfpRasterJob::LfpRasterJob(LfpBitmapRenderer* r, int b)
+    : ThreadPoolJob("LFP raster band"), renderer(r), band(b)
+{
+}
+
+ThreadPoolJob::JobStatus LfpRasterJob::runJob()
+{
+    renderer->renderBand(band);
+    return jobHasFinished;
+}
+
+LfpBitmapRenderer::LfpBitmapRenderer(LfpDisplayCanvas* c, LfpDisplay* d)
+    : canvas(c), display(d), bandHeight(0), eventValues(nullptr), dataOffset(0),
+      numDataColumns(0), cursorColumn(-1), lastCursorColumn(-1)
+{
+    int numThreads = jlimit(1, MAX_RENDER_THREADS, SystemStats::getNumCpus() - 1);
+
+    if (numThreads > 1)
+        pool = new ThreadPool(numThreads);
+
+    for (int i = 0; i < numThreads; i++)
+        jobs.add(new LfpRasterJob(this, i));
+
+    for (int i = 0; i < 8; i++)
+        eventEnabled[i] = false;
+}
+
+LfpBitmapRenderer::~LfpBitmapRenderer()
+{
+    if (pool != nullptr)
+        pool->removeAllJobs(true, 1000);
+}
+
+void LfpBitmapRenderer::addDirtyColumns(int start, int end)
+{
+    start = jmax(0, start);
+    end = jmin(image.getWidth(), end);
+
+    if (start < end)
+        dirtyColumns.add(Range<int>(start, end));
+}
+
+void LfpBitmapRenderer::render(const Rectangle<int>& visibleArea, bool fullRedraw, RectangleList<int>& dirtyArea)
+{
+    if (visibleArea.isEmpty())
+        return;
+
+    if (imageArea != visibleArea || !image.isValid())
+    {
+        image = Image(Image::ARGB, visibleArea.getWidth(), visibleArea.getHeight(), false, SoftwareImageType());
+        imageArea = visibleArea;
+        columnBackground.malloc(imageArea.getWidth());
+        fullRedraw = true;
+    }
+
+    const int leftmargin = LfpDisplayCanvas::leftmargin;
+    const int numChans = display->channels.size();
+
+    dataOffset = imageArea.getX() - leftmargin;
+    numDataColumns = jmin(canvas->getScreenBufferSize(), display->getWidth() - leftmargin);
+
+    // background and timing grid, matching LfpDisplayCanvas::paint
+    PixelARGB background = Colour(0,18,43).getPixelARGB();
+    PixelARGB grid = Colour(25,25,60).getPixelARGB();
+
+    int w = display->getWidth() - leftmargin;
+
+    for (int x = 0; x < imageArea.getWidth(); x++)
+        columnBackground[x] = background;
+
+    for (int i = 0; i < 10; i++)
+    {
+        int gx = w/10*i + leftmargin - imageArea.getX();
+        int halfWidth = (i == 0 || i == 5) ? 1 : 0;
+
+        for (int x = gx - halfWidth; x <= gx + halfWidth; x++)
+        {
+            if (x >= 0 && x < imageArea.getWidth())
+                columnBackground[x] = grid;
+        }
+    }
+
+    // channel geometry, read on the message thread so the workers never touch components
+    traces.clearQuick();
+    dirtyColumns.clearQuick();
+
+    int minIndex = INT_MAX;
+    int maxIndex = -1;
+
+    for (int i = 0; i < numChans; i++)
+    {
+        LfpChannelDisplay* chan = display->channels[i];
+
+        int top = chan->getY() - imageArea.getY();
+        int bottom = top + chan->getHeight();
+
+        if (bottom <= 0 || top >= imageArea.getHeight())
+            continue;
+
+        TraceInfo t;
+        t.top = top;
+        t.bottom = bottom;
+        t.center = top + chan->getHeight()/2;
+        t.stripTop = t.center - chan->getChannelHeight()/2;
+        t.stripBottom = t.center + chan->getChannelHeight()/2;
+        t.scale = chan->getVerticalScale();
+        t.colour = chan->getColour().getPixelARGB();
+        t.enabled = chan->getEnabledState();
+        t.minValues = canvas->getScreenBufferMinPointer(i);
+        t.maxValues = canvas->getScreenBufferMaxPointer(i);
+        traces.add(t);
+
+        minIndex = jmin(minIndex, canvas->lastScreenBufferIndex[i]);
+        maxIndex = jmax(maxIndex, canvas->screenBufferIndex[i]);
+    }
+
+    // the extra channel of the screen buffer holds the event bits
+    eventValues = canvas->getScreenBufferEventPointer();
+
+    for (int i = 0; i < 8; i++)
+    {
+        eventEnabled[i] = display->getEventDisplayState(i);
+        eventColours[i] = display->channelColours[i*2].withAlpha(0.35f).getPixelARGB();
+    }
+
+    cursorColumn = (maxIndex >= 0) ? maxIndex + 1 - dataOffset : -1;
+
+    if (fullRedraw)
+    {
+        addDirtyColumns(0, imageArea.getWidth());
+    }
+    else if (maxIndex >= 0)
+    {
+        // a little before the update, so the new columns join the old ones,
+        // up to and including the cursor
+        addDirtyColumns(minIndex - 2 - dataOffset, maxIndex + 2 - dataOffset);
+
+        // erase the cursor left behind when the sweep wraps around
+        if (lastCursorColumn >= 0 && (lastCursorColumn < minIndex - 2 - dataOffset || lastCursorColumn >= maxIndex + 2 - dataOffset))
+            addDirtyColumns(lastCursorColumn, lastCursorColumn + 1);
+    }
+
+    lastCursorColumn = cursorColumn;
+
+    if (dirtyColumns.size() == 0)
+        return;
+
+    bitmap = new Image::BitmapData(image, Image::BitmapData::readWrite);
+    bandHeight = (imageArea.getHeight() + jobs.size() - 1) / jobs.size();
+
+    if (pool == nullptr)
+    {
+        renderBand(0);
+    }
+    else
+    {
+        for (int i = 0; i < jobs.size(); i++)
+            pool->addJob(jobs[i], false);
+
+        for (int i = 0; i < jobs.size(); i++)
+            pool->waitForJobToFinish(jobs[i], -1);
+    }
+
+    bitmap = nullptr;
+
+    for (int i = 0; i < dirtyColumns.size(); i++)
+    {
+        dirtyArea.add(Rectangle<int>(imageArea.getX() + dirtyColumns[i].getStart(), imageArea.getY(),
+                                     dirtyColumns[i].getLength(), imageArea.getHeight()));
+    }
+}
+
+void LfpBitmapRenderer::renderBand(int band)
+{
+    const int y0 = band * bandHeight;
+    const int y1 = jmin(imageArea.getHeight(), y0 + bandHeight);
+
+    if (y0 >= y1)
+        return;
+
+    const PixelARGB midline = Colour(40,40,40).getPixelARGB();
+    const PixelARGB cursor = Colour(Colours::yellow).getPixelARGB();
+
+    for (int r = 0; r < dirtyColumns.size(); r++)
+    {
+        const int xStart = dirtyColumns.getReference(r).getStart();
+        const int xEnd = dirtyColumns.getReference(r).getEnd();
+
+        for (int y = y0; y < y1; y++)
+        {
+            PixelARGB* line = (PixelARGB*) bitmap->getLinePointer(y);
+
+            for (int x = xStart; x < xEnd; x++)
+                line[x] = columnBackground[x];
+        }
+
+        for (int c = 0; c < traces.size(); c++)
+        {
+            const TraceInfo& t = traces.getReference(c);
+
+            const int clipTop = jmax(y0, t.top);
+            const int clipBottom = jmin(y1, t.bottom);
+
+            if (clipTop >= clipBottom)
+                continue;
+
+            if (cursorColumn >= xStart && cursorColumn < xEnd)
+            {
+                for (int y = clipTop; y < clipBottom; y++)
+                    *((PixelARGB*) bitmap->getPixelPointer(cursorColumn, y)) = cursor;
+            }
+
+            if (!t.enabled)
+                continue;
+
+            const int eventTop = jmax(clipTop, t.stripTop);
+            const int eventBottom = jmin(clipBottom, t.stripBottom + 1);
+
+            for (int x = xStart; x < xEnd; x++)
+            {
+                const int i = x + dataOffset;
+
+                if (i < 0 || i >= numDataColumns)
+                    continue;
+
+                if (t.center >= clipTop && t.center < clipBottom)
+                    *((PixelARGB*) bitmap->getPixelPointer(x, t.center)) = midline;
+
+                // event markers: one bit per event channel
+                const int eventBits = (int) eventValues[i];
+
+                if (eventBits != 0)
+                {
+                    for (int ev = 0; ev < 8; ev++)
+                    {
+                        if (eventEnabled[ev] && (eventBits & (1 << ev)))
+                        {
+                            for (int y = eventTop; y < eventBottom; y++)
+                                ((PixelARGB*) bitmap->getPixelPointer(x, y))->blend(eventColours[ev]);
+                        }
+                    }
+                }
+
+                // vertical run between the min and max of the column
+                int a = int(t.maxValues[i] * t.scale) + t.center;
+                int b = int(t.minValues[i] * t.scale) + t.center;
+                int from = jmin(a, b);
+                int to = jmax(a, b);
+
+                if (to - from < SPARSE_RUN)
+                {
+                    const int step = (to - from < THIN_RUN) ? 1 : 2;
+
+                    for (int y = jmax(from, clipTop); y <= to && y < clipBottom; y++)
+                    {
+                        if (step == 1 || ((y - from) & 1) == 0)
+                            *((PixelARGB*) bitmap->getPixelPointer(x, y)) = t.colour;
+                    }
+                }
+                else
+                {
+                    if (from >= clipTop && from < clipBottom)
+                        *((PixelARGB*) bitmap->getPixelPointer(x, from)) = t.colour;
+                    if (to >= clipTop && to < clipBottom)
+                        *((PixelARGB*) bitmap->getPixelPointer(x, to)) = t.colour;
+                }
+            }
+        }
+    }
+}
+
+void LfpBitmapRenderer::paint(Graphics& g)
+{
+    if (image.isValid())
+        g.drawImageAt(image, imageArea.getX(), imageArea.getY());
+}
@@ -0,0 +1,132 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2013 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef __LFPBITMAPRENDERER_H__
+#define __LFPBITMAPRENDERER_H__
+
+#include <VisualizerWindowHeaders.h>
+
+class LfpDisplayCanvas;
+class LfpDisplay;
+class LfpBitmapRenderer;
+
+/**
+
+  Rasterizes one horizontal band of the LFP display.
+
+  @see LfpBitmapRenderer
+
+*/
+
+class LfpRasterJob : public ThreadPoolJob
+{
+public:
+    LfpRasterJob(LfpBitmapRenderer* renderer, int band);
+
+    JobStatus runJob();
+
+private:
+    LfpBitmapRenderer* renderer;
+    int band;
+};
+
+/**
+
+  Draws the min/max traces of all visible channels straight into an image.
+
+  The visible part of the LfpDisplay is rasterized into a software image,
+  one column per screen buffer value. Only the columns that changed since
+  the last refresh are redrawn, and the image is split into horizontal bands
+  that are rendered in parallel on a thread pool. Each band clips every
+  channel to its own rows, so overlapping traces never race.
+
+  Used for the default (pixel-wise) draw method; the anti-aliased line method
+  is still painted by the LfpChannelDisplay components.
+
+  @see LfpDisplay, LfpDisplayCanvas
+
+*/
+
+class LfpBitmapRenderer
+{
+public:
+    LfpBitmapRenderer(LfpDisplayCanvas* canvas, LfpDisplay* display);
+    ~LfpBitmapRenderer();
+
+    /** Rasterizes the columns that changed since the last call, or the whole
+        visible area if fullRedraw is set or the visible area has moved. The
+        areas that need repainting are added to dirtyArea, in display coordinates. */
+    void render(const Rectangle<int>& visibleArea, bool fullRedraw, RectangleList<int>& dirtyArea);
+
+    /** Draws the rasterized image onto the display */
+    void paint(Graphics& g);
+
+    /** Renders one band of the image; called by the raster jobs */
+    void renderBand(int band);
+
+private:
+
+    /** Drawing parameters of one channel, in image coordinates */
+    struct TraceInfo
+    {
+        int top;        // component extent, used for clipping
+        int bottom;
+        int stripTop;   // extent of the channel's own strip, for event markers
+        int stripBottom;
+        int center;
+        float scale;    // pixels per unit, negative unless inverted
+        PixelARGB colour;
+        bool enabled;
+        const float* minValues;
+        const float* maxValues;
+    };
+
+    void addDirtyColumns(int start, int end);
+
+    LfpDisplayCanvas* canvas;
+    LfpDisplay* display;
+
+    Image image;
+    Rectangle<int> imageArea;
+    ScopedPointer<Image::BitmapData> bitmap;
+
+    ScopedPointer<ThreadPool> pool;
+    OwnedArray<LfpRasterJob> jobs;
+    int bandHeight;
+
+    Array<TraceInfo> traces;
+    Array<Range<int> > dirtyColumns;
+    HeapBlock<PixelARGB> columnBackground;
+
+    const float* eventValues;
+    PixelARGB eventColours[8];
+    bool eventEnabled[8];
+
+    int dataOffset;      // data column = image column + dataOffset
+    int numDataColumns;
+    int cursorColumn;    // image column of the sweep cursor, or -1
+    int lastCursorColumn;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LfpBitmapRenderer);
+};
+
+#endif  // __LFPBITMAPRENDERER_H__
@@ -833,6 +833,26 @@ const float LfpDisplayCanvas::getYCoordMax(int chan, int samp)
     return *screenBufferMax->getReadPointer(chan, samp);
 }
 
+const float* LfpDisplayCanvas::getScreenBufferMinPointer(int chan)
+{
+    return screenBufferMin->getReadPointer(chan);
+}
+
+const float* LfpDisplayCanvas::getScreenBufferMaxPointer(int chan)
+{
+    return screenBufferMax->getReadPointer(chan);
+}
+
+const float* LfpDisplayCanvas::getScreenBufferEventPointer()
+{
+    return screenBuffer->getReadPointer(nChans);
+}
+
+int LfpDisplayCanvas::getScreenBufferSize()
+{
+    return screenBuffer->getNumSamples();
+}
+
 
 bool LfpDisplayCanvas::getInputInvertedState()
 {
@@ -1136,7 +1156,7 @@ void LfpTimescale::setTimebase(float t)
 // ---------------------------------------------------------------
 
 LfpDisplay::LfpDisplay(LfpDisplayCanvas* c, Viewport* v) :
-    singleChan(-1), canvas(c), viewport(v)
+    singleChan(-1), canvas(c), viewport(v), drawMethod(false)
 {
     totalHeight = 0;
     colorGrouping=1;
@@ -1173,10 +1193,13 @@ LfpDisplay::LfpDisplay(LfpDisplayCanvas* c, Viewport* v) :
 
     isPaused=false;
 
+    renderer = new LfpBitmapRenderer(c, this);
+
 }
 
 LfpDisplay::~LfpDisplay()
 {
+    renderer = nullptr;
     deleteAllChildren();
 }
 
@@ -1309,12 +1332,25 @@ void LfpDisplay::resized()
 
 void LfpDisplay::paint(Graphics& g)
 {
-
+    if (!drawMethod)
+        renderer->paint(g);
 }
 
 void LfpDisplay::refresh()
 {
 
+    if (!drawMethod)
+    {
+        // pixel-wise drawing: rasterize the changed columns of all channels at once
+        RectangleList<int> dirtyArea;
+        renderer->render(viewport->getViewArea(), canvas->fullredraw, dirtyArea);
+
+        for (int i = 0; i < dirtyArea.getNumRectangles(); i++)
+            repaint(dirtyArea.getRectangle(i));
+
+        canvas->fullredraw = false;
+        return;
+    }
 
     int topBorder = viewport->getViewPositionY();
     int bottomBorder = viewport->getViewHeight() + topBorder;
@@ -1414,6 +1450,8 @@ void LfpDisplay::setInputInverted(bool isInverted)
 
 void LfpDisplay::setDrawMethod(bool isDrawMethod)
 {
+    drawMethod = isDrawMethod;
+
     for (int i = 0; i < numChans; i++)
     {
         channels[i]->setDrawMethod(isDrawMethod);
@@ -1677,8 +1715,11 @@ void LfpChannelDisplay::paint(Graphics& g)
 
     //g.fillAll(Colours::grey);
 
-    g.setColour(Colours::yellow);   // draw most recent drawn sample position
-    g.drawLine(canvas->screenBufferIndex[chan]+1, 0, canvas->screenBufferIndex[chan]+1, getHeight());
+    if (drawMethod)
+    {
+        g.setColour(Colours::yellow);   // draw most recent drawn sample position
+        g.drawLine(canvas->screenBufferIndex[chan]+1, 0, canvas->screenBufferIndex[chan]+1, getHeight());
+    }
 
 
     //g.setColour(Colours::red); // draw oldest drawn sample position
@@ -1740,12 +1781,14 @@ void LfpChannelDisplay::paint(Graphics& g)
         }
 
 
+        // traces drawn pixel-wise are rasterized by the LfpBitmapRenderer of the display
+        if (!drawMethod)
+            return;
+
         g.setColour(Colour(40,40,40));
         g.drawLine(0, getHeight()/2, getWidth(), getHeight()/2);
 
         int stepSize = 1;
-        int from = 0; // for vertical line drawing in the LFP data
-        int to = 0;
 
         //for (int i = 0; i < getWidth()-stepSize; i += stepSize) // redraw entire display
         int ifrom = canvas->lastScreenBufferIndex[chan] - 3; // need to start drawing a bit before the actual redraw windowfor the interpolated line to join correctly
@@ -1788,63 +1831,11 @@ void LfpChannelDisplay::paint(Graphics& g)
             //std::cout << "e " << canvas->getYCoord(canvas->getNumChannels()-1, i) << std::endl;
             g.setColour(lineColour);
 
-            if (drawMethod) // switched between to line drawing and pixel wise drawing
-            {
-
-                // drawLine makes for ok anti-aliased plots, but is pretty slow
-                g.drawLine(i,
-                           (canvas->getYCoord(chan, i)/range*channelHeightFloat)+getHeight()/2,
-                           i+stepSize,
-                           (canvas->getYCoord(chan, i+stepSize)/range*channelHeightFloat)+getHeight()/2);
-
-
-            }
-            else
-            {
-
-                // // pixel wise line plot has no anti-aliasing, but runs much faster
-                double a = (canvas->getYCoordMax(chan, i)/range*channelHeightFloat)+getHeight()/2;
-                double b = (canvas->getYCoordMin(chan, i)/range*channelHeightFloat)+getHeight()/2;
-                //double m = (canvas->getYCoordMean(chan, i)/range*channelHeightFloat)+getHeight()/2;
-                if (a<b)
-                {
-                    from = (a);
-                    to = (b);
-                }
-                else
-                {
-                    from = (b);
-                    to = (a);
-                }
-
-                //g.setColour(lineColour.withMultipliedBrightness( 1+(((((float)(to-from)*range)/getHeight())-0.01)*2)  )); // make spikes etc slightly brighter
-
-
-                if ((to-from) < 200)  // if there is too much vertical range in one pixel, don't draw the full line for speed reasons
-                {
-                    for (int j = from; j <= to; j += 1)
-                    {
-                        g.setPixel(i,j);
-                    }
-                }
-                else if ((to-from) < 400)
-                {
-                    for (int j = from; j <= to; j += 2)
-                    {
-                        g.setPixel(i,j);
-                    }
-                }
-                else
-                {
-                    g.setPixel(i,to);
-                    g.setPixel(i,from);
-                }
-
-                //draw mean
-                //g.setColour(Colours::black);
-                //g.setPixel(i,m);
-
-            }
+            // drawLine makes for ok anti-aliased plots, but is pretty slow
+            g.drawLine(i,
+                       (canvas->getYCoord(chan, i)/range*channelHeightFloat)+getHeight()/2,
+                       i+stepSize,
+                       (canvas->getYCoord(chan, i+stepSize)/range*channelHeightFloat)+getHeight()/2);
 
         }
     }
@@ -1965,6 +1956,16 @@ void LfpChannelDisplay::setDrawMethod(bool isDrawMethod)
 }
 
 
+float LfpChannelDisplay::getVerticalScale()
+{
+    return channelHeightFloat / range;
+}
+
+Colour LfpChannelDisplay::getColour()
+{
+    return lineColour;
+}
+
 void LfpChannelDisplay::setName(String name_)
 {
     name = name_;
@@ -25,6 +25,7 @@
 
 #include <VisualizerWindowHeaders.h>
 #include "LfpDisplayNode.h"
+#include "LfpBitmapRenderer.h"
 
 #define CHANNEL_TYPES 3
 
@@ -86,6 +87,16 @@ public:
     const float getYCoordMean(int chan, int samp);
     const float getYCoordMax(int chan, int samp);
 
+    /** Per-pixel minima and maxima of a channel, for the bitmap renderer */
+    const float* getScreenBufferMinPointer(int chan);
+    const float* getScreenBufferMaxPointer(int chan);
+
+    /** Per-pixel event bits (the extra channel of the screen buffer) */
+    const float* getScreenBufferEventPointer();
+
+    /** Number of pixel columns held by the screen buffers */
+    int getScreenBufferSize();
+
     Array<int> screenBufferIndex;
     Array<int> lastScreenBufferIndex;
 
@@ -277,6 +288,8 @@ private:
 
     float range[3];
 
+    bool drawMethod;
+    ScopedPointer<LfpBitmapRenderer> renderer;
 
 };
 
@@ -311,6 +324,10 @@ public:
 
     void setDrawMethod(bool);
 
+    /** Pixels per unit of the trace; negative unless the input is inverted */
+    float getVerticalScale();
+    Colour getColour();
+
     PopupMenu getOptions();
     void changeParameter(const int id);
 
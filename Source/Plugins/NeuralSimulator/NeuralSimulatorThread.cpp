@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "NeuralSimulatorThread.h"
+
+#define NUM_CHANNELS 1024
+#define NUM_EVENT_CHANNELS 8
+#define SAMPLE_RATE 30000.0f
+#define RANDOM_SEED 1
+
+// samples are generated and handed over in blocks of this size
+#define BLOCK_SIZE 256
+
+NeuralSimulatorThread::NeuralSimulatorThread(SourceNode* sn)
+    : DataThread(sn), block(NUM_CHANNELS, BLOCK_SIZE),
+      startTicks(0), generationTicks(0), numDropped(0)
+{
+    dataBuffer = new DataBuffer(NUM_CHANNELS, 10000);
+
+    timestamps.malloc(BLOCK_SIZE);
+    eventCodes.malloc(BLOCK_SIZE);
+
+    synthesizer = new NeuralSynthesizer(NUM_CHANNELS, NUM_EVENT_CHANNELS, SAMPLE_RATE, RANDOM_SEED);
+    synthesizer->addRandomUnits(3, 1.0f, 20.0f);
+
+    // 10 ms trial marker every second, 1 ms stimulus every 100 ms,
+    // and square-wave clocks of increasing period on the remaining lines
+    synthesizer->setTtlPattern(0, 30000, 300, 0);
+    synthesizer->setTtlPattern(1, 3000, 30, 150);
+
+    for (int line = 2; line < NUM_EVENT_CHANNELS; line++)
+        synthesizer->setTtlPattern(line, 1000 << line, 500 << line, 0);
+
+    std::cout << "Neural simulator: " << synthesizer->getNumUnits() << " units on "
+              << NUM_CHANNELS << " channels." << std::endl;
+
+    eventCode = 0;
+}
+
+NeuralSimulatorThread::~NeuralSimulatorThread()
+{
+}
+
+bool NeuralSimulatorThread::foundInputSource()
+{
+    return true;
+}
+
+int NeuralSimulatorThread::getNumHeadstageOutputs()
+{
+    return NUM_CHANNELS;
+}
+
+int NeuralSimulatorThread::getNumEventChannels()
+{
+    return NUM_EVENT_CHANNELS;
+}
+
+float NeuralSimulatorThread::getSampleRate()
+{
+    return SAMPLE_RATE;
+}
+
+float NeuralSimulatorThread::getBitVolts(Channel* chan)
+{
+    return 0.195f;
+}
+
+bool NeuralSimulatorThread::startAcquisition()
+{
+    dataBuffer->clear();
+    synthesizer->reset();
+
+    timestamp = 0;
+    generationTicks = 0;
+    numDropped = 0;
+    startTicks = Time::getHighResolutionTicks();
+
+    startThread();
+    return true;
+}
+
+bool NeuralSimulatorThread::stopAcquisition()
+{
+    if (isThreadRunning())
+    {
+        signalThreadShouldExit();
+    }
+
+    // cost of the synthesis itself, to tell generator load apart from the load of the signal chain
+    double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+    double busy = Time::highResolutionTicksToSeconds(generationTicks);
+
+    if (elapsed > 0)
+    {
+        std::cout << "Neural simulator: generated " << synthesizer->getNumSamplesGenerated()
+                  << " samples per channel, synthesis used " << 100.0 * busy / elapsed
+                  << "% of real time, " << numDropped << " samples dropped." << std::endl;
+    }
+
+    return true;
+}
+
+bool NeuralSimulatorThread::updateBuffer()
+{
+    double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+    int64 target = int64(elapsed * SAMPLE_RATE);
+
+    while (synthesizer->getNumSamplesGenerated() + BLOCK_SIZE <= target)
+    {
+        int64 start = Time::getHighResolutionTicks();
+        synthesizer->generate(block, eventCodes, BLOCK_SIZE);
+        generationTicks += Time::getHighResolutionTicks() - start;
+
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            timestamps[i] = timestamp + i;
+
+        numDropped += BLOCK_SIZE - dataBuffer->addBlockToBuffer(block, timestamps, eventCodes, BLOCK_SIZE);
+
+        timestamp += BLOCK_SIZE;
+    }
+
+    wait(1);
+
+    return true;
+}
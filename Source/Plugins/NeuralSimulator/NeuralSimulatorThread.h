@@ -0,0 +1,75 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __NEURALSIMULATORTHREAD_H__
+#define __NEURALSIMULATORTHREAD_H__
+
+#include <DataThreadHeaders.h>
+#include "NeuralSynthesizer.h"
+
+/**
+
+  Synthetic data source for load testing.
+
+  Streams 1024 channels of simulated extracellular data at 30 kHz, with
+  spiking units, background LFP and TTL patterns on the event channels,
+  paced by the wall clock like a hardware source. The output is seeded, so
+  every run produces exactly the same samples and benchmarks of a signal
+  chain can be repeated without hardware.
+
+  @see NeuralSynthesizer
+
+*/
+
+class NeuralSimulatorThread : public DataThread
+{
+public:
+    NeuralSimulatorThread(SourceNode* sn);
+    ~NeuralSimulatorThread();
+
+    bool updateBuffer();
+
+    bool foundInputSource();
+    bool startAcquisition();
+    bool stopAcquisition();
+
+    int getNumHeadstageOutputs();
+    int getNumEventChannels();
+    float getSampleRate();
+    float getBitVolts(Channel* chan);
+
+private:
+    ScopedPointer<NeuralSynthesizer> synthesizer;
+
+    AudioSampleBuffer block;
+    HeapBlock<int64> timestamps;
+    HeapBlock<uint64> eventCodes;
+
+    int64 startTicks;
+    int64 generationTicks;
+    int numDropped;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NeuralSimulatorThread);
+};
+
+#endif  // __NEURALSIMULATORTHREAD_H__
@@ -0,0 +1,337 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "NeuralSynthesizer.h"
+
+// absolute refractory period of the simulated units
+#define REFRACTORY_MS 2.0
+
+// length of the default spike templates
+#define TEMPLATE_MS 1.6
+
+// brings the output of the pink noise filter back to roughly unit amplitude
+#define PINK_GAIN 0.11f
+
+NeuralSynthesizer::NeuralSynthesizer(int numChannels_, int numTtlLines_, float sampleRate_, uint32 seed_)
+    : numChannels(numChannels_), numTtlLines(numTtlLines_), sampleRate(sampleRate_), seed(seed_),
+      noiseAmplitude(0), oscillationFrequency(0), oscillationAmplitude(0),
+      samplesGenerated(0), oscillationSize(0)
+{
+    noiseChannels.calloc(numChannels);
+
+    TtlPattern off = {0, 0, 0};
+    for (int line = 0; line < numTtlLines; line++)
+        ttlPatterns.add(off);
+
+    createDefaultTemplates();
+    setLfp(20.0f, 8.0f, 40.0f);
+    reset();
+}
+
+NeuralSynthesizer::~NeuralSynthesizer()
+{
+}
+
+void NeuralSynthesizer::RandomStream::seed(uint32 s)
+{
+    // xorshift gets stuck at zero
+    state = (s != 0) ? s : 0x9E3779B9;
+}
+
+uint32 NeuralSynthesizer::streamSeed(uint32 stream) const
+{
+    // splitmix64 finalizer, so neighbouring streams are uncorrelated
+    uint64 z = ((uint64(seed) << 32) | stream) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return uint32(z);
+}
+
+void NeuralSynthesizer::createDefaultTemplates()
+{
+    // trough followed by a slower after-hyperpolarization: narrow, broad and
+    // strongly biphasic units. Widths and delays in milliseconds.
+    const double params[3][4] =
+    {
+        {0.12, 0.35, 0.35, 0.30},
+        {0.18, 0.25, 0.50, 0.45},
+        {0.15, 0.60, 0.30, 0.20}
+    };
+
+    int length = int(TEMPLATE_MS * sampleRate / 1000.0);
+    HeapBlock<float> shape(length);
+
+    for (int t = 0; t < 3; t++)
+    {
+        float peak = 0;
+
+        for (int i = 0; i < length; i++)
+        {
+            double ms = i * 1000.0 / sampleRate - 0.5;
+            double trough = (ms / params[t][0]);
+            double rebound = (ms - params[t][2]) / params[t][3];
+            shape[i] = float(-std::exp(-trough*trough) + params[t][1] * std::exp(-rebound*rebound));
+            peak = jmax(peak, std::abs(shape[i]));
+        }
+
+        FloatVectorOperations::multiply(shape, 1.0f / peak, length);
+        setTemplate(t, shape, length);
+    }
+}
+
+void NeuralSynthesizer::setTemplate(int index, const float* shape, int length)
+{
+    SpikeTemplate* t = new SpikeTemplate();
+    t->shape.malloc(length);
+    t->length = length;
+    FloatVectorOperations::copy(t->shape, shape, length);
+
+    if (index < templates.size())
+        templates.set(index, t);
+    else
+        templates.add(t);
+}
+
+int NeuralSynthesizer::getNumTemplates() const
+{
+    return templates.size();
+}
+
+void NeuralSynthesizer::addUnit(int channel, int templateIndex, float amplitude, float rate)
+{
+    if (channel < 0 || channel >= numChannels || templateIndex < 0 || templateIndex >= templates.size())
+        return;
+
+    Unit unit;
+    unit.channel = channel;
+    unit.templateIndex = templateIndex;
+    unit.amplitude = amplitude;
+    unit.rate = rate;
+    unit.random.seed(streamSeed(0x80000000 + units.size()));
+    unit.lastSpike = -1;
+    unit.nextSpike = samplesGenerated + drawInterval(unit);
+
+    units.add(unit);
+}
+
+void NeuralSynthesizer::addRandomUnits(int maxUnitsPerChannel, float minRate, float maxRate)
+{
+    RandomStream random;
+    random.seed(streamSeed(0x7FFFFFFF));
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        int numUnits = random.next() % (maxUnitsPerChannel + 1);
+
+        for (int n = 0; n < numUnits; n++)
+        {
+            int templateIndex = random.next() % templates.size();
+            float amplitude = 40.0f + 160.0f * random.nextFloat();
+            float rate = minRate + (maxRate - minRate) * random.nextFloat();
+
+            addUnit(chan, templateIndex, amplitude, rate);
+        }
+    }
+}
+
+void NeuralSynthesizer::clearUnits()
+{
+    units.clear();
+}
+
+int NeuralSynthesizer::getNumUnits() const
+{
+    return units.size();
+}
+
+void NeuralSynthesizer::setLfp(float noise, float frequency, float amplitude)
+{
+    noiseAmplitude = noise;
+    oscillationFrequency = frequency;
+    oscillationAmplitude = amplitude;
+
+    // the oscillation reverses polarity halfway down the probe, like a current dipole
+    for (int chan = 0; chan < numChannels; chan++)
+        noiseChannels[chan].oscillationGain = amplitude * (float) std::cos(double_Pi * chan / numChannels);
+}
+
+void NeuralSynthesizer::setTtlPattern(int line, int period, int width, int offset)
+{
+    if (line < 0 || line >= numTtlLines)
+        return;
+
+    TtlPattern pattern = {period, width, offset};
+    ttlPatterns.set(line, pattern);
+}
+
+void NeuralSynthesizer::reset()
+{
+    samplesGenerated = 0;
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        noiseChannels[chan].random.seed(streamSeed(chan));
+        for (int k = 0; k < 7; k++)
+            noiseChannels[chan].b[k] = 0;
+    }
+
+    for (int i = 0; i < units.size(); i++)
+    {
+        Unit& unit = units.getReference(i);
+        unit.random.seed(streamSeed(0x80000000 + i));
+        unit.lastSpike = -1;
+        unit.nextSpike = drawInterval(unit);
+    }
+}
+
+int64 NeuralSynthesizer::getNumSamplesGenerated() const
+{
+    return samplesGenerated;
+}
+
+int64 NeuralSynthesizer::drawInterval(Unit& unit)
+{
+    int refractory = jmax(int(REFRACTORY_MS * sampleRate / 1000.0), templates[unit.templateIndex]->length);
+
+    if (unit.rate <= 0)
+        return std::numeric_limits<int64>::max() / 2;
+
+    // exponential inter-spike interval after the refractory period
+    double u = unit.random.nextFloat();
+    return refractory + int64(-std::log(1.0 - u) * sampleRate / unit.rate);
+}
+
+void NeuralSynthesizer::generate(AudioSampleBuffer& block, uint64* eventCodes, int numSamples)
+{
+    jassert(block.getNumChannels() >= numChannels && block.getNumSamples() >= numSamples);
+
+    if (oscillationSize < numSamples)
+    {
+        oscillation.realloc(numSamples);
+        oscillationSize = numSamples;
+    }
+
+    // shared oscillation, restarted from the exact phase at every block so it never drifts
+    double w = 2.0 * double_Pi * oscillationFrequency / sampleRate;
+    double cycles = samplesGenerated * (double) oscillationFrequency / sampleRate;
+    double phase = 2.0 * double_Pi * (cycles - std::floor(cycles));
+    double k = 2.0 * std::cos(w);
+    double s0 = std::sin(phase - w);
+    double s1 = std::sin(phase);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        oscillation[i] = (float) s1;
+        double s2 = k * s1 - s0;
+        s0 = s1;
+        s1 = s2;
+    }
+
+    for (int chan = 0; chan < numChannels; chan++)
+        generateBackground(block.getWritePointer(chan), noiseChannels[chan], numSamples);
+
+    for (int i = 0; i < units.size(); i++)
+        addSpikes(block, units.getReference(i), numSamples);
+
+    for (int i = 0; i < numSamples; i++)
+        eventCodes[i] = 0;
+
+    for (int line = 0; line < numTtlLines; line++)
+    {
+        const TtlPattern& p = ttlPatterns.getReference(line);
+
+        if (p.period <= 0)
+            continue;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            int64 t = samplesGenerated + i - p.offset;
+
+            if (t >= 0 && t % p.period < p.width)
+                eventCodes[i] |= (uint64(1) << line);
+        }
+    }
+
+    samplesGenerated += numSamples;
+}
+
+void NeuralSynthesizer::generateBackground(float* dest, NoiseChannel& channel, int numSamples)
+{
+    // Paul Kellet's pink noise filter, kept in registers for the whole block
+    RandomStream random = channel.random;
+    float b0 = channel.b[0], b1 = channel.b[1], b2 = channel.b[2], b3 = channel.b[3];
+    float b4 = channel.b[4], b5 = channel.b[5], b6 = channel.b[6];
+    const float gain = noiseAmplitude * PINK_GAIN;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        float white = 2.0f * random.nextFloat() - 1.0f;
+
+        b0 = 0.99886f * b0 + white * 0.0555179f;
+        b1 = 0.99332f * b1 + white * 0.0750759f;
+        b2 = 0.96900f * b2 + white * 0.1538520f;
+        b3 = 0.86650f * b3 + white * 0.3104856f;
+        b4 = 0.55000f * b4 + white * 0.5329522f;
+        b5 = -0.7616f * b5 - white * 0.0168980f;
+
+        dest[i] = gain * (b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f);
+        b6 = white * 0.115926f;
+    }
+
+    channel.random = random;
+    channel.b[0] = b0; channel.b[1] = b1; channel.b[2] = b2; channel.b[3] = b3;
+    channel.b[4] = b4; channel.b[5] = b5; channel.b[6] = b6;
+
+    FloatVectorOperations::addWithMultiply(dest, oscillation, channel.oscillationGain, numSamples);
+}
+
+void NeuralSynthesizer::addSpikes(AudioSampleBuffer& block, Unit& unit, int numSamples)
+{
+    const SpikeTemplate& t = *templates[unit.templateIndex];
+    float* dest = block.getWritePointer(unit.channel);
+    int64 blockEnd = samplesGenerated + numSamples;
+
+    // tail of a spike that started in an earlier block
+    if (unit.lastSpike >= 0)
+        addSpike(dest, unit.lastSpike, t, unit.amplitude, numSamples);
+
+    while (unit.nextSpike < blockEnd)
+    {
+        addSpike(dest, unit.nextSpike, t, unit.amplitude, numSamples);
+        unit.lastSpike = unit.nextSpike;
+        unit.nextSpike += drawInterval(unit);
+    }
+}
+
+void NeuralSynthesizer::addSpike(float* dest, int64 spikeStart, const SpikeTemplate& t, float amplitude, int numSamples)
+{
+    int64 from = jmax(spikeStart, samplesGenerated);
+    int64 to = jmin(spikeStart + t.length, samplesGenerated + numSamples);
+
+    if (to > from)
+        FloatVectorOperations::addWithMultiply(dest + (from - samplesGenerated),
+                                               t.shape + (from - spikeStart),
+                                               amplitude,
+                                               int(to - from));
+}
@@ -0,0 +1,170 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __NEURALSYNTHESIZER_H__
+#define __NEURALSYNTHESIZER_H__
+
+#include <DataThreadHeaders.h>
+
+/**
+
+  Deterministic generator of synthetic extracellular recordings.
+
+  Every channel gets approximately 1/f background noise, a slow oscillation
+  whose amplitude and polarity change along the probe, and the spikes of a
+  few simulated units. Each unit fires as a Poisson process with a
+  refractory period and adds a scaled copy of its template to its channel.
+  TTL lines carry periodic pulse trains.
+
+  Data is generated channel by channel over whole blocks: the shared
+  oscillation is computed once per block and mixed in with vector
+  operations, and spike templates are added with vector operations too.
+  Every channel and every unit draws from its own random stream seeded from
+  a single seed, so the output depends only on the seed, never on the block
+  sizes used to generate it.
+
+  @see NeuralSimulatorThread
+
+*/
+
+class NeuralSynthesizer
+{
+public:
+    NeuralSynthesizer(int numChannels, int numTtlLines, float sampleRate, uint32 seed);
+    ~NeuralSynthesizer();
+
+    /** Replaces (or adds) a spike template. The shape should have a peak
+        magnitude of 1; units scale it by their amplitude. */
+    void setTemplate(int index, const float* shape, int length);
+
+    int getNumTemplates() const;
+
+    /** Adds a unit to a channel. Amplitude is in microvolts, rate in Hz. */
+    void addUnit(int channel, int templateIndex, float amplitude, float rate);
+
+    /** Adds up to maxUnitsPerChannel units to every channel, with templates,
+        amplitudes and rates drawn from the seed. */
+    void addRandomUnits(int maxUnitsPerChannel, float minRate, float maxRate);
+
+    void clearUnits();
+
+    int getNumUnits() const;
+
+    /** Sets the background: noise amplitude, and frequency and amplitude of the
+        oscillation, all amplitudes in microvolts. */
+    void setLfp(float noiseAmplitude, float oscillationFrequency, float oscillationAmplitude);
+
+    /** Makes a TTL line high for 'width' samples every 'period' samples,
+        starting at sample 'offset'. A period of 0 keeps the line low. */
+    void setTtlPattern(int line, int period, int width, int offset);
+
+    /** Rewinds every random stream and the sample counter to the start. */
+    void reset();
+
+    /** Writes the next numSamples samples of every channel to the first
+        numSamples samples of block, and the TTL word of each sample to
+        eventCodes. */
+    void generate(AudioSampleBuffer& block, uint64* eventCodes, int numSamples);
+
+    int64 getNumSamplesGenerated() const;
+
+private:
+
+    /** xorshift32 random stream */
+    struct RandomStream
+    {
+        void seed(uint32 s);
+        inline uint32 next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+        /** Uniform in [0, 1) */
+        inline float nextFloat() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+        uint32 state;
+    };
+
+    struct SpikeTemplate
+    {
+        HeapBlock<float> shape;
+        int length;
+    };
+
+    struct NoiseChannel
+    {
+        RandomStream random;
+        float b[7];
+        float oscillationGain;
+    };
+
+    struct Unit
+    {
+        int channel;
+        int templateIndex;
+        float amplitude;
+        float rate;
+        RandomStream random;
+        int64 lastSpike;
+        int64 nextSpike;
+    };
+
+    struct TtlPattern
+    {
+        int period;
+        int width;
+        int offset;
+    };
+
+    void generateBackground(float* dest, NoiseChannel& channel, int numSamples);
+    void addSpikes(AudioSampleBuffer& block, Unit& unit, int numSamples);
+    void addSpike(float* dest, int64 spikeStart, const SpikeTemplate& t, float amplitude, int numSamples);
+    int64 drawInterval(Unit& unit);
+    uint32 streamSeed(uint32 stream) const;
+    void createDefaultTemplates();
+
+    int numChannels;
+    int numTtlLines;
+    float sampleRate;
+    uint32 seed;
+
+    float noiseAmplitude;
+    float oscillationFrequency;
+    float oscillationAmplitude;
+
+    int64 samplesGenerated;
+
+    OwnedArray<SpikeTemplate> templates;
+    HeapBlock<NoiseChannel> noiseChannels;
+    Array<Unit> units;
+    Array<TtlPattern> ttlPatterns;
+
+    HeapBlock<float> oscillation;
+    int oscillationSize;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NeuralSynthesizer);
+};
+
+#endif  // __NEURALSYNTHESIZER_H__
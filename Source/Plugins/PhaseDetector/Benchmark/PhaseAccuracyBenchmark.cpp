@@ -0,0 +1,208 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Measures how close the PhaseEstimatorBank triggers to its target phase.
+
+    A synthetic oscillation, optionally with noise, frequency drift and
+    amplitude modulation, is run through one estimator per target angle,
+    with the targets spread over the cycle. At each trigger the true phase
+    of the oscillation is compared with the target. The first seconds are
+    skipped while the filters settle.
+
+    Noise is white noise through a one-pole low-pass at 20 Hz, so that most
+    of it falls near the band; the SNR is the ratio of the RMS of the
+    oscillation to that of the noise.
+
+        make benchmark            (in the PhaseDetector directory)
+        ./PhaseAccuracyBenchmark [seconds]
+
+    Errors are true phase minus target, in degrees: positive means late.
+*/
+
+#include "../PhaseEstimator.h"
+
+#include <random>
+
+#define SAMPLE_RATE 30000.0
+#define BLOCK_SIZE 1024
+#define NUM_TARGETS 8
+#define SETTLING_SECONDS 5.0
+
+namespace
+{
+struct TestCase
+{
+    const char* name;
+    double frequency;
+    float lowCut, highCut;
+    double drift;       // peak relative frequency deviation, over a 20 s period
+    double modulation;  // peak relative amplitude deviation, over a 7 s period
+    double snr;         // 0 for no noise
+};
+
+struct Accuracy
+{
+    int numTriggers;
+    double meanError[NUM_TARGETS];
+    double sdError[NUM_TARGETS];
+};
+
+double wrapDegrees(double degrees)
+{
+    while (degrees > 180.0)
+        degrees -= 360.0;
+    while (degrees <= -180.0)
+        degrees += 360.0;
+    return degrees;
+}
+
+Accuracy run(const TestCase& test, double seconds)
+{
+    Array<float> lowCuts, highCuts;
+
+    for (int k = 0; k < NUM_TARGETS; k++)
+    {
+        lowCuts.add(test.lowCut);
+        highCuts.add(test.highCut);
+    }
+
+    PhaseEstimatorBank bank;
+    bank.prepare(SAMPLE_RATE, lowCuts, highCuts);
+
+    for (int k = 0; k < NUM_TARGETS; k++)
+        bank.setTargetPhase(k, 360.0f * k / NUM_TARGETS);
+
+    std::mt19937 generator(1);
+    std::normal_distribution<double> gaussian(0.0, 1.0);
+
+    // the noise low-pass loses most of the white noise's power; scale it back
+    const double noiseCoefficient = 1.0 - std::exp(-2.0 * double_Pi * 20.0 / SAMPLE_RATE);
+    const double noiseGain = std::sqrt((2.0 - noiseCoefficient) / noiseCoefficient);
+    const double noiseLevel = (test.snr > 0) ? std::sqrt(0.5) / test.snr : 0.0;
+    double noise = 0;
+
+    HeapBlock<float> signal(BLOCK_SIZE);
+    HeapBlock<double> truePhase(BLOCK_SIZE);
+    HeapBlock<const float*> inputs(NUM_TARGETS);
+    Array<PhaseEstimatorBank::Trigger> triggers;
+
+    for (int k = 0; k < NUM_TARGETS; k++)
+        inputs[k] = signal;
+
+    double sum[NUM_TARGETS] = {0}, sumSquares[NUM_TARGETS] = {0};
+    int count[NUM_TARGETS] = {0};
+    double phase = 0;
+
+    const int64 numSamples = int64(seconds * SAMPLE_RATE);
+    const int64 settlingSamples = int64(SETTLING_SECONDS * SAMPLE_RATE);
+
+    for (int64 start = 0; start < numSamples; start += BLOCK_SIZE)
+    {
+        for (int i = 0; i < BLOCK_SIZE; i++)
+        {
+            const double t = double(start + i) / SAMPLE_RATE;
+            const double f = test.frequency * (1.0 + test.drift * std::sin(2.0 * double_Pi * t / 20.0));
+            const double amplitude = 1.0 + test.modulation * std::sin(2.0 * double_Pi * t / 7.0);
+
+            noise += noiseCoefficient * (gaussian(generator) - noise);
+
+            // cosine convention, as the estimator's: phase 0 is a peak
+            truePhase[i] = phase;
+            signal[i] = float(amplitude * std::cos(phase) + noiseLevel * noiseGain * noise);
+
+            phase += 2.0 * double_Pi * f / SAMPLE_RATE;
+
+            if (phase >= 2.0 * double_Pi)
+                phase -= 2.0 * double_Pi;
+        }
+
+        triggers.clearQuick();
+        bank.process(inputs, BLOCK_SIZE, triggers);
+
+        if (start < settlingSamples)
+            continue;
+
+        for (int n = 0; n < triggers.size(); n++)
+        {
+            const int k = triggers[n].estimator;
+            const double error = wrapDegrees(truePhase[triggers[n].sampleOffset] * 180.0 / double_Pi
+                                             - 360.0 * k / NUM_TARGETS);
+            sum[k] += error;
+            sumSquares[k] += error * error;
+            count[k]++;
+        }
+    }
+
+    Accuracy result;
+    result.numTriggers = 0;
+
+    for (int k = 0; k < NUM_TARGETS; k++)
+    {
+        const int n = jmax(1, count[k]);
+        result.meanError[k] = sum[k] / n;
+        result.sdError[k] = std::sqrt(jmax(0.0, sumSquares[k] / n - result.meanError[k] * result.meanError[k]));
+        result.numTriggers += count[k];
+    }
+
+    std::cout << test.name << ": decimation " << bank.getDecimationFactor() << ", "
+              << bank.getHilbertLength() << " taps, " << bank.getGroupDelayMs() << " ms group delay" << std::endl;
+
+    return result;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 120.0;
+
+    const TestCase tests[] =
+    {
+        {"6 Hz, band 4-8, clean", 6.0, 4.0f, 8.0f, 0.0, 0.0, 0.0},
+        {"6 Hz, band 4-8, SNR 3", 6.0, 4.0f, 8.0f, 0.0, 0.0, 3.0},
+        {"6 Hz, band 4-8, 15% drift, 50% AM, SNR 3", 6.0, 4.0f, 8.0f, 0.15, 0.5, 3.0},
+        {"40 Hz, band 30-50, 10% drift, SNR 3", 40.0, 30.0f, 50.0f, 0.10, 0.0, 3.0}
+    };
+
+    printf("%.0f s at %.0f Hz, first %.0f s skipped\n", seconds, SAMPLE_RATE, SETTLING_SECONDS);
+
+    for (int n = 0; n < int(sizeof(tests) / sizeof(tests[0])); n++)
+    {
+        const Accuracy result = run(tests[n], seconds);
+
+        printf("  target   mean    SD   (degrees, %d triggers)\n", result.numTriggers);
+
+        double worstMean = 0, meanSd = 0;
+
+        for (int k = 0; k < NUM_TARGETS; k++)
+        {
+            printf("  %6.0f %6.1f %5.1f\n", 360.0 * k / NUM_TARGETS, result.meanError[k], result.sdError[k]);
+            worstMean = jmax(worstMean, std::abs(result.meanError[k]));
+            meanSd += result.sdError[k] / NUM_TARGETS;
+        }
+
+        printf("  largest |mean| %.1f, average SD %.1f\n\n", worstMean, meanSd);
+    }
+
+    return 0;
+}
@@ -27,10 +27,12 @@
 
 PhaseDetector::PhaseDetector()
     : GenericProcessor("Phase Detector"), activeModule(-1),
-      risingPos(false), risingNeg(false), fallingPos(false), fallingNeg(false)
+      risingPos(false), risingNeg(false), fallingPos(false), fallingNeg(false),
+      publishedEstimators(nullptr), estimators(nullptr)
 
 {
-
+    triggers.ensureStorageAllocated(64);
+    pulseLength = 1000;
 }
 
 PhaseDetector::~PhaseDetector()
@@ -59,6 +61,9 @@ void PhaseDetector::addModule()
     m.samplesSinceTrigger = 5000;
     m.wasTriggered = false;
     m.phase = NO_PHASE;
+    m.targetPhase = -1.0f;
+    m.lowCut = 4.0f;
+    m.highCut = 8.0f;
 
     modules.add(m);
 }
@@ -104,6 +109,7 @@ void PhaseDetector::setParameter(int parameterIndex, float newValue)
     else if (parameterIndex == 2)   // inputChan
     {
         module.inputChan = (int) newValue;
+        updateEstimators();
     }
     else if (parameterIndex == 3)   // outputChan
     {
@@ -121,6 +127,21 @@ void PhaseDetector::setParameter(int parameterIndex, float newValue)
             module.isActive = false;
         }
     }
+    else if (parameterIndex == 5)   // target phase, in degrees
+    {
+        module.targetPhase = newValue;
+        updateEstimators();
+    }
+    else if (parameterIndex == 6)   // low cut
+    {
+        module.lowCut = newValue;
+        updateEstimators();
+    }
+    else if (parameterIndex == 7)   // high cut
+    {
+        module.highCut = newValue;
+        updateEstimators();
+    }
 
 }
 
@@ -131,9 +152,142 @@ void PhaseDetector::updateSettings()
 
 bool PhaseDetector::enable()
 {
+    // the input may have been decimated
+    pulseLength = jmax(1, roundToInt(getSampleRate() / 30.0f));
+
+    // the audio thread isn't running yet, so the old sets can go;
+    // start from a freshly reset bank
+    estimators = nullptr;
+    estimatorSets.clear();
+    updateEstimators();
+    estimators = publishedEstimators.get();
+
+    const PhaseEstimatorBank& bank = estimators->bank;
+
+    if (bank.getNumEstimators() > 0)
+    {
+        std::cout << "Phase detector: " << bank.getNumEstimators() << " phase estimators, decimation "
+                  << bank.getDecimationFactor() << ", " << bank.getHilbertLength()
+                  << "-tap Hilbert transformer, " << bank.getGroupDelayMs()
+                  << " ms group delay compensated" << std::endl;
+    }
+
     return true;
 }
 
+bool PhaseDetector::EstimatorSet::hasSameBands(const EstimatorSet& other) const
+{
+    return modules == other.modules && lowCuts == other.lowCuts && highCuts == other.highCuts;
+}
+
+void PhaseDetector::updateEstimators()
+{
+    EstimatorSet* set = new EstimatorSet();
+
+    for (int i = 0; i < modules.size(); i++)
+    {
+        const DetectorModule& module = modules.getReference(i);
+
+        if (module.targetPhase >= 0 && module.inputChan >= 0 && module.lowCut > 0 && module.highCut > module.lowCut)
+        {
+            set->moduleEstimators.add(set->modules.size());
+            set->modules.add(i);
+            set->lowCuts.add(module.lowCut);
+            set->highCuts.add(module.highCut);
+        }
+        else
+        {
+            set->moduleEstimators.add(-1);
+        }
+    }
+
+    set->bank.prepare(getSampleRate(), set->lowCuts, set->highCuts);
+    set->inputs.calloc(jmax(1, set->modules.size()));
+
+    for (int k = 0; k < set->modules.size(); k++)
+        set->bank.setTargetPhase(k, modules[set->modules[k]].targetPhase);
+
+    // nothing runs the older sets while acquisition is stopped
+    if (!CoreServices::getAcquisitionStatus())
+    {
+        estimators = nullptr;
+        estimatorSets.clear();
+    }
+
+    estimatorSets.add(set);
+    publishedEstimators = set;
+}
+
+void PhaseDetector::switchEstimators()
+{
+    EstimatorSet* latest = publishedEstimators.get();
+
+    if (latest == estimators)
+        return;
+
+    // retargeting doesn't need the filters to settle again
+    if (estimators != nullptr && latest->hasSameBands(*estimators))
+        latest->bank.copyStateFrom(estimators->bank);
+
+    estimators = latest;
+}
+
+void PhaseDetector::processEstimators(AudioSampleBuffer& buffer, MidiBuffer& events)
+{
+    // the bank runs all channels in lockstep over the shortest input
+    int numSamples = -1;
+
+    for (int k = 0; k < estimators->modules.size(); k++)
+    {
+        DetectorModule& module = modules.getReference(estimators->modules[k]);
+
+        if (module.inputChan >= buffer.getNumChannels())
+            return;
+
+        estimators->inputs[k] = buffer.getReadPointer(module.inputChan);
+        estimators->bank.setEnabled(k, module.isActive && module.outputChan >= 0);
+
+        int n = getNumSamples(module.inputChan);
+        numSamples = (numSamples < 0) ? n : jmin(numSamples, n);
+    }
+
+    triggers.clearQuick();
+    estimators->bank.process(estimators->inputs, numSamples, triggers);
+
+    for (int t = 0; t < triggers.size(); t++)
+    {
+        DetectorModule& module = modules.getReference(estimators->modules[triggers[t].estimator]);
+        const int offset = triggers[t].sampleOffset;
+
+        // end the previous pulse if it's due before this one
+        if (module.wasTriggered && offset >= pulseLength - module.samplesSinceTrigger)
+        {
+            addEvent(events, TTL, jmax(0, pulseLength - module.samplesSinceTrigger), 0, module.outputChan);
+            module.wasTriggered = false;
+        }
+
+        if (!module.wasTriggered)
+        {
+            addEvent(events, TTL, offset, 1, module.outputChan);
+            module.wasTriggered = true;
+            module.samplesSinceTrigger = -offset;
+        }
+    }
+
+    for (int k = 0; k < estimators->modules.size(); k++)
+    {
+        DetectorModule& module = modules.getReference(estimators->modules[k]);
+
+        if (module.wasTriggered && pulseLength - module.samplesSinceTrigger < numSamples)
+        {
+            addEvent(events, TTL, jmax(0, pulseLength - module.samplesSinceTrigger), 0, module.outputChan);
+            module.wasTriggered = false;
+        }
+
+        module.samplesSinceTrigger += numSamples;
+    }
+}
+
 void PhaseDetector::handleEvent(int eventType, MidiMessage& event, int sampleNum)
 {
     // MOVED GATING TO PULSE PAL OUTPUT!
@@ -172,13 +326,22 @@ void PhaseDetector::process(AudioSampleBuffer& buffer,
 
     checkForEvents(events);
 
+    switchEstimators();
+
+    if (estimators->modules.size() > 0)
+        processEstimators(buffer, events);
+
     // loop through the modules
     for (int i = 0; i < modules.size(); i++)
     {
         DetectorModule& module = modules.getReference(i);
 
+        // modules with an estimator were handled above
+        const bool hasEstimator = i < estimators->moduleEstimators.size()
+                                  && estimators->moduleEstimators.getUnchecked(i) >= 0;
+
         // check to see if it's active and has a channel
-        if (module.isActive && module.outputChan >= 0 &&
+        if (!hasEstimator && module.isActive && module.outputChan >= 0 &&
             module.inputChan >= 0 &&
             module.inputChan < buffer.getNumChannels())
         {
@@ -243,7 +406,7 @@ void PhaseDetector::process(AudioSampleBuffer& buffer,
 
                 if (module.wasTriggered)
                 {
-                    if (module.samplesSinceTrigger > 1000)
+                    if (module.samplesSinceTrigger > pulseLength)
                     {
                         addEvent(events, TTL, i, 0, module.outputChan);
                         module.wasTriggered = false;
@@ -26,6 +26,7 @@
 
 
 #include <ProcessorHeaders.h>
+#include "PhaseEstimator.h"
 
 #define NUM_INTERVALS 5
 
@@ -33,6 +34,9 @@
 
   Uses peaks to estimate the phase of a continuous signal.
 
+  Modules with a target phase angle use a PhaseEstimatorBank instead,
+  which tracks the phase continuously and can trigger at any angle.
+
   @see GenericProcessor, PhaseDetectorEditor
 
 */
@@ -86,6 +90,10 @@ private:
         bool wasTriggered;
         ModuleType type;
         PhaseType phase;
+
+        float targetPhase; // degrees; negative to trigger on peaks and zero crossings instead
+        float lowCut;
+        float highCut;
     };
 
     Array<DetectorModule> modules;
@@ -98,6 +106,44 @@ private:
 
     void estimateFrequency();
 
+    /** An estimator bank and the modules it serves. Sets are built on the
+        message thread and not changed by it once published. */
+    struct EstimatorSet
+    {
+        PhaseEstimatorBank bank;
+        Array<int> modules;             // module of each estimator
+        Array<int> moduleEstimators;    // estimator of each module, or -1
+        Array<float> lowCuts;
+        Array<float> highCuts;
+        HeapBlock<const float*> inputs;
+
+        /** True if the bank has the same modules and bands, so only the
+            target phases differ. */
+        bool hasSameBands(const EstimatorSet& other) const;
+    };
+
+    /** Message thread: builds an estimator set from the current module
+        settings and publishes it to the audio thread. */
+    void updateEstimators();
+
+    /** Audio thread: switches to the latest published estimator set. If only
+        the target phases changed, the filters keep their state. */
+    void switchEstimators();
+
+    /** Runs the estimator bank and adds its triggers to the event buffer */
+    void processEstimators(AudioSampleBuffer& buffer, MidiBuffer& events);
+
+    // every set published since acquisition started; the audio thread may
+    // still be using any of them, so they are only freed while stopped
+    OwnedArray<EstimatorSet> estimatorSets;
+    Atomic<EstimatorSet*> publishedEstimators;
+    EstimatorSet* estimators;   // audio thread
+
+    Array<PhaseEstimatorBank::Trigger> triggers;
+
+    /** Length of the output pulses in samples, 1/30 s at the input rate */
+    int pulseLength;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhaseDetector);
 
 };
@@ -34,7 +34,7 @@ PhaseDetectorEditor::PhaseDetectorEditor(GenericProcessor* parentNode, bool useD
     : GenericEditor(parentNode, useDefaultParameterEditors), previousChannelCount(-1)
 
 {
-    desiredWidth = 220;
+    desiredWidth = 310;
 
     // intputChannelLabel = new Label("input", "Input channel:");
     // intputChannelLabel->setBounds(15,25,180,20);
@@ -140,7 +140,7 @@ void PhaseDetectorEditor::addDetector()
     int detectorNumber = interfaces.size()+1;
 
     DetectorInterface* di = new DetectorInterface(pd, backgroundColours[detectorNumber%5], detectorNumber-1);
-    di->setBounds(10,50,190,80);
+    di->setBounds(10,50,290,80);
 
     addAndMakeVisible(di);
 
@@ -175,6 +175,9 @@ void PhaseDetectorEditor::saveCustomParameters(XmlElement* xml)
         d->setAttribute("INPUT",interfaces[i]->getInputChan());
         d->setAttribute("GATE",interfaces[i]->getGateChan());
         d->setAttribute("OUTPUT",interfaces[i]->getOutputChan());
+        d->setAttribute("ANGLE",interfaces[i]->getTargetPhase());
+        d->setAttribute("LOWCUT",interfaces[i]->getLowCut());
+        d->setAttribute("HIGHCUT",interfaces[i]->getHighCut());
     }
 }
 
@@ -197,6 +200,9 @@ void PhaseDetectorEditor::loadCustomParameters(XmlElement* xml)
             interfaces[i]->setInputChan(xmlNode->getIntAttribute("INPUT"));
             interfaces[i]->setGateChan(xmlNode->getIntAttribute("GATE"));
             interfaces[i]->setOutputChan(xmlNode->getIntAttribute("OUTPUT"));
+            interfaces[i]->setBand(xmlNode->getDoubleAttribute("LOWCUT", 4.0),
+                                   xmlNode->getDoubleAttribute("HIGHCUT", 8.0));
+            interfaces[i]->setTargetPhase(xmlNode->getDoubleAttribute("ANGLE", -1.0));
 
             i++;
         }
@@ -207,7 +213,7 @@ void PhaseDetectorEditor::loadCustomParameters(XmlElement* xml)
 // ===================================================================
 
 DetectorInterface::DetectorInterface(PhaseDetector* pd, Colour c, int id) :
-    backgroundColour(c), idNum(id), processor(pd)
+    backgroundColour(c), idNum(id), processor(pd), targetPhase(-1.0f), lowCut(4.0f), highCut(8.0f)
 {
 
     font = Font("Small Text", 10, Font::plain);
@@ -279,6 +285,26 @@ DetectorInterface::DetectorInterface(PhaseDetector* pd, Colour c, int id) :
     outputSelector->setSelectedId(1);
     addAndMakeVisible(outputSelector);
 
+    // target angle and band of the continuous phase estimator
+    angleValue = new Label("angle value", "-");
+    angleValue->setBounds(240,5,45,18);
+    lowCutValue = new Label("low cut value", String(lowCut));
+    lowCutValue->setBounds(240,30,45,18);
+    highCutValue = new Label("high cut value", String(highCut));
+    highCutValue->setBounds(240,55,45,18);
+
+    Label* values[] = {angleValue, lowCutValue, highCutValue};
+
+    for (int i = 0; i < 3; i++)
+    {
+        values[i]->setFont(Font("Default", 13, Font::plain));
+        values[i]->setColour(Label::textColourId, Colours::white);
+        values[i]->setColour(Label::backgroundColourId, Colours::grey);
+        values[i]->setEditable(true);
+        values[i]->addListener(this);
+        addAndMakeVisible(values[i]);
+    }
+
 
     std::cout << "Updating channels" << std::endl;
 
@@ -332,6 +358,53 @@ void DetectorInterface::buttonClicked(Button* b)
 
     processor->setParameter(1, (float) i+1);
 
+    // picking a peak or zero crossing leaves the phase estimator
+    setTargetPhase(-1.0f);
+
+}
+
+void DetectorInterface::labelTextChanged(Label* label)
+{
+
+    if (label == angleValue)
+    {
+        String text = label->getText().trim();
+
+        if (text.isEmpty() || text == "-")
+        {
+            setTargetPhase(-1.0f);
+            return;
+        }
+
+        float angle = text.getFloatValue();
+
+        if (angle < 0 || angle >= 360)
+        {
+            CoreServices::sendStatusMessage("Phase angle must be between 0 and 360 degrees.");
+            setTargetPhase(targetPhase);
+            return;
+        }
+
+        for (int i = 0; i < phaseButtons.size(); i++)
+            phaseButtons[i]->setToggleState(false, dontSendNotification);
+
+        setTargetPhase(angle);
+    }
+    else
+    {
+        float newLow = (label == lowCutValue) ? label->getText().getFloatValue() : lowCut;
+        float newHigh = (label == highCutValue) ? label->getText().getFloatValue() : highCut;
+
+        if (newLow < 0.1f || newHigh <= newLow || newHigh > 1000.0f)
+        {
+            CoreServices::sendStatusMessage("Value out of range.");
+            setBand(lowCut, highCut);
+            return;
+        }
+
+        setBand(newLow, newHigh);
+    }
+
 }
 
 void DetectorInterface::updateChannels(int numChannels)
@@ -365,6 +438,9 @@ void DetectorInterface::paint(Graphics& g)
     g.drawText("INPUT",50,10,85,10,Justification::right, true);
     g.drawText("GATE",50,35,85,10,Justification::right, true);
     g.drawText("OUTPUT",50,60,85,10,Justification::right, true);
+    g.drawText("ANGLE",190,10,45,10,Justification::right, true);
+    g.drawText("LOW",190,35,45,10,Justification::right, true);
+    g.drawText("HIGH",190,60,45,10,Justification::right, true);
 
 }
 
@@ -429,4 +505,44 @@ int DetectorInterface::getOutputChan()
 int DetectorInterface::getGateChan()
 {
     return gateSelector->getSelectedId()-2;
-}
\ No newline at end of file
+}
+
+void DetectorInterface::setTargetPhase(float angle)
+{
+    targetPhase = (angle >= 0) ? angle : -1.0f;
+
+    angleValue->setText((targetPhase >= 0) ? String(targetPhase) : String("-"), dontSendNotification);
+
+    processor->setActiveModule(idNum);
+
+    processor->setParameter(5, targetPhase);
+}
+
+void DetectorInterface::setBand(float low, float high)
+{
+    lowCut = low;
+    highCut = high;
+
+    lowCutValue->setText(String(lowCut), dontSendNotification);
+    highCutValue->setText(String(highCut), dontSendNotification);
+
+    processor->setActiveModule(idNum);
+
+    processor->setParameter(6, lowCut);
+    processor->setParameter(7, highCut);
+}
+
+float DetectorInterface::getTargetPhase()
+{
+    return targetPhase;
+}
+
+float DetectorInterface::getLowCut()
+{
+    return lowCut;
+}
+
+float DetectorInterface::getHighCut()
+{
+    return highCut;
+}
@@ -82,7 +82,8 @@ private:
 
 class DetectorInterface : public Component,
     public ComboBox::Listener,
-    public Button::Listener
+    public Button::Listener,
+    public Label::Listener
 {
 public:
     DetectorInterface(PhaseDetector*, Colour, int);
@@ -92,6 +93,7 @@ public:
 
     void comboBoxChanged(ComboBox*);
     void buttonClicked(Button*);
+    void labelTextChanged(Label*);
 
     void updateChannels(int);
 
@@ -100,11 +102,20 @@ public:
     void setOutputChan(int);
     void setGateChan(int);
 
+    /** Phase angle in degrees to trigger at, or a negative value
+        to trigger on the selected peak or zero crossing. */
+    void setTargetPhase(float);
+    void setBand(float lowCut, float highCut);
+
     int getPhase();
     int getInputChan();
     int getOutputChan();
     int getGateChan();
 
+    float getTargetPhase();
+    float getLowCut();
+    float getHighCut();
+
 private:
 
     Colour backgroundColour;
@@ -122,6 +133,14 @@ private:
     ScopedPointer<ComboBox> gateSelector;
     ScopedPointer<ComboBox> outputSelector;
 
+    ScopedPointer<Label> angleValue;
+    ScopedPointer<Label> lowCutValue;
+    ScopedPointer<Label> highCutValue;
+
+    float targetPhase;
+    float lowCut;
+    float highCut;
+
 };
 
 #endif  // __PHASEDETECTOREDITOR_H_136829C6__
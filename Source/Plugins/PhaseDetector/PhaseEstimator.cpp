@@ -0,0 +1,403 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PhaseEstimator.h"
+
+// decimated samples per cycle of the highest high cut
+#define SAMPLES_PER_CYCLE 10
+#define MAX_HILBERT_DELAY 256
+
+// smoothing of the instantaneous frequency, per decimated sample
+#define FREQUENCY_SMOOTHING 0.1f
+
+namespace
+{
+inline float wrapPi(float phase)
+{
+    while (phase > float_Pi)
+        phase -= 2.0f * float_Pi;
+    while (phase <= -float_Pi)
+        phase += 2.0f * float_Pi;
+    return phase;
+}
+
+inline float wrapTwoPi(float phase)
+{
+    while (phase >= 2.0f * float_Pi)
+        phase -= 2.0f * float_Pi;
+    while (phase < 0)
+        phase += 2.0f * float_Pi;
+    return phase;
+}
+}
+
+void PhaseEstimatorBank::BiquadBank::allocate(int numEstimators)
+{
+    b0.calloc(numEstimators);
+    b1.calloc(numEstimators);
+    b2.calloc(numEstimators);
+    a1.calloc(numEstimators);
+    a2.calloc(numEstimators);
+    z1.calloc(numEstimators);
+    z2.calloc(numEstimators);
+}
+
+void PhaseEstimatorBank::BiquadBank::setButterworth(int index, bool isHighPass, double cutoff, double rate)
+{
+    const double w0 = 2.0 * double_Pi * cutoff / rate;
+    const double cosw = cos(w0);
+    const double alpha = sin(w0) / sqrt(2.0);
+    const double a0 = 1.0 + alpha;
+
+    if (isHighPass)
+    {
+        b0[index] = (1.0 + cosw) / 2.0 / a0;
+        b1[index] = -(1.0 + cosw) / a0;
+    }
+    else
+    {
+        b0[index] = (1.0 - cosw) / 2.0 / a0;
+        b1[index] = (1.0 - cosw) / a0;
+    }
+
+    b2[index] = b0[index];
+    a1[index] = -2.0 * cosw / a0;
+    a2[index] = (1.0 - alpha) / a0;
+}
+
+void PhaseEstimatorBank::BiquadBank::reset(int numEstimators)
+{
+    for (int k = 0; k < numEstimators; k++)
+        z1[k] = z2[k] = 0;
+}
+
+double PhaseEstimatorBank::BiquadBank::getPhase(int index, double w) const
+{
+    // arg of (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) at z = e^jw
+    const double c1 = cos(w), s1 = sin(w);
+    const double c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+
+    const double numRe = b0[index] + b1[index] * c1 + b2[index] * c2;
+    const double numIm = -b1[index] * s1 - b2[index] * s2;
+    const double denRe = 1.0 + a1[index] * c1 + a2[index] * c2;
+    const double denIm = -a1[index] * s1 - a2[index] * s2;
+
+    return atan2(numIm, numRe) - atan2(denIm, denRe);
+}
+
+/**********************/
+
+PhaseEstimatorBank::PhaseEstimatorBank()
+    : numEstimators(0), sampleRate(30000.0), decimation(1), decimationCounter(0),
+      hilbertDelay(0), hilbertLength(1), historyIndex(0), numDecimatedSamples(0)
+{
+}
+
+PhaseEstimatorBank::~PhaseEstimatorBank()
+{
+}
+
+void PhaseEstimatorBank::prepare(double rate, const Array<float>& lowCuts, const Array<float>& highCuts)
+{
+    jassert(lowCuts.size() == highCuts.size());
+
+    numEstimators = lowCuts.size();
+    sampleRate = rate;
+
+    if (numEstimators == 0)
+        return;
+
+    float lowest = lowCuts[0];
+    float highest = highCuts[0];
+    for (int k = 1; k < numEstimators; k++)
+    {
+        lowest = jmin(lowest, lowCuts[k]);
+        highest = jmax(highest, highCuts[k]);
+    }
+
+    decimation = jmax(1, int(sampleRate / (SAMPLES_PER_CYCLE * highest)));
+    const double decimatedRate = sampleRate / decimation;
+
+    // the Hilbert transformer spans one cycle of the lowest low cut, so it
+    // delays the analytic signal by half a cycle
+    hilbertDelay = jlimit(2, MAX_HILBERT_DELAY, roundToInt(decimatedRate / lowest / 2.0));
+    hilbertLength = 2 * hilbertDelay + 1;
+
+    hilbertCoefficients.calloc(hilbertLength);
+    for (int j = 0; j < hilbertLength; j++)
+    {
+        const int n = j - hilbertDelay;
+        if (n % 2 != 0)
+        {
+            const double window = 0.54 - 0.46 * cos(2.0 * double_Pi * j / (hilbertLength - 1));
+            hilbertCoefficients[j] = float(2.0 / (double_Pi * n) * window);
+        }
+    }
+
+    lowPass.allocate(numEstimators);
+    highPass.allocate(numEstimators);
+
+    filtered.calloc(numEstimators);
+    history.calloc(2 * hilbertLength * numEstimators);
+    quadrature.calloc(numEstimators);
+
+    lastPhase.calloc(numEstimators);
+    currentPhase.calloc(numEstimators);
+    frequency.calloc(numEstimators);
+    minFrequency.calloc(numEstimators);
+    maxFrequency.calloc(numEstimators);
+    targetPhase.calloc(numEstimators);
+    enabled.calloc(numEstimators);
+    armed.calloc(numEstimators);
+    countdown.calloc(numEstimators);
+
+    for (int k = 0; k < numEstimators; k++)
+    {
+        // the low-pass runs at the input rate and also keeps the decimation from aliasing;
+        // the high-pass is much better conditioned at the decimated rate
+        lowPass.setButterworth(k, false, highCuts[k], sampleRate);
+        highPass.setButterworth(k, true, lowCuts[k], decimatedRate);
+
+        minFrequency[k] = float(2.0 * double_Pi * lowCuts[k] / decimatedRate);
+        maxFrequency[k] = float(2.0 * double_Pi * highCuts[k] / decimatedRate);
+        enabled[k] = true;
+    }
+
+    reset();
+}
+
+void PhaseEstimatorBank::reset()
+{
+    lowPass.reset(numEstimators);
+    highPass.reset(numEstimators);
+
+    for (int k = 0; k < 2 * hilbertLength * numEstimators; k++)
+        history[k] = 0;
+
+    for (int k = 0; k < numEstimators; k++)
+    {
+        lastPhase[k] = currentPhase[k] = 0;
+        frequency[k] = 0.5f * (minFrequency[k] + maxFrequency[k]);
+        armed[k] = false;
+        countdown[k] = 0;
+    }
+
+    decimationCounter = 0;
+    historyIndex = 0;
+    numDecimatedSamples = 0;
+}
+
+void PhaseEstimatorBank::copyStateFrom(const PhaseEstimatorBank& other)
+{
+    jassert(other.numEstimators == numEstimators && other.hilbertLength == hilbertLength
+            && other.decimation == decimation);
+
+    const int K = numEstimators;
+    const size_t doubles = sizeof(double) * K;
+    const size_t floats = sizeof(float) * K;
+
+    memcpy(lowPass.z1, other.lowPass.z1, doubles);
+    memcpy(lowPass.z2, other.lowPass.z2, doubles);
+    memcpy(highPass.z1, other.highPass.z1, doubles);
+    memcpy(highPass.z2, other.highPass.z2, doubles);
+
+    memcpy(filtered, other.filtered, floats);
+    memcpy(history, other.history, floats * 2 * hilbertLength);
+    memcpy(quadrature, other.quadrature, floats);
+    memcpy(lastPhase, other.lastPhase, floats);
+    memcpy(currentPhase, other.currentPhase, floats);
+    memcpy(frequency, other.frequency, floats);
+    memcpy(enabled, other.enabled, sizeof(bool) * K);
+    memcpy(armed, other.armed, sizeof(bool) * K);
+    memcpy(countdown, other.countdown, sizeof(int) * K);
+
+    decimationCounter = other.decimationCounter;
+    historyIndex = other.historyIndex;
+    numDecimatedSamples = other.numDecimatedSamples;
+}
+
+int PhaseEstimatorBank::getNumEstimators() const
+{
+    return numEstimators;
+}
+
+void PhaseEstimatorBank::setTargetPhase(int index, float degrees)
+{
+    targetPhase[index] = wrapTwoPi(degrees * float_Pi / 180.0f);
+}
+
+void PhaseEstimatorBank::setEnabled(int index, bool shouldBeEnabled)
+{
+    enabled[index] = shouldBeEnabled;
+
+    if (!shouldBeEnabled)
+        countdown[index] = 0;
+}
+
+float PhaseEstimatorBank::getPhase(int index) const
+{
+    return currentPhase[index] * 180.0f / float_Pi;
+}
+
+int PhaseEstimatorBank::getDecimationFactor() const
+{
+    return decimation;
+}
+
+int PhaseEstimatorBank::getHilbertLength() const
+{
+    return hilbertLength;
+}
+
+double PhaseEstimatorBank::getGroupDelayMs() const
+{
+    return 1000.0 * hilbertDelay * decimation / sampleRate;
+}
+
+void PhaseEstimatorBank::process(const float* const* inputs, int numSamples, Array<Trigger>& triggers)
+{
+    const int K = numEstimators;
+    const double* lb0 = lowPass.b0;
+    const double* lb1 = lowPass.b1;
+    const double* lb2 = lowPass.b2;
+    const double* la1 = lowPass.a1;
+    const double* la2 = lowPass.a2;
+    double* lz1 = lowPass.z1;
+    double* lz2 = lowPass.z2;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        for (int k = 0; k < K; k++)
+        {
+            const double x = inputs[k][i];
+            const double y = lb0[k] * x + lz1[k];
+            lz1[k] = lb1[k] * x - la1[k] * y + lz2[k];
+            lz2[k] = lb2[k] * x - la2[k] * y;
+            filtered[k] = float(y);
+        }
+
+        if (++decimationCounter == decimation)
+        {
+            decimationCounter = 0;
+            hilbertStep();
+        }
+
+        for (int k = 0; k < K; k++)
+        {
+            if (countdown[k] > 0 && --countdown[k] == 0)
+            {
+                Trigger t;
+                t.estimator = k;
+                t.sampleOffset = i;
+                triggers.add(t);
+            }
+        }
+    }
+}
+
+void PhaseEstimatorBank::hilbertStep()
+{
+    const int K = numEstimators;
+    const double* hb0 = highPass.b0;
+    const double* hb1 = highPass.b1;
+    const double* hb2 = highPass.b2;
+    const double* ha1 = highPass.a1;
+    const double* ha2 = highPass.a2;
+    double* hz1 = highPass.z1;
+    double* hz2 = highPass.z2;
+
+    // the newest sample goes in both copies of the ring
+    float* newest = history + (historyIndex + hilbertLength) * K;
+    float* copy = history + historyIndex * K;
+
+    for (int k = 0; k < K; k++)
+    {
+        const double x = filtered[k];
+        const double y = hb0[k] * x + hz1[k];
+        hz1[k] = hb1[k] * x - ha1[k] * y + hz2[k];
+        hz2[k] = hb2[k] * x - ha2[k] * y;
+        newest[k] = copy[k] = float(y);
+    }
+
+    // only the odd taps of a Hilbert transformer are non-zero
+    for (int k = 0; k < K; k++)
+        quadrature[k] = 0;
+
+    for (int j = 1 - (hilbertDelay % 2); j < hilbertLength; j += 2)
+    {
+        const float h = hilbertCoefficients[j];
+        const float* x = newest - j * K;
+
+        for (int k = 0; k < K; k++)
+            quadrature[k] += h * x[k];
+    }
+
+    const float* delayed = newest - hilbertDelay * K;
+
+    historyIndex = (historyIndex + 1) % hilbertLength;
+    numDecimatedSamples++;
+
+    const bool warmedUp = numDecimatedSamples > 2 * hilbertLength;
+
+    for (int k = 0; k < K; k++)
+    {
+        const float phase = atan2(quadrature[k], delayed[k]);
+        const float step = wrapPi(phase - lastPhase[k]);
+        lastPhase[k] = phase;
+
+        frequency[k] += FREQUENCY_SMOOTHING * (step - frequency[k]);
+        frequency[k] = jlimit(minFrequency[k], maxFrequency[k], frequency[k]);
+
+        // advance over the Hilbert delay and undo the band-pass phase shift
+        const double filterPhase = lowPass.getPhase(k, frequency[k] / decimation)
+                                   + highPass.getPhase(k, frequency[k]);
+
+        currentPhase[k] = wrapTwoPi(phase + frequency[k] * hilbertDelay - float(filterPhase));
+
+        if (!warmedUp || !enabled[k] || countdown[k] > 0)
+            continue;
+
+        const float ahead = wrapTwoPi(targetPhase[k] - currentPhase[k]);
+
+        // re-arm once the oscillation is on the opposite side of the cycle
+        if (!armed[k])
+        {
+            armed[k] = ahead > 0.5f * float_Pi && ahead < 1.5f * float_Pi;
+            continue;
+        }
+
+        const float stepsToTarget = ahead / frequency[k];
+
+        if (stepsToTarget < 1.0f)
+        {
+            countdown[k] = roundToInt(stepsToTarget * decimation) + 1;
+            armed[k] = false;
+        }
+        else if (ahead > 2.0f * float_Pi - 0.5f * frequency[k])
+        {
+            // the target was just passed between two decimated samples
+            countdown[k] = 1;
+            armed[k] = false;
+        }
+    }
+}
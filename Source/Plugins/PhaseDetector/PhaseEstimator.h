@@ -0,0 +1,155 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __PHASEESTIMATOR_H__
+#define __PHASEESTIMATOR_H__
+
+#include <ProcessorHeaders.h>
+
+/**
+
+  Causal estimate of the instantaneous phase of several channels, computed
+  in lockstep.
+
+  Each channel goes through a 2nd-order Butterworth high-pass and low-pass
+  at its own band edges. It is then decimated to about ten samples per cycle
+  of the highest band edge and fed to a shared Hamming-windowed FIR Hilbert
+  transformer one cycle of the lowest band edge long. The analytic signal
+  lags the input by half that length, half a cycle (the group delay reported
+  by getGroupDelayMs()). The phase is advanced
+  over that delay at the smoothed instantaneous frequency, and the band-pass
+  phase response at that frequency is taken out, which gives the phase of
+  the current sample.
+
+  Triggers are scheduled ahead of time: when the phase will reach the target
+  before the next decimated sample, the trigger is placed on the input sample
+  at which it is predicted to get there.
+
+  Filter and Hilbert state is stored channel-innermost, so every stage is a
+  loop over channels that the compiler can vectorize.
+
+  Phases use the cosine convention: 0 degrees is a peak, 90 a falling zero
+  crossing, 180 a trough and 270 a rising zero crossing.
+
+  @see PhaseDetector
+
+*/
+
+class PhaseEstimatorBank
+{
+public:
+    struct Trigger
+    {
+        int estimator;
+        int sampleOffset;
+    };
+
+    PhaseEstimatorBank();
+    ~PhaseEstimatorBank();
+
+    /** Sets up one estimator per band and resets their state. The decimation
+        factor and Hilbert length are shared, and are chosen from the highest
+        high cut and the lowest low cut. */
+    void prepare(double sampleRate, const Array<float>& lowCuts, const Array<float>& highCuts);
+
+    /** Clears the filter state of every estimator */
+    void reset();
+
+    /** Takes over the filter and phase state of a bank prepared with the same
+        sample rate and bands, keeping this bank's target phases. Doesn't
+        allocate, so the audio thread can call it when switching banks. */
+    void copyStateFrom(const PhaseEstimatorBank& other);
+
+    int getNumEstimators() const;
+
+    /** Sets the phase, in degrees, at which an estimator triggers */
+    void setTargetPhase(int index, float degrees);
+
+    /** Disabled estimators keep tracking the phase but don't trigger */
+    void setEnabled(int index, bool enabled);
+
+    /** Processes numSamples samples of every estimator; inputs[k] holds the
+        samples of estimator k. Triggers falling in this block are appended
+        to triggers. */
+    void process(const float* const* inputs, int numSamples, Array<Trigger>& triggers);
+
+    /** Latest phase estimate of an estimator, in degrees */
+    float getPhase(int index) const;
+
+    int getDecimationFactor() const;
+    int getHilbertLength() const;
+
+    /** Delay of the analytic signal, compensated by the phase advance */
+    double getGroupDelayMs() const;
+
+private:
+    /** 2nd-order sections of every estimator, in transposed direct form II.
+        Doubles, because the poles of low cuts sit very close to the unit circle. */
+    struct BiquadBank
+    {
+        void allocate(int numEstimators);
+        void setButterworth(int index, bool highPass, double cutoff, double sampleRate);
+        void reset(int numEstimators);
+
+        /** Phase response of one section at w radians per input sample */
+        double getPhase(int index, double w) const;
+
+        HeapBlock<double> b0, b1, b2, a1, a2, z1, z2;
+    };
+
+    void hilbertStep();
+
+    int numEstimators;
+    double sampleRate;
+
+    BiquadBank highPass;
+    BiquadBank lowPass;
+
+    HeapBlock<float> filtered;
+
+    int decimation;
+    int decimationCounter;
+
+    // Hilbert transformer, 2 * hilbertDelay + 1 taps
+    int hilbertDelay;
+    int hilbertLength;
+    HeapBlock<float> hilbertCoefficients;
+    HeapBlock<float> history;   // two copies of the ring, so each window is contiguous
+    HeapBlock<float> quadrature;
+    int historyIndex;
+    int numDecimatedSamples;
+
+    HeapBlock<float> lastPhase;
+    HeapBlock<float> currentPhase;
+    HeapBlock<float> frequency;     // radians per decimated sample
+    HeapBlock<float> minFrequency;
+    HeapBlock<float> maxFrequency;
+    HeapBlock<float> targetPhase;
+    HeapBlock<bool> enabled;
+    HeapBlock<bool> armed;
+    HeapBlock<int> countdown;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhaseEstimatorBank);
+};
+
+#endif  // __PHASEESTIMATOR_H__
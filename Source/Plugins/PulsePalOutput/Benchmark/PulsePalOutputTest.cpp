@@ -0,0 +1,252 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Runs an OutputDispatcher and a PulsePalOutputDevice against a
+    pseudo-terminal standing in for the Pulse Pal. A thread on the master
+    side answers the handshake and records every trigger message. Checks
+    that:
+      - triggers on different channels queued together go out as one message
+      - a channel triggered twice in a batch is fired twice
+      - triggers due at different times go out as separate messages, even
+        when the I/O thread finds them due together
+      - triggers queued at intervals arrive within MAX_LATENCY ms, without
+        the audio thread waking the I/O thread
+
+        make test                 (in Source/Plugins/PulsePalOutput)
+
+    Linux and OS X only.
+*/
+
+#include "../PulsePalOutputDevice.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define NUM_TIMED_TRIGGERS 200
+#define TRIGGER_INTERVAL 5 // ms
+#define MAX_LATENCY 5.0 // ms
+
+namespace
+{
+struct Trigger
+{
+    uint8 code;
+    int64 arrivalTicks;
+};
+
+/** The master side of the pseudo-terminal, playing the Pulse Pal */
+class FakePulsePal : public Thread
+{
+public:
+    FakePulsePal(int masterFd) : Thread("Fake Pulse Pal"), fd(masterFd) {}
+
+    ~FakePulsePal()
+    {
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        Array<uint8> pending;
+        uint8 bytes[256];
+
+        while (! threadShouldExit())
+        {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+
+            if (poll(&pfd, 1, 10) <= 0)
+                continue;
+
+            const int n = int(read(fd, bytes, sizeof(bytes)));
+
+            if (n <= 0)
+                continue;
+
+            const int64 now = Time::getHighResolutionTicks();
+            pending.addArray(static_cast<const uint8*>(bytes), n);
+
+            while (pending.size() >= 2 && pending[0] == 213)
+            {
+                if (pending[1] == 72) // handshake, answered with a firmware version
+                {
+                    uint8 reply[5] = {75, 20, 0, 0, 0};
+                    write(fd, reply, sizeof(reply));
+                    pending.removeRange(0, 2);
+                }
+                else if (pending[1] == 77 && pending.size() >= 3) // trigger
+                {
+                    const ScopedLock sl(lock);
+                    Trigger trigger = { pending[2], now };
+                    triggers.add(trigger);
+                    pending.removeRange(0, 3);
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    Array<Trigger> waitForTriggers(int count, int timeoutMs = 2000)
+    {
+        for (int i = 0; i < timeoutMs && getNumTriggers() < count; i++)
+            Thread::sleep(1);
+
+        // give unexpected extra messages a chance to show up
+        Thread::sleep(20);
+
+        const ScopedLock sl(lock);
+        Array<Trigger> result(triggers);
+        triggers.clearQuick();
+        return result;
+    }
+
+private:
+    int getNumTriggers()
+    {
+        const ScopedLock sl(lock);
+        return triggers.size();
+    }
+
+    int fd;
+    CriticalSection lock;
+    Array<Trigger> triggers;
+};
+
+bool check(bool condition, const char* what)
+{
+    printf("%s: %s\n", condition ? "ok  " : "FAIL", what);
+    return condition;
+}
+
+String describe(const Array<Trigger>& triggers)
+{
+    String s;
+    for (int i = 0; i < triggers.size(); i++)
+        s << (i > 0 ? " " : "") << int(triggers[i].code);
+    return "[" + s + "]";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        printf("FAIL: can't create a pseudo-terminal\n");
+        return 1;
+    }
+
+    const String slavePath(ptsname(master));
+
+    // raw mode on both ends, so trigger codes aren't translated; the slave
+    // stays open to keep its settings
+    const int slave = open(slavePath.toRawUTF8(), O_RDWR | O_NOCTTY);
+    struct termios options;
+    tcgetattr(slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(slave, TCSANOW, &options);
+    tcgetattr(master, &options);
+    cfmakeraw(&options);
+    tcsetattr(master, TCSANOW, &options);
+
+    FakePulsePal fake(master);
+    fake.startThread();
+
+    PulsePal pulsePal;
+    pulsePal.initialize(slavePath.toStdString());
+
+    PulsePalOutputDevice device(pulsePal);
+    OutputDispatcher dispatcher("Pulse Pal test", &device);
+    bool pass = true;
+
+    // queued before the I/O thread starts, so each set is one batch
+    dispatcher.addCommand(1, 1);
+    dispatcher.addCommand(2, 1);
+    dispatcher.addCommand(4, 1);
+    dispatcher.start();
+    Array<Trigger> triggers = fake.waitForTriggers(1);
+    dispatcher.stop();
+    pass &= check(triggers.size() == 1 && triggers[0].code == 11,
+                  ("channels 1, 2 and 4 together fire once with code 11, got " + describe(triggers)).toRawUTF8());
+
+    dispatcher.addCommand(1, 1);
+    dispatcher.addCommand(1, 1);
+    dispatcher.addCommand(2, 1);
+    dispatcher.start();
+    triggers = fake.waitForTriggers(2);
+    dispatcher.stop();
+    pass &= check(triggers.size() == 2 && triggers[0].code == 1 && triggers[1].code == 3,
+                  ("channel 1 twice then channel 2 fires 1 then 3, got " + describe(triggers)).toRawUTF8());
+
+    dispatcher.addCommand(1, 1);
+    dispatcher.addCommand(2, 1, 5.0);
+    Thread::sleep(20);
+    dispatcher.start();
+    triggers = fake.waitForTriggers(2);
+    dispatcher.stop();
+    pass &= check(triggers.size() == 2 && triggers[0].code == 1 && triggers[1].code == 2,
+                  ("channel 1 now and channel 2 after 5 ms, both overdue, fire separately, got " + describe(triggers)).toRawUTF8());
+
+    // end to end: each trigger is queued without waking the I/O thread
+    dispatcher.start();
+
+    Array<int64> queuedTicks;
+    for (int i = 0; i < NUM_TIMED_TRIGGERS; i++)
+    {
+        queuedTicks.add(Time::getHighResolutionTicks());
+        dispatcher.addCommand(i % 4 + 1, 1);
+        Thread::sleep(TRIGGER_INTERVAL);
+    }
+
+    triggers = fake.waitForTriggers(NUM_TIMED_TRIGGERS);
+    dispatcher.stop();
+
+    bool inOrder = triggers.size() == NUM_TIMED_TRIGGERS;
+    double maxLatencyMs = 0;
+
+    for (int i = 0; i < triggers.size() && inOrder; i++)
+    {
+        inOrder = triggers[i].code == (1 << (i % 4));
+        maxLatencyMs = jmax(maxLatencyMs, 1000.0 * Time::highResolutionTicksToSeconds(triggers[i].arrivalTicks - queuedTicks[i]));
+    }
+
+    pass &= check(inOrder, (String(NUM_TIMED_TRIGGERS) + " timed triggers arrive one by one, in order, got "
+                            + String(triggers.size())).toRawUTF8());
+    pass &= check(maxLatencyMs <= MAX_LATENCY, ("queue to arrival at most " + String(MAX_LATENCY, 1)
+                                                + " ms, max " + String(maxLatencyMs, 3) + " ms").toRawUTF8());
+
+    printf("%s\n", dispatcher.getLatencyReport().toRawUTF8());
+
+    fake.stopThread(1000);
+    close(slave);
+    close(master);
+
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
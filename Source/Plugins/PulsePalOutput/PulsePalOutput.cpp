@@ -26,9 +26,8 @@
 
 #include "PulsePalOutput.h"
 
-
 PulsePalOutput::PulsePalOutput()
-    : GenericProcessor("Pulse Pal"), channelToChange(0)
+    : GenericProcessor("Pulse Pal"), channelToChange(0), outputDevice(pulsePal)
 {
 
     pulsePal.initialize();
@@ -42,10 +41,13 @@ PulsePalOutput::PulsePalOutput()
         channelState.add(true);
     }
 
+    dispatcher = new OutputDispatcher("Pulse Pal", &outputDevice);
+
 }
 
 PulsePalOutput::~PulsePalOutput()
 {
+    dispatcher = nullptr;
 
     pulsePal.updateDisplay("PULSE PAL v1.0","Click for menu");
 }
@@ -72,7 +74,7 @@ void PulsePalOutput::handleEvent(int eventType, MidiMessage& event, int sampleNu
         {
             if (eventId == 1 && eventChannel == channelTtlTrigger[i] && channelState[i])
             {
-                pulsePal.triggerChannel(i+1);
+                dispatcher->addCommand(i+1, 1, 0.0, getEventAcquisitionTicks(event));
             }
 
             if (eventChannel == channelTtlGate[i])
@@ -88,6 +90,22 @@ void PulsePalOutput::handleEvent(int eventType, MidiMessage& event, int sampleNu
 
 }
 
+bool PulsePalOutput::enable()
+{
+    dispatcher->resetLatencyStats();
+    dispatcher->start();
+    return true;
+}
+
+bool PulsePalOutput::disable()
+{
+    dispatcher->stop();
+
+    std::cout << "Pulse Pal: " << dispatcher->getLatencyReport() << std::endl;
+
+    return true;
+}
+
 void PulsePalOutput::setParameter(int parameterIndex, float newValue)
 {
     editor->updateParameterButtons(parameterIndex);
@@ -25,15 +25,20 @@
 #define __PULSEPALOUTPUT_H_A8BF66D6__
 
 #include <ProcessorHeaders.h>
+#include <SerialLib.h>
 #include "PulsePalOutputEditor.h"
 #include "serial/PulsePal.h"
+#include "PulsePalOutputDevice.h"
 
 /**
 
   Allows the signal chain to send outputs to the Pulse Pal
   from Lucid Biosystems (www.lucidbiosystems.com)
 
-  @see GenericProcessor, PulsePalOutputEditor, PulsePal
+  Triggers are queued from the audio thread and written by an
+  OutputDispatcher.
+
+  @see GenericProcessor, PulsePalOutputEditor, PulsePal, OutputDispatcher
 
 */
 
@@ -50,6 +55,9 @@ public:
 
     void handleEvent(int eventType, MidiMessage& event, int sampleNum);
 
+    bool enable();
+    bool disable();
+
     AudioProcessorEditor* createEditor();
 
     bool isSink()
@@ -67,6 +75,9 @@ private:
 
     PulsePal pulsePal;
 
+    PulsePalOutputDevice outputDevice;
+    ScopedPointer<OutputDispatcher> dispatcher;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PulsePalOutput);
 
 };
@@ -0,0 +1,64 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PulsePalOutputDevice.h"
+
+// triggers due closer together than this are fired together, in ms
+#define SIMULTANEOUS_TRIGGER_WINDOW 0.5
+
+void PulsePalOutputDevice::sendCommands(const OutputCommand* commands, int numCommands)
+{
+    const int64 window = Time::secondsToHighResolutionTicks(SIMULTANEOUS_TRIGGER_WINDOW / 1000.0);
+
+    uint8_t channels[4] = {0, 0, 0, 0};
+    int64 firstDueTicks = 0;
+    bool anyChannel = false;
+
+    for (int i = 0; i < numCommands; i++)
+    {
+        const OutputCommand& command = commands[i];
+
+        if (command.channel < 1 || command.channel > 4)
+            continue;
+
+        // the commands are sorted by due time
+        if (anyChannel && (channels[command.channel - 1] || command.dueTicks - firstDueTicks > window))
+        {
+            pulsePal.triggerChannels(channels[0], channels[1], channels[2], channels[3]);
+
+            for (int c = 0; c < 4; c++)
+                channels[c] = 0;
+
+            anyChannel = false;
+        }
+
+        if (! anyChannel)
+            firstDueTicks = command.dueTicks;
+
+        channels[command.channel - 1] = 1;
+        anyChannel = true;
+    }
+
+    if (anyChannel)
+        pulsePal.triggerChannels(channels[0], channels[1], channels[2], channels[3]);
+}
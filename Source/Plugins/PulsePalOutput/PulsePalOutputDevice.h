@@ -0,0 +1,50 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __PULSEPALOUTPUTDEVICE_H__
+#define __PULSEPALOUTPUTDEVICE_H__
+
+#include <SerialLib.h>
+#include "serial/PulsePal.h"
+
+/**
+
+  Fires Pulse Pal channels from the OutputDispatcher thread. Triggers on
+  different channels that are due within SIMULTANEOUS_TRIGGER_WINDOW of
+  each other are merged into a single serial message; a channel that is
+  triggered again, or a trigger due later, starts a new message.
+
+*/
+
+class PulsePalOutputDevice : public OutputDevice
+{
+public:
+    PulsePalOutputDevice(PulsePal& pulsePal_) : pulsePal(pulsePal_) {}
+
+    void sendCommands(const OutputCommand* commands, int numCommands);
+
+private:
+    PulsePal& pulsePal;
+};
+
+#endif  // __PULSEPALOUTPUTDEVICE_H__
@@ -96,11 +96,12 @@ void PulsePal::initialize()
 
    // bool foundDevice = false;
 
-    int id = devices[0].getDeviceID();
-        string path = devices[0].getDevicePath();
-        string name = devices[0].getDeviceName();
+    initialize(devices[0].getDevicePath());
+}
 
-    serial.setup(id, 115200);
+void PulsePal::initialize(string portName)
+{
+    serial.setup(portName, 115200);
     std::cout << "Found Pulse Pal with firmware version " << getFirmwareVersion() << std::endl;
 }
 
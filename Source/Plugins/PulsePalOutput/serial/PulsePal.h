@@ -42,6 +42,8 @@ public:
     PulsePal();
     ~PulsePal();
     void initialize();
+    /** Connects to the Pulse Pal on a given serial port */
+    void initialize(string portName);
     uint32_t getFirmwareVersion();
     void disconnectClient();
 
@@ -27,13 +27,14 @@
 
 RecordControl::RecordControl()
     : GenericProcessor("Record Control"),
-      triggerChannel(0)
+      triggerChannel(0), preTriggerSeconds(1.0f), postTriggerSeconds(2.0f)
 {
 
 }
 
 RecordControl::~RecordControl()
 {
+    cancelPendingUpdate();
 
 }
 
@@ -57,6 +58,14 @@ void RecordControl::setParameter(int parameterIndex, float newValue)
     {
         triggerEdge = (Edges)((int)newValue - 1);
     }
+    else if (parameterIndex == 3)
+    {
+        preTriggerSeconds = newValue;
+    }
+    else if (parameterIndex == 4)
+    {
+        postTriggerSeconds = newValue;
+    }
 }
 
 void RecordControl::updateTriggerChannel(int newChannel)
@@ -67,6 +76,12 @@ void RecordControl::updateTriggerChannel(int newChannel)
 bool RecordControl::enable()
 {
 
+    if (triggerType == TRIGGERED && triggerChannel >= 0)
+    {
+        CoreServices::RecordNode::setTriggeredRecording(triggerChannel, triggerEdge == RISING ? 1 : 0,
+                                                        preTriggerSeconds, postTriggerSeconds);
+    }
+
     return true;
 }
 
@@ -92,25 +107,39 @@ void RecordControl::handleEvent(int eventType, MidiMessage& event, int)
 
         //std::cout << "Trigger!" << std::endl;
 
-        const MessageManagerLock mmLock;
-
+        // the RecordNode handles the edges itself in triggered mode; otherwise the
+        // request is passed on rather than blocking this thread on the message thread
         if (triggerType == SET)
         {
-            if (eventId == edge)
-            {
-                CoreServices::setRecordingStatus(true);
-            }
-            else
-            {
-                CoreServices::setRecordingStatus(false);
-            }
+            pendingRequest = (eventId == edge) ? START : STOP;
+            triggerAsyncUpdate();
         }
         else if (triggerType == TOGGLE && eventId == edge)
         {
-            CoreServices::setRecordingStatus(!CoreServices::getRecordingStatus());
+            pendingRequest = FLIP;
+            triggerAsyncUpdate();
         }
     }
 
 }
 
+void RecordControl::handleAsyncUpdate()
+{
+    int request = pendingRequest.exchange(NONE);
+
+    if (request == START)
+    {
+        CoreServices::setRecordingStatus(true);
+    }
+    else if (request == STOP)
+    {
+        CoreServices::setRecordingStatus(false);
+    }
+    else if (request == FLIP)
+    {
+        CoreServices::setRecordingStatus(!CoreServices::getRecordingStatus());
+    }
+
+}
+
 
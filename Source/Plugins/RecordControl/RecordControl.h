@@ -31,11 +31,16 @@
 
   Stops and stops recording in response to incoming events.
 
+  The recording state is changed on the message thread, so the edge only
+  takes effect a few blocks later. For sample-accurate trial windows, the
+  "Triggered window" mode hands the trigger channel to the RecordNode instead.
+
   @see RecordNode
 
 */
 
-class RecordControl : public GenericProcessor
+class RecordControl : public GenericProcessor,
+    public AsyncUpdater
 {
 public:
     RecordControl();
@@ -46,6 +51,9 @@ public:
     void updateTriggerChannel(int newChannel);
     void handleEvent(int eventType, MidiMessage& event, int);
 
+    /** Applies the recording state requested by the last trigger */
+    void handleAsyncUpdate();
+
     bool enable();
 
     bool isUtility()
@@ -58,10 +66,16 @@ public:
 private:
     int triggerChannel;
     enum Edges { RISING = 0, FALLING = 1 };
-    enum Types {SET = 0, TOGGLE = 1};
+    enum Types {SET = 0, TOGGLE = 1, TRIGGERED = 2};
     Edges triggerEdge;
     Types triggerType;
 
+    float preTriggerSeconds;
+    float postTriggerSeconds;
+
+    enum Requests {NONE = 0, START = 1, STOP = 2, FLIP = 3};
+    Atomic<int> pendingRequest;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordControl);
 
 };
@@ -28,7 +28,7 @@
 RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors=true)
     : GenericEditor(parentNode, useDefaultParameterEditors)
 {
-    desiredWidth = 170;
+    desiredWidth = 240;
 
     //channelSelector->eventsOnly = true;
 
@@ -85,6 +85,42 @@ RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useD
 
     addAndMakeVisible(triggerPol);
 
+    // pre- and post-trigger times of the triggered window mode
+    lastPreString = "1";
+    lastPostString = "2";
+
+    preLabel = new Label("Pre Text", "Pre (s):");
+    preLabel->setEditable(false);
+    preLabel->setJustificationType(Justification::centredLeft);
+    preLabel->setBounds(150, 20, 80, 20);
+    addAndMakeVisible(preLabel);
+
+    preValue = new Label("Pre Value", lastPreString);
+    preValue->setBounds(155, 40, 60, 18);
+    preValue->setFont(Font("Default", 15, Font::plain));
+    preValue->setColour(Label::textColourId, Colours::white);
+    preValue->setColour(Label::backgroundColourId, Colours::grey);
+    preValue->setEditable(true);
+    preValue->addListener(this);
+    preValue->setTooltip("Seconds recorded before the trigger");
+    addAndMakeVisible(preValue);
+
+    postLabel = new Label("Post Text", "Post (s):");
+    postLabel->setEditable(false);
+    postLabel->setJustificationType(Justification::centredLeft);
+    postLabel->setBounds(150, 60, 80, 20);
+    addAndMakeVisible(postLabel);
+
+    postValue = new Label("Post Value", lastPostString);
+    postValue->setBounds(155, 80, 60, 18);
+    postValue->setFont(Font("Default", 15, Font::plain));
+    postValue->setColour(Label::textColourId, Colours::white);
+    postValue->setColour(Label::backgroundColourId, Colours::grey);
+    postValue->setEditable(true);
+    postValue->addListener(this);
+    postValue->setTooltip("Seconds recorded after the trigger; 0 records until the opposite edge");
+    addAndMakeVisible(postValue);
+
     availableChans->addItem("None",1);
     for (int i = 0; i < 10 ; i++)
     {
@@ -96,6 +132,7 @@ RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useD
 
     triggerMode->addItem("Edge set", 1);
     triggerMode->addItem("Edge toggle", 2);
+    triggerMode->addItem("Triggered window", 3);
     triggerMode->setSelectedId(1, sendNotification);
 
     triggerPol->addItem("Rising", 1);
@@ -129,6 +166,30 @@ void RecordControlEditor::comboBoxChanged(ComboBox* comboBox)
 }
 
 
+void RecordControlEditor::labelTextChanged(Label* label)
+{
+    float requestedValue = label->getText().getFloatValue();
+
+    if (requestedValue < 0 || requestedValue > 60)
+    {
+        CoreServices::sendStatusMessage("Value out of range.");
+
+        label->setText(label == preValue ? lastPreString : lastPostString, dontSendNotification);
+        return;
+    }
+
+    if (label == preValue)
+    {
+        getProcessor()->setParameter(3, requestedValue);
+        lastPreString = label->getText();
+    }
+    else
+    {
+        getProcessor()->setParameter(4, requestedValue);
+        lastPostString = label->getText();
+    }
+}
+
 void RecordControlEditor::updateSettings()
 {
     //availableChans->clear();
@@ -146,6 +207,8 @@ void RecordControlEditor::saveCustomParameters(XmlElement* xml)
     info->setAttribute("Channel",availableChans->getSelectedId());
     info->setAttribute("Mode", triggerMode->getSelectedId());
     info->setAttribute("Edge", triggerPol->getSelectedId());
+    info->setAttribute("PreTrigger", lastPreString);
+    info->setAttribute("PostTrigger", lastPostString);
 
 }
 
@@ -160,6 +223,8 @@ void RecordControlEditor::loadCustomParameters(XmlElement* xml)
             availableChans->setSelectedId(xmlNode->getIntAttribute("Channel"), sendNotification);
             triggerMode->setSelectedId(xmlNode->getIntAttribute("Mode", 1), sendNotification);
             triggerPol->setSelectedId(xmlNode->getIntAttribute("Edge", 1), sendNotification);
+            preValue->setText(xmlNode->getStringAttribute("PreTrigger", "1"), sendNotificationSync);
+            postValue->setText(xmlNode->getStringAttribute("PostTrigger", "2"), sendNotificationSync);
         }
 
     }
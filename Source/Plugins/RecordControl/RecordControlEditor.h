@@ -35,12 +35,14 @@
 */
 
 class RecordControlEditor : public GenericEditor,
-    public ComboBox::Listener
+    public ComboBox::Listener,
+    public Label::Listener
 {
 public:
     RecordControlEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors);
     ~RecordControlEditor();
     void comboBoxChanged(ComboBox* comboBox);
+    void labelTextChanged(Label* label);
     void updateSettings();
     void loadCustomParameters(XmlElement*);
     void saveCustomParameters(XmlElement*);
@@ -48,6 +50,9 @@ public:
 private:
     ScopedPointer<ComboBox> availableChans, triggerMode, triggerPol;
     ScopedPointer<Label> chanSel, triggerLabel, polLabel;
+    ScopedPointer<Label> preLabel, postLabel, preValue, postValue;
+
+    String lastPreString, lastPostString;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordControlEditor);
 
@@ -0,0 +1,282 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Publishes numbered samples through SharedMemoryRing while a child process
+    follows the segment with the C reader library (Reader/oe_shm_reader.c)
+    and checks every sample it copies. Reports the writer's cost per block,
+    the reader's rate and latency, and the samples it lost to overwriting.
+
+        make test                 (in Source/Plugins/SharedMemoryExport)
+        ./SharedMemoryTest [seconds]
+
+    When the writer is paced at real time the reader has to get every
+    sample; when it writes as fast as it can, samples may be lost, but none
+    that oe_shm_copy reports as valid may differ from what was written.
+*/
+
+#include "../SharedMemoryRing.h"
+#include "../Reader/oe_shm_reader.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SAMPLE_RATE 30000.0
+#define BLOCK_SIZE 1024
+#define RING_SECONDS 2.0
+#define CHUNK 4096
+#define MAX_LATENCIES 100000
+
+// unpaced runs write this many times more, so the ring wraps many times over
+#define FLAT_OUT_FACTOR 10
+
+namespace
+{
+struct Scenario
+{
+    int numChannels;
+    bool paced;
+};
+
+struct ReaderResult
+{
+    uint64 samples;
+    uint64 lost;
+    uint64 bad;
+    double seconds;
+    double medianLatencyUs;
+    double p99LatencyUs;
+};
+
+inline float sampleValue(int channel, uint64 index)
+{
+    // whole numbers below 2^24, so they are exact as floats
+    return float((index * 31 + uint64(channel) * 1009) % 100003);
+}
+
+double secondsSince(int64 start)
+{
+    return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+}
+
+/** Child process: follows the segment until the writer stops */
+void followRing(const char* name, int fd)
+{
+    ReaderResult result = {};
+    oe_shm_reader* r = oe_shm_open(name);
+    char ready = (r != nullptr) ? 1 : 0;
+
+    if (write(fd, &ready, 1) != 1 || r == nullptr)
+        _exit(1);
+
+    const int numChannels = int(oe_shm_num_channels(r));
+    HeapBlock<float> buffer(CHUNK);
+    HeapBlock<uint64> latencies(MAX_LATENCIES);
+    int numLatencies = 0;
+
+    uint64 next = 0;
+    const uint64 start = oe_shm_now_ns();
+
+    for (;;)
+    {
+        // the writer publishes its last block before it stops, so once it
+        // has stopped the write index is final
+        const bool stopped = ! oe_shm_is_running(r);
+        const uint64 end = stopped ? oe_shm_write_index(r) : oe_shm_wait(r, next, 100);
+        uint64_t writeTime;
+
+        if (end > next && numLatencies < MAX_LATENCIES && oe_shm_get_write_time(r, end - 1, &writeTime) == 0)
+            latencies[numLatencies++] = oe_shm_now_ns() - writeTime;
+
+        while (next < end)
+        {
+            const uint32 count = uint32(jmin<uint64>(end - next, CHUNK));
+            bool copied = true;
+            bool matches = true;
+
+            for (int ch = 0; ch < numChannels && copied && matches; ch++)
+            {
+                copied = oe_shm_copy(r, uint32(ch), next, buffer, count) == 0;
+
+                for (uint32 i = 0; i < count && copied && matches; i++)
+                    matches = buffer[i] == sampleValue(ch, next + i);
+            }
+
+            if (! copied)
+                result.lost += count;
+            else if (! matches)
+                result.bad += count;
+            else
+                result.samples += count;
+
+            next += count;
+        }
+
+        if (stopped)
+            break;
+    }
+
+    result.seconds = (oe_shm_now_ns() - start) * 1e-9;
+
+    if (numLatencies > 0)
+    {
+        std::sort(latencies.getData(), latencies.getData() + numLatencies);
+        result.medianLatencyUs = latencies[numLatencies / 2] * 1e-3;
+        result.p99LatencyUs = latencies[numLatencies * 99 / 100] * 1e-3;
+    }
+
+    oe_shm_close(r);
+
+    _exit(write(fd, &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+}
+
+bool readAll(int fd, void* dest, size_t size)
+{
+    char* p = static_cast<char*>(dest);
+
+    while (size > 0)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= size_t(n);
+    }
+
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 3.0;
+    const Scenario scenarios[] = {{64, true}, {256, true}, {64, false}, {256, false}};
+    const String name("oe-shm-test-" + String(getpid()));
+    const int pacedBlocks = jmax(1, int(seconds * SAMPLE_RATE / BLOCK_SIZE));
+    bool allPassed = true;
+
+    printf("%d blocks of %d samples per channel at %.0f Hz (%dx as many unpaced), ring of %.0f s\n",
+           pacedBlocks, BLOCK_SIZE, SAMPLE_RATE, FLAT_OUT_FACTOR, RING_SECONDS);
+
+    for (int n = 0; n < int(sizeof(scenarios) / sizeof(scenarios[0])); n++)
+    {
+        const int numChannels = scenarios[n].numChannels;
+        const bool paced = scenarios[n].paced;
+        const int numBlocks = paced ? pacedBlocks : pacedBlocks * FLAT_OUT_FACTOR;
+        const uint64 numSamples = uint64(numBlocks) * BLOCK_SIZE;
+
+        StringArray names;
+        Array<float> bitVolts;
+        Array<int> channels;
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            names.add("CH" + String(ch + 1));
+            bitVolts.add(0.195f);
+            channels.add(ch);
+        }
+
+        SharedMemoryRing ring;
+
+        if (! ring.create(name, SAMPLE_RATE, int(RING_SECONDS * SAMPLE_RATE), names, bitVolts, channels, true))
+        {
+            printf("Can't create the shared memory segment %s\n", name.toRawUTF8());
+            return 1;
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0)
+            return 1;
+
+        const pid_t child = fork();
+
+        if (child == 0)
+        {
+            close(fds[0]);
+            followRing(name.toRawUTF8(), fds[1]);
+        }
+
+        close(fds[1]);
+
+        char ready = 0;
+        if (child < 0 || ! readAll(fds[0], &ready, 1) || ! ready)
+        {
+            printf("The reader couldn't open %s\n", name.toRawUTF8());
+            return 1;
+        }
+
+        AudioSampleBuffer buffer(numChannels, BLOCK_SIZE);
+        double writeSeconds = 0;
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBlocks; b++)
+        {
+            const uint64 first = uint64(b) * BLOCK_SIZE;
+
+            // hand blocks over once they are due, like an acquisition board
+            while (paced && secondsSince(start) * SAMPLE_RATE < double(first + BLOCK_SIZE))
+                Thread::sleep(1);
+
+            for (int ch = 0; ch < numChannels; ch++)
+            {
+                float* dest = buffer.getWritePointer(ch);
+                for (int i = 0; i < BLOCK_SIZE; i++)
+                    dest[i] = sampleValue(ch, first + i);
+            }
+
+            const int64 writeStart = Time::getHighResolutionTicks();
+            ring.writeBlock(buffer, channels.getRawDataPointer(), BLOCK_SIZE, int64(first));
+            writeSeconds += secondsSince(writeStart);
+        }
+
+        ring.close();
+
+        ReaderResult result;
+        int status = 0;
+        const bool gotResult = readAll(fds[0], &result, sizeof(result));
+        close(fds[0]);
+        waitpid(child, &status, 0);
+
+        if (! gotResult || ! WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            printf("The reader failed\n");
+            return 1;
+        }
+
+        // paced, the reader must keep up; flat out, it may fall a ring behind
+        const bool passed = result.bad == 0 && result.samples + result.lost == numSamples
+                            && (! paced || result.lost == 0);
+        allPassed = allPassed && passed;
+
+        const double readMB = double(result.samples) * numChannels * sizeof(float) / (1024.0 * 1024.0);
+
+        printf("%3d channels, %-8s: write %6.1f us/block, read %7.1f MB/s, %llu lost, %llu bad, "
+               "latency median %6.1f us, 99%% %6.1f us  %s\n",
+               numChannels, paced ? "paced" : "flat out", writeSeconds * 1e6 / numBlocks,
+               readMB / result.seconds, (unsigned long long) result.lost, (unsigned long long) result.bad,
+               result.medianLatencyUs, result.p99LatencyUs, passed ? "ok" : "FAILED");
+    }
+
+    printf("%s\n", allPassed ? "All scenarios passed" : "Some scenarios failed");
+
+    return allPassed ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef OE_SHM_H_INCLUDED
+#define OE_SHM_H_INCLUDED
+
+/*
+    Layout of the shared-memory segment written by the Shared Memory Export
+    processor. This header is plain C so it can be used by the processor and
+    by readers in any language that can map memory.
+
+    The segment is named "/oe-shm-<node id>" (POSIX shm_open) or
+    "Local\oe-shm-<node id>" (Windows file mapping). All integers are
+    little-endian, all offsets are from the start of the segment.
+
+        oe_shm_header        at 0
+        oe_shm_channel       numChannels entries at channelOffset
+        oe_shm_block         maxBlocks entries at blockOffset
+        float32 samples      numChannels rings of capacity samples at dataOffset
+
+    Samples are in microvolts. Channel c's ring starts at
+    dataOffset + c * capacity * 4; sample number i (counted from the start of
+    acquisition) is stored at position i & (capacity - 1).
+
+    For every block the writer first raises writeLimit to the end of the
+    block, then copies the samples into every ring, fills the block entry
+    blocks[blockCount & (maxBlocks - 1)], publishes blockCount and writeIndex
+    (the number of samples written per channel) with release semantics, and
+    finally increments sequence. Readers load writeIndex with acquire
+    semantics. Samples below writeLimit - capacity may be overwritten at any
+    time, so a reader that copies data must load writeLimit after the copy
+    and check its range again (oe_shm_copy does this).
+
+    If OE_SHM_FLAG_FUTEX is set (Linux), readers can sleep on the 32-bit
+    sequence word with FUTEX_WAIT after incrementing numWaiters; the writer
+    issues FUTEX_WAKE after every block while numWaiters is not zero.
+    Otherwise readers poll writeIndex.
+
+    When acquisition stops the writer clears running and removes the name;
+    the next acquisition creates a new segment, so readers that see running
+    drop to zero should close and reopen.
+*/
+
+#include <stdint.h>
+
+#define OE_SHM_MAGIC 0x4D534F45u /* "OESM" */
+#define OE_SHM_VERSION 1
+
+#define OE_SHM_FLAG_FUTEX 1u
+
+#define OE_SHM_NAME_PREFIX "oe-shm-"
+#define OE_SHM_CHANNEL_NAME_LENGTH 32
+
+typedef struct oe_shm_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;        /* sizeof(oe_shm_header) */
+    uint32_t flags;
+
+    uint32_t numChannels;
+    uint32_t capacity;          /* samples per channel ring, a power of two */
+    uint32_t maxBlocks;         /* entries in the block table, a power of two */
+    uint32_t writerPid;
+
+    double sampleRate;
+
+    uint64_t channelOffset;
+    uint64_t blockOffset;
+    uint64_t dataOffset;
+    uint64_t totalSize;         /* size of the whole segment */
+
+    volatile uint32_t running;  /* 1 during acquisition */
+    volatile uint32_t sequence; /* incremented after every block; futex word */
+    volatile uint32_t numWaiters;
+    uint32_t reserved;
+
+    volatile uint64_t writeIndex;  /* samples written per channel */
+    volatile uint64_t blockCount;  /* blocks written */
+    volatile uint64_t writeLimit;  /* end of the block being written */
+} oe_shm_header;
+
+typedef struct oe_shm_channel
+{
+    char name[OE_SHM_CHANNEL_NAME_LENGTH];
+    float bitVolts;
+    uint32_t sourceChannel;     /* index of the channel at the processor's input */
+} oe_shm_channel;
+
+typedef struct oe_shm_block
+{
+    uint64_t startIndex;        /* sample number of the first sample */
+    int64_t timestamp;          /* acquisition timestamp of the first sample */
+    uint64_t writeTimeNs;       /* oe_shm_now_ns() when the block was published */
+    uint32_t numSamples;
+    uint32_t reserved;
+} oe_shm_block;
+
+/* memory ordering helpers shared by the writer and the readers */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <windows.h>
+
+/* x86 and x64 don't reorder stores with stores or loads with loads */
+static __inline uint64_t oe_shm_load_u64(const volatile uint64_t* p)
+{
+    uint64_t v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+
+static __inline void oe_shm_store_u64(volatile uint64_t* p, uint64_t v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+
+static __inline uint32_t oe_shm_load_u32(const volatile uint32_t* p)
+{
+    uint32_t v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+
+static __inline void oe_shm_store_u32(volatile uint32_t* p, uint32_t v)
+{
+    _ReadWriteBarrier();
+    *p = v;
+}
+
+static __inline void oe_shm_fence_acquire(void)
+{
+    _ReadWriteBarrier();
+}
+
+static __inline void oe_shm_fence_release(void)
+{
+    _ReadWriteBarrier();
+}
+
+static __inline uint32_t oe_shm_add_u32(volatile uint32_t* p, int32_t v)
+{
+    return (uint32_t) _InterlockedExchangeAdd((volatile long*) p, v) + v;
+}
+
+static __inline uint64_t oe_shm_now_ns(void)
+{
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * 1.0e9 / (double) frequency.QuadPart);
+}
+
+#else
+#include <time.h>
+
+static inline uint64_t oe_shm_load_u64(const volatile uint64_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void oe_shm_store_u64(volatile uint64_t* p, uint64_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t oe_shm_load_u32(const volatile uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void oe_shm_store_u32(volatile uint32_t* p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline void oe_shm_fence_acquire(void)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void oe_shm_fence_release(void)
+{
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline uint32_t oe_shm_add_u32(volatile uint32_t* p, int32_t v)
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST);
+}
+
+static inline uint64_t oe_shm_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+#endif
+
+#endif /* OE_SHM_H_INCLUDED */
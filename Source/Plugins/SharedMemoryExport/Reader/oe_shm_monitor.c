@@ -0,0 +1,148 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/*
+    Follows a Shared Memory Export segment and reports what a reader gets:
+    samples per second, bandwidth, samples lost to overwriting, and the
+    latency from the writer publishing a block to the reader copying it.
+
+        cc -O2 -o oe_shm_monitor oe_shm_monitor.c oe_shm_reader.c -lrt
+        ./oe_shm_monitor oe-shm-105 [seconds]
+
+    Run it while the GUI acquires to check that an analysis process can keep
+    up with the channels it needs. make test in the plugin folder builds it
+    too, and runs SharedMemoryTest, which needs no GUI.
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "oe_shm_reader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHUNK 4096
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv)
+{
+    oe_shm_reader* r;
+    float* buffer;
+    uint64_t* latencies;
+    uint32_t numChannels;
+    uint64_t next, start, lastReport;
+    uint64_t samples = 0, lost = 0;
+    int numLatencies = 0, maxLatencies = 100000;
+    double seconds;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <segment name> [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    seconds = (argc > 2) ? atof(argv[2]) : 10.0;
+
+    r = oe_shm_open(argv[1]);
+
+    if (r == NULL)
+    {
+        fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    numChannels = oe_shm_num_channels(r);
+    printf("%s: %u channels at %.1f Hz, ring of %u samples%s\n", argv[1], numChannels,
+           oe_shm_sample_rate(r), oe_shm_capacity(r),
+           (oe_shm_get_header(r)->flags & OE_SHM_FLAG_FUTEX) ? ", futex wake-up" : "");
+
+    buffer = (float*) malloc(CHUNK * sizeof(float));
+    latencies = (uint64_t*) malloc(maxLatencies * sizeof(uint64_t));
+
+    next = oe_shm_write_index(r);
+    start = oe_shm_now_ns();
+    lastReport = start;
+
+    while (oe_shm_is_running(r) && oe_shm_now_ns() - start < (uint64_t) (seconds * 1e9))
+    {
+        uint64_t end = oe_shm_wait(r, next, 100);
+        uint64_t writeTime;
+        uint32_t ch;
+
+        if (end <= next)
+            continue;
+
+        /* the block holding the newest sample was published just now */
+        if (numLatencies < maxLatencies && oe_shm_get_write_time(r, end - 1, &writeTime) == 0)
+            latencies[numLatencies++] = oe_shm_now_ns() - writeTime;
+
+        while (next < end)
+        {
+            uint32_t count = (end - next > CHUNK) ? CHUNK : (uint32_t) (end - next);
+            int ok = 1;
+
+            for (ch = 0; ch < numChannels; ch++)
+                ok &= (oe_shm_copy(r, ch, next, buffer, count) == 0);
+
+            if (ok)
+                samples += count;
+            else
+                lost += count;
+
+            next += count;
+        }
+
+        if (oe_shm_now_ns() - lastReport > 1000000000u)
+        {
+            double elapsed = (oe_shm_now_ns() - start) * 1e-9;
+
+            printf("%.0f samples/s per channel, %.1f MB/s, %llu lost\n", samples / elapsed,
+                   samples * numChannels * sizeof(float) / elapsed / 1e6, (unsigned long long) lost);
+            lastReport = oe_shm_now_ns();
+        }
+    }
+
+    if (numLatencies > 0)
+    {
+        qsort(latencies, numLatencies, sizeof(uint64_t), compare_u64);
+
+        printf("latency over %d blocks: median %.1f us, 99%% %.1f us, max %.1f us\n", numLatencies,
+               latencies[numLatencies / 2] * 1e-3, latencies[numLatencies * 99 / 100] * 1e-3,
+               latencies[numLatencies - 1] * 1e-3);
+    }
+
+    free(latencies);
+    free(buffer);
+    oe_shm_close(r);
+
+    return 0;
+}
@@ -0,0 +1,360 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "oe_shm_reader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+struct oe_shm_reader
+{
+    char* segment;
+    size_t size;
+    oe_shm_header* header;
+    const oe_shm_channel* channels;
+    const oe_shm_block* blocks;
+    const float* data;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+};
+
+static void unmap(oe_shm_reader* r)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(r->segment);
+    CloseHandle(r->mapping);
+#else
+    munmap(r->segment, r->size);
+#endif
+}
+
+oe_shm_reader* oe_shm_open(const char* name)
+{
+    oe_shm_reader* r = (oe_shm_reader*) calloc(1, sizeof(oe_shm_reader));
+    char systemName[256];
+
+    if (r == NULL)
+        return NULL;
+
+#ifdef _WIN32
+    snprintf(systemName, sizeof(systemName), "Local\\%s", name);
+
+    r->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, systemName);
+
+    if (r->mapping == NULL)
+    {
+        free(r);
+        return NULL;
+    }
+
+    r->segment = (char*) MapViewOfFile(r->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+    if (r->segment == NULL)
+    {
+        CloseHandle(r->mapping);
+        free(r);
+        return NULL;
+    }
+
+    {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(r->segment, &info, sizeof(info));
+        r->size = info.RegionSize;
+    }
+#else
+    struct stat st;
+    int fd;
+    void* address;
+
+    snprintf(systemName, sizeof(systemName), "/%s", name);
+
+    fd = shm_open(systemName, O_RDWR, 0);
+
+    if (fd < 0)
+    {
+        free(r);
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(oe_shm_header))
+    {
+        close(fd);
+        free(r);
+        return NULL;
+    }
+
+    r->size = (size_t) st.st_size;
+    address = mmap(NULL, r->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        free(r);
+        return NULL;
+    }
+
+    r->segment = (char*) address;
+#endif
+
+    r->header = (oe_shm_header*) r->segment;
+
+    /* the writer stores the magic number once the rest of the header is set */
+    if (oe_shm_load_u32(&r->header->magic) != OE_SHM_MAGIC
+        || r->header->version != OE_SHM_VERSION
+        || r->header->headerSize < sizeof(oe_shm_header)
+        || r->header->totalSize > r->size)
+    {
+        unmap(r);
+        free(r);
+        return NULL;
+    }
+
+    r->channels = (const oe_shm_channel*) (r->segment + r->header->channelOffset);
+    r->blocks = (const oe_shm_block*) (r->segment + r->header->blockOffset);
+    r->data = (const float*) (r->segment + r->header->dataOffset);
+
+    return r;
+}
+
+void oe_shm_close(oe_shm_reader* r)
+{
+    if (r == NULL)
+        return;
+
+    unmap(r);
+    free(r);
+}
+
+const oe_shm_header* oe_shm_get_header(const oe_shm_reader* r)
+{
+    return r->header;
+}
+
+uint32_t oe_shm_num_channels(const oe_shm_reader* r)
+{
+    return r->header->numChannels;
+}
+
+double oe_shm_sample_rate(const oe_shm_reader* r)
+{
+    return r->header->sampleRate;
+}
+
+uint32_t oe_shm_capacity(const oe_shm_reader* r)
+{
+    return r->header->capacity;
+}
+
+const oe_shm_channel* oe_shm_channel_info(const oe_shm_reader* r, uint32_t channel)
+{
+    if (channel >= r->header->numChannels)
+        return NULL;
+
+    return &r->channels[channel];
+}
+
+int oe_shm_is_running(const oe_shm_reader* r)
+{
+    return oe_shm_load_u32(&r->header->running) != 0;
+}
+
+uint64_t oe_shm_write_index(const oe_shm_reader* r)
+{
+    return oe_shm_load_u64(&r->header->writeIndex);
+}
+
+uint64_t oe_shm_wait(oe_shm_reader* r, uint64_t index, int timeoutMs)
+{
+    oe_shm_header* h = r->header;
+    uint64_t deadline = oe_shm_now_ns() + (uint64_t) timeoutMs * 1000000u;
+    uint64_t writeIndex = oe_shm_load_u64(&h->writeIndex);
+
+    while (writeIndex <= index && oe_shm_load_u32(&h->running))
+    {
+        uint64_t now = oe_shm_now_ns();
+
+        if (now >= deadline)
+            break;
+
+#ifdef __linux__
+        if (h->flags & OE_SHM_FLAG_FUTEX)
+        {
+            uint64_t remaining = deadline - now;
+            struct timespec timeout;
+            uint32_t sequence;
+
+            /* announce the wait before sampling sequence, so the writer
+               either sees the waiter or we see its new sequence number */
+            oe_shm_add_u32(&h->numWaiters, 1);
+            sequence = oe_shm_load_u32(&h->sequence);
+
+            if (oe_shm_load_u64(&h->writeIndex) <= index && oe_shm_load_u32(&h->running))
+            {
+                timeout.tv_sec = (time_t) (remaining / 1000000000u);
+                timeout.tv_nsec = (long) (remaining % 1000000000u);
+
+                syscall(SYS_futex, &h->sequence, FUTEX_WAIT, sequence, &timeout, NULL, 0);
+            }
+
+            oe_shm_add_u32(&h->numWaiters, -1);
+        }
+        else
+#endif
+        {
+#ifdef _WIN32
+            Sleep(1);
+#else
+            usleep(1000);
+#endif
+        }
+
+        writeIndex = oe_shm_load_u64(&h->writeIndex);
+    }
+
+    return writeIndex;
+}
+
+const float* oe_shm_channel_data(const oe_shm_reader* r, uint32_t channel)
+{
+    if (channel >= r->header->numChannels)
+        return NULL;
+
+    return r->data + (size_t) channel * r->header->capacity;
+}
+
+int oe_shm_copy(const oe_shm_reader* r, uint32_t channel, uint64_t start, float* dest, uint32_t count)
+{
+    const uint32_t capacity = r->header->capacity;
+    const float* ring;
+    uint32_t position, firstPart;
+
+    if (channel >= r->header->numChannels || count > capacity)
+        return -1;
+
+    if (start + count > oe_shm_load_u64(&r->header->writeIndex))
+        return -1;
+
+    ring = oe_shm_channel_data(r, channel);
+    position = (uint32_t) (start & (capacity - 1));
+    firstPart = capacity - position;
+
+    if (firstPart > count)
+        firstPart = count;
+
+    memcpy(dest, ring + position, firstPart * sizeof(float));
+    memcpy(dest + firstPart, ring, (count - firstPart) * sizeof(float));
+
+    /* the copy is only valid if the writer hadn't started on these samples */
+    oe_shm_fence_acquire();
+
+    if (start + capacity < oe_shm_load_u64(&r->header->writeLimit))
+        return -1;
+
+    return 0;
+}
+
+/* Finds the block holding sample index; returns its table entry, copied */
+static int find_block(const oe_shm_reader* r, uint64_t index, oe_shm_block* found)
+{
+    const oe_shm_header* h = r->header;
+    const uint64_t mask = h->maxBlocks - 1;
+    uint64_t count = oe_shm_load_u64(&h->blockCount);
+    uint64_t lo, hi;
+
+    if (count == 0)
+        return -1;
+
+    /* the oldest entry may be the one being overwritten */
+    lo = (count > h->maxBlocks - 1) ? count - (h->maxBlocks - 1) : 0;
+    hi = count - 1;
+
+    if (index < r->blocks[lo & mask].startIndex)
+        return -1;
+
+    /* last block that starts at or before index */
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+
+        if (r->blocks[mid & mask].startIndex <= index)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    *found = r->blocks[lo & mask];
+
+    oe_shm_fence_acquire();
+
+    if (lo + h->maxBlocks <= oe_shm_load_u64(&h->blockCount))
+        return -1;
+
+    if (index >= found->startIndex + found->numSamples)
+        return -1;
+
+    return 0;
+}
+
+int oe_shm_get_timestamp(const oe_shm_reader* r, uint64_t index, int64_t* timestamp)
+{
+    oe_shm_block block;
+
+    if (find_block(r, index, &block) != 0)
+        return -1;
+
+    *timestamp = block.timestamp + (int64_t) (index - block.startIndex);
+    return 0;
+}
+
+int oe_shm_get_write_time(const oe_shm_reader* r, uint64_t index, uint64_t* writeTimeNs)
+{
+    oe_shm_block block;
+
+    if (find_block(r, index, &block) != 0)
+        return -1;
+
+    *writeTimeNs = block.writeTimeNs;
+    return 0;
+}
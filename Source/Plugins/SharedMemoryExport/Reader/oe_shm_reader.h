@@ -0,0 +1,102 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef OE_SHM_READER_H_INCLUDED
+#define OE_SHM_READER_H_INCLUDED
+
+/*
+    Small C library for reading the segment published by the Shared Memory
+    Export processor (see oe_shm.h for the layout).
+
+        oe_shm_reader* r = oe_shm_open("oe-shm-105");
+        uint64_t next = oe_shm_write_index(r);
+
+        while (oe_shm_is_running(r))
+        {
+            uint64_t end = oe_shm_wait(r, next, 100);
+            ... oe_shm_copy(r, channel, next, buffer, end - next) ...
+            next = end;
+        }
+
+        oe_shm_close(r);
+
+    Build with the C compiler of your choice; on Linux, link with -lrt.
+    Readers only ever write the numWaiters word, so any number of them can
+    follow the same processor.
+*/
+
+#include "oe_shm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct oe_shm_reader oe_shm_reader;
+
+/* Maps the segment with the given name ("oe-shm-<node id>", without a
+   leading slash). Returns NULL if it doesn't exist or isn't valid. */
+oe_shm_reader* oe_shm_open(const char* name);
+
+void oe_shm_close(oe_shm_reader* r);
+
+const oe_shm_header* oe_shm_get_header(const oe_shm_reader* r);
+
+uint32_t oe_shm_num_channels(const oe_shm_reader* r);
+double oe_shm_sample_rate(const oe_shm_reader* r);
+uint32_t oe_shm_capacity(const oe_shm_reader* r);
+const oe_shm_channel* oe_shm_channel_info(const oe_shm_reader* r, uint32_t channel);
+
+/* Zero while the processor isn't acquiring into this segment any more;
+   a new acquisition creates a new segment, so close and reopen. */
+int oe_shm_is_running(const oe_shm_reader* r);
+
+/* Number of samples per channel written so far */
+uint64_t oe_shm_write_index(const oe_shm_reader* r);
+
+/* Waits up to timeoutMs until more than index samples have been written or
+   the writer stops, and returns the write index. Sleeps on a futex when the
+   writer supports it and polls every millisecond otherwise. */
+uint64_t oe_shm_wait(oe_shm_reader* r, uint64_t index, int timeoutMs);
+
+/* The ring of one channel, capacity samples; sample i is at i & (capacity - 1).
+   Zero-copy access: samples older than write index - capacity are overwritten. */
+const float* oe_shm_channel_data(const oe_shm_reader* r, uint32_t channel);
+
+/* Copies samples [start, start + count) of a channel. Returns 0, or -1 if any
+   of them haven't been written yet or were overwritten during the copy. */
+int oe_shm_copy(const oe_shm_reader* r, uint32_t channel, uint64_t start, float* dest, uint32_t count);
+
+/* Finds the acquisition timestamp of sample index. Returns 0, or -1 if its
+   block has left the block table. */
+int oe_shm_get_timestamp(const oe_shm_reader* r, uint64_t index, int64_t* timestamp);
+
+/* Finds when the block holding sample index was published (oe_shm_now_ns).
+   Returns 0, or -1 if its block has left the block table. */
+int oe_shm_get_write_time(const oe_shm_reader* r, uint64_t index, uint64_t* writeTimeNs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OE_SHM_READER_H_INCLUDED */
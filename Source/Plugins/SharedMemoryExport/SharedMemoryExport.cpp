@@ -0,0 +1,140 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "SharedMemoryExport.h"
+
+SharedMemoryExport::SharedMemoryExport()
+    : GenericProcessor("Shared Memory"), ringSeconds(2.0f), wakeReaders(true),
+      inputSourceId(0), mixedSources(false)
+{
+    Array<var> ringLengths;
+    ringLengths.add(1);
+    ringLengths.add(2);
+    ringLengths.add(5);
+    ringLengths.add(10);
+
+    parameters.add(Parameter("Ring (s)", ringLengths, 1, 0));
+    parameters.add(Parameter("Wake readers", true, 1));
+}
+
+SharedMemoryExport::~SharedMemoryExport()
+{
+}
+
+void SharedMemoryExport::setParameter(int parameterIndex, float newValue)
+{
+    editor->updateParameterButtons(parameterIndex);
+
+    if (CoreServices::getAcquisitionStatus())
+    {
+        CoreServices::sendStatusMessage("Shared memory settings apply from the next acquisition.");
+    }
+
+    if (parameterIndex == 0)
+    {
+        ringSeconds = newValue;
+    }
+    else if (parameterIndex == 1)
+    {
+        wakeReaders = (newValue > 0.0f);
+    }
+}
+
+void SharedMemoryExport::updateSettings()
+{
+    mixedSources = false;
+
+    if (channels.size() > 0)
+        inputSourceId = channels[0]->sourceNodeId;
+
+    for (int i = 0; i < channels.size(); i++)
+    {
+        if (channels[i]->sourceNodeId != inputSourceId)
+            mixedSources = true;
+    }
+}
+
+bool SharedMemoryExport::isReady()
+{
+    if (mixedSources)
+    {
+        CoreServices::sendStatusMessage("Shared memory inputs must all come from the same source.");
+        return false;
+    }
+
+    return true;
+}
+
+bool SharedMemoryExport::enable()
+{
+    exportedChannels = getEditor()->getActiveChannels();
+
+    StringArray names;
+    Array<float> bitVolts;
+
+    for (int i = 0; i < exportedChannels.size(); i++)
+    {
+        Channel* chan = channels[exportedChannels[i]];
+
+        names.add(chan->getName());
+        bitVolts.add(chan->bitVolts);
+    }
+
+    double sampleRate = (channels.size() > 0) ? channels[0]->sampleRate : settings.sampleRate;
+    String name = OE_SHM_NAME_PREFIX + String(nodeId);
+
+    if (!ring.create(name, sampleRate, int(sampleRate * ringSeconds), names, bitVolts,
+                     exportedChannels, wakeReaders))
+    {
+        CoreServices::sendStatusMessage("Could not create shared memory " + name);
+        exportedChannels.clear();
+
+        // acquisition goes on without the export
+        return true;
+    }
+
+    std::cout << "Shared memory: " << ring.getName() << ", " << ring.getNumChannels() << " channels, "
+              << ring.getCapacity() << " samples per channel, " << ring.getTotalSize() / 1024 << " kB" << std::endl;
+
+    CoreServices::sendStatusMessage("Exporting " + String(ring.getNumChannels()) + " channels to " + name);
+
+    return true;
+}
+
+bool SharedMemoryExport::disable()
+{
+    ring.close();
+    exportedChannels.clear();
+
+    return true;
+}
+
+void SharedMemoryExport::process(AudioSampleBuffer& buffer, MidiBuffer& events)
+{
+    if (exportedChannels.size() == 0)
+        return;
+
+    ring.writeBlock(buffer, exportedChannels.getRawDataPointer(),
+                    numSamples[inputSourceId], timestamps[inputSourceId]);
+}
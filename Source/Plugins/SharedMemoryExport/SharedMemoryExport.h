@@ -0,0 +1,94 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef SHAREDMEMORYEXPORT_H_INCLUDED
+#define SHAREDMEMORYEXPORT_H_INCLUDED
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <ProcessorHeaders.h>
+
+#include "SharedMemoryRing.h"
+
+/**
+
+    Publishes continuous channels to other processes on the same machine.
+
+    During acquisition the channels selected in the editor are copied, in
+    microvolts, into a shared-memory ring named "oe-shm-<node id>"; a Python,
+    MATLAB or C program maps it and reads the newest samples without any
+    copies through sockets or files. Reader/oe_shm.h documents the layout and
+    Reader/oe_shm_reader.c is a small C library for it.
+
+    The ring holds the last 1 to 10 seconds of every channel. On Linux,
+    readers can sleep until the next block arrives instead of polling.
+
+    All input channels must come from the same source.
+
+    @see SharedMemoryRing
+
+*/
+
+class SharedMemoryExport : public GenericProcessor
+{
+public:
+    SharedMemoryExport();
+    ~SharedMemoryExport();
+
+    bool isSink()
+    {
+        return true;
+    }
+
+    void process(AudioSampleBuffer& buffer, MidiBuffer& events);
+
+    /** parameterIndex = 0: ring length in seconds,
+        parameterIndex = 1: wake sleeping readers */
+    void setParameter(int parameterIndex, float newValue);
+
+    void updateSettings();
+
+    bool isReady();
+    bool enable();
+    bool disable();
+
+private:
+    SharedMemoryRing ring;
+
+    /** Buffer channel of every exported channel */
+    Array<int> exportedChannels;
+
+    float ringSeconds;
+    bool wakeReaders;
+
+    /** Source of the input channels, whose sample counts and timestamps are read */
+    int inputSourceId;
+    bool mixedSources;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryExport);
+};
+
+#endif  // SHAREDMEMORYEXPORT_H_INCLUDED
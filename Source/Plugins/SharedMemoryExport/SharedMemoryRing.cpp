@@ -0,0 +1,298 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemoryRing.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define MIN_CAPACITY 1024
+#define MIN_BLOCKS 256
+
+namespace
+{
+inline size_t alignTo(size_t n, size_t alignment)
+{
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+inline uint32 nextPowerOfTwo32(uint32 n)
+{
+    uint32 p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+}
+
+SharedMemoryRing::SharedMemoryRing()
+    : segment(nullptr), totalSize(0), header(nullptr), blocks(nullptr), data(nullptr),
+      numChannels(0), capacity(0), maxBlocks(0), writeIndex(0), blockCount(0)
+#ifdef _WIN32
+    , mapping(NULL)
+#endif
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+    close();
+}
+
+bool SharedMemoryRing::create(const String& name_, double sampleRate, int numSamplesPerChannel,
+                              const StringArray& channelNames, const Array<float>& bitVolts,
+                              const Array<int>& sourceChannels, bool useFutex)
+{
+    close();
+
+    name = name_;
+    numChannels = channelNames.size();
+    capacity = nextPowerOfTwo32(uint32(jmax(numSamplesPerChannel, MIN_CAPACITY)));
+    maxBlocks = nextPowerOfTwo32(jmax(uint32(MIN_BLOCKS), capacity / 32));
+    writeIndex = 0;
+    blockCount = 0;
+
+    size_t channelOffset = alignTo(sizeof(oe_shm_header), 64);
+    size_t blockOffset = alignTo(channelOffset + numChannels * sizeof(oe_shm_channel), 64);
+    size_t dataOffset = alignTo(blockOffset + maxBlocks * sizeof(oe_shm_block), 4096);
+    totalSize = dataOffset + size_t(numChannels) * capacity * sizeof(float);
+
+#ifdef _WIN32
+    systemName = "Local\\" + name;
+
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                 DWORD(uint64(totalSize) >> 32), DWORD(totalSize & 0xFFFFFFFF),
+                                 systemName.toRawUTF8());
+
+    if (mapping == NULL)
+    {
+        std::cout << "Can't create shared memory " << systemName << std::endl;
+        return false;
+    }
+
+    segment = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, totalSize));
+
+    if (segment == nullptr)
+    {
+        CloseHandle(mapping);
+        mapping = NULL;
+        return false;
+    }
+
+    useFutex = false;
+#else
+    systemName = "/" + name;
+
+    // a segment left behind by a crash would otherwise keep the old layout
+    shm_unlink(systemName.toRawUTF8());
+
+    int fd = shm_open(systemName.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd < 0)
+    {
+        std::cout << "Can't create shared memory " << systemName << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, off_t(totalSize)) != 0)
+    {
+        ::close(fd);
+        shm_unlink(systemName.toRawUTF8());
+        return false;
+    }
+
+    void* address = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        shm_unlink(systemName.toRawUTF8());
+        return false;
+    }
+
+    segment = static_cast<char*>(address);
+
+#ifndef __linux__
+    useFutex = false;
+#endif
+#endif
+
+    // touch every page now rather than on the audio thread
+    memset(segment, 0, totalSize);
+
+    header = reinterpret_cast<oe_shm_header*>(segment);
+    blocks = reinterpret_cast<oe_shm_block*>(segment + blockOffset);
+    data = reinterpret_cast<float*>(segment + dataOffset);
+
+    oe_shm_channel* channelTable = reinterpret_cast<oe_shm_channel*>(segment + channelOffset);
+
+    for (int i = 0; i < numChannels; i++)
+    {
+        channelNames[i].copyToUTF8(channelTable[i].name, OE_SHM_CHANNEL_NAME_LENGTH);
+        channelTable[i].bitVolts = bitVolts[i];
+        channelTable[i].sourceChannel = uint32(sourceChannels[i]);
+    }
+
+    header->version = OE_SHM_VERSION;
+    header->headerSize = sizeof(oe_shm_header);
+    header->flags = useFutex ? OE_SHM_FLAG_FUTEX : 0;
+    header->numChannels = uint32(numChannels);
+    header->capacity = capacity;
+    header->maxBlocks = maxBlocks;
+#ifdef _WIN32
+    header->writerPid = uint32(GetCurrentProcessId());
+#else
+    header->writerPid = uint32(getpid());
+#endif
+    header->sampleRate = sampleRate;
+    header->channelOffset = channelOffset;
+    header->blockOffset = blockOffset;
+    header->dataOffset = dataOffset;
+    header->totalSize = totalSize;
+    header->running = 1;
+
+    // readers check the magic number last
+    oe_shm_store_u32(&header->magic, OE_SHM_MAGIC);
+
+    return true;
+}
+
+void SharedMemoryRing::close()
+{
+    if (segment == nullptr)
+        return;
+
+    oe_shm_store_u32(&header->running, 0);
+    oe_shm_add_u32(&header->sequence, 1);
+    wakeReaders();
+
+#ifdef _WIN32
+    UnmapViewOfFile(segment);
+    CloseHandle(mapping);
+    mapping = NULL;
+#else
+    munmap(segment, totalSize);
+    shm_unlink(systemName.toRawUTF8());
+#endif
+
+    segment = nullptr;
+    header = nullptr;
+    blocks = nullptr;
+    data = nullptr;
+}
+
+bool SharedMemoryRing::isOpen() const
+{
+    return segment != nullptr;
+}
+
+void SharedMemoryRing::writeBlock(const AudioSampleBuffer& buffer, const int* bufferChannels,
+                                  int numSamples, int64 timestamp)
+{
+    if (segment == nullptr || numSamples <= 0)
+        return;
+
+    // a block longer than the ring only leaves its last samples
+    int skipped = 0;
+    if (uint32(numSamples) > capacity)
+    {
+        skipped = numSamples - int(capacity);
+        writeIndex += skipped;
+        timestamp += skipped;
+        numSamples = int(capacity);
+    }
+
+    // readers copying the oldest samples learn that they are about to change
+    oe_shm_store_u64(&header->writeLimit, writeIndex + numSamples);
+    oe_shm_fence_release();
+
+    uint32 position = uint32(writeIndex) & (capacity - 1);
+    int firstPart = jmin(numSamples, int(capacity - position));
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const float* source = buffer.getReadPointer(bufferChannels[ch], skipped);
+        float* ring = data + size_t(ch) * capacity;
+
+        memcpy(ring + position, source, firstPart * sizeof(float));
+
+        if (numSamples > firstPart)
+            memcpy(ring, source + firstPart, (numSamples - firstPart) * sizeof(float));
+    }
+
+    oe_shm_block& block = blocks[blockCount & (maxBlocks - 1)];
+    block.startIndex = writeIndex;
+    block.timestamp = timestamp;
+    block.numSamples = uint32(numSamples);
+    block.writeTimeNs = oe_shm_now_ns();
+
+    writeIndex += numSamples;
+    blockCount++;
+
+    // blockCount first, so a reader that sees the new writeIndex finds its block
+    oe_shm_store_u64(&header->blockCount, blockCount);
+    oe_shm_store_u64(&header->writeIndex, writeIndex);
+    oe_shm_add_u32(&header->sequence, 1);
+
+    wakeReaders();
+}
+
+void SharedMemoryRing::wakeReaders()
+{
+#ifdef __linux__
+    // the system call is skipped unless a reader is about to sleep. Reading the
+    // count with a full barrier pairs with the reader's increment before it
+    // samples sequence, so a wake-up can't be missed.
+    if ((header->flags & OE_SHM_FLAG_FUTEX) && oe_shm_add_u32(&header->numWaiters, 0) != 0)
+        syscall(SYS_futex, &header->sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+String SharedMemoryRing::getName() const
+{
+    return name;
+}
+
+int SharedMemoryRing::getNumChannels() const
+{
+    return numChannels;
+}
+
+int SharedMemoryRing::getCapacity() const
+{
+    return int(capacity);
+}
+
+size_t SharedMemoryRing::getTotalSize() const
+{
+    return totalSize;
+}
@@ -0,0 +1,104 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYRING_H_INCLUDED
+#define SHAREDMEMORYRING_H_INCLUDED
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+#include "Reader/oe_shm.h"
+
+/**
+
+    Writer side of the shared-memory segment described in Reader/oe_shm.h.
+
+    create() maps a new named segment sized for the channels and ring
+    length; writeBlock() is called from the audio thread and only copies
+    samples and updates the header, plus a futex wake-up on Linux when a
+    reader is waiting.
+
+    @see SharedMemoryExport, oe_shm.h
+
+*/
+
+class SharedMemoryRing
+{
+public:
+    SharedMemoryRing();
+    ~SharedMemoryRing();
+
+    /** Creates and maps the segment, replacing any stale one with the same
+        name. Returns false (and leaves the ring closed) on failure. */
+    bool create(const String& name, double sampleRate, int numSamplesPerChannel,
+                const StringArray& channelNames, const Array<float>& bitVolts,
+                const Array<int>& sourceChannels, bool useFutex);
+
+    /** Marks the segment as stopped, wakes the readers and removes the name */
+    void close();
+
+    bool isOpen() const;
+
+    /** Appends numSamples samples of the given buffer channels, which start
+        at acquisition timestamp. Audio thread only. */
+    void writeBlock(const AudioSampleBuffer& buffer, const int* bufferChannels,
+                    int numSamples, int64 timestamp);
+
+    /** Name a reader passes to oe_shm_open */
+    String getName() const;
+
+    int getNumChannels() const;
+    int getCapacity() const;
+    size_t getTotalSize() const;
+
+private:
+    void wakeReaders();
+
+    String name;
+    String systemName;
+
+    char* segment;
+    size_t totalSize;
+
+    oe_shm_header* header;
+    oe_shm_block* blocks;
+    float* data;
+
+    int numChannels;
+    uint32 capacity;
+    uint32 maxBlocks;
+
+    uint64 writeIndex;
+    uint64 blockCount;
+
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryRing);
+};
+
+#endif  // SHAREDMEMORYRING_H_INCLUDED
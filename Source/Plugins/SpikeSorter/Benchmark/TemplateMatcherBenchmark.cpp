@@ -0,0 +1,133 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Times TemplateMatcher::matchSpike on one core: a tetrode with 40 samples
+    per channel, synthetic templates and noisy spikes drawn from them.
+    Reports spikes per second and how many spikes went to the template they
+    came from, for a range of template counts.
+
+        make benchmark            (in Source/Plugins/SpikeSorter)
+        ./TemplateMatcherBenchmark [numSpikes]
+
+    The sorter has to keep up with 10k spikes/s per core.
+*/
+
+#include "../TemplateMatcher.h"
+
+#include <random>
+
+#define NUM_CHANNELS 4
+#define WAVEFORM_LENGTH 40
+#define GAIN 5000.0f
+#define REQUIRED_RATE 10000.0
+
+namespace
+{
+/** Stores a waveform in microvolts the way spike detectors do */
+void makeSpike(SpikeObject& so, const float* waveform)
+{
+    memset(&so, 0, sizeof(SpikeObject));
+    so.nChannels = NUM_CHANNELS;
+    so.nSamples = WAVEFORM_LENGTH;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+        so.gain[ch] = GAIN;
+
+    for (int i = 0; i < NUM_CHANNELS * WAVEFORM_LENGTH; i++)
+    {
+        const float value = waveform[i] * GAIN / 1000.0f + 32768.0f;
+        so.data[i] = uint16(jlimit(0.0f, 65535.0f, value));
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int numSpikes = (argc > 1) ? atoi(argv[1]) : 100000;
+    const int dim = NUM_CHANNELS * WAVEFORM_LENGTH;
+    const int templateCounts[] = {8, 32, 128, 512};
+    bool fastEnough = true;
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> shape(0.0f, 90.0f);
+    std::normal_distribution<float> noise(0.0f, 30.0f);
+
+    printf("%d spikes, %d channels x %d samples\n", numSpikes, NUM_CHANNELS, WAVEFORM_LENGTH);
+
+    for (int n = 0; n < int(sizeof(templateCounts) / sizeof(templateCounts[0])); n++)
+    {
+        const int numTemplates = templateCounts[n];
+        const uint8 color[3] = {255, 255, 255};
+
+        TemplateMatcher matcher(NUM_CHANNELS, WAVEFORM_LENGTH);
+        HeapBlock<float> templates(numTemplates * dim);
+
+        for (int t = 0; t < numTemplates; t++)
+        {
+            for (int i = 0; i < dim; i++)
+                templates[t * dim + i] = shape(rng);
+
+            // the noise puts spikes about sqrt(dim) * 30 uV from their template
+            matcher.addTemplate(t + 1, color, templates + t * dim, 600.0f);
+        }
+
+        Array<SpikeObject> spikes;
+        spikes.resize(numSpikes);
+        HeapBlock<float> waveform(dim);
+
+        for (int s = 0; s < numSpikes; s++)
+        {
+            const float* source = templates + (s % numTemplates) * dim;
+
+            for (int i = 0; i < dim; i++)
+                waveform[i] = source[i] + noise(rng);
+
+            makeSpike(spikes.getReference(s), waveform);
+        }
+
+        int correct = 0;
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int s = 0; s < numSpikes; s++)
+        {
+            SpikeObject& so = spikes.getReference(s);
+
+            if (matcher.matchSpike(&so) && so.sortedId == (s % numTemplates) + 1)
+                correct++;
+        }
+
+        const double seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+        const double rate = numSpikes / seconds;
+
+        printf("%4d templates: %10.0f spikes/s (%6.2f us/spike), %d of %d matched correctly\n",
+               numTemplates, rate, 1e6 * seconds / numSpikes, correct, numSpikes);
+
+        if (rate < REQUIRED_RATE)
+            fastEnough = false;
+    }
+
+    printf("%s %.0f spikes/s per core\n", fastEnough ? "All counts sustain" : "Some counts fall below", REQUIRED_RATE);
+
+    return fastEnough ? 0 : 1;
+}
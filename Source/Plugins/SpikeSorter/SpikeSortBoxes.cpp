@@ -26,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "SpikeSortBoxes.h"
 #include "SpikeSorter.h"
 
+// PCA units with fewer buffered spikes than this get no template
+#define MIN_SPIKES_PER_TEMPLATE 10
+
 PointD::PointD()
 {
     X = Y = 0;
@@ -591,6 +594,7 @@ void BoxUnit::updateWaveform(SpikeObject* so)
 /***********************************************/
 
 SpikeSortBoxes::SpikeSortBoxes(UniqueIDgenerator* uniqueIDgenerator_,PCAcomputingThread* pth, int numch, double SamplingRate, int WaveFormLength)
+    : templateMatcher(numch, WaveFormLength)
 {
     uniqueIDgenerator = uniqueIDgenerator_;
     computingThread = pth;
@@ -599,7 +603,6 @@ SpikeSortBoxes::SpikeSortBoxes(UniqueIDgenerator* uniqueIDgenerator_,PCAcomputin
     spikeBufferIndex = -1;
     bPCAcomputed = false;
     bPCAJobSubmitted = false;
-    bPCAjobFinished = false;
     selectedUnit = -1;
     selectedBox = -1;
     bRePCA = false;
@@ -647,6 +650,7 @@ void SpikeSortBoxes::resizeWaveform(int numSamples)
     {
         boxUnits[k].resizeWaveform(waveformLength);
     }
+    templateMatcher.resize(numChannels, waveformLength);
     //EndCriticalSection();
 }
 
@@ -680,8 +684,8 @@ void SpikeSortBoxes::loadCustomParametersFromXml(XmlElement* electrodeNode)
                     pc1max = UnitNode->getDoubleAttribute("pc1max");
                     pc2max = UnitNode->getDoubleAttribute("pc2max");
 
-                    bPCAjobFinished = UnitNode->getBoolAttribute("PCAjobFinished");
                     bPCAcomputed = UnitNode->getBoolAttribute("PCAcomputed");
+                    newPCArange = bPCAcomputed ? 1 : 0;
 
                     delete(pc1);
                     delete(pc2);
@@ -753,6 +757,11 @@ void SpikeSortBoxes::loadCustomParametersFromXml(XmlElement* electrodeNode)
                     // add polygon unit
                     pcaUnits.push_back(pcaUnit);
                 }
+                if (UnitNode->hasTagName("TEMPLATES"))
+                {
+                    templateMatcher.resize(numChannels, waveformLength);
+                    templateMatcher.loadFromXml(UnitNode);
+                }
             }
         }
     }
@@ -776,7 +785,7 @@ void SpikeSortBoxes::saveCustomParametersToXml(XmlElement* electrodeNode)
     pcaNode->setAttribute("pc1max", pc1max);
     pcaNode->setAttribute("pc2max", pc2max);
 
-    pcaNode->setAttribute("PCAjobFinished", bPCAjobFinished);
+    pcaNode->setAttribute("PCAjobFinished", bPCAcomputed);
     pcaNode->setAttribute("PCAcomputed", bPCAcomputed);
 
     for (int k=0; k<numChannels*waveformLength; k++)
@@ -826,6 +835,8 @@ void SpikeSortBoxes::saveCustomParametersToXml(XmlElement* electrodeNode)
         }
     }
 
+    templateMatcher.saveToXml(spikesortNode);
+
 
     //float *pc1, *pc2;
 
@@ -855,14 +866,13 @@ void SpikeSortBoxes::getSelectedUnitAndBox(int& unitID, int& boxid)
 
 void SpikeSortBoxes::projectOnPrincipalComponents(SpikeObject* so)
 {
+    // sorting workers call this while the GUI may change the electrode
+    const ScopedLock myScopedLock(mut);
+
     SpikeObject copySpike = *so;
     spikeBufferIndex++;
     spikeBufferIndex %= bufferSize;
     spikeBuffer.set(spikeBufferIndex, copySpike);
-    if (bPCAjobFinished)
-    {
-        bPCAcomputed = true;
-    }
 
     if (bPCAcomputed)
     {
@@ -887,7 +897,7 @@ void SpikeSortBoxes::projectOnPrincipalComponents(SpikeObject* so)
             bPCAJobSubmitted = true;
             bRePCA = false;
             // submit a new job to compute the spike buffer.
-            PCAjob job(spikeBuffer,pc1,pc2, &pc1min, &pc2min, &pc1max, &pc2max, &bPCAjobFinished);
+            PCAjob job(spikeBuffer, this);
             computingThread->addPCAjob(job);
         }
     }
@@ -895,6 +905,7 @@ void SpikeSortBoxes::projectOnPrincipalComponents(SpikeObject* so)
 
 void SpikeSortBoxes::getPCArange(float& p1min,float& p2min, float& p1max,  float& p2max)
 {
+    const ScopedLock myScopedLock(mut);
     p1min = pc1min;
     p2min = pc2min;
     p1max = pc1max;
@@ -903,6 +914,7 @@ void SpikeSortBoxes::getPCArange(float& p1min,float& p2min, float& p1max,  float
 
 void SpikeSortBoxes::setPCArange(float p1min,float p2min, float p1max,  float p2max)
 {
+    const ScopedLock myScopedLock(mut);
     pc1min=p1min;
     pc2min=p2min;
     pc1max=p1max;
@@ -910,17 +922,44 @@ void SpikeSortBoxes::setPCArange(float p1min,float p2min, float p1max,  float p2
 }
 
 
-void SpikeSortBoxes::resetJobStatus()
+void SpikeSortBoxes::setPCAresult(const float* newPc1, const float* newPc2, int dim,
+                                  float p1min, float p2min, float p1max, float p2max)
 {
-    bPCAjobFinished = false;
+    const ScopedLock myScopedLock(mut);
+
+    // the waveform was resized while the job ran; a new job will follow
+    if (dim != numChannels * waveformLength)
+        return;
+
+    memcpy(pc1, newPc1, dim * sizeof(float));
+    memcpy(pc2, newPc2, dim * sizeof(float));
+    pc1min = p1min;
+    pc2min = p2min;
+    pc1max = p1max;
+    pc2max = p2max;
+    bPCAcomputed = true;
+
+    newPCArange = 1;
 }
 
-bool SpikeSortBoxes::isPCAfinished()
+bool SpikeSortBoxes::getNewPCArange(float& p1min, float& p2min, float& p1max, float& p2max)
 {
-    return bPCAjobFinished;
+    const ScopedTryLock myScopedTryLock(mut);
+
+    // if a worker holds the lock, the range is picked up with a later spike
+    if (!myScopedTryLock.isLocked() || !newPCArange.compareAndSetBool(0, 1))
+        return false;
+
+    p1min = pc1min;
+    p2min = pc2min;
+    p1max = pc1max;
+    p2max = pc2max;
+    return true;
 }
+
 void SpikeSortBoxes::RePCA()
 {
+    const ScopedLock myScopedLock(mut);
     bPCAcomputed = false;
     bPCAJobSubmitted = false;
     bRePCA = true;
@@ -1047,6 +1086,8 @@ void SpikeSortBoxes::generateNewIDs()
     {
         pcaUnits[k].UnitID = generateUnitID();
     }
+    // templates carry the old IDs
+    templateMatcher.clear();
 }
 
 void SpikeSortBoxes::removeAllUnits()
@@ -1054,6 +1095,7 @@ void SpikeSortBoxes::removeAllUnits()
     const ScopedLock myScopedLock(mut);
     boxUnits.clear();
     pcaUnits.clear();
+    templateMatcher.clear();
 }
 
 bool SpikeSortBoxes::removeUnit(int unitID)
@@ -1075,6 +1117,7 @@ bool SpikeSortBoxes::removeUnit(int unitID)
         if (pcaUnits[k].getUnitID() == unitID)
         {
             pcaUnits.erase(pcaUnits.begin()+k);
+            templateMatcher.removeTemplate(unitID);
             //EndCriticalSection();
             return true;
         }
@@ -1169,65 +1212,141 @@ void SpikeSortBoxes::updateBoxUnits(std::vector<BoxUnit> _units)
 bool SpikeSortBoxes::sortSpike(SpikeObject* so, bool PCAfirst)
 {
     const ScopedLock myScopedLock(mut);
+
+    // learned templates take over from the PCA polygons
+    if (templateMatcher.getNumTemplates() > 0)
+        return templateMatcher.matchSpike(so) || sortWithBoxUnits(so);
+
     if (PCAfirst)
-    {
+        return sortWithPCAUnits(so, false) || sortWithBoxUnits(so);
+    else
+        return sortWithBoxUnits(so) || sortWithPCAUnits(so, true);
+}
 
-        for (int k=0; k<pcaUnits.size(); k++)
+bool SpikeSortBoxes::sortWithBoxUnits(SpikeObject* so)
+{
+    for (int k=0; k<boxUnits.size(); k++)
+    {
+        if (boxUnits[k].isWaveFormInsideAllBoxes(so))
         {
-            if (pcaUnits[k].isWaveFormInsidePolygon(so))
-            {
-                so->sortedId = pcaUnits[k].getUnitID();
-                so->color[0] = pcaUnits[k].ColorRGB[0];
-                so->color[1] = pcaUnits[k].ColorRGB[1];
-                so->color[2] = pcaUnits[k].ColorRGB[2];
-                return true;
-            }
+            so->sortedId = boxUnits[k].getUnitID();
+            so->color[0] = boxUnits[k].ColorRGB[0];
+            so->color[1] = boxUnits[k].ColorRGB[1];
+            so->color[2] = boxUnits[k].ColorRGB[2];
+            boxUnits[k].updateWaveform(so);
+            return true;
         }
+    }
+    return false;
+}
 
-        for (int k=0; k<boxUnits.size(); k++)
+bool SpikeSortBoxes::sortWithPCAUnits(SpikeObject* so, bool updateWaveform)
+{
+    for (int k=0; k<pcaUnits.size(); k++)
+    {
+        if (pcaUnits[k].isWaveFormInsidePolygon(so))
         {
-            if (boxUnits[k].isWaveFormInsideAllBoxes(so))
-            {
-                so->sortedId = boxUnits[k].getUnitID();
-                so->color[0] = boxUnits[k].ColorRGB[0];
-                so->color[1] = boxUnits[k].ColorRGB[1];
-                so->color[2] = boxUnits[k].ColorRGB[2];
-                boxUnits[k].updateWaveform(so);
-                return true;
-            }
+            so->sortedId = pcaUnits[k].getUnitID();
+            so->color[0] = pcaUnits[k].ColorRGB[0];
+            so->color[1] = pcaUnits[k].ColorRGB[1];
+            so->color[2] = pcaUnits[k].ColorRGB[2];
+            if (updateWaveform)
+                pcaUnits[k].updateWaveform(so);
+            return true;
         }
     }
-    else
+    return false;
+}
+
+int SpikeSortBoxes::learnTemplates()
+{
+    const ScopedLock myScopedLock(mut);
+
+    templateMatcher.clear();
+
+    if (!bPCAcomputed)
+        return 0;
+
+    const int dim = numChannels * waveformLength;
+    HeapBlock<float> waveforms(bufferSize * dim);
+    HeapBlock<float> meanWaveform(dim);
+
+    // project the buffered spikes once
+    Array<SpikeObject> projected;
+    for (int n = 0; n < bufferSize; n++)
     {
+        SpikeObject so = spikeBuffer[n];
+        float* w = waveforms + projected.size() * dim;
+        if (so.timestamp == 0 || !TemplateMatcher::getWaveform(&so, numChannels, waveformLength, w))
+            continue;
 
-        for (int k=0; k<boxUnits.size(); k++)
+        so.pcProj[0] = so.pcProj[1] = 0;
+        for (int k=0; k<dim; k++)
         {
-            if (boxUnits[k].isWaveFormInsideAllBoxes(so))
-            {
-                so->sortedId = boxUnits[k].getUnitID();
-                so->color[0] = boxUnits[k].ColorRGB[0];
-                so->color[1] = boxUnits[k].ColorRGB[1];
-                so->color[2] = boxUnits[k].ColorRGB[2];
-                boxUnits[k].updateWaveform(so);
-                return true;
-            }
+            so.pcProj[0] += pc1[k]* w[k];
+            so.pcProj[1] += pc2[k]* w[k];
         }
-        for (int k=0; k<pcaUnits.size(); k++)
+        projected.add(so);
+    }
+
+    for (int u=0; u<pcaUnits.size(); u++)
+    {
+        Array<int> members;
+        for (int n = 0; n < projected.size(); n++)
         {
-            if (pcaUnits[k].isWaveFormInsidePolygon(so))
-            {
-                so->sortedId = pcaUnits[k].getUnitID();
-                so->color[0] = pcaUnits[k].ColorRGB[0];
-                so->color[1] = pcaUnits[k].ColorRGB[1];
-                so->color[2] = pcaUnits[k].ColorRGB[2];
-                pcaUnits[k].updateWaveform(so);
-                return true;
-            }
+            if (pcaUnits[u].isWaveFormInsidePolygon(&projected.getReference(n)))
+                members.add(n);
         }
 
+        if (members.size() < MIN_SPIKES_PER_TEMPLATE)
+            continue;
+
+        FloatVectorOperations::clear(meanWaveform, dim);
+        for (int m = 0; m < members.size(); m++)
+            FloatVectorOperations::add(meanWaveform, waveforms + members[m] * dim, dim);
+        FloatVectorOperations::multiply(meanWaveform, 1.0f / members.size(), dim);
+
+        // accept spikes up to three standard deviations beyond the mean member distance
+        RunningStat distances;
+        for (int m = 0; m < members.size(); m++)
+        {
+            const float* w = waveforms + members[m] * dim;
+            double d2 = 0;
+            for (int k=0; k<dim; k++)
+                d2 += (w[k] - meanWaveform[k]) * (w[k] - meanWaveform[k]);
+            distances.Push(sqrt(d2));
+        }
+
+        templateMatcher.addTemplate(pcaUnits[u].UnitID, pcaUnits[u].ColorRGB, meanWaveform,
+                                    distances.Mean() + 3.0 * distances.StandardDeviation());
     }
 
-    return false;
+    return templateMatcher.getNumTemplates();
+}
+
+void SpikeSortBoxes::clearTemplates()
+{
+    const ScopedLock myScopedLock(mut);
+    templateMatcher.clear();
+}
+
+int SpikeSortBoxes::getNumTemplates()
+{
+    const ScopedLock myScopedLock(mut);
+    return templateMatcher.getNumTemplates();
+}
+
+void SpikeSortBoxes::saveTemplatesToXml(XmlElement* parentNode)
+{
+    const ScopedLock myScopedLock(mut);
+    templateMatcher.saveToXml(parentNode);
+}
+
+int SpikeSortBoxes::loadTemplatesFromXml(XmlElement* templatesNode)
+{
+    const ScopedLock myScopedLock(mut);
+    templateMatcher.clear();
+    return templateMatcher.loadFromXml(templatesNode);
 }
 
 
@@ -1708,20 +1827,21 @@ static int iminarg1,iminarg2;
 static double sqrarg;
 #define SQR(a) ((sqrarg = (a)) == 0.0 ? 0.0 : sqrarg * sqrarg)
 
-PCAjob::PCAjob(Array<SpikeObject> _spikes, float* _pc1, float* _pc2,
-               float* pc1Min, float* pc2Min, float* pc1Max, float* pc2Max, bool* _reportDone) : spikes(_spikes), reportDone(_reportDone)
+PCAjob::PCAjob(Array<SpikeObject> _spikes, SpikeSortBoxes* _owner) : spikes(_spikes), owner(_owner)
 {
     cov = nullptr;
-    pc1 = _pc1;
-    pc2 = _pc2;
-    pc1min = pc1Min;
-    pc2min = pc2Min;
-    pc1max = pc1Max;
-    pc2max = pc2Max;
+    pc1min = pc2min = -1;
+    pc1max = pc2max = 1;
     dim = spikes[0].nChannels*spikes[0].nSamples;
-
+    pc1.resize(dim);
+    pc2.resize(dim);
 };
 
+void PCAjob::reportResult()
+{
+    owner->setPCAresult(&pc1[0], &pc2[0], dim, pc1min, pc2min, pc1max, pc2max);
+}
+
 PCAjob::~PCAjob()
 {
 
@@ -2117,10 +2237,10 @@ void PCAjob::computeSVD()
     }
 
 
-    *pc1min = min1 - 1.5 * (max1-min1);
-    *pc2min = min2 - 1.5 * (max2-min2);
-    *pc1max = max1 + 1.5 * (max1-min1);
-    *pc2max = max2 + 1.5 * (max2-min2);
+    pc1min = min1 - 1.5 * (max1-min1);
+    pc2min = min2 - 1.5 * (max2-min2);
+    pc1max = max1 + 1.5 * (max1-min1);
+    pc2max = max2 + 1.5 * (max2-min2);
 
     // clear memory
     for (int k = 0; k < dim; k++)
@@ -2145,6 +2265,8 @@ void PCAjob::computeSVD()
 
 void PCAcomputingThread::addPCAjob(PCAjob job)
 {
+    // jobs are submitted by every sorting worker
+    const ScopedLock myScopedLock(jobLock);
     jobs.push(job);
     if (!isThreadRunning())
     {
@@ -2154,10 +2276,17 @@ void PCAcomputingThread::addPCAjob(PCAjob job)
 
 void PCAcomputingThread::run()
 {
-    while (jobs.size() > 0)
+    while (true)
     {
+        jobLock.enter();
+        if (jobs.size() == 0)
+        {
+            jobLock.exit();
+            break;
+        }
         PCAjob J = jobs.front();
         jobs.pop();
+        jobLock.exit();
         // compute PCA
         // 1. Compute Covariance matrix
         // 2. Apply SVD on covariance matrix
@@ -2166,8 +2295,8 @@ void PCAcomputingThread::run()
         J.computeCov();
         J.computeSVD();
 
-        // 4. Report to the spike sorting electrode that PCA is finished
-        *(J.reportDone) = true;
+        // 4. Hand the components to the spike sorting electrode, under its lock
+        J.reportResult();
     }
 }
 
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <SpikeLib.h>
 #include "SpikeSorterEditor.h"
+#include "TemplateMatcher.h"
 #include <algorithm>    // std::sort
 #include <list>
 #include <queue>
@@ -156,20 +157,24 @@ class PCAjob
 public:
 PCAjob();
 };*/
+class SpikeSortBoxes;
+
 class PCAjob
 {
 public:
-    PCAjob(Array<SpikeObject> _spikes, float* _pc1, float* _pc2,
-           float*, float*, float*, float*, bool* _reportDone);
+    PCAjob(Array<SpikeObject> _spikes, SpikeSortBoxes* _owner);
     ~PCAjob();
     void computeCov();
     void computeSVD();
 
+    /** Hands the components and their display range to the owner */
+    void reportResult();
+
     float** cov;
     Array<SpikeObject> spikes;
-    float* pc1, *pc2;
-    float* pc1min, *pc2min, *pc1max, *pc2max;
-    bool* reportDone;
+    std::vector<float> pc1, pc2;
+    float pc1min, pc2min, pc1max, pc2max;
+    SpikeSortBoxes* owner;
 private:
     int svdcmp(float** a, int nRows, int nCols, float* w, float** v);
     float pythag(float a, float b);
@@ -196,6 +201,7 @@ public:
     void addPCAjob(PCAjob job);
 
     std::queue<PCAjob> jobs;
+    CriticalSection jobLock;
 };
 
 class PCAUnit
@@ -243,8 +249,14 @@ public:
 
     void getPCArange(float& p1min,float& p2min, float& p1max,  float& p2max);
     void setPCArange(float p1min,float p2min, float p1max,  float p2max);
-    void resetJobStatus();
-    bool isPCAfinished();
+
+    /** Called by the PCA thread when a job is done */
+    void setPCAresult(const float* newPc1, const float* newPc2, int dim,
+                      float p1min, float p2min, float p1max, float p2max);
+
+    /** Returns true, once, with the range of newly computed components.
+        Never waits for the electrode's lock, so the audio thread can call it. */
+    bool getNewPCArange(float& p1min, float& p2min, float& p1max, float& p2max);
 
     bool removeUnit(int unitID);
 
@@ -267,7 +279,19 @@ public:
     void getSelectedUnitAndBox(int& unitID, int& boxid);
     void saveCustomParametersToXml(XmlElement* electrodeNode);
     void loadCustomParametersFromXml(XmlElement* electrodeNode);
+
+    /** builds a template for every PCA unit from the buffered spikes that fall
+        inside its polygon. Templates take over from the polygons when sorting.
+        Returns the number of templates learned. */
+    int learnTemplates();
+    void clearTemplates();
+    int getNumTemplates();
+    void saveTemplatesToXml(XmlElement* parentNode);
+    int loadTemplatesFromXml(XmlElement* templatesNode);
 private:
+    bool sortWithBoxUnits(SpikeObject* so);
+    bool sortWithPCAUnits(SpikeObject* so, bool updateWaveform);
+
     //void  StartCriticalSection();
     //void  EndCriticalSection();
     UniqueIDgenerator* uniqueIDgenerator;
@@ -281,7 +305,9 @@ private:
     Array<SpikeObject> spikeBuffer;
     int bufferSize,spikeBufferIndex;
     PCAcomputingThread* computingThread;
-    bool bPCAJobSubmitted,bPCAcomputed,bRePCA,bPCAjobFinished ;
+    bool bPCAJobSubmitted,bPCAcomputed,bRePCA;
+    Atomic<int> newPCArange; // set by the PCA thread, cleared by the plot's consumer
+    TemplateMatcher templateMatcher;
 
 
 };
@@ -46,6 +46,8 @@ SpikeSorter::SpikeSorter()
     autoDACassignment = false;
     syncThresholds = false;
     flipSignal = false;
+    sortingLatency = 20.0f;
+    numSortingThreads = jlimit(1, 4, SystemStats::getNumCpus() / 2);
 }
 
 bool SpikeSorter::getFlipSignalState()
@@ -503,6 +505,11 @@ bool SpikeSorter::removeElectrode(int index)
     //addNetworkEventToQueue(StringTS(eventlog));
 
     //int idToRemove = electrodes[index]->electrodeID;
+
+    // queued spikes hold pointers to their electrodes
+    if (sortingPool.isRunning())
+        sortingPool.flush();
+
     electrodes.remove(index);
 
     //(idToRemove);
@@ -645,6 +652,12 @@ bool SpikeSorter::enable()
         useOverflowBuffer.add(false);
 
 
+    if (sortingLatency > 0)
+    {
+        sortingPool.setMaxLatency(sortingLatency);
+        sortingPool.start(numSortingThreads, PCAbeforeBoxes);
+    }
+
     SpikeSorterEditor* editor = (SpikeSorterEditor*) getEditor();
     editor->enable();
 
@@ -665,11 +678,50 @@ bool SpikeSorter::disable()
     {
         resetElectrode(electrodes[n]);
     }
+
+    if (sortingPool.isRunning())
+    {
+        std::cout << "Spike sorter: " << sortingPool.getStatisticsReport() << std::endl;
+        sortingPool.stop();
+    }
     //editor->disable();
     mut.exit();
     return true;
 }
 
+void SpikeSorter::setSortingLatency(float milliseconds)
+{
+    sortingLatency = jmax(0.0f, milliseconds);
+
+    mut.enter();
+    if (sortingPool.isRunning() && sortingLatency > 0)
+        sortingPool.setMaxLatency(sortingLatency);
+    mut.exit();
+}
+
+float SpikeSorter::getSortingLatency()
+{
+    return sortingLatency;
+}
+
+void SpikeSorter::setNumSortingThreads(int numThreads)
+{
+    numSortingThreads = jmax(1, numThreads);
+}
+
+int SpikeSorter::getNumSortingThreads()
+{
+    return numSortingThreads;
+}
+
+SortingStatistics SpikeSorter::getSortingStatistics()
+{
+    mut.enter();
+    SortingStatistics stats = sortingPool.getStatistics();
+    mut.exit();
+    return stats;
+}
+
 Electrode* SpikeSorter::getActiveElectrode()
 {
     if (electrodes.size() == 0)
@@ -679,6 +731,53 @@ Electrode* SpikeSorter::getActiveElectrode()
 }
 
 
+String SpikeSorter::saveTemplatesToFile(File file)
+{
+    XmlElement root("SPIKE_TEMPLATES");
+
+    mut.enter();
+    for (int i = 0; i < electrodes.size(); i++)
+    {
+        XmlElement* electrodeNode = root.createNewChildElement("ELECTRODE");
+        electrodeNode->setAttribute("electrodeID", electrodes[i]->electrodeID);
+        electrodeNode->setAttribute("name", electrodes[i]->name);
+        electrodes[i]->spikeSort->saveTemplatesToXml(electrodeNode);
+    }
+    mut.exit();
+
+    if (!root.writeToFile(file, String::empty))
+        return "Could not write " + file.getFileName();
+
+    return "Saved spike templates to " + file.getFileName();
+}
+
+String SpikeSorter::loadTemplatesFromFile(File file)
+{
+    XmlDocument doc(file);
+    ScopedPointer<XmlElement> root = doc.getDocumentElement();
+
+    if (root == nullptr || !root->hasTagName("SPIKE_TEMPLATES"))
+        return "Not a spike template file: " + file.getFileName();
+
+    int numTemplates = 0;
+
+    mut.enter();
+    forEachXmlChildElementWithTagName(*root, electrodeNode, "ELECTRODE")
+    {
+        XmlElement* templatesNode = electrodeNode->getChildByName("TEMPLATES");
+        int electrodeID = electrodeNode->getIntAttribute("electrodeID");
+
+        for (int i = 0; i < electrodes.size(); i++)
+        {
+            if (electrodes[i]->electrodeID == electrodeID && templatesNode != nullptr)
+                numTemplates += electrodes[i]->spikeSort->loadTemplatesFromXml(templatesNode);
+        }
+    }
+    mut.exit();
+
+    return "Loaded " + String(numTemplates) + " spike templates from " + file.getFileName();
+}
+
 void SpikeSorter::addSpikeEvent(SpikeObject* s, MidiBuffer& eventBuffer, int peakIndex)
 {
 
@@ -696,6 +795,34 @@ void SpikeSorter::addSpikeEvent(SpikeObject* s, MidiBuffer& eventBuffer, int pea
     //std::cout << "Adding spike" << std::endl;
 }
 
+void SpikeSorter::transferSpikeToPlot(Electrode* electrode, const SpikeObject& s)
+{
+    if (electrode->spikePlot != nullptr)
+    {
+        float p1min,p2min, p1max,  p2max;
+        if (electrode->spikeSort->getNewPCArange(p1min,p2min, p1max,  p2max))
+            electrode->spikePlot->setPCARange(p1min,p2min, p1max,  p2max);
+
+        electrode->spikePlot->processSpikeObject(s);
+    }
+}
+
+void SpikeSorter::addSortedSpikeEvents(MidiBuffer& eventBuffer)
+{
+    SortingJob* job;
+    bool expired;
+
+    while ((job = sortingPool.getNextReadyJob(expired)) != nullptr)
+    {
+        // expired spikes were never projected, so they are left out of the plots
+        if (!expired)
+            transferSpikeToPlot(job->electrode, job->spike);
+
+        addSpikeEvent(&job->spike, eventBuffer, sortingPool.getSampleOffset(job));
+        sortingPool.releaseJob(job);
+    }
+}
+
 void SpikeSorter::addWaveformToSpikeObject(SpikeObject* s,
                                            int& peakIndex,
                                            int& electrodeNumber,
@@ -883,6 +1010,11 @@ void SpikeSorter::process(AudioSampleBuffer& buffer,
     Electrode* electrode;
     dataBuffer = &buffer;
 
+    // sort on the workers when they are running, otherwise inline
+    const bool deferSorting = sortingPool.isRunning();
+    if (deferSorting)
+        sortingPool.beginBlock();
+
     checkForEvents(events); // find latest's packet timestamps
 
     //channelBuffers->update(buffer, hardware_timestamp,software_timestamp, nSamples);
@@ -960,6 +1092,7 @@ void SpikeSorter::process(AudioSampleBuffer& buffer,
 
                         SpikeObject newSpike;
                         newSpike.sortedId = 0; // unsorted.
+                        newSpike.matchScore = 0;
                         newSpike.timestamp = getTimestamp(currentChannel) + peakIndex;
                         newSpike.electrodeID = electrode->electrodeID;
                         newSpike.channel = chan;
@@ -993,30 +1126,30 @@ void SpikeSorter::process(AudioSampleBuffer& buffer,
                         }
                         */
 
-                        //for (int xxx = 0; xxx < 1000; xxx++) // overload with spikes for testing purposes
-                        electrode->spikeSort->projectOnPrincipalComponents(&newSpike);
-
-                        // Add spike to drawing buffer....
-                        electrode->spikeSort->sortSpike(&newSpike, PCAbeforeBoxes);
-
-
-                        // transfer buffered spikes to spike plot
-                        if (electrode->spikePlot != nullptr)
+                        if (deferSorting)
                         {
-                            if (electrode->spikeSort->isPCAfinished())
+                            newSpike.pcProj[0] = newSpike.pcProj[1] = 0;
+
+                            // a full queue means the workers can't keep up: send it unsorted
+                            if (!sortingPool.submit(electrode, newSpike, peakIndex))
                             {
-                                electrode->spikeSort->resetJobStatus();
-                                float p1min,p2min, p1max,  p2max;
-                                electrode->spikeSort->getPCArange(p1min,p2min, p1max,  p2max);
-                                electrode->spikePlot->setPCARange(p1min,p2min, p1max,  p2max);
+                                sortingPool.countOverflow();
+                                addSpikeEvent(&newSpike, events, peakIndex);
                             }
-
-
-                            electrode->spikePlot->processSpikeObject(newSpike);
                         }
+                        else
+                        {
+                            //for (int xxx = 0; xxx < 1000; xxx++) // overload with spikes for testing purposes
+                            electrode->spikeSort->projectOnPrincipalComponents(&newSpike);
+
+                            // Add spike to drawing buffer....
+                            electrode->spikeSort->sortSpike(&newSpike, PCAbeforeBoxes);
 
+                            // transfer buffered spikes to spike plot
+                            transferSpikeToPlot(electrode, newSpike);
 
-                        addSpikeEvent(&newSpike, events, peakIndex);
+                            addSpikeEvent(&newSpike, events, peakIndex);
+                        }
                         //prevSpike = newSpike;
                         // advance the sample index
                         sampleIndex = peakIndex + electrode->postPeakSamples;
@@ -1057,8 +1190,13 @@ void SpikeSorter::process(AudioSampleBuffer& buffer,
             useOverflowBuffer.set(i, false);
         }
 
+        if (deferSorting)
+            sortingPool.notifyWorkers();
+
     } // end cycle through electrodes
 
+    if (deferSorting)
+        addSortedSpikeEvents(events);
 
     mut.exit();
     //printf("Exitting Spike Detector::process\n");
@@ -1222,6 +1360,8 @@ void SpikeSorter::saveCustomParametersToXml(XmlElement* parentElement)
     mainNode->setAttribute("syncThresholds",syncThresholds);
     mainNode->setAttribute("uniqueID",uniqueID);
     mainNode->setAttribute("flipSignal",flipSignal);
+    mainNode->setAttribute("sortingLatency",sortingLatency);
+    mainNode->setAttribute("sortingThreads",numSortingThreads);
 
     XmlElement* countNode = mainNode->createNewChildElement("ELECTRODE_COUNTER");
 
@@ -1284,6 +1424,8 @@ void SpikeSorter::loadCustomParametersFromXml()
                 syncThresholds = mainNode->getBoolAttribute("syncThresholds");
                 uniqueID = mainNode->getIntAttribute("uniqueID");
                 flipSignal = mainNode->getBoolAttribute("flipSignal");
+                setSortingLatency(mainNode->getDoubleAttribute("sortingLatency", sortingLatency));
+                setNumSortingThreads(mainNode->getIntAttribute("sortingThreads", numSortingThreads));
 
                 forEachXmlChildElement(*mainNode, xmlNode)
                 {
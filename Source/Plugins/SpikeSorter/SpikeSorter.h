@@ -28,6 +28,7 @@
 #include <SpikeLib.h>
 #include "SpikeSorterEditor.h"
 #include "SpikeSortBoxes.h"
+#include "SpikeSortingPool.h"
 #include <algorithm>    // std::sort
 #include <queue>
 #include <stdlib.h>
@@ -359,6 +360,24 @@ public:
 
     void removeAllUnits(int electrodeID);
 
+    /** Sets how long a detected spike may wait for the sorting workers before
+        it is emitted unsorted. 0 sorts every spike on the audio thread. */
+    void setSortingLatency(float milliseconds);
+    float getSortingLatency();
+
+    /** Sets the number of sorting workers used by the next acquisition */
+    void setNumSortingThreads(int numThreads);
+    int getNumSortingThreads();
+
+    /** Queue depth and sort time of the sorting workers */
+    SortingStatistics getSortingStatistics();
+
+    /** Writes the spike templates of every electrode to an xml file. Returns a status message. */
+    String saveTemplatesToFile(File file);
+
+    /** Loads templates written by saveTemplatesToFile, matching electrodes by ID. Returns a status message. */
+    String loadTemplatesFromFile(File file);
+
     void setElectrodeVoltageScale(int electrodeID, int index, float newvalue);
     std::vector<int> getElectrodeChannels(int ID);
 
@@ -428,6 +447,12 @@ private:
 
     void addSpikeEvent(SpikeObject* s, MidiBuffer& eventBuffer, int peakIndex);
 
+    /** sends a sorted spike to the electrode's spike plot, if it has one */
+    void transferSpikeToPlot(Electrode* electrode, const SpikeObject& s);
+
+    /** adds the spikes sorted by the workers so far to the event buffer */
+    void addSortedSpikeEvents(MidiBuffer& eventBuffer);
+
     void resetElectrode(Electrode*);
     CriticalSection mut;
     bool autoDACassignment;
@@ -445,6 +470,11 @@ private:
 
     Array<Electrode*> electrodes;
     PCAcomputingThread computingThread;
+
+    SpikeSortingPool sortingPool;
+    float sortingLatency;
+    int numSortingThreads;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeSorter);
 
 };
@@ -72,6 +72,21 @@ SpikeSorterCanvas::SpikeSorterCanvas(SpikeSorter* n) :
     deleteAllUnits->addListener(this);
     addAndMakeVisible(deleteAllUnits);
 
+    learnTemplatesButton = new UtilityButton("Learn templates", Font("Small Text", 13, Font::plain));
+    learnTemplatesButton->setRadius(3.0f);
+    learnTemplatesButton->addListener(this);
+    addAndMakeVisible(learnTemplatesButton);
+
+    saveTemplatesButton = new UtilityButton("Save templates", Font("Small Text", 13, Font::plain));
+    saveTemplatesButton->setRadius(3.0f);
+    saveTemplatesButton->addListener(this);
+    addAndMakeVisible(saveTemplatesButton);
+
+    loadTemplatesButton = new UtilityButton("Load templates", Font("Small Text", 13, Font::plain));
+    loadTemplatesButton->setRadius(3.0f);
+    loadTemplatesButton->addListener(this);
+    addAndMakeVisible(loadTemplatesButton);
+
     nextElectrode = new UtilityButton("Next Electrode", Font("Small Text", 13, Font::plain));
     nextElectrode->setRadius(3.0f);
     nextElectrode->addListener(this);
@@ -160,6 +175,10 @@ void SpikeSorterCanvas::resized()
     newIDbuttons->setBounds(0, 270, 120,20);
     deleteAllUnits->setBounds(0, 300, 120,20);
 
+    learnTemplatesButton->setBounds(0, 330, 120,20);
+    saveTemplatesButton->setBounds(0, 360, 120,20);
+    loadTemplatesButton->setBounds(0, 390, 120,20);
+
 }
 
 void SpikeSorterCanvas::paint(Graphics& g)
@@ -402,6 +421,31 @@ void SpikeSorterCanvas::buttonClicked(Button* button)
         electrode->spikePlot->updateUnitsFromProcessor();
         processor->removeAllUnits(electrode->electrodeID);
     }
+    else if (button == learnTemplatesButton)
+    {
+        int numTemplates = processor->getActiveElectrode()->spikeSort->learnTemplates();
+        CoreServices::sendStatusMessage("Learned " + String(numTemplates) + " spike templates from the PCA units.");
+    }
+    else if (button == saveTemplatesButton)
+    {
+        FileChooser fc("Choose the file name...",
+                       File::getCurrentWorkingDirectory(),
+                       "*.xml",
+                       true);
+
+        if (fc.browseForFileToSave(true))
+            CoreServices::sendStatusMessage(processor->saveTemplatesToFile(fc.getResult()));
+    }
+    else if (button == loadTemplatesButton)
+    {
+        FileChooser fc("Choose a file to load...",
+                       File::getCurrentWorkingDirectory(),
+                       "*.xml",
+                       true);
+
+        if (fc.browseForFileToOpen())
+            CoreServices::sendStatusMessage(processor->loadTemplatesFromFile(fc.getResult()));
+    }
 
     repaint();
 }
@@ -103,7 +103,8 @@ public:
     SpikeSorter* processor;
 
     ScopedPointer<UtilityButton> addPolygonUnitButton,
-                  addUnitButton, delUnitButton, addBoxButton, delBoxButton, rePCAButton,nextElectrode,prevElectrode,newIDbuttons,deleteAllUnits;
+                  addUnitButton, delUnitButton, addBoxButton, delBoxButton, rePCAButton,nextElectrode,prevElectrode,newIDbuttons,deleteAllUnits,
+                  learnTemplatesButton, saveTemplatesButton, loadTemplatesButton;
 
 private:
     void removeUnitOrBox();
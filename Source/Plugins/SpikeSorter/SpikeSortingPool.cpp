@@ -0,0 +1,313 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeSortingPool.h"
+#include "SpikeSorter.h"
+#include "SpikeSortBoxes.h"
+
+#define SORTING_QUEUE_SIZE 256
+
+SortingJob::SortingJob()
+    : electrode(nullptr), peakIndex(0), blockNumber(0), queuedTicks(0), state(FREE)
+{
+}
+
+SortingStatistics::SortingStatistics()
+    : numSorted(0), numExpired(0), numOverflowed(0), queueDepth(0), maxQueueDepth(0),
+      meanSortTimeUs(0), maxSortTimeUs(0)
+{
+}
+
+SortingWorker::SortingWorker(int index, int queueSize, bool PCAfirst)
+    : Thread("Spike sorting " + String(index)), fillIndex(0), emitIndex(0), readIndex(0),
+      sortFirstInPCA(PCAfirst)
+{
+    for (int i = 0; i < queueSize; i++)
+        jobs.add(new SortingJob());
+}
+
+SortingWorker::~SortingWorker()
+{
+    stopThread(1000);
+}
+
+void SortingWorker::reset()
+{
+    for (int i = 0; i < jobs.size(); i++)
+        jobs[i]->state = SortingJob::FREE;
+
+    fillIndex = emitIndex = readIndex = 0;
+    pending = 0;
+}
+
+void SortingWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        SortingJob* job = jobs.getUnchecked(readIndex);
+        int state = job->state.get();
+
+        if (state == SortingJob::QUEUED)
+        {
+            // the audio thread may expire the job between the read and the swap
+            if (!job->state.compareAndSetBool(SortingJob::SORTING, SortingJob::QUEUED))
+                continue;
+
+            int64 start = Time::getHighResolutionTicks();
+
+            job->electrode->spikeSort->projectOnPrincipalComponents(&job->spike);
+            job->electrode->spikeSort->sortSpike(&job->spike, sortFirstInPCA);
+
+            int64 elapsed = Time::getHighResolutionTicks() - start;
+            numSortTicks += elapsed;
+            ++numSorts;
+            if (elapsed > maxSortTicks.get())
+                maxSortTicks = elapsed;
+
+            job->state = SortingJob::SORTED;
+        }
+        else if (state == SortingJob::EXPIRED)
+        {
+            // already emitted unsorted by the audio thread
+            job->state = SortingJob::FREE;
+        }
+        else
+        {
+            wait(10);
+            continue;
+        }
+
+        --pending;
+        readIndex = (readIndex + 1) % jobs.size();
+    }
+}
+
+/**********************/
+
+SpikeSortingPool::SpikeSortingPool()
+    : currentWorker(0), currentJobExpired(false), blockNumber(0), maxLatencyTicks(0), maxLatencyMs(0)
+{
+    setMaxLatency(20.0f);
+}
+
+SpikeSortingPool::~SpikeSortingPool()
+{
+    stop();
+}
+
+void SpikeSortingPool::start(int numWorkers, bool PCAfirst)
+{
+    stop();
+
+    numWorkers = jmax(1, numWorkers);
+    workerHasJobs.calloc(numWorkers);
+
+    for (int i = 0; i < numWorkers; i++)
+        workers.add(new SortingWorker(i, SORTING_QUEUE_SIZE, PCAfirst));
+
+    blockNumber = 0;
+    numSorted = 0;
+    numExpired = 0;
+    numOverflowed = 0;
+    maxQueueDepth = 0;
+
+    for (int i = 0; i < numWorkers; i++)
+        workers[i]->startThread();
+}
+
+void SpikeSortingPool::stop()
+{
+    for (int i = 0; i < workers.size(); i++)
+        workers[i]->stopThread(1000);
+
+    workers.clear();
+}
+
+void SpikeSortingPool::flush()
+{
+    for (int i = 0; i < workers.size(); i++)
+    {
+        workers[i]->stopThread(1000);
+        workers[i]->reset();
+        workers[i]->startThread();
+    }
+}
+
+bool SpikeSortingPool::isRunning() const
+{
+    return workers.size() > 0;
+}
+
+void SpikeSortingPool::setMaxLatency(float milliseconds)
+{
+    maxLatencyMs = jmax(0.0f, milliseconds);
+    maxLatencyTicks = int64(Time::getHighResolutionTicksPerSecond() * maxLatencyMs / 1000.0);
+}
+
+float SpikeSortingPool::getMaxLatency() const
+{
+    return maxLatencyMs;
+}
+
+void SpikeSortingPool::beginBlock()
+{
+    blockNumber++;
+}
+
+bool SpikeSortingPool::submit(Electrode* electrode, const SpikeObject& spike, int peakIndex)
+{
+    // an electrode always goes to the same worker, so its spikes are sorted in order
+    int index = electrode->electrodeID % workers.size();
+    SortingWorker* worker = workers.getUnchecked(index);
+    SortingJob* job = worker->jobs.getUnchecked(worker->fillIndex);
+
+    if (job->state.get() != SortingJob::FREE)
+        return false;
+
+    job->spike = spike;
+    job->electrode = electrode;
+    job->peakIndex = peakIndex;
+    job->blockNumber = blockNumber;
+    job->queuedTicks = Time::getHighResolutionTicks();
+    job->state = SortingJob::QUEUED;
+
+    worker->fillIndex = (worker->fillIndex + 1) % worker->jobs.size();
+
+    int depth = ++worker->pending;
+    if (depth > maxQueueDepth.get())
+        maxQueueDepth = depth;
+
+    workerHasJobs[index] = true;
+    return true;
+}
+
+void SpikeSortingPool::notifyWorkers()
+{
+    for (int i = 0; i < workers.size(); i++)
+    {
+        if (workerHasJobs[i])
+        {
+            workerHasJobs[i] = false;
+            workers[i]->notify();
+        }
+    }
+}
+
+SortingJob* SpikeSortingPool::getNextReadyJob(bool& expired)
+{
+    int64 now = Time::getHighResolutionTicks();
+
+    for (int i = 0; i < workers.size(); i++)
+    {
+        SortingWorker* worker = workers.getUnchecked(i);
+        SortingJob* job = worker->jobs.getUnchecked(worker->emitIndex);
+        int state = job->state.get();
+
+        if (state == SortingJob::SORTED)
+            expired = false;
+        else if (state == SortingJob::QUEUED
+                 && now - job->queuedTicks > maxLatencyTicks
+                 && job->state.compareAndSetBool(SortingJob::EXPIRED, SortingJob::QUEUED))
+            expired = true;
+        else
+            continue;
+
+        currentWorker = i;
+        currentJobExpired = expired;
+        return job;
+    }
+
+    return nullptr;
+}
+
+void SpikeSortingPool::releaseJob(SortingJob* job)
+{
+    SortingWorker* worker = workers.getUnchecked(currentWorker);
+
+    jassert(job == worker->jobs[worker->emitIndex]);
+
+    if (!currentJobExpired)
+    {
+        ++numSorted;
+        job->state = SortingJob::FREE;
+    }
+    else
+    {
+        // expired jobs are freed by the worker once it gets past them
+        ++numExpired;
+    }
+
+    worker->emitIndex = (worker->emitIndex + 1) % worker->jobs.size();
+}
+
+void SpikeSortingPool::countOverflow()
+{
+    ++numOverflowed;
+}
+
+int SpikeSortingPool::getSampleOffset(SortingJob* job) const
+{
+    return (job->blockNumber == blockNumber) ? job->peakIndex : 0;
+}
+
+SortingStatistics SpikeSortingPool::getStatistics() const
+{
+    SortingStatistics stats;
+
+    stats.numSorted = numSorted.get();
+    stats.numExpired = numExpired.get();
+    stats.numOverflowed = numOverflowed.get();
+    stats.maxQueueDepth = maxQueueDepth.get();
+
+    int64 totalTicks = 0;
+    int64 totalSorts = 0;
+    int64 maxTicks = 0;
+
+    for (int i = 0; i < workers.size(); i++)
+    {
+        stats.queueDepth += workers[i]->pending.get();
+        totalTicks += workers[i]->numSortTicks.get();
+        totalSorts += workers[i]->numSorts.get();
+        maxTicks = jmax(maxTicks, workers[i]->maxSortTicks.get());
+    }
+
+    double usPerTick = 1.0e6 / double(Time::getHighResolutionTicksPerSecond());
+
+    if (totalSorts > 0)
+        stats.meanSortTimeUs = totalTicks * usPerTick / totalSorts;
+    stats.maxSortTimeUs = maxTicks * usPerTick;
+
+    return stats;
+}
+
+String SpikeSortingPool::getStatisticsReport() const
+{
+    SortingStatistics stats = getStatistics();
+
+    return String(workers.size()) + " workers, "
+           + String(stats.numSorted) + " spikes sorted, "
+           + String(stats.numExpired) + " expired, "
+           + String(stats.numOverflowed) + " overflowed, queue depth "
+           + String(stats.queueDepth) + " (max " + String(stats.maxQueueDepth) + "), sort time "
+           + String(stats.meanSortTimeUs, 1) + " us (max " + String(stats.maxSortTimeUs, 1) + " us)";
+}
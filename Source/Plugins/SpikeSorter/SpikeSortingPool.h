@@ -0,0 +1,203 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __SPIKESORTINGPOOL_H__
+#define __SPIKESORTINGPOOL_H__
+
+#include <ProcessorHeaders.h>
+#include <SpikeLib.h>
+
+class Electrode;
+class SpikeSortingPool;
+
+/**
+
+  One detected spike travelling through the sorting pool.
+
+  Jobs live in a ring owned by a worker and go through
+  FREE -> QUEUED -> SORTING -> SORTED -> FREE. A job that is still QUEUED
+  when its latency bound runs out is marked EXPIRED by the audio thread,
+  which emits it unsorted; the worker then skips it and frees the slot.
+
+*/
+
+struct SortingJob
+{
+    enum State {FREE, QUEUED, SORTING, SORTED, EXPIRED};
+
+    SortingJob();
+
+    SpikeObject spike;
+    Electrode* electrode;
+    int peakIndex;
+    int64 blockNumber;
+    int64 queuedTicks;
+    Atomic<int> state;
+};
+
+/** Counters collected by the sorting pool since it was last started */
+struct SortingStatistics
+{
+    SortingStatistics();
+
+    int64 numSorted;        // sorted by a worker and emitted
+    int64 numExpired;       // emitted unsorted because the latency bound ran out
+    int64 numOverflowed;    // emitted unsorted because the worker's queue was full
+    int queueDepth;         // spikes waiting to be sorted right now, all workers
+    int maxQueueDepth;      // deepest a single worker's queue has been
+    double meanSortTimeUs;
+    double maxSortTimeUs;
+};
+
+/**
+
+  Sorting thread of the pool. Sorts, in order, the spikes of the electrodes
+  assigned to it, so each electrode's SpikeSortBoxes is only ever used by
+  one worker.
+
+*/
+
+class SortingWorker : public Thread
+{
+public:
+    SortingWorker(int index, int queueSize, bool PCAfirst);
+    ~SortingWorker();
+
+    void run();
+
+    /** Drops every job and rewinds the ring. The thread must be stopped. */
+    void reset();
+
+    OwnedArray<SortingJob> jobs;
+
+    /** Audio thread side of the ring */
+    int fillIndex;
+    int emitIndex;
+
+    /** Worker side of the ring */
+    int readIndex;
+
+    /** Jobs submitted and not yet taken by the worker */
+    Atomic<int> pending;
+
+    Atomic<int64> numSortTicks;
+    Atomic<int64> maxSortTicks;
+    Atomic<int64> numSorts;
+
+private:
+    bool sortFirstInPCA;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SortingWorker);
+};
+
+/**
+
+  Sorts detected spikes off the audio thread.
+
+  SpikeSorter::process submits each detected spike to the worker that owns
+  its electrode (electrodes are partitioned by ID) and collects sorted spikes
+  at the end of every buffer. Spikes sorted within the same buffer keep their
+  sample position; later ones are emitted at the start of the buffer in which
+  they become available, carrying their original timestamp. A spike that has
+  waited longer than the latency bound is emitted unsorted, so downstream
+  processors never see it later than the bound plus one buffer.
+
+  @see SpikeSorter, SpikeSortBoxes
+
+*/
+
+class SpikeSortingPool
+{
+public:
+    SpikeSortingPool();
+    ~SpikeSortingPool();
+
+    /** Starts numWorkers sorting threads. Called from SpikeSorter::enable(). */
+    void start(int numWorkers, bool PCAfirst);
+
+    /** Stops the threads and drops every queued spike */
+    void stop();
+
+    bool isRunning() const;
+
+    /** Sets how long a spike may wait to be sorted before it is emitted unsorted */
+    void setMaxLatency(float milliseconds);
+    float getMaxLatency() const;
+
+    /** Audio thread: starts a new buffer */
+    void beginBlock();
+
+    /** Audio thread: hands a detected spike over to its electrode's worker.
+        Returns false if the queue is full; the spike must then be emitted unsorted.
+    */
+    bool submit(Electrode* electrode, const SpikeObject& spike, int peakIndex);
+
+    /** Audio thread: wakes up the workers that received spikes in this buffer */
+    void notifyWorkers();
+
+    /** Audio thread: returns the next job ready to be emitted, either sorted or
+        expired, or nullptr if none is. expired is set to the state seen when the
+        job was picked; the job's state must not be read again, as the worker
+        frees an expired job as soon as it gets to it. Every returned job must
+        be handed back with releaseJob() before the next call.
+    */
+    SortingJob* getNextReadyJob(bool& expired);
+
+    /** Audio thread: gives back the job returned by getNextReadyJob() */
+    void releaseJob(SortingJob* job);
+
+    /** Audio thread: counts a spike emitted unsorted because submit() failed */
+    void countOverflow();
+
+    /** Stops the workers, drops every queued spike and starts them again,
+        keeping the statistics. Called when electrodes change during acquisition.
+    */
+    void flush();
+
+    /** Sample offset at which a job should be added to the current buffer */
+    int getSampleOffset(SortingJob* job) const;
+
+    SortingStatistics getStatistics() const;
+
+    /** Returns the statistics as a single line of text */
+    String getStatisticsReport() const;
+
+private:
+    OwnedArray<SortingWorker> workers;
+
+    int currentWorker;
+    bool currentJobExpired;
+    int64 blockNumber;
+    int64 maxLatencyTicks;
+    float maxLatencyMs;
+    HeapBlock<bool> workerHasJobs;
+
+    Atomic<int64> numSorted;
+    Atomic<int64> numExpired;
+    Atomic<int64> numOverflowed;
+    Atomic<int> maxQueueDepth;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeSortingPool);
+};
+
+#endif  // __SPIKESORTINGPOOL_H__
@@ -0,0 +1,265 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "TemplateMatcher.h"
+
+// rows are padded to a multiple of this many floats
+#define TEMPLATE_ALIGNMENT 8
+
+namespace
+{
+/** n must be a multiple of TEMPLATE_ALIGNMENT. Eight independent
+    accumulators let the compiler keep the loop in vector registers. */
+inline float dotProduct(const float* a, const float* b, int n)
+{
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0, s5 = 0, s6 = 0, s7 = 0;
+
+    for (int i = 0; i < n; i += TEMPLATE_ALIGNMENT)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i+1] * b[i+1];
+        s2 += a[i+2] * b[i+2];
+        s3 += a[i+3] * b[i+3];
+        s4 += a[i+4] * b[i+4];
+        s5 += a[i+5] * b[i+5];
+        s6 += a[i+6] * b[i+6];
+        s7 += a[i+7] * b[i+7];
+    }
+
+    return ((s0 + s4) + (s1 + s5)) + ((s2 + s6) + (s3 + s7));
+}
+}
+
+TemplateMatcher::TemplateMatcher(int numChannels_, int waveformLength_)
+    : numChannels(0), waveformLength(0), dim(0), stride(0), capacity(0)
+{
+    resize(numChannels_, waveformLength_);
+}
+
+TemplateMatcher::~TemplateMatcher()
+{
+}
+
+void TemplateMatcher::resize(int numChannels_, int waveformLength_)
+{
+    numChannels = numChannels_;
+    waveformLength = waveformLength_;
+    dim = numChannels * waveformLength;
+    stride = (dim + TEMPLATE_ALIGNMENT - 1) / TEMPLATE_ALIGNMENT * TEMPLATE_ALIGNMENT;
+
+    // the padding stays at zero, so it never adds to a dot product
+    waveform.calloc(jmax(stride, TEMPLATE_ALIGNMENT));
+
+    info.clear();
+    templates.free();
+    capacity = 0;
+}
+
+void TemplateMatcher::clear()
+{
+    info.clear();
+}
+
+int TemplateMatcher::getNumTemplates() const
+{
+    return info.size();
+}
+
+float* TemplateMatcher::getRow(int index) const
+{
+    return templates + index * stride;
+}
+
+void TemplateMatcher::addTemplate(int unitID, const uint8 color[3], const float* source, float maxDistance)
+{
+    int index = 0;
+    while (index < info.size() && info.getReference(index).unitID != unitID)
+        index++;
+
+    if (index == info.size())
+    {
+        if (index == capacity)
+        {
+            capacity = jmax(8, capacity * 2);
+            templates.realloc(capacity * stride);
+        }
+
+        TemplateInfo newInfo;
+        info.add(newInfo);
+    }
+
+    float* row = getRow(index);
+    FloatVectorOperations::copy(row, source, dim);
+    FloatVectorOperations::clear(row + dim, stride - dim);
+
+    TemplateInfo& t = info.getReference(index);
+    t.unitID = unitID;
+    t.color[0] = color[0];
+    t.color[1] = color[1];
+    t.color[2] = color[2];
+    t.energy = dotProduct(row, row, stride);
+    t.maxDistance = maxDistance;
+}
+
+bool TemplateMatcher::removeTemplate(int unitID)
+{
+    for (int i = 0; i < info.size(); i++)
+    {
+        if (info.getReference(i).unitID == unitID)
+        {
+            // keep the rows packed
+            int last = info.size() - 1;
+            if (i != last)
+                FloatVectorOperations::copy(getRow(i), getRow(last), stride);
+
+            info.set(i, info.getLast());
+            info.removeLast();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TemplateMatcher::getWaveform(const SpikeObject* so, int numChannels, int waveformLength, float* dest)
+{
+    if (so->nChannels != numChannels || so->nSamples != waveformLength)
+        return false;
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        if (so->gain[ch] == 0)
+            return false;
+
+        // same conversion as spikeDataIndexToMicrovolts
+        const float scale = 1000.0f / so->gain[ch];
+        const uint16* data = so->data + ch * waveformLength;
+        float* d = dest + ch * waveformLength;
+
+        for (int i = 0; i < waveformLength; i++)
+            d[i] = (float(data[i]) - 32768.0f) * scale;
+    }
+
+    return true;
+}
+
+bool TemplateMatcher::matchSpike(SpikeObject* so)
+{
+    so->matchScore = 0;
+
+    if (info.size() == 0 || !getWaveform(so, numChannels, waveformLength, waveform))
+        return false;
+
+    const float spikeEnergy = dotProduct(waveform, waveform, stride);
+
+    int best = -1;
+    float bestDistance = 0;
+
+    for (int i = 0; i < info.size(); i++)
+    {
+        const TemplateInfo& t = info.getReference(i);
+        float distance = spikeEnergy - 2.0f * dotProduct(waveform, getRow(i), stride) + t.energy;
+
+        if (best < 0 || distance < bestDistance)
+        {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+
+    const TemplateInfo& t = info.getReference(best);
+    bestDistance = jmax(0.0f, bestDistance);
+
+    if (bestDistance > t.maxDistance * t.maxDistance)
+        return false;
+
+    so->sortedId = t.unitID;
+    so->color[0] = t.color[0];
+    so->color[1] = t.color[1];
+    so->color[2] = t.color[2];
+    so->matchScore = (t.energy > 0) ? 1.0f - bestDistance / t.energy : 0.0f;
+
+    return true;
+}
+
+void TemplateMatcher::saveToXml(XmlElement* parentNode) const
+{
+    XmlElement* templatesNode = parentNode->createNewChildElement("TEMPLATES");
+    templatesNode->setAttribute("numChannels", numChannels);
+    templatesNode->setAttribute("waveformLength", waveformLength);
+
+    for (int i = 0; i < info.size(); i++)
+    {
+        const TemplateInfo& t = info.getReference(i);
+        XmlElement* templateNode = templatesNode->createNewChildElement("TEMPLATE");
+        templateNode->setAttribute("UnitID", t.unitID);
+        templateNode->setAttribute("ColorR", t.color[0]);
+        templateNode->setAttribute("ColorG", t.color[1]);
+        templateNode->setAttribute("ColorB", t.color[2]);
+        templateNode->setAttribute("maxDistance", t.maxDistance);
+
+        String values;
+        const float* row = getRow(i);
+        for (int k = 0; k < dim; k++)
+            values << row[k] << " ";
+
+        templateNode->addTextElement(values.trimEnd());
+    }
+}
+
+int TemplateMatcher::loadFromXml(const XmlElement* templatesNode)
+{
+    if (templatesNode->getIntAttribute("numChannels") != numChannels
+        || templatesNode->getIntAttribute("waveformLength") != waveformLength)
+    {
+        std::cout << "Skipping spike templates of a different size" << std::endl;
+        return 0;
+    }
+
+    HeapBlock<float> values(jmax(dim, 1));
+    int numLoaded = 0;
+
+    forEachXmlChildElementWithTagName(*templatesNode, templateNode, "TEMPLATE")
+    {
+        StringArray tokens;
+        tokens.addTokens(templateNode->getAllSubText(), " \t\r\n", "");
+        tokens.removeEmptyStrings();
+
+        if (tokens.size() != dim)
+            continue;
+
+        for (int k = 0; k < dim; k++)
+            values[k] = tokens[k].getFloatValue();
+
+        uint8 color[3];
+        color[0] = (uint8) templateNode->getIntAttribute("ColorR");
+        color[1] = (uint8) templateNode->getIntAttribute("ColorG");
+        color[2] = (uint8) templateNode->getIntAttribute("ColorB");
+
+        addTemplate(templateNode->getIntAttribute("UnitID"), color, values,
+                    (float) templateNode->getDoubleAttribute("maxDistance"));
+        numLoaded++;
+    }
+
+    return numLoaded;
+}
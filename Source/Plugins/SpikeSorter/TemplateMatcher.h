@@ -0,0 +1,108 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2013 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __TEMPLATEMATCHER_H__
+#define __TEMPLATEMATCHER_H__
+
+#include <ProcessorHeaders.h>
+#include <SpikeLib.h>
+
+/**
+
+  Online template-matching classifier for the spikes of one electrode.
+
+  Each template is the mean waveform of a unit, in microvolts, with all
+  channels of the electrode laid end to end. A spike goes to the template
+  closest to it in Euclidean distance, provided it lies within that
+  template's maximum distance. The squared distance is computed from
+  dot products, |x|^2 - 2 x.t + |t|^2, over rows padded to a multiple of
+  eight floats so the inner loop vectorizes without a tail.
+
+  The match score written to SpikeObject::matchScore is the fraction of the
+  template energy explained by the spike, 1 - |x - t|^2 / |t|^2.
+
+  @see SpikeSortBoxes
+
+*/
+
+class TemplateMatcher
+{
+public:
+    TemplateMatcher(int numChannels, int waveformLength);
+    ~TemplateMatcher();
+
+    /** Changes the waveform size, dropping every template */
+    void resize(int numChannels, int waveformLength);
+
+    /** Removes every template */
+    void clear();
+
+    int getNumTemplates() const;
+
+    /** Adds or replaces the template of a unit. waveform holds
+        numChannels * waveformLength values in microvolts. */
+    void addTemplate(int unitID, const uint8 color[3], const float* waveform, float maxDistance);
+
+    /** Removes the template of a unit. Returns false if it had none. */
+    bool removeTemplate(int unitID);
+
+    /** Matches a spike against every template. On success sets its sortedId,
+        color and matchScore and returns true. */
+    bool matchSpike(SpikeObject* so);
+
+    /** Converts the waveform of a spike to microvolts. Returns false if the
+        spike doesn't have the expected size or has no gain. */
+    static bool getWaveform(const SpikeObject* so, int numChannels, int waveformLength, float* dest);
+
+    void saveToXml(XmlElement* parentNode) const;
+
+    /** Loads the templates saved by saveToXml. Templates of the wrong size
+        are skipped. Returns the number of templates loaded. */
+    int loadFromXml(const XmlElement* templatesNode);
+
+private:
+    struct TemplateInfo
+    {
+        int unitID;
+        uint8 color[3];
+        float energy;
+        float maxDistance;
+    };
+
+    float* getRow(int index) const;
+
+    int numChannels;
+    int waveformLength;
+    int dim;
+    int stride;
+
+    Array<TemplateInfo> info;
+    HeapBlock<float> templates;
+    int capacity;
+
+    HeapBlock<float> waveform;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TemplateMatcher);
+};
+
+#endif  // __TEMPLATEMATCHER_H__
@@ -26,7 +26,8 @@
 #include "AudioNode.h"
 
 AudioNode::AudioNode()
-    : GenericProcessor("Audio Node"), audioEditor(0), volume(0.00001f), noiseGateLevel(0.0f)
+    : GenericProcessor("Audio Node"), audioEditor(0), volume(0.00001f), noiseGateLevel(0.0f),
+      destBufferSampleRate(44100.0), estimatedSamples(1024)
 {
 
     settings.numInputs = 4096;
@@ -37,8 +38,6 @@ AudioNode::AudioNode()
 
     nextAvailableChannel = 2; // keep first two channels empty
 
-    tempBuffer = new AudioSampleBuffer(16, 1024);
-
 }
 
 
@@ -165,35 +164,37 @@ void AudioNode::prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock)
 
 void AudioNode::recreateBuffers()
 {
-	numSamplesExpected.clear();
-    samplesInBackupBuffer.clear();
-    samplesInOverflowBuffer.clear();
-    ratio.clear();
-    filters.clear();
-    bufferA.clear();
-    bufferB.clear();
-    bufferSwap.clear();
+    streams.clear();
 
     for (int i = 0; i < channelPointers.size(); i++)
     {
-        // processor sample rate divided by sound card sample rate
-        numSamplesExpected.add((int)(channelPointers[i]->sampleRate/destBufferSampleRate*float(estimatedSamples)) + 1);
-        samplesInBackupBuffer.add(0);
-        samplesInOverflowBuffer.add(0);
-        sourceBufferSampleRate.add(channelPointers[i]->sampleRate);
+        SourceStream* stream = nullptr;
+
+        for (int s = 0; s < streams.size(); s++)
+        {
+            if (streams[s]->sourceNodeId == channelPointers[i]->sourceNodeId)
+                stream = streams[s];
+        }
 
-        filters.add(new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 1> (1024));
+        if (stream == nullptr)
+        {
+            stream = new SourceStream();
+            stream->sourceNodeId = channelPointers[i]->sourceNodeId;
 
-        ratio.add(float(numSamplesExpected[i])/float(estimatedSamples));
-        updateFilter(i);
+            // processor sample rate to sound card sample rate
+            stream->resampler.prepare(1, channelPointers[i]->sampleRate, destBufferSampleRate);
 
-        bufferA.add(new AudioSampleBuffer(1,10000));
-        bufferB.add(new AudioSampleBuffer(1,10000));
-        bufferSwap.add(false);
+            stream->fifo.setSize(1, 8*estimatedSamples + stream->resampler.getMaxOutputSamples(4096));
+            stream->samplesInFifo = 0;
+            stream->isPlaying = false;
 
+            streams.add(stream);
+        }
+
+        stream->channels.add(i);
     }
 
-    tempBuffer->setSize(getNumInputs(), 4096);
+    mixBuffer.setSize(1, jmax(estimatedSamples, 4096));
 }
 
 bool AudioNode::enable()
@@ -202,266 +203,150 @@ bool AudioNode::enable()
 	return true;
 }
 
-void AudioNode::updateFilter(int i)
+void AudioNode::consumeFifo(SourceStream* stream, int numToDrop)
 {
+    numToDrop = jmin(numToDrop, stream->samplesInFifo);
+    stream->samplesInFifo -= numToDrop;
 
-    double cutoffFreq = (ratio[i] > 1.0) ? 2 * destBufferSampleRate  // downsample
-                        : destBufferSampleRate / 2; // upsample
-
-    double sampleFreq = (ratio[i] > 1.0) ? sourceBufferSampleRate[i] // downsample
-                        : destBufferSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filters[i]->setParams(params);
-
+    if (stream->samplesInFifo > 0)
+    {
+        float* fifo = stream->fifo.getWritePointer(0);
+        memmove(fifo, fifo + numToDrop, sizeof(float) * stream->samplesInFifo);
+    }
 }
 
 void AudioNode::process(AudioSampleBuffer& buffer,
                         MidiBuffer& events)
 {
-    float gain;
     int valuesNeeded = buffer.getNumSamples(); // samples needed to fill out the buffer
 
-    //std::cout << "Buffer size: " << buffer.getNumChannels() << std::endl;
-
     // clear the left and right channels
     buffer.clear(0,0,buffer.getNumSamples());
     buffer.clear(1,0,buffer.getNumSamples());
 
-    if (1)
-    {
-
-        AudioSampleBuffer* overflowBuffer;
-        AudioSampleBuffer* backupBuffer;
-
-        if (channelPointers.size() > 0) // we have some channels
-        {
-
-            tempBuffer->clear();
-
-            for (int i = 0; i < buffer.getNumChannels()-2; i++) // cycle through them all
-            {
+    if (channelPointers.size() == 0) // no channels to monitor
+        return;
 
-                if (channelPointers[i]->isMonitored)
-                {
+    // amount of resampled audio kept in reserve, so that blocks of input that
+    // arrive a little late don't cause gaps
+    const int cushion = 2*valuesNeeded;
 
-                    //std::cout << "Processing channel " << i << std::endl;
-
-                    if (!bufferSwap[i])
-                    {
-                        overflowBuffer = bufferA[i];
-                        backupBuffer = bufferB[i];
-
-                        bufferSwap.set(i,true);
-                    }
-                    else
-                    {
-                        overflowBuffer = bufferB[i];
-                        backupBuffer = bufferA[i];
-
-                        bufferSwap.set(i,false);
-                    }
-
-                    backupBuffer->clear();
-
-                    samplesInOverflowBuffer.set(i,samplesInBackupBuffer[i]); // size of buffer after last round
-                    samplesInBackupBuffer.set(i,0);
-
-                    int orphanedSamples = 0;
-
-                    // 1. copy overflow buffer
-
-                    int samplesToCopyFromOverflowBuffer =
-                        ((samplesInOverflowBuffer[i] <= numSamplesExpected[i]) ?
-                         samplesInOverflowBuffer[i] :
-                         numSamplesExpected[i]);
-
-                    //std::cout << "Copying " << samplesToCopyFromOverflowBuffer << " samples from overflow buffer of " << samplesInOverflowBuffer[i] << " samples." << std::endl;
-
-                    if (samplesToCopyFromOverflowBuffer > 0) // need to re-add samples from backup buffer
-                    {
+    for (int s = 0; s < streams.size(); s++)
+    {
+        SourceStream* stream = streams[s];
 
-                        tempBuffer->addFrom(i,    // destination channel
-                                            0,                // destination start sample
-                                            *overflowBuffer,  // source
-                                            0,                // source channel
-                                            0,                // source start sample
-                                            samplesToCopyFromOverflowBuffer,    // number of samples
-                                            1.0f              // gain to apply
-                                           );
+        // a source that hasn't sent a buffer yet has nothing to play
+        std::map<uint8, int>::const_iterator count = numSamples.find(uint8(stream->sourceNodeId));
 
-                        int leftoverSamples = samplesInOverflowBuffer[i] - samplesToCopyFromOverflowBuffer;
+        if (count == numSamples.end())
+            continue;
 
-                        // std::cout << "Samples remaining in overflow buffer: " << leftoverSamples << std::endl;
+        int samplesAvailable = count->second;
 
-                        if (leftoverSamples > 0) // move remaining samples to the backup buffer
-                        {
+        if (samplesAvailable > mixBuffer.getNumSamples())
+            mixBuffer.setSize(1, samplesAvailable, false, false, true);
 
-                            backupBuffer->addFrom(0, // destination channel
-                                                  0,                     // destination start sample
-                                                  *overflowBuffer,       // source
-                                                  0,                     // source channel
-                                                  samplesToCopyFromOverflowBuffer,         // source start sample
-                                                  leftoverSamples,       // number of samples
-                                                  1.0f                   // gain to apply
-                                                 );
-                        }
+        // 1. mix the monitored channels of this source at their own sample rate
 
-                        samplesInBackupBuffer.set(i,leftoverSamples);
-                    }
+        bool isMonitored = false;
+        mixBuffer.clear(0, 0, samplesAvailable);
 
-                    gain = volume/(float(0x7fff) * channelPointers[i]->bitVolts);
-                    // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
-                    // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
+        for (int n = 0; n < stream->channels.size(); n++)
+        {
+            int i = stream->channels[n];
 
-                    int remainingSamples = numSamplesExpected[i] - samplesToCopyFromOverflowBuffer;
+            if (i + 2 >= buffer.getNumChannels() || !channelPointers[i]->isMonitored)
+                continue;
 
-                    int samplesAvailable = numSamples.at(channelPointers[i]->sourceNodeId);
+            float gain = volume/(float(0x7fff) * channelPointers[i]->bitVolts);
+            // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
+            // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
 
-                    int samplesToCopyFromIncomingBuffer = ((remainingSamples <= samplesAvailable) ?
-                                                           remainingSamples :
-                                                           samplesAvailable);
+            mixBuffer.addFrom(0,                // destination channel
+                              0,                // destination start sample
+                              buffer,           // source
+                              i+2,              // source channel (add 2 to account for output channels)
+                              0,                // source start sample
+                              samplesAvailable, // number of samples
+                              gain              // gain to apply
+                             );
 
-                    //std::cout << "Copying " << samplesToCopyFromIncomingBuffer << " samples from incoming buffer of " << samplesAvailable << " samples." << std::endl;
+            isMonitored = true;
+        }
 
+        if (!isMonitored)
+        {
+            // start from silence the next time one of these channels is selected
+            if (stream->isPlaying || stream->samplesInFifo > 0)
+            {
+                stream->resampler.reset();
+                stream->samplesInFifo = 0;
+                stream->isPlaying = false;
+            }
+            continue;
+        }
 
-                    if (samplesToCopyFromIncomingBuffer > 0)
-                    {
+        // 2. convert the mix to the sound card rate, at the end of the fifo
 
-                        tempBuffer->addFrom(i,       // destination channel
-                                            samplesToCopyFromOverflowBuffer,           // destination start sample
-                                            buffer,      // source
-                                            i+2,           // source channel (add 2 to account for output channels)
-                                            0,           // source start sample
-                                            samplesToCopyFromIncomingBuffer, //  number of samples
-                                            gain       // gain to apply
-                                           );
+        int samplesProduced = stream->resampler.getNumOutputSamples(samplesAvailable);
 
-                        //if (destBufferPos == 0)
-                        //  std::cout << "Temp buffer 0 value: " << *tempBuffer->getReadPointer(i,0) << std::endl;
+        if (samplesProduced > stream->fifo.getNumSamples())
+            stream->fifo.setSize(1, samplesProduced + cushion, true, false, true);
 
-                    }
+        if (stream->samplesInFifo + samplesProduced > stream->fifo.getNumSamples())
+            consumeFifo(stream, stream->samplesInFifo + samplesProduced - stream->fifo.getNumSamples());
 
-                    orphanedSamples = samplesAvailable - samplesToCopyFromIncomingBuffer;
+        const float* source = mixBuffer.getReadPointer(0);
+        float* dest = stream->fifo.getWritePointer(0, stream->samplesInFifo);
 
-                    // std::cout << "Samples remaining in incoming buffer: " << orphanedSamples << std::endl;
+        stream->samplesInFifo += stream->resampler.process(&source, samplesAvailable, &dest);
 
-                    if (orphanedSamples > 0 && (samplesInBackupBuffer[i] + orphanedSamples < backupBuffer->getNumSamples()))
-                    {
+        // 3. play from the front of the fifo
 
-                        backupBuffer->addFrom(0,                            // destination channel
-                                              samplesInBackupBuffer[i],     // destination start sample
-                                              buffer,                       // source
-                                              i+2,                          // source channel (add 2 to account for output channels)
-                                              remainingSamples,             // source start sample
-                                              orphanedSamples,              //  number of samples
-                                              gain                          // gain to apply
-                                             );
+        if (!stream->isPlaying && stream->samplesInFifo >= cushion)
+            stream->isPlaying = true;
 
-                        samplesInBackupBuffer.set(i, samplesInBackupBuffer[i] + orphanedSamples);
+        if (stream->isPlaying)
+        {
+            int samplesToPlay = jmin(valuesNeeded, stream->samplesInFifo);
 
-                    }
+            buffer.addFrom(0,               // destination channel
+                           0,               // destination start sample
+                           stream->fifo,    // source
+                           0,               // source channel
+                           0,               // source start sample
+                           samplesToPlay,   // number of samples
+                           1.0f             // gain to apply
+                          );
 
-                    // now that our tempBuffer is ready, we can filter it and copy it into the
-                    // original buffer
-
-                    //std::cout << "Ratio = " << ratio[i] << ", gain = " << gain << std::endl;
-                    //std::cout << "Values needed = " << valuesNeeded << ", channel = " << i << std::endl;
-
-                    if (ratio[i] > 1.00001)
-                    {
-                        // pre-apply filter before downsampling
-                        float* ptr = tempBuffer->getWritePointer(i);
-                        filters[i]->process(numSamplesExpected[i], &ptr);
-                    }
-
-                    // initialize variables
-                    int sourceBufferPos = 0;
-                    int sourceBufferSize = numSamplesExpected[i];
-                    float subSampleOffset = 0.0;
-                    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-                    int destBufferPos;
-
-                    // code modified from "juce_ResamplingAudioSource.cpp":
-
-                    for (destBufferPos = 0; destBufferPos < valuesNeeded; destBufferPos++)
-                    {
-                        float gain = 1.0;
-                        float alpha = (float) subSampleOffset;
-                        float invAlpha = 1.0f - alpha;
-
-                        // std::cout << "Copying sample " << sourceBufferPos << std::endl;
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,  // destSampleOffset
-                                       *tempBuffer,     // source
-                                       i,    // sourceChannel
-                                       sourceBufferPos,// sourceSampleOffset
-                                       1,        // number of samples
-                                       invAlpha*gain);      // gain to apply to source
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,   // destSampleOffset
-                                       *tempBuffer,     // source
-                                       i,      // sourceChannel
-                                       nextPos,      // sourceSampleOffset
-                                       1,        // number of samples
-                                       alpha*gain);       // gain to apply to source
-
-                        // if (destBufferPos == 0)
-                        //std::cout << "Output buffer 0 value: " << *buffer.getReadPointer(i+2,destBufferPos) << std::endl;
-
-                        subSampleOffset += ratio[i];
+            consumeFifo(stream, samplesToPlay);
 
-                        while (subSampleOffset >= 1.0)
-                        {
-                            if (++sourceBufferPos >= sourceBufferSize)
-                                sourceBufferPos = 0;
-
-                            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-                            subSampleOffset -= 1.0;
-                        }
-                    }
-
-                    if (ratio[i] < 0.99999)
-                    {
-                        // apply the filter after upsampling
-                        float* ptr = buffer.getWritePointer(0);
-                        filters[i]->process(destBufferPos, &ptr);
-                    }
-
-                    // now copy the channel into the output zone
-
-                    // buffer.addFrom(0,    // destChannel
-                    //                0,  // destSampleOffset
-                    //                buffer,     // source
-                    //                 i+2,    // sourceChannel
-                    //                 0,// sourceSampleOffset
-                    //                 valuesNeeded,        // number of samples
-                    //                 1.0);      // gain to apply to source
-
-                } // if channelPointers[i]->isMonitored
-            } // end cycling through channels
-
-            // Simple implementation of a "noise gate" on audio output
-            expander.process(buffer.getWritePointer(0), // expand the left channel
-                             buffer.getNumSamples());
-
-            // copy the signal into the right channel (no stereo audio yet!)
-            buffer.addFrom(1,    // destChannel
-                           0,  // destSampleOffset
-                           buffer,     // source
-                           0,    // sourceChannel
-                           0,// sourceSampleOffset
-                           valuesNeeded,        // number of samples
-                           1.0);      // gain to apply to source
+            if (samplesToPlay < valuesNeeded)
+            {
+                // ran dry; build the cushion up again before playing on
+                stream->isPlaying = false;
+            }
+            else if (stream->samplesInFifo > 2*cushion)
+            {
+                // the source clock runs faster than the sound card's; drop the
+                // excess rather than let the delay grow
+                consumeFifo(stream, stream->samplesInFifo - cushion);
+            }
         }
     }
+
+    // Simple implementation of a "noise gate" on audio output
+    expander.process(buffer.getWritePointer(0), // expand the left channel
+                     buffer.getNumSamples());
+
+    // copy the signal into the right channel (no stereo audio yet!)
+    buffer.addFrom(1,    // destChannel
+                   0,  // destSampleOffset
+                   buffer,     // source
+                   0,    // sourceChannel
+                   0,// sourceSampleOffset
+                   valuesNeeded,        // number of samples
+                   1.0);      // gain to apply to source
 }
 
 // ==========================================================
@@ -30,7 +30,7 @@
 
 #include "../GenericProcessor/GenericProcessor.h"
 #include "AudioEditor.h"
-#include "../Dsp/Dsp.h"
+#include "PolyphaseResampler.h"
 
 #include "../Channel/Channel.h"
 
@@ -120,8 +120,6 @@ public:
 
     void prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock);
 
-    void updateFilter(int i);
-
 	bool enable();
 
 private:
@@ -135,29 +133,35 @@ private:
     /** An array of pointers to the channels that feed into the AudioNode. */
     Array<Channel*> channelPointers;
 
-    OwnedArray<AudioSampleBuffer> bufferA;
-    OwnedArray<AudioSampleBuffer> bufferB;
+    /** Monitored channels of one source are mixed at the source rate and
+        converted to the sound card rate in a single pass. */
+    struct SourceStream
+    {
+        int sourceNodeId;
+        Array<int> channels; // indices into channelPointers
 
-    Array<int> numSamplesExpected;
+        PolyphaseResampler resampler;
 
-    Array<int> samplesInBackupBuffer;
-    Array<int> samplesInOverflowBuffer;
-    Array<double> sourceBufferSampleRate;
-    double destBufferSampleRate;
-	int estimatedSamples;
+        /** Resampled audio waiting to be played; it absorbs the difference
+            between the amount of data that arrives and the amount the sound
+            card takes in each block. */
+        AudioSampleBuffer fifo;
+        int samplesInFifo;
+        bool isPlaying;
+    };
 
-    Array<bool> bufferSwap;
+    /** Drops the oldest numToDrop samples of a stream's fifo. */
+    void consumeFifo(SourceStream* stream, int numToDrop);
 
-    Expander expander;
+    OwnedArray<SourceStream> streams;
 
-    // sample rate, timebase, and ratio info:
-    Array<double> ratio;
+    /** Mix of the monitored channels of one source, before resampling */
+    AudioSampleBuffer mixBuffer;
 
-    // major objects:
-    OwnedArray<Dsp::Filter> filters;
+    double destBufferSampleRate;
+    int estimatedSamples;
 
-    // Temporary buffer for data
-    ScopedPointer<AudioSampleBuffer> tempBuffer;
+    Expander expander;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioNode);
 
@@ -0,0 +1,327 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+    Compares the PolyphaseResampler with the linear interpolation the
+    AudioNode used before it: a biquad lowpass when downsampling, then two
+    single-sample addFrom calls per output sample and channel.
+
+    1. Throughput, in multiples of real time, for the channel counts and
+       rates of the audio monitor and the ResamplingNode.
+    2. Output level of tones in the passband and of tones that would alias,
+       relative to the input, in dB.
+    3. Largest difference between the output for 1024-sample blocks and for
+       blocks of random length, which should be zero.
+
+        make                      (in this directory)
+        ./ResamplerBenchmark [seconds]
+*/
+
+#include "../PolyphaseResampler.h"
+
+#define BLOCK_SIZE 1024
+
+namespace
+{
+/** The AudioNode's conversion before the PolyphaseResampler, for one block */
+class LinearInterpolator
+{
+public:
+    LinearInterpolator(int numChannels_, double sourceRate, double destRate)
+        : numChannels(numChannels_), ratio(sourceRate / destRate),
+          temp(numChannels_, BLOCK_SIZE)
+    {
+        for (int c = 0; c < numChannels; c++)
+        {
+            filters.add(new IIRFilter());
+            filters[c]->setCoefficients(IIRCoefficients::makeLowPass(sourceRate, 0.5 * destRate));
+        }
+    }
+
+    int getNumOutputSamples(int numInputSamples) const
+    {
+        return int(numInputSamples / ratio);
+    }
+
+    int process(const AudioSampleBuffer& input, int numInputSamples, AudioSampleBuffer& output)
+    {
+        const int valuesNeeded = getNumOutputSamples(numInputSamples);
+
+        output.clear();
+
+        for (int c = 0; c < numChannels; c++)
+        {
+            temp.copyFrom(c, 0, input, c, 0, numInputSamples);
+
+            if (ratio > 1.00001)
+                filters[c]->processSamples(temp.getWritePointer(c), numInputSamples);
+
+            int sourcePos = 0;
+            int nextPos = 1 % numInputSamples;
+            double subSampleOffset = 0.0;
+
+            for (int i = 0; i < valuesNeeded; i++)
+            {
+                const float alpha = float(subSampleOffset);
+
+                output.addFrom(c, i, temp, c, sourcePos, 1, 1.0f - alpha);
+                output.addFrom(c, i, temp, c, nextPos, 1, alpha);
+
+                subSampleOffset += ratio;
+
+                while (subSampleOffset >= 1.0)
+                {
+                    if (++sourcePos >= numInputSamples)
+                        sourcePos = 0;
+
+                    nextPos = (sourcePos + 1) % numInputSamples;
+                    subSampleOffset -= 1.0;
+                }
+            }
+        }
+
+        return valuesNeeded;
+    }
+
+private:
+    int numChannels;
+    double ratio;
+    AudioSampleBuffer temp;
+    OwnedArray<IIRFilter> filters;
+};
+
+void fillTone(AudioSampleBuffer& buffer, int numSamples, double frequency, double sampleRate, int64 start)
+{
+    for (int c = 0; c < buffer.getNumChannels(); c++)
+    {
+        float* data = buffer.getWritePointer(c);
+
+        for (int i = 0; i < numSamples; i++)
+            data[i] = float(std::sin(2.0 * double_Pi * frequency * double(start + i) / sampleRate));
+    }
+}
+
+double toDecibels(double amplitude)
+{
+    return 20.0 * std::log10(jmax(amplitude, 1e-12));
+}
+
+/** Runs a unit sine through either converter and returns the RMS amplitude
+    of the output, scaled to the amplitude of a sine, once the filters have
+    settled. */
+template <typename Converter>
+double measureTone(Converter& converter, double sourceRate, double frequency, int numBlocks)
+{
+    AudioSampleBuffer input(1, BLOCK_SIZE);
+    AudioSampleBuffer output(1, converter.getNumOutputSamples(BLOCK_SIZE) + 2);
+    double sumSquares = 0;
+    int64 inputPosition = 0, counted = 0;
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        fillTone(input, BLOCK_SIZE, frequency, sourceRate, inputPosition);
+        inputPosition += BLOCK_SIZE;
+
+        const int n = converter.process(input, BLOCK_SIZE, output);
+        const float* out = output.getReadPointer(0);
+
+        if (b < numBlocks / 4)
+            continue;
+
+        for (int i = 0; i < n; i++)
+            sumSquares += out[i] * out[i];
+
+        counted += n;
+    }
+
+    return std::sqrt(2.0 * sumSquares / double(counted));
+}
+
+/** Adapts the PolyphaseResampler to the interface of LinearInterpolator */
+class PolyphaseConverter
+{
+public:
+    PolyphaseConverter(int numChannels, double sourceRate, double destRate)
+    {
+        resampler.prepare(numChannels, sourceRate, destRate);
+    }
+
+    int getNumOutputSamples(int numInputSamples) const
+    {
+        return resampler.getMaxOutputSamples(numInputSamples);
+    }
+
+    int process(const AudioSampleBuffer& input, int numInputSamples, AudioSampleBuffer& output)
+    {
+        return resampler.process(input.getArrayOfReadPointers(), numInputSamples,
+                                 output.getArrayOfWritePointers());
+    }
+
+    PolyphaseResampler resampler;
+};
+
+template <typename Converter>
+double timeConverter(int numChannels, double sourceRate, double destRate, double seconds)
+{
+    Converter converter(numChannels, sourceRate, destRate);
+    AudioSampleBuffer input(numChannels, BLOCK_SIZE);
+    AudioSampleBuffer output(numChannels, converter.getNumOutputSamples(BLOCK_SIZE) + 2);
+    Random random(1);
+
+    for (int c = 0; c < numChannels; c++)
+        for (int i = 0; i < BLOCK_SIZE; i++)
+            input.setSample(c, i, random.nextFloat() * 2.0f - 1.0f);
+
+    const int numBlocks = jmax(1, int(seconds * sourceRate / BLOCK_SIZE));
+    const int64 start = Time::getHighResolutionTicks();
+
+    for (int b = 0; b < numBlocks; b++)
+        converter.process(input, BLOCK_SIZE, output);
+
+    const double elapsed = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+    return (numBlocks * double(BLOCK_SIZE) / sourceRate) / elapsed;
+}
+
+/** Largest difference between whole blocks and blocks of random length */
+float compareBlockSplits(int numChannels, double sourceRate, double destRate)
+{
+    const int numSamples = 20 * BLOCK_SIZE;
+    AudioSampleBuffer input(numChannels, numSamples);
+    Random random(2);
+
+    for (int c = 0; c < numChannels; c++)
+        for (int i = 0; i < numSamples; i++)
+            input.setSample(c, i, random.nextFloat() * 2.0f - 1.0f);
+
+    PolyphaseResampler a, b;
+    a.prepare(numChannels, sourceRate, destRate);
+    b.prepare(numChannels, sourceRate, destRate);
+
+    const int maxOut = a.getMaxOutputSamples(numSamples) + 2;
+    AudioSampleBuffer outA(numChannels, maxOut), outB(numChannels, maxOut);
+    HeapBlock<const float*> in(numChannels);
+    HeapBlock<float*> out(numChannels);
+    int producedA = 0, producedB = 0;
+
+    for (int done = 0; done < numSamples; done += BLOCK_SIZE)
+    {
+        for (int c = 0; c < numChannels; c++)
+        {
+            in[c] = input.getReadPointer(c, done);
+            out[c] = outA.getWritePointer(c, producedA);
+        }
+
+        producedA += a.process(in, BLOCK_SIZE, out);
+    }
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int n = jmin(numSamples - done, 1 + random.nextInt(2 * BLOCK_SIZE));
+
+        for (int c = 0; c < numChannels; c++)
+        {
+            in[c] = input.getReadPointer(c, done);
+            out[c] = outB.getWritePointer(c, producedB);
+        }
+
+        producedB += b.process(in, n, out);
+        done += n;
+    }
+
+    if (producedA != producedB)
+        return 1e9f;
+
+    float maxDifference = 0;
+
+    for (int c = 0; c < numChannels; c++)
+        for (int i = 0; i < producedA; i++)
+            maxDifference = jmax(maxDifference, std::abs(outA.getSample(c, i) - outB.getSample(c, i)));
+
+    return maxDifference;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 20.0;
+
+    struct Case { int numChannels; double sourceRate, destRate; };
+    const Case cases[] = {{1, 30000, 44100}, {16, 30000, 44100}, {8, 30000, 1000}, {64, 30000, 5000},
+                          {256, 30000, 1000}};
+
+    printf("Throughput, x real time, %.0f s of input in blocks of %d\n", seconds, BLOCK_SIZE);
+
+    for (int n = 0; n < int(sizeof(cases) / sizeof(cases[0])); n++)
+    {
+        const Case& c = cases[n];
+        const double oldRate = timeConverter<LinearInterpolator>(c.numChannels, c.sourceRate, c.destRate, seconds);
+        const double newRate = timeConverter<PolyphaseConverter>(c.numChannels, c.sourceRate, c.destRate, seconds);
+
+        printf("  %3d ch %5.1fk -> %5.1fk   old %8.0fx   new %8.0fx\n", c.numChannels,
+               c.sourceRate / 1000.0, c.destRate / 1000.0, oldRate, newRate);
+    }
+
+    printf("Passband, 30k -> 44.1k, output level, dB\n");
+
+    const double passband[] = {1000, 5000, 10000};
+
+    for (int n = 0; n < 3; n++)
+    {
+        LinearInterpolator oldConverter(1, 30000, 44100);
+        PolyphaseConverter newConverter(1, 30000, 44100);
+
+        printf("  %5.0f Hz   old %7.2f   new %7.2f\n", passband[n],
+               toDecibels(measureTone(oldConverter, 30000, passband[n], 200)),
+               toDecibels(measureTone(newConverter, 30000, passband[n], 200)));
+    }
+
+    printf("Aliasing, 30k -> 5k, output level of tones above 2.5 kHz, dB\n");
+
+    const double stopband[] = {3500, 4000, 7000};
+
+    for (int n = 0; n < 3; n++)
+    {
+        LinearInterpolator oldConverter(1, 30000, 5000);
+        PolyphaseConverter newConverter(1, 30000, 5000);
+
+        printf("  %5.0f Hz   old %7.1f   new %7.1f\n", stopband[n],
+               toDecibels(measureTone(oldConverter, 30000, stopband[n], 200)),
+               toDecibels(measureTone(newConverter, 30000, stopband[n], 200)));
+    }
+
+    printf("Block split, largest difference from 1024-sample blocks\n");
+
+    const Case splits[] = {{1, 30000, 44100}, {3, 30000, 5000}, {8, 30000, 1000}, {19, 25000, 30000},
+                           {9, 44100, 48000}, {12, 30000, 30000}, {5, 20000, 7777}};
+
+    for (int n = 0; n < int(sizeof(splits) / sizeof(splits[0])); n++)
+    {
+        const Case& c = splits[n];
+
+        printf("  %2d ch %6.0f -> %6.0f   %g\n", c.numChannels, c.sourceRate, c.destRate,
+               compareBlockSplits(c.numChannels, c.sourceRate, c.destRate));
+    }
+
+    return 0;
+}
@@ -0,0 +1,337 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <cmath>
+
+#include "PolyphaseResampler.h"
+
+namespace
+{
+// zeroth order modified Bessel function of the first kind, for the Kaiser window
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+
+        if (term < sum * 1e-12)
+            break;
+    }
+
+    return sum;
+}
+
+int greatestCommonDivisor(int64 a, int64 b)
+{
+    while (b != 0)
+    {
+        int64 t = a % b;
+        a = b;
+        b = t;
+    }
+    return int(a);
+}
+}
+
+PolyphaseResampler::PolyphaseResampler()
+    : numChannels(0), upFactor(1), downFactor(1), numTaps(0),
+      groupWidth(1), numGroups(0), historyIndex(0), phase(0), inputsUntilOutput(1)
+{
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+void PolyphaseResampler::prepare(int numChannels_, double sourceRate, double destRate, int tapsPerPhase)
+{
+    jassert(sourceRate > 0 && destRate > 0 && tapsPerPhase > 0);
+
+    numChannels = jmax(1, numChannels_);
+
+    computeRatio(sourceRate, destRate);
+
+    if (isBypassed())
+        numTaps = 1;
+    else
+        designFilter(tapsPerPhase);
+
+    groupWidth = (numChannels == 1) ? 1 : CHANNELS_PER_GROUP;
+    numGroups = (numChannels + groupWidth - 1) / groupWidth;
+
+    history.allocate(numGroups * 2 * numTaps * groupWidth, true);
+
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    if (history != nullptr)
+        FloatVectorOperations::clear(history, numGroups * 2 * numTaps * groupWidth);
+
+    historyIndex = 0;
+    phase = 0;
+    inputsUntilOutput = 1;
+}
+
+void PolyphaseResampler::computeRatio(double sourceRate, double destRate)
+{
+    int64 source = (int64) std::floor(sourceRate + 0.5);
+    int64 dest = (int64) std::floor(destRate + 0.5);
+
+    if (std::abs(sourceRate - double(source)) < 1e-6 && std::abs(destRate - double(dest)) < 1e-6)
+    {
+        int gcd = greatestCommonDivisor(source, dest);
+
+        if (dest / gcd <= maxFactor && source / gcd <= maxFactor)
+        {
+            upFactor = int(dest / gcd);
+            downFactor = int(source / gcd);
+            return;
+        }
+    }
+
+    // continued fraction expansion of destRate/sourceRate; the last convergent
+    // whose terms both fit is the best approximation within maxFactor
+    double x = destRate / sourceRate;
+    int64 p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+
+    for (int i = 0; i < 32; i++)
+    {
+        int64 a = (int64) std::floor(x);
+        int64 p2 = a * p1 + p0;
+        int64 q2 = a * q1 + q0;
+
+        if (p2 > maxFactor || q2 > maxFactor)
+            break;
+
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+
+        double remainder = x - double(a);
+
+        if (remainder < 1e-9)
+            break;
+
+        x = 1.0 / remainder;
+    }
+
+    if (p1 == 0 || q1 == 0) // the ratio is beyond maxFactor in one direction
+    {
+        p1 = (destRate > sourceRate) ? int64(maxFactor) : 1;
+        q1 = (destRate > sourceRate) ? 1 : int64(maxFactor);
+    }
+
+    upFactor = int(p1);
+    downFactor = int(q1);
+
+    std::cout << "PolyphaseResampler: approximating " << destRate / sourceRate
+              << " by " << upFactor << "/" << downFactor << std::endl;
+}
+
+void PolyphaseResampler::designFilter(int tapsPerPhase)
+{
+    // when decimating the filter has to span downFactor/upFactor times more
+    // input samples to keep the same transition band at the output rate
+    numTaps = (tapsPerPhase * jmax(upFactor, downFactor) + upFactor - 1) / upFactor;
+
+    const int length = upFactor * numTaps;
+    const double cutoff = 0.5 / jmax(upFactor, downFactor); // cycles per sample at upFactor * sourceRate
+    const double centre = (length - 1) / 2.0;
+    const double beta = 8.0;
+    const double norm = besselI0(beta);
+
+    HeapBlock<double> prototype(length);
+    double sum = 0.0;
+
+    for (int n = 0; n < length; n++)
+    {
+        double t = n - centre;
+        double sinc = (t == 0.0) ? 1.0 : std::sin(2.0 * double_Pi * cutoff * t) / (2.0 * double_Pi * cutoff * t);
+        double r = (length > 1) ? 2.0 * n / (length - 1) - 1.0 : 0.0;
+        double window = besselI0(beta * std::sqrt(jmax(0.0, 1.0 - r * r))) / norm;
+
+        prototype[n] = sinc * window;
+        sum += prototype[n];
+    }
+
+    // every branch sees one in upFactor samples of the zero-stuffed input,
+    // so the branches together need a DC gain of upFactor
+    const double scale = double(upFactor) / sum;
+
+    coefficients.allocate(upFactor * numTaps, true);
+
+    for (int p = 0; p < upFactor; p++)
+    {
+        float* branch = coefficients + p * numTaps;
+
+        for (int m = 0; m < numTaps; m++)
+            branch[m] = float(prototype[p + (numTaps - 1 - m) * upFactor] * scale);
+    }
+}
+
+double PolyphaseResampler::getLatency() const
+{
+    if (isBypassed())
+        return 0.0;
+
+    return (upFactor * numTaps - 1) / (2.0 * upFactor);
+}
+
+int PolyphaseResampler::getNumOutputSamples(int numInputSamples) const
+{
+    if (isBypassed())
+        return numInputSamples;
+
+    // position of the next output on the upsampled grid, counted from the
+    // first of the new input samples
+    int64 next = int64(inputsUntilOutput - 1) * upFactor + phase;
+    int64 last = int64(numInputSamples) * upFactor - 1;
+
+    if (numInputSamples <= 0 || next > last)
+        return 0;
+
+    return int((last - next) / downFactor + 1);
+}
+
+int PolyphaseResampler::getMaxOutputSamples(int numInputSamples) const
+{
+    if (isBypassed())
+        return numInputSamples;
+
+    return int((int64(numInputSamples) * upFactor) / downFactor + 1);
+}
+
+void PolyphaseResampler::computeOutput(const float* window, const float* taps,
+                                       float* const* outputs, int numOutputChannels, int outputIndex)
+{
+    if (groupWidth == 1)
+    {
+        // four partial sums break the dependency chain of a single dot product
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        int m = 0;
+
+        for (; m + 4 <= numTaps; m += 4)
+        {
+            s0 += taps[m] * window[m];
+            s1 += taps[m + 1] * window[m + 1];
+            s2 += taps[m + 2] * window[m + 2];
+            s3 += taps[m + 3] * window[m + 3];
+        }
+
+        for (; m < numTaps; m++)
+            s0 += taps[m] * window[m];
+
+        outputs[0][outputIndex] = (s0 + s1) + (s2 + s3);
+        return;
+    }
+
+    // one lane per channel; the sums stay in registers for the whole filter
+    float sums[CHANNELS_PER_GROUP] = {};
+
+    for (int m = 0; m < numTaps; m++)
+    {
+        const float tap = taps[m];
+        const float* row = window + m * groupWidth;
+
+        for (int j = 0; j < CHANNELS_PER_GROUP; j++)
+            sums[j] += tap * row[j];
+    }
+
+    for (int j = 0; j < numOutputChannels; j++)
+        outputs[j][outputIndex] = sums[j];
+}
+
+int PolyphaseResampler::process(const float* const* inputs, int numInputSamples, float* const* outputs)
+{
+    if (isBypassed())
+    {
+        for (int c = 0; c < numChannels; c++)
+        {
+            if (outputs[c] != inputs[c])
+                FloatVectorOperations::copy(outputs[c], inputs[c], numInputSamples);
+        }
+        return numInputSamples;
+    }
+
+    int numOutputs = 0;
+    int index = historyIndex;
+    int nextPhase = phase;
+    int remaining = inputsUntilOutput;
+
+    // groups are converted one after the other over the whole block, so only
+    // one group's history needs to stay in cache at a time
+    for (int g = 0; g < numGroups; g++)
+    {
+        const int firstChannel = g * groupWidth;
+        const int numGroupChannels = jmin(groupWidth, numChannels - firstChannel);
+        const float* const* groupInputs = inputs + firstChannel;
+        float* const* groupOutputs = outputs + firstChannel;
+        float* groupHistory = history + g * 2 * numTaps * groupWidth;
+
+        index = historyIndex;
+        nextPhase = phase;
+        remaining = inputsUntilOutput;
+        numOutputs = 0;
+
+        for (int i = 0; i < numInputSamples; i++)
+        {
+            float* slot = groupHistory + index * groupWidth;
+            float* copy = slot + numTaps * groupWidth;
+
+            for (int j = 0; j < numGroupChannels; j++)
+            {
+                slot[j] = groupInputs[j][i];
+                copy[j] = slot[j];
+            }
+
+            if (++index == numTaps)
+                index = 0;
+
+            if (--remaining > 0)
+                continue;
+
+            do
+            {
+                computeOutput(groupHistory + index * groupWidth, coefficients + nextPhase * numTaps,
+                              groupOutputs, numGroupChannels, numOutputs++);
+
+                nextPhase += downFactor;
+                remaining = nextPhase / upFactor;
+                nextPhase %= upFactor;
+            }
+            while (remaining == 0);
+        }
+    }
+
+    historyIndex = index;
+    phase = nextPhase;
+    inputsUntilOutput = remaining;
+
+    return numOutputs;
+}
@@ -0,0 +1,133 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __POLYPHASERESAMPLER_H_3C1F7A2E__
+#define __POLYPHASERESAMPLER_H_3C1F7A2E__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+#define CHANNELS_PER_GROUP 32
+
+/**
+
+  Streaming sample rate converter for any rational ratio between two rates.
+
+  The ratio is reduced to upFactor/downFactor (L/M) and the signal is
+  interpolated with a Kaiser-windowed lowpass FIR split into L polyphase
+  branches, so each output sample costs numTaps multiply-adds per channel
+  however large L is. The cutoff sits at the Nyquist frequency of the slower
+  of the two rates.
+
+  The last numTaps input samples of every channel are kept between calls,
+  so consecutive blocks of any length join without discontinuities. The
+  history of each group of CHANNELS_PER_GROUP channels is interleaved and the
+  inner loop runs across the channels of a group, so the compiler turns every
+  tap into a few independent vector multiply-adds. With eight channels per
+  group each tap had to wait for the previous one's sum, which held back the
+  long filters of large decimation factors.
+
+  @see AudioNode, ResamplingNode
+
+*/
+
+class PolyphaseResampler
+{
+public:
+    PolyphaseResampler();
+    ~PolyphaseResampler();
+
+    /** Designs the filter for converting numChannels channels from sourceRate
+        to destRate and clears the history. Rates that are not integer ratios
+        of each other are approximated by the closest fraction whose terms do
+        not exceed maxFactor.
+
+        tapsPerPhase sets the filter length in units of the slower rate; the
+        default gives a transition band of about 15% of that rate and around
+        80 dB of stopband attenuation.
+    */
+    void prepare(int numChannels, double sourceRate, double destRate, int tapsPerPhase = 32);
+
+    /** Clears the history, as if the resampler had just been prepared. */
+    void reset();
+
+    /** Number of output samples that the next numInputSamples input samples
+        will produce. */
+    int getNumOutputSamples(int numInputSamples) const;
+
+    /** Largest number of output samples that numInputSamples input samples can
+        produce, whatever the current state. */
+    int getMaxOutputSamples(int numInputSamples) const;
+
+    /** Converts numInputSamples samples of every channel. The output arrays must
+        hold getNumOutputSamples(numInputSamples) samples; returns the number of
+        samples written. */
+    int process(const float* const* inputs, int numInputSamples, float* const* outputs);
+
+    /** Delay introduced by the filter, in input samples. */
+    double getLatency() const;
+
+    int getNumChannels() const { return numChannels; }
+    int getUpFactor() const { return upFactor; }
+    int getDownFactor() const { return downFactor; }
+
+    /** True when the two rates are equal and samples are copied unchanged. */
+    bool isBypassed() const { return upFactor == downFactor; }
+
+    /** Largest up or down factor accepted when approximating a ratio. */
+    static const int maxFactor = 1024;
+
+private:
+    void computeRatio(double sourceRate, double destRate);
+    void designFilter(int tapsPerPhase);
+
+    /** Writes one output sample of every channel of a group from the numTaps
+        input samples starting at window. */
+    void computeOutput(const float* window, const float* taps,
+                       float* const* outputs, int numOutputChannels, int outputIndex);
+
+    int numChannels;
+    int upFactor;
+    int downFactor;
+    int numTaps;
+
+    /** upFactor branches of numTaps coefficients, oldest sample first */
+    HeapBlock<float> coefficients;
+
+    /** Channels are split in groups of CHANNELS_PER_GROUP (or a single group
+        of one channel). Each group keeps 2 * numTaps samples with its channels
+        interleaved; every input sample is written twice so the newest numTaps
+        always form one contiguous run. Unused lanes of the last group stay zero. */
+    HeapBlock<float> history;
+    int groupWidth;
+    int numGroups;
+    int historyIndex;
+
+    /** Branch of the next output sample and the number of input samples still
+        needed before it can be computed */
+    int phase;
+    int inputsUntilOutput;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResampler);
+};
+
+#endif  // __POLYPHASERESAMPLER_H_3C1F7A2E__
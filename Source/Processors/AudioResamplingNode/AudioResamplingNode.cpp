@@ -27,7 +27,7 @@
 AudioResamplingNode::AudioResamplingNode()
     : GenericProcessor("Resampling Node"),
       sourceBufferSampleRate(40000.0), destBufferSampleRate(44100.0),
-      ratio(1.0), lastRatio(1.0), destBuffer(0), tempBuffer(0),
+      destBuffer(0), tempBuffer(0),
       destBufferIsTempBuffer(true), isTransmitting(false), destBufferPos(0)
 {
 
@@ -39,9 +39,6 @@ AudioResamplingNode::AudioResamplingNode()
                          44100.0, // sampleRate
                          128);    // blockSize
 
-    filter = new Dsp::SmoothedFilterDesign
-    <Dsp::RBJ::Design::LowPass, 1> (1024);
-
     if (destBufferIsTempBuffer)
         destBufferWidth = 1024;
     else
@@ -61,7 +58,6 @@ AudioResamplingNode::~AudioResamplingNode()
     delete[] continuousDataBuffer;
     deleteAndZero(tempBuffer);
     deleteAndZero(destBuffer);
-    delete filter;
 }
 
 
@@ -93,6 +89,9 @@ void AudioResamplingNode::prepareToPlay(double sampleRate_, int estimatedSamples
 
     // std::cout << "AudioResamplingNode preparing to play." << std::endl;
 
+    if (channels.size() > 0)
+        sourceBufferSampleRate = channels[0]->sampleRate;
+
     if (destBufferIsTempBuffer)
     {
         destBufferSampleRate = sampleRate_;
@@ -119,18 +118,7 @@ void AudioResamplingNode::prepareToPlay(double sampleRate_, int estimatedSamples
 void AudioResamplingNode::updateFilter()
 {
 
-    double cutoffFreq = (ratio > 1.0) ? 2 * destBufferSampleRate  // downsample
-                        : destBufferSampleRate / 2; // upsample
-
-    double sampleFreq = (ratio > 1.0) ? sourceBufferSampleRate // downsample
-                        : destBufferSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filter->setParams(params);
+    resampler.prepare(jmax(1, getNumInputs()), sourceBufferSampleRate, destBufferSampleRate);
 
 }
 
@@ -143,115 +131,27 @@ void AudioResamplingNode::process(AudioSampleBuffer& buffer,
                                   MidiBuffer& midiMessages)
 {
 
-    int nSamps = buffer.getNumSamples(); // WRONG!!!!
-    int valuesNeeded;
-
-    if (destBufferIsTempBuffer)
-    {
-        ratio = float(nSamps) / float(buffer.getNumSamples());
-        valuesNeeded = buffer.getNumSamples();
-    }
-    else
-    {
-        ratio = sourceBufferSampleRate / destBufferSampleRate;
-        valuesNeeded = (int) buffer.getNumSamples() / ratio;
-        //std::cout << std::endl;
-        //std::cout << "Ratio: " << ratio << std::endl;
-        //std::cout << "Values needed: " << valuesNeeded << std::endl;
-    }
-
-
-
-    if (lastRatio != ratio)
-    {
-        updateFilter();
-        lastRatio = ratio;
-    }
-
-
-    if (ratio > 1.0001)
-    {
-        // pre-apply filter before downsampling
-        filter->process(nSamps, buffer.getArrayOfWritePointers());
-    }
-
-
-    // initialize variables
-    tempBuffer->clear();
-    int sourceBufferPos = 0;
-    int sourceBufferSize = buffer.getNumSamples();
-    float subSampleOffset = 0.0;
-    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-    int tempBufferPos;
-    //int totalSamples = 0;
+    int nSamps = (channels.size() > 0) ? getNumSamples(0) : buffer.getNumSamples();
+    int numChannels = resampler.getNumChannels();
 
-    // code modified from "juce_ResamplingAudioSource.cpp":
+    if (numChannels > buffer.getNumChannels() || numChannels > tempBuffer->getNumChannels())
+        return;
 
-    for (tempBufferPos = 0; tempBufferPos < valuesNeeded; tempBufferPos++)
-    {
-        float gain = 1.0;
-        float alpha = (float) subSampleOffset;
-        float invAlpha = 1.0f - alpha;
-
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-        {
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,  // destSampleOffset
-                                buffer,			// source
-                                channel,		// sourceChannel
-                                sourceBufferPos,// sourceSampleOffset
-                                1,				// number of samples
-                                invAlpha*gain);      // gain to apply to source
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,   // destSampleOffset
-                                buffer,			// source
-                                channel,			// sourceChannel
-                                nextPos,		 	// sourceSampleOffset
-                                1,				// number of samples
-                                alpha*gain);     	 // gain to apply to source
-
-        }
-
-        subSampleOffset += ratio;
+    int valuesNeeded = resampler.getNumOutputSamples(nSamps);
 
+    if (valuesNeeded > tempBuffer->getNumSamples())
+        tempBuffer->setSize(tempBuffer->getNumChannels(), valuesNeeded, false, false, true);
 
-
-        while (subSampleOffset >= 1.0)
-        {
-            if (++sourceBufferPos >= sourceBufferSize)
-                sourceBufferPos = 0;
-
-            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-            subSampleOffset -= 1.0;
-        }
-    }
-
-    // std::cout << sourceBufferPos << " " << tempBufferPos << std::endl;
-
-
-    if (ratio < 0.9999)
-    {
-
-        filter->process(tempBufferPos, tempBuffer->getArrayOfWritePointers());
-        // apply the filter after upsampling
-        ///////filter->process (totalSamples, buffer.getArrayOfChannels());
-    }
-    else if (ratio <= 1.0001)
-    {
-
-        // no resampling is being applied, no need to filter, BUT...
-        // keep the filter stoked with samples to avoid discontinuities
-
-    }
+    resampler.process(buffer.getArrayOfReadPointers(), nSamps, tempBuffer->getArrayOfWritePointers());
 
     if (destBufferIsTempBuffer)
     {
 
         // copy the temp buffer into the original buffer
-        buffer = AudioSampleBuffer(tempBuffer->getArrayOfWritePointers(), 2, tempBufferPos);//buffer.getNumSamples());
+        valuesNeeded = jmin(valuesNeeded, buffer.getNumSamples());
+
+        for (int channel = 0; channel < numChannels; channel++)
+            buffer.copyFrom(channel, 0, *tempBuffer, channel, 0, valuesNeeded);
 
     }
     else
@@ -261,16 +161,13 @@ void AudioResamplingNode::process(AudioSampleBuffer& buffer,
 
         // copy the temp buffer into the destination buffer
 
-        int pos = 0;
-
-        while (*tempBuffer->getWritePointer(0,pos) != 0)
-            pos++;
+        int pos = jmin(valuesNeeded, destBufferWidth);
 
         int spaceAvailable = destBufferWidth - destBufferPos;
         int blockSize1 = (spaceAvailable > pos) ? pos : spaceAvailable;
         int blockSize2 = (spaceAvailable > pos) ? 0 : (pos - spaceAvailable);
 
-        for (int channel = 0; channel < destBuffer->getNumChannels(); channel++)
+        for (int channel = 0; channel < jmin(numChannels, destBuffer->getNumChannels()); channel++)
         {
 
             // copy first block
@@ -293,12 +190,9 @@ void AudioResamplingNode::process(AudioSampleBuffer& buffer,
 
         }
 
-        //destBufferPos = (spaceAvailable > tempBufferPos) ? destBufferPos
-
         destBufferPos += pos;
         destBufferPos %= destBufferWidth;
 
-        //std::cout << "Temp buffer position: " << tempBufferPos << std::endl;
         //std::cout << "Resampling node value:" << *destBuffer->getReadPointer(0,0) << std::endl;
 
     }
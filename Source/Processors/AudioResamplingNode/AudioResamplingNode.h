@@ -25,7 +25,7 @@
 #define __AUDIORESAMPLINGNODE_H_CFAB182E__
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
-#include "../Dsp/Dsp.h"
+#include "../AudioNode/PolyphaseResampler.h"
 #include "../GenericProcessor/GenericProcessor.h"
 
 /**
@@ -33,13 +33,11 @@
   Changes the sample rate of continuous data, specialized for increasing
   the sample rate to 44.1 kHz for audio output.
 
-  Code is based on Juce's ResamplingAudioSource class.
+  Conversion is done by a PolyphaseResampler, which keeps its state between
+  buffers, so inputs that provide a different number of samples in each
+  buffer are converted without shifting the pitch.
 
-  This processor could be vastly improved by implementing a scheme to handle
-  inputs that do not provide the same amount of samples in each buffer. At the
-  moment, the resampling process shifts the pitch of the incoming signal.
-
-  @see GenericProcessor
+  @see GenericProcessor, PolyphaseResampler
 
 */
 
@@ -55,6 +53,7 @@ public:
     {
         return destBuffer;
     }
+    /** Prepares the resampler for the current rates and number of channels. */
     void updateFilter();
 
     void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
@@ -70,14 +69,13 @@ public:
 
 private:
 
-    // sample rate, timebase, and ratio info:
+    // sample rate and timebase info:
     double sourceBufferSampleRate, destBufferSampleRate;
-    double ratio, lastRatio;
     double destBufferTimebaseSecs;
     int destBufferWidth;
 
     // major objects:
-    Dsp::Filter* filter;
+    PolyphaseResampler resampler;
     AudioSampleBuffer* destBuffer;
     AudioSampleBuffer* tempBuffer;
 
@@ -28,6 +28,7 @@ DataBuffer::DataBuffer(int chans, int size)
 {
     timestampBuffer.malloc(size);
     eventCodeBuffer.malloc(size);
+    arrivalBuffer.malloc(size);
 
 }
 
@@ -45,6 +46,7 @@ void DataBuffer::resize(int chans, int size)
     buffer.setSize(chans, size);
     timestampBuffer.malloc(size);
     eventCodeBuffer.malloc(size);
+    arrivalBuffer.malloc(size);
 
     numChans = chans;
 }
@@ -67,16 +69,59 @@ void DataBuffer::addToBuffer(float* data, int64* timestamps, uint64* eventCodes,
     *(timestampBuffer + startIndex1) = *timestamps;
     *(eventCodeBuffer + startIndex1) = *eventCodes;
 
+    // every slot gets a stamp, so a read starting anywhere in this chunk finds one
+    int64 now = Time::getHighResolutionTicks();
+
+    for (int i = 0; i < blockSize1; i++)
+        arrivalBuffer[startIndex1 + i] = now;
+    for (int i = 0; i < blockSize2; i++)
+        arrivalBuffer[startIndex2 + i] = now;
+
     abstractFifo.finishedWrite(numItems);
 }
 
+int DataBuffer::addBlockToBuffer(const AudioSampleBuffer& data, const int64* timestamps, const uint64* eventCodes, int numItems)
+{
+    int startIndex1, blockSize1, startIndex2, blockSize2;
+    abstractFifo.prepareToWrite(numItems, startIndex1, blockSize1, startIndex2, blockSize2);
+
+    int64 now = Time::getHighResolutionTicks();
+
+    for (int chan = 0; chan < numChans; chan++)
+    {
+        buffer.copyFrom(chan, startIndex1, data, chan, 0, blockSize1);
+
+        if (blockSize2 > 0)
+            buffer.copyFrom(chan, startIndex2, data, chan, blockSize1, blockSize2);
+    }
+
+    memcpy(timestampBuffer + startIndex1, timestamps, blockSize1 * sizeof(int64));
+    memcpy(eventCodeBuffer + startIndex1, eventCodes, blockSize1 * sizeof(uint64));
+
+    if (blockSize2 > 0)
+    {
+        memcpy(timestampBuffer + startIndex2, timestamps + blockSize1, blockSize2 * sizeof(int64));
+        memcpy(eventCodeBuffer + startIndex2, eventCodes + blockSize1, blockSize2 * sizeof(uint64));
+    }
+
+    for (int i = 0; i < blockSize1; i++)
+        arrivalBuffer[startIndex1 + i] = now;
+    for (int i = 0; i < blockSize2; i++)
+        arrivalBuffer[startIndex2 + i] = now;
+
+    abstractFifo.finishedWrite(blockSize1 + blockSize2);
+
+    return blockSize1 + blockSize2;
+}
+
 int DataBuffer::getNumSamples()
 {
     return abstractFifo.getNumReady();
 }
 
 
-int DataBuffer::readAllFromBuffer(AudioSampleBuffer& data, uint64* timestamp, uint64* eventCodes, int maxSize)
+int DataBuffer::readAllFromBuffer(AudioSampleBuffer& data, uint64* timestamp, uint64* eventCodes, int maxSize,
+                                  int64* arrivalTicks)
 {
     // check to see if the maximum size is smaller than the total number of available ints
 
@@ -106,10 +151,16 @@ int DataBuffer::readAllFromBuffer(AudioSampleBuffer& data, uint64* timestamp, ui
 
         memcpy(timestamp, timestampBuffer+startIndex1, 8);
         memcpy(eventCodes, eventCodeBuffer+startIndex1, blockSize1*8);
+
+        if (arrivalTicks != nullptr)
+            *arrivalTicks = arrivalBuffer[startIndex1];
     }
     else
     {
         memcpy(timestamp, timestampBuffer+startIndex2, 8);
+
+        if (arrivalTicks != nullptr)
+            *arrivalTicks = (blockSize2 > 0) ? arrivalBuffer[startIndex2] : 0;
     }
 
     if (blockSize2 > 0)
@@ -45,14 +45,24 @@ public:
     /** Clears the buffer.*/
     void clear();
 
-    /** Add an array of floats to the buffer.*/
+    /** Add an array of floats to the buffer. The arrival time of the samples
+        is stamped with the high resolution clock.*/
     void addToBuffer(float* data, int64* ts, uint64* eventCodes, int numItems);
 
+    /** Adds numItems samples of every channel at once. The data is channel-major,
+        one channel per AudioSampleBuffer channel, so sources that generate whole
+        blocks avoid a copy per sample. Returns the number of samples written,
+        which is smaller than numItems if the buffer is full.*/
+    int addBlockToBuffer(const AudioSampleBuffer& data, const int64* ts, const uint64* eventCodes, int numItems);
+
     /** Returns the number of samples currently available in the buffer.*/
     int getNumSamples();
 
-    /** Copies as many samples as possible from the DataBuffer to an AudioSampleBuffer.*/
-    int readAllFromBuffer(AudioSampleBuffer& data, uint64* ts, uint64* eventCodes, int maxSize);
+    /** Copies as many samples as possible from the DataBuffer to an AudioSampleBuffer.
+        If arrivalTicks is given, it receives the high resolution ticks at which the
+        oldest sample that was read entered the buffer.*/
+    int readAllFromBuffer(AudioSampleBuffer& data, uint64* ts, uint64* eventCodes, int maxSize,
+                          int64* arrivalTicks = nullptr);
 
     /** Resizes the data buffer */
     void resize(int chans, int size);
@@ -63,6 +73,7 @@ private:
 
     HeapBlock<int64> timestampBuffer;
     HeapBlock<uint64> eventCodeBuffer;
+    HeapBlock<int64> arrivalBuffer;
 
     int numChans;
 
@@ -0,0 +1,141 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "TTLEdgeDetector.h"
+
+#if JUCE_MSVC
+#include <intrin.h>
+#endif
+
+// number of samples checked at once when looking for a change
+#define SCAN_BLOCK_SIZE 8
+
+TTLEdgeDetector::TTLEdgeDetector(int numChannels) : mask(0), state(0)
+{
+    setNumChannels(numChannels);
+}
+
+TTLEdgeDetector::~TTLEdgeDetector()
+{
+}
+
+void TTLEdgeDetector::setNumChannels(int numChannels)
+{
+    if (numChannels >= 64)
+        mask = ~uint64(0);
+    else if (numChannels <= 0)
+        mask = 0;
+    else
+        mask = (uint64(1) << numChannels) - 1;
+
+    state &= mask;
+}
+
+void TTLEdgeDetector::reset(uint64 s)
+{
+    state = s & mask;
+}
+
+uint64 TTLEdgeDetector::getState() const
+{
+    return state;
+}
+
+int TTLEdgeDetector::findLowestSetBit(uint64 word)
+{
+    jassert(word != 0);
+
+#if JUCE_GCC || JUCE_CLANG
+    return __builtin_ctzll(word);
+#elif JUCE_MSVC && JUCE_64BIT
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int) index;
+#elif JUCE_MSVC
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long) word))
+        return (int) index;
+    _BitScanForward(&index, (unsigned long) (word >> 32));
+    return (int) index + 32;
+#else
+    int index = 0;
+    while ((word & 1) == 0)
+    {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+int TTLEdgeDetector::findEdges(const uint64* words, int numSamples, Array<TTLEdge>& edges)
+{
+    int numEdges = 0;
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        // skip whole blocks that match the current state; the reduction has no
+        // branches so the compiler can vectorize it
+        while (i + SCAN_BLOCK_SIZE <= numSamples)
+        {
+            uint64 changed = 0;
+            for (int k = 0; k < SCAN_BLOCK_SIZE; k++)
+                changed |= words[i + k] ^ state;
+
+            if ((changed & mask) != 0)
+                break;
+
+            i += SCAN_BLOCK_SIZE;
+        }
+
+        if (i >= numSamples)
+            break;
+
+        uint64 changed = (words[i] ^ state) & mask;
+
+        if (changed != 0)
+        {
+            uint64 word = words[i] & mask;
+
+            while (changed != 0)
+            {
+                int channel = findLowestSetBit(changed);
+                changed &= changed - 1;
+
+                TTLEdge edge;
+                edge.sample = i;
+                edge.channel = channel;
+                edge.rising = ((word >> channel) & 1) != 0;
+                edges.add(edge);
+                numEdges++;
+            }
+
+            state = word;
+        }
+
+        i++;
+    }
+
+    return numEdges;
+}
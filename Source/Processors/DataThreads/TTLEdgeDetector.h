@@ -0,0 +1,84 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __TTLEDGEDETECTOR_H__
+#define __TTLEDGEDETECTOR_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+
+/** A single TTL transition found by TTLEdgeDetector */
+struct TTLEdge
+{
+    int sample;
+    int channel;
+    bool rising;
+};
+
+/**
+
+    Extracts TTL transitions from a stream of event words (one bit per
+    event channel, one word per sample).
+
+    Runs of samples whose word doesn't change are skipped in blocks, and
+    only the bits that actually changed are visited, so the cost depends on
+    the number of transitions rather than on samples x channels. The state
+    of every channel is kept between calls.
+
+    Used by the SourceNode; data threads can use it to find transitions in
+    their own event words.
+
+    See @SourceNode, @DataBuffer
+
+*/
+
+class PLUGIN_API TTLEdgeDetector
+{
+public:
+    TTLEdgeDetector(int numChannels = 64);
+    ~TTLEdgeDetector();
+
+    /** Sets how many low bits of every word are event channels (up to 64). */
+    void setNumChannels(int numChannels);
+
+    /** Sets the state the next block is compared against. */
+    void reset(uint64 state = 0);
+
+    /** Returns the state of all channels after the last processed sample. */
+    uint64 getState() const;
+
+    /** Appends every transition in words[0..numSamples) to edges, ordered by
+        sample and then by channel. Returns the number of edges found. */
+    int findEdges(const uint64* words, int numSamples, Array<TTLEdge>& edges);
+
+    /** Returns the index of the lowest set bit of a non-zero word. */
+    static int findLowestSetBit(uint64 word);
+
+private:
+    uint64 mask;
+    uint64 state;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TTLEdgeDetector);
+};
+
+#endif  // __TTLEDGEDETECTOR_H__
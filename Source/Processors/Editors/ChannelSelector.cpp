@@ -21,6 +21,7 @@
  
  */
 
+
 #include "ChannelSelector.h"
 #include <math.h>
 
@@ -30,10 +31,16 @@
 #include "../ProcessorGraph/ProcessorGraph.h"
 #include "../../UI/GraphViewer.h"
 
+#define ROW_HEIGHT 14
+
+// the first 96 channels use narrower columns than the rest
+#define NUM_NARROW_CHANNELS 96
+
 ChannelSelector::ChannelSelector(bool createButtons, Font& titleFont_) :
-eventsOnly(false), paramsToggled(true), paramsActive(true),
+eventsOnly(false), numChannels(0), paramsToggled(true), paramsActive(true),
 recActive(true), radioStatus(false), isNotSink(createButtons),
-moveRight(false), moveLeft(false), offsetLR(0), offsetUD(0), desiredOffset(0), titleFont(titleFont_), acquisitionIsActive(false)
+moveRight(false), moveLeft(false), offsetLR(0), offsetUD(0), overallHeight(0), desiredOffset(0), titleFont(titleFont_),
+acquisitionIsActive(false), lastClickedChannel(-1)
 {
     
     // initialize buttons
@@ -55,16 +62,11 @@ moveRight(false), moveLeft(false), offsetLR(0), offsetUD(0), desiredOffset(0), t
     
     paramsButton->setToggleState(true, dontSendNotification);
     
-    audioButtons.clear();
-    recordButtons.clear();
-    
     // set button layout parameters
     parameterOffset = 0;
     recordOffset = getDesiredWidth();
     audioOffset = getDesiredWidth()*2;
     
-    parameterButtons.clear();
-    
     allButton = new EditorButton("all", titleFont);
     allButton->addListener(this);
     addAndMakeVisible(allButton);
@@ -73,8 +75,17 @@ moveRight(false), moveLeft(false), offsetLR(0), offsetUD(0), desiredOffset(0), t
     noneButton->addListener(this);
     addAndMakeVisible(noneButton);
     
-    channelSelectorRegion = new ChannelSelectorRegion(this);
-    //channelSelectorRegion->setBounds(0,20,0,getHeight()-35);
+    Font searchFont = titleFont;
+    searchFont.setHeight(10);
+    
+    searchBox = new TextEditor("Channel search");
+    searchBox->setFont(searchFont);
+    searchBox->setTextToShowWhenEmpty("find", Colours::grey);
+    searchBox->setTooltip("Channel number to jump to, or channels to select (e.g. 1-64, 100)");
+    searchBox->addListener(this);
+    addAndMakeVisible(searchBox);
+    
+    channelSelectorRegion = new ChannelSelectorRegion(this, titleFont);
     addAndMakeVisible(channelSelectorRegion);
     channelSelectorRegion->toBack();
     
@@ -114,35 +125,32 @@ void ChannelSelector::paint(Graphics& g)
 void ChannelSelector::setNumChannels(int numChans)
 {
     
-    int difference = numChans - parameterButtons.size();
-    
-    // std::cout << difference << " buttons needed." << std::endl;
+    int oldNumChannels = numChannels;
+    numChannels = jmax(0, numChans);
     
-    if (difference > 0)
+    if (numChannels > oldNumChannels)
     {
-        for (int n = 0; n < difference; n++)
-        {
-            addButton();
-        }
+        parameterSelection.setRange(oldNumChannels, numChannels - oldNumChannels, paramsToggled);
     }
-    else if (difference < 0)
+    else if (numChannels < oldNumChannels)
     {
-        for (int n = 0; n < -difference; n++)
-        {
-            removeButton();
-        }
+        parameterSelection.setRange(numChannels, oldNumChannels - numChannels, false);
+        recordSelection.setRange(numChannels, oldNumChannels - numChannels, false);
+        audioSelection.setRange(numChannels, oldNumChannels - numChannels, false);
     }
     
+    if (lastClickedChannel >= numChannels)
+        lastClickedChannel = -1;
+    
     //Reassign numbers according to the actual channels (useful for channel mapper)
-    for (int n = 0; n < parameterButtons.size(); n++)
+    GenericEditor* editor = (GenericEditor*) getParentComponent();
+    
+    displayNumbers.clearQuick();
+    displayNumbers.ensureStorageAllocated(numChannels);
+    
+    for (int n = 0; n < numChannels; n++)
     {
-        int num = ((GenericEditor*)getParentComponent())->getChannel(n)->nodeIndex;
-        parameterButtons[n]->setChannel(n+1, num+1);
-        if (isNotSink)
-        {
-            recordButtons[n]->setChannel(n+1, num+1);
-            audioButtons[n]->setChannel(n+1, num+1);
-        }
+        displayNumbers.add(editor->getChannel(n)->nodeIndex + 1);
     }
     
     refreshButtonBoundaries();
@@ -151,13 +159,13 @@ void ChannelSelector::setNumChannels(int numChans)
 
 int ChannelSelector::getNumChannels()
 {
-    return parameterButtons.size();
+    return numChannels;
 }
 
 void ChannelSelector::shiftChannelsVertical(float amount)
 {
     
-    if (parameterButtons.size() > 32)
+    if (numChannels > 32)
     {
         offsetUD -= amount*10;
         offsetUD = jmin(offsetUD, 0.0f);
@@ -166,52 +174,38 @@ void ChannelSelector::shiftChannelsVertical(float amount)
     
     //std::cout << "offsetUD = " << offsetUD << std::endl;
     
-    refreshButtonBoundaries();
+    channelSelectorRegion->repaint();
     
 }
 
-void ChannelSelector::refreshButtonBoundaries()
+void ChannelSelector::scrollToChannel(int chan)
 {
     
-    channelSelectorRegion->setBounds(0,20,getWidth(),getHeight()-35);
+    if (chan < 0 || chan >= numChannels)
+        return;
     
-    int rowHeight = 14;
-    int column = 0;
-    int row = 0;
-    int nColumns;
+    int top = channelSelectorRegion->getRow(chan) * ROW_HEIGHT;
+    int visibleHeight = channelSelectorRegion->getHeight();
     
-    for (int i = 0; i < parameterButtons.size(); i++)
+    if (top + offsetUD < 0 || top + ROW_HEIGHT + offsetUD > visibleHeight)
     {
-        
-        if (i < 96)
-            nColumns = numColumnsLessThan100;
-        else
-            nColumns = numColumnsGreaterThan100;
-        
-        int columnWidth = getDesiredWidth() / (nColumns + 1) + 1;
-        
-        int xLoc = columnWidth / 2 + offsetLR + columnWidth*column;
-        int yLoc = row * rowHeight + offsetUD;
-        
-        parameterButtons[i]->setBounds(xLoc, yLoc, columnWidth, rowHeight);
-        
-        if (isNotSink)
-        {
-            recordButtons[i]->setBounds(xLoc - getDesiredWidth(), yLoc, columnWidth, rowHeight);
-            audioButtons[i]->setBounds(xLoc - getDesiredWidth()*2, yLoc, columnWidth, rowHeight);
-        }
-        
-        column++;
-        
-        if (column >= nColumns)
-        {
-            column = 0;
-            row++;
-            overallHeight = row * rowHeight;
-        }
-        
+        offsetUD = (float) (visibleHeight / 2 - top);
+        offsetUD = jmin(offsetUD, 0.0f);
+        offsetUD = jmax(offsetUD, (float) -overallHeight);
     }
     
+    channelSelectorRegion->repaint();
+    
+}
+
+void ChannelSelector::refreshButtonBoundaries()
+{
+    
+    channelSelectorRegion->setBounds(0,20,getWidth(),getHeight()-35);
+    
+    overallHeight = channelSelectorRegion->getGridHeight();
+    offsetUD = jmax(offsetUD, (float) -overallHeight);
+    
     int w = getWidth()/3;
     int h = 15;
     
@@ -219,8 +213,11 @@ void ChannelSelector::refreshButtonBoundaries()
     recordButton->setBounds(w, 0, w, h);
     paramsButton->setBounds(w*2, 0, w, h);
     
-    allButton->setBounds(0, getHeight()-15, getWidth()/2, 15);
-    noneButton->setBounds(getWidth()/2, getHeight()-15, getWidth()/2, 15);
+    allButton->setBounds(0, getHeight()-15, w, 15);
+    noneButton->setBounds(w, getHeight()-15, w, 15);
+    searchBox->setBounds(w*2, getHeight()-15, getWidth() - w*2, 15);
+    
+    channelSelectorRegion->repaint();
     
 }
 
@@ -253,61 +250,38 @@ void ChannelSelector::timerCallback()
         stopTimer();
     }
     
-    refreshButtonBoundaries();
+    channelSelectorRegion->repaint();
     
 }
 
-void ChannelSelector::addButton()
+BigInteger& ChannelSelector::getSelectionReference(int type)
 {
-    
-    int size = parameterButtons.size();
-    
-    ChannelSelectorButton* b = new ChannelSelectorButton(size+1, PARAMETER, titleFont);
-    parameterButtons.add(b);
-    channelSelectorRegion->addAndMakeVisible(b);
-    
-    if (paramsToggled)
-        b->setToggleState(true, dontSendNotification);
+    if (type == AUDIO)
+        return audioSelection;
+    else if (type == RECORD)
+        return recordSelection;
     else
-        b->setToggleState(false, dontSendNotification);
-    
-    if (!paramsActive)
-        b->setActive(false);
-    
-    b->addListener(this);
-    
-    if (isNotSink)
-    {
-        ChannelSelectorButton* br = new ChannelSelectorButton(size+1, RECORD, titleFont);
-        recordButtons.add(br);
-        channelSelectorRegion->addAndMakeVisible(br);
-        br->addListener(this);
-        
-        ChannelSelectorButton* ba = new ChannelSelectorButton(size+1, AUDIO, titleFont);
-        audioButtons.add(ba);
-        channelSelectorRegion->addAndMakeVisible(ba);
-        ba->addListener(this);
-    }
+        return parameterSelection;
 }
 
-void ChannelSelector::removeButton()
+bool ChannelSelector::isTypeActive(int type)
 {
-    int size = parameterButtons.size();
-    
-    ChannelSelectorButton* b = parameterButtons.remove(size-1);
-    channelSelectorRegion->removeChildComponent(b);
-    deleteAndZero(b);
-    
-    if (isNotSink)
-    {
-        ChannelSelectorButton* br = recordButtons.remove(size-1);
-        channelSelectorRegion->removeChildComponent(br);
-        deleteAndZero(br);
-        
-        ChannelSelectorButton* ba = audioButtons.remove(size-1);
-        channelSelectorRegion->removeChildComponent(ba);
-        deleteAndZero(ba);
-    }
+    if (type == PARAMETER)
+        return paramsActive;
+    else if (type == RECORD)
+        return recActive;
+    else
+        return true;
+}
+
+int ChannelSelector::getCurrentType()
+{
+    if (desiredOffset == recordOffset)
+        return RECORD;
+    else if (desiredOffset == audioOffset)
+        return AUDIO;
+    else
+        return PARAMETER;
 }
 
 Array<int> ChannelSelector::getActiveChannels()
@@ -316,10 +290,10 @@ Array<int> ChannelSelector::getActiveChannels()
     
     if (!eventsOnly)
     {
-        for (int i = 0; i < parameterButtons.size(); i++)
+        for (int i = parameterSelection.findNextSetBit(0); i >= 0 && i < numChannels;
+             i = parameterSelection.findNextSetBit(i + 1))
         {
-            if (parameterButtons[i]->getToggleState())
-                a.add(i);
+            a.add(i);
         }
     }
     else
@@ -335,42 +309,31 @@ void ChannelSelector::setActiveChannels(Array<int> a)
     
     //std::cout << "Setting active channels!" << std::endl;
     
-    for (int i = 0; i < parameterButtons.size(); i++)
-    {
-        parameterButtons[i]->setToggleState(false, dontSendNotification);
-    }
+    parameterSelection.clear();
     
     for (int i = 0; i < a.size(); i++)
     {
-        if (a[i] < parameterButtons.size())
+        if (a[i] >= 0 && a[i] < numChannels)
         {
-            parameterButtons[a[i]]->setToggleState(true, dontSendNotification);
+            parameterSelection.setBit(a[i]);
         }
     }
+    
+    channelSelectorRegion->repaint();
 }
 
 void ChannelSelector::inactivateButtons()
 {
     
     paramsActive = false;
-    
-    for (int i = 0; i < parameterButtons.size(); i++)
-    {
-        parameterButtons[i]->setActive(false);
-        parameterButtons[i]->repaint();
-    }
+    channelSelectorRegion->repaint();
 }
 
 void ChannelSelector::activateButtons()
 {
     
     paramsActive = true;
-    
-    for (int i = 0; i < parameterButtons.size(); i++)
-    {
-        parameterButtons[i]->setActive(true);
-        parameterButtons[i]->repaint();
-    }
+    channelSelectorRegion->repaint();
     
 }
 
@@ -378,24 +341,14 @@ void ChannelSelector::inactivateRecButtons()
 {
     
     recActive = false;
-    
-    for (int i = 0; i < recordButtons.size(); i++)
-    {
-        recordButtons[i]->setActive(false);
-        recordButtons[i]->repaint();
-    }
+    channelSelectorRegion->repaint();
 }
 
 void ChannelSelector::activateRecButtons()
 {
     
     recActive = true;
-    
-    for (int i = 0; i < recordButtons.size(); i++)
-    {
-        recordButtons[i]->setActive(true);
-        recordButtons[i]->repaint();
-    }
+    channelSelectorRegion->repaint();
     
 }
 
@@ -428,31 +381,18 @@ void ChannelSelector::setRadioStatus(bool radioOn)
         
         radioStatus = radioOn;
         
-        for (int i = 0; i < parameterButtons.size(); i++)
-        {
-            if (radioOn)
-            {
-                parameterButtons[i]->setToggleState(false, dontSendNotification);
-                parameterButtons[i]->setRadioGroupId(999);
-            }
-            else
-            {
-                parameterButtons[i]->setToggleState(false, dontSendNotification);
-                parameterButtons[i]->setRadioGroupId(0);
-            }
-        }
+        parameterSelection.clear();
+        channelSelectorRegion->repaint();
         
     }
     
-    
-    
 }
 
 bool ChannelSelector::getParamStatus(int chan)
 {
     
-    if (chan >= 0 && chan < parameterButtons.size())
-        return parameterButtons[chan]->getToggleState();
+    if (chan >= 0 && chan < numChannels)
+        return parameterSelection[chan];
     else
         return false;
     
@@ -461,8 +401,8 @@ bool ChannelSelector::getParamStatus(int chan)
 bool ChannelSelector::getRecordStatus(int chan)
 {
     
-    if (chan >= 0 && chan < recordButtons.size())
-        return recordButtons[chan]->getToggleState();
+    if (isNotSink && chan >= 0 && chan < numChannels)
+        return recordSelection[chan];
     else
         return false;
     
@@ -471,8 +411,8 @@ bool ChannelSelector::getRecordStatus(int chan)
 bool ChannelSelector::getAudioStatus(int chan)
 {
     
-    if (chan >= 0 && chan < audioButtons.size())
-        return audioButtons[chan]->getToggleState();
+    if (isNotSink && chan >= 0 && chan < numChannels)
+        return audioSelection[chan];
     else
         return false;
     
@@ -481,31 +421,207 @@ bool ChannelSelector::getAudioStatus(int chan)
 void ChannelSelector::setParamStatus(int chan, bool b)
 {
     
-    if (chan >= 0 && chan < parameterButtons.size())
-        parameterButtons[chan]->setToggleState(b, sendNotification);
+    setRangeStatus(PARAMETER, chan, 1, b, true);
     
 }
 
 void ChannelSelector::setRecordStatus(int chan, bool b)
 {
     
-    if (chan >= 0 && chan < recordButtons.size())
-        recordButtons[chan]->setToggleState(b, sendNotification);
+    setRangeStatus(RECORD, chan, 1, b, true);
     
 }
 
 void ChannelSelector::setAudioStatus(int chan, bool b)
 {
     
-    if (chan >= 0 && chan < audioButtons.size())
-        audioButtons[chan]->setToggleState(b, sendNotification);
+    setRangeStatus(AUDIO, chan, 1, b, true);
     
 }
 
 void ChannelSelector::clearAudio()
 {
-    for (int chan = 0; chan < audioButtons.size(); chan++)
-        audioButtons[chan]->setToggleState(false, sendNotification);
+    setSelection(AUDIO, BigInteger(), true);
+}
+
+BigInteger ChannelSelector::getSelection(SelectionType type)
+{
+    return getSelectionReference(type);
+}
+
+void ChannelSelector::setSelection(SelectionType type, const BigInteger& selection, bool notify)
+{
+    
+    if (type != PARAMETER && !isNotSink)
+        return;
+    
+    BigInteger target(selection);
+    
+    if (target.getHighestBit() >= numChannels)
+        target.setRange(numChannels, target.getHighestBit() + 1 - numChannels, false);
+    
+    if (type == PARAMETER && radioStatus && target.countNumberOfSetBits() > 1)
+    {
+        int first = target.findNextSetBit(0);
+        target.clear();
+        target.setBit(first);
+    }
+    
+    BigInteger& current = getSelectionReference(type);
+    BigInteger changed = current ^ target;
+    
+    current = target;
+    
+    if (notify && !changed.isZero())
+    {
+        for (int i = changed.findNextSetBit(0); i >= 0; i = changed.findNextSetBit(i + 1))
+        {
+            handleChannelChange(type, i);
+        }
+        
+        refreshParameterColors();
+    }
+    
+    channelSelectorRegion->repaint();
+    
+}
+
+void ChannelSelector::setRangeStatus(SelectionType type, int firstChannel, int num, bool state, bool notify)
+{
+    
+    int first = jmax(0, firstChannel);
+    int last = jmin(numChannels, firstChannel + num);
+    
+    if (last <= first)
+        return;
+    
+    BigInteger selection = getSelectionReference(type);
+    
+    if (type == PARAMETER && radioStatus && state)
+        selection.clear();
+    
+    selection.setRange(first, last - first, state);
+    
+    setSelection(type, selection, notify);
+    
+}
+
+bool ChannelSelector::setChannelState(int type, int chan, bool state)
+{
+    
+    BigInteger& selection = getSelectionReference(type);
+    
+    if (type == PARAMETER && radioStatus && state)
+    {
+        bool wasOnlyOne = selection[chan] && selection.countNumberOfSetBits() == 1;
+        selection.clear();
+        selection.setBit(chan);
+        return !wasOnlyOne;
+    }
+    
+    if (selection[chan] == state)
+        return false;
+    
+    selection.setBit(chan, state);
+    return true;
+    
+}
+
+void ChannelSelector::handleChannelChange(int type, int chan)
+{
+    
+    GenericEditor* editor = (GenericEditor*) getParentComponent();
+    
+    if (type == AUDIO)
+    {
+        // get audio node, and inform it of the change
+        Channel* ch = editor->getChannel(chan);
+        bool status = audioSelection[chan];
+        
+        std::cout << "Requesting audio monitor for channel " << ch->nodeIndex+1 << std::endl;
+        
+        if (acquisitionIsActive) // use setParameter to change parameter safely
+        {
+            AccessClass::getProcessorGraph()->
+            getAudioNode()->setChannelStatus(ch, status);
+        }
+        else     // change parameter directly
+        {
+            ch->isMonitored = status;
+        }
+        
+    }
+    else if (type == RECORD)
+    {
+        // get record node, and inform it of the change
+        Channel* ch = editor->getChannel(chan);
+        bool status = recordSelection[chan];
+        
+        if (acquisitionIsActive) // use setParameter to change parameter safely
+        {
+            AccessClass::getProcessorGraph()->
+            getRecordNode()->
+            setChannelStatus(ch, status);
+        }
+        else     // change parameter directly
+        {
+            //std::cout << "Setting record status for channel " << chan+1 << std::endl;
+            ch->setRecordState(status);
+        }
+        
+        AccessClass::getGraphViewer()->repaint();
+        
+    }
+    else // parameter type
+    {
+        
+        editor->channelChanged(chan);
+        
+        if (radioStatus) // if radio buttons are active
+        {
+            // send a message to parent
+            editor->channelChanged(chan+1);
+        }
+    }
+    
+}
+
+void ChannelSelector::channelClicked(int type, int chan, bool shiftDown)
+{
+    
+    if (!isTypeActive(type))
+    {
+        // inactive channels don't toggle, but the editor still hears about the click
+        handleChannelChange(type, chan);
+        refreshParameterColors();
+        return;
+    }
+    
+    bool isRadio = (type == PARAMETER && radioStatus);
+    
+    if (shiftDown && !isRadio && lastClickedChannel >= 0)
+    {
+        // range selection: every channel between the two clicks takes the state of the first one
+        bool state = getSelectionReference(type)[lastClickedChannel];
+        int first = jmin(lastClickedChannel, chan);
+        int last = jmax(lastClickedChannel, chan);
+        
+        setRangeStatus((SelectionType) type, first, last - first + 1, state, true);
+    }
+    else
+    {
+        bool state = isRadio ? true : !getSelectionReference(type)[chan];
+        
+        // like a radio button, a click is reported even if nothing changed
+        setChannelState(type, chan, state);
+        handleChannelChange(type, chan);
+        refreshParameterColors();
+        
+        lastClickedChannel = chan;
+    }
+    
+    channelSelectorRegion->repaint();
+    
 }
 
 int ChannelSelector::getDesiredWidth()
@@ -513,6 +629,62 @@ int ChannelSelector::getDesiredWidth()
     return 150;
 }
 
+void ChannelSelector::textEditorReturnKeyPressed(TextEditor& editor)
+{
+    
+    String text = searchBox->getText().trim();
+    
+    if (text.isEmpty())
+        return;
+    
+    if (text.containsOnly("0123456789"))
+    {
+        // a single number: jump to that channel
+        int chan = displayNumbers.indexOf(text.getIntValue());
+        
+        if (chan >= 0)
+        {
+            scrollToChannel(chan);
+            channelSelectorRegion->setHighlightedChannel(chan);
+        }
+        
+        return;
+    }
+    
+    // a list of channels and ranges: add them to the current tab
+    int type = getCurrentType();
+    BigInteger selection = getSelectionReference(type);
+    int firstFound = -1;
+    
+    StringArray tokens;
+    tokens.addTokens(text, ",; ", "");
+    tokens.removeEmptyStrings();
+    
+    for (int t = 0; t < tokens.size(); t++)
+    {
+        int low = tokens[t].upToFirstOccurrenceOf("-", false, false).getIntValue();
+        int high = tokens[t].contains("-") ? tokens[t].fromFirstOccurrenceOf("-", false, false).getIntValue() : low;
+        
+        for (int chan = 0; chan < numChannels; chan++)
+        {
+            if (displayNumbers[chan] >= low && displayNumbers[chan] <= high)
+            {
+                selection.setBit(chan);
+                
+                if (firstFound < 0 || chan < firstFound)
+                    firstFound = chan;
+            }
+        }
+    }
+    
+    if (firstFound >= 0)
+    {
+        setSelection((SelectionType) type, selection, true);
+        scrollToChannel(firstFound);
+    }
+    
+}
+
 void ChannelSelector::buttonClicked(Button* button)
 {
     //checkChannelSelectors();
@@ -561,22 +733,11 @@ void ChannelSelector::buttonClicked(Button* button)
         // select all active buttons
         if (offsetLR == recordOffset)
         {
-            
-            
-            for (int i = 0; i < recordButtons.size(); i++)
-            {
-                recordButtons[i]->setToggleState(true, sendNotification);
-            }
-            
+            setRangeStatus(RECORD, 0, numChannels, true, true);
         }
         else if (offsetLR == parameterOffset)
         {
-            
-            
-            for (int i = 0; i < parameterButtons.size(); i++)
-            {
-                parameterButtons[i]->setToggleState(true, sendNotification);
-            }
+            setRangeStatus(PARAMETER, 0, numChannels, true, true);
         }
         else if (offsetLR == audioOffset)
         {
@@ -588,24 +749,15 @@ void ChannelSelector::buttonClicked(Button* button)
         // deselect all active buttons
         if (offsetLR == recordOffset)
         {
-            for (int i = 0; i < recordButtons.size(); i++)
-            {
-                recordButtons[i]->setToggleState(false, sendNotification);
-            }
+            setSelection(RECORD, BigInteger(), true);
         }
         else if (offsetLR == parameterOffset)
         {
-            for (int i = 0; i < parameterButtons.size(); i++)
-            {
-                parameterButtons[i]->setToggleState(false, sendNotification);
-            }
+            setSelection(PARAMETER, BigInteger(), true);
         }
         else if (offsetLR == audioOffset)
         {
-            for (int i = 0; i < audioButtons.size(); i++)
-            {
-                audioButtons[i]->setToggleState(false, sendNotification);
-            }
+            setSelection(AUDIO, BigInteger(), true);
         }
         
         if (radioStatus) // if radio buttons are active
@@ -613,77 +765,9 @@ void ChannelSelector::buttonClicked(Button* button)
             // send a message to parent
             GenericEditor* editor = (GenericEditor*) getParentComponent();
             editor->channelChanged(-1);
+            refreshParameterColors();
         }
     }
-    else
-    {
-        
-        ChannelSelectorButton* b = (ChannelSelectorButton*) button;
-        
-        if (b->getType() == AUDIO)
-        {
-            // get audio node, and inform it of the change
-            GenericEditor* editor = (GenericEditor*) getParentComponent();
-            
-            Channel* ch = editor->getChannel(b->getChannel()-1);
-            //int channelNum = editor->getStartChannel() + b->getChannel() - 1;
-            bool status = b->getToggleState();
-            
-            std::cout << "Requesting audio monitor for channel " << ch->nodeIndex+1 << std::endl;
-            
-            if (acquisitionIsActive) // use setParameter to change parameter safely
-            {
-                AccessClass::getProcessorGraph()->
-                getAudioNode()->setChannelStatus(ch, status);
-            }
-            else     // change parameter directly
-            {
-                ch->isMonitored = status;
-            }
-            
-            
-        }
-        else if (b->getType() == RECORD)
-        {
-            // get record node, and inform it of the change
-            GenericEditor* editor = (GenericEditor*) getParentComponent();
-            
-            Channel* ch = editor->getChannel(b->getChannel()-1);
-            //int channelNum = editor->getStartChannel() + b->getChannel() - 1;
-            bool status = b->getToggleState();
-            
-            if (acquisitionIsActive) // use setParameter to change parameter safely
-            {
-                AccessClass::getProcessorGraph()->
-                getRecordNode()->
-                setChannelStatus(ch, status);
-            }
-            else     // change parameter directly
-            {
-                //std::cout << "Setting record status for channel " << b->getChannel() << std::endl;
-                ch->setRecordState(status);
-            }
-            
-            AccessClass::getGraphViewer()->repaint();
-            
-        }
-        else // parameter type
-        {
-            
-            GenericEditor* editor = (GenericEditor*) getParentComponent();
-            editor->channelChanged(b->getChannel()-1);
-            
-            // do nothing
-            if (radioStatus) // if radio buttons are active
-            {
-                // send a message to parent
-                GenericEditor* editor = (GenericEditor*) getParentComponent();
-                editor->channelChanged(b->getChannel());
-            }
-        }
-        
-    }
-    refreshParameterColors();
 }
 
 
@@ -872,87 +956,121 @@ void EditorButton::paintButton(Graphics& g, bool isMouseOver, bool isButtonDown)
 }
 
 
-ChannelSelectorButton::ChannelSelectorButton(int num_, int type_, Font& f) : Button("name")
+
+ChannelSelectorRegion::ChannelSelectorRegion(ChannelSelector* cs, Font& f) :
+channelSelector(cs), hoverType(-1), hoverChannel(-1), highlightedChannel(-1), dragType(-1), dragState(false)
 {
-    isActive = true;
-    num = num_;
-    displayNum = num_;
-    type = type_;
-    
-    setClickingTogglesState(true);
-    
     buttonFont = f;
     buttonFont.setHeight(10);
 }
 
-ChannelSelectorButton::~ChannelSelectorButton() {}
+ChannelSelectorRegion::~ChannelSelectorRegion()
+{
+    deleteAllChildren();
+}
 
-int ChannelSelectorButton::getType()
+int ChannelSelectorRegion::getRow(int chan)
 {
-    return type;
+    int narrow = channelSelector->numColumnsLessThan100;
+    int wide = channelSelector->numColumnsGreaterThan100;
+    
+    if (chan < NUM_NARROW_CHANNELS)
+        return chan / narrow;
+    else
+        return NUM_NARROW_CHANNELS / narrow + (chan - NUM_NARROW_CHANNELS) / wide;
 }
 
-int ChannelSelectorButton::getChannel()
+int ChannelSelectorRegion::getFirstChannelInRow(int row)
 {
-    return num;
+    int narrowRows = NUM_NARROW_CHANNELS / channelSelector->numColumnsLessThan100;
+    
+    if (row < narrowRows)
+        return row * channelSelector->numColumnsLessThan100;
+    else
+        return NUM_NARROW_CHANNELS + (row - narrowRows) * channelSelector->numColumnsGreaterThan100;
 }
 
-void ChannelSelectorButton::setChannel(int n)
+int ChannelSelectorRegion::getNumColumnsInRow(int row)
 {
-    num = n;
-    displayNum = n;
+    if (row < NUM_NARROW_CHANNELS / channelSelector->numColumnsLessThan100)
+        return channelSelector->numColumnsLessThan100;
+    else
+        return channelSelector->numColumnsGreaterThan100;
 }
-void ChannelSelectorButton::setChannel(int n, int d)
+
+int ChannelSelectorRegion::getColumnWidth(int nColumns)
 {
-    num = n;
-    displayNum = d;
+    return channelSelector->getDesiredWidth() / (nColumns + 1) + 1;
 }
 
-void ChannelSelectorButton::paintButton(Graphics& g, bool isMouseOver, bool isButtonDown)
+int ChannelSelectorRegion::getPanelOrigin(int type)
 {
-    if (isActive)
-    {
-        if (getToggleState() == true)
-            g.setColour(Colours::orange);
-        else
-            g.setColour(Colours::darkgrey);
-        
-        if (isMouseOver)
-            g.setColour(Colours::white);
-    }
+    if (type == ChannelSelector::AUDIO)
+        return channelSelector->offsetLR - channelSelector->audioOffset;
+    else if (type == ChannelSelector::RECORD)
+        return channelSelector->offsetLR - channelSelector->recordOffset;
     else
-    {
-        if (getToggleState() == true)
-            g.setColour(Colours::yellow);
-        else
-            g.setColour(Colours::lightgrey);
-    }
-    
-    // g.fillRect(0,0,getWidth(),getHeight());
-    
-    g.setFont(buttonFont);
-    
-    // g.drawRect(0,0,getWidth(),getHeight(),1.0);
+        return channelSelector->offsetLR - channelSelector->parameterOffset;
+}
+
+int ChannelSelectorRegion::getGridHeight()
+{
+    if (channelSelector->numChannels == 0)
+        return 0;
     
-    g.drawText(String(displayNum),0,0,getWidth(),getHeight(),Justification::centred,true);
+    return (getRow(channelSelector->numChannels - 1) + 1) * ROW_HEIGHT;
 }
 
-void ChannelSelectorButton::setActive(bool t)
+Rectangle<int> ChannelSelectorRegion::getCellBounds(int type, int chan)
 {
-    isActive = t;
-    setClickingTogglesState(t);
+    int row = getRow(chan);
+    int column = chan - getFirstChannelInRow(row);
+    int columnWidth = getColumnWidth(getNumColumnsInRow(row));
+    
+    int xLoc = getPanelOrigin(type) + columnWidth / 2 + columnWidth * column;
+    int yLoc = row * ROW_HEIGHT + (int) channelSelector->offsetUD;
+    
+    return Rectangle<int>(xLoc, yLoc, columnWidth, ROW_HEIGHT);
 }
 
-ChannelSelectorRegion::ChannelSelectorRegion(ChannelSelector* cs)
+bool ChannelSelectorRegion::getCellAt(int x, int y, int& type, int& chan)
 {
-    channelSelector = cs;
+    int row = (y - (int) channelSelector->offsetUD) / ROW_HEIGHT;
+    
+    if (y < (int) channelSelector->offsetUD)
+        return false;
+    
+    const int types[3] = {ChannelSelector::PARAMETER, ChannelSelector::RECORD, ChannelSelector::AUDIO};
+    
+    for (int t = 0; t < 3; t++)
+    {
+        if (types[t] != ChannelSelector::PARAMETER && !channelSelector->isNotSink)
+            continue;
+        
+        int nColumns = getNumColumnsInRow(row);
+        int columnWidth = getColumnWidth(nColumns);
+        int left = getPanelOrigin(types[t]) + columnWidth / 2;
+        
+        if (x < left || x >= left + columnWidth * nColumns)
+            continue;
+        
+        int c = getFirstChannelInRow(row) + (x - left) / columnWidth;
+        
+        if (c < channelSelector->numChannels)
+        {
+            type = types[t];
+            chan = c;
+            return true;
+        }
+    }
     
-    addMouseListener((MouseListener*) this, true);
+    return false;
 }
 
-ChannelSelectorRegion::~ChannelSelectorRegion()
+void ChannelSelectorRegion::setHighlightedChannel(int chan)
 {
-    deleteAllChildren();
+    highlightedChannel = chan;
+    repaint();
 }
 
 void ChannelSelectorRegion::mouseWheelMove(const MouseEvent& event,
@@ -963,7 +1081,138 @@ void ChannelSelectorRegion::mouseWheelMove(const MouseEvent& event,
     channelSelector->shiftChannelsVertical(-wheel.deltaY);
 }
 
+void ChannelSelectorRegion::mouseMove(const MouseEvent& event)
+{
+    int type = -1, chan = -1;
+    
+    if (!getCellAt(event.x, event.y, type, chan))
+    {
+        type = -1;
+        chan = -1;
+    }
+    
+    if (type != hoverType || chan != hoverChannel)
+    {
+        if (hoverChannel >= 0)
+            repaint(getCellBounds(hoverType, hoverChannel));
+        
+        hoverType = type;
+        hoverChannel = chan;
+        
+        if (hoverChannel >= 0)
+            repaint(getCellBounds(hoverType, hoverChannel));
+    }
+}
+
+void ChannelSelectorRegion::mouseExit(const MouseEvent& event)
+{
+    if (hoverChannel >= 0)
+        repaint(getCellBounds(hoverType, hoverChannel));
+    
+    hoverType = -1;
+    hoverChannel = -1;
+}
+
+void ChannelSelectorRegion::mouseDown(const MouseEvent& event)
+{
+    int type, chan;
+    
+    dragType = -1;
+    highlightedChannel = -1;
+    
+    if (!getCellAt(event.x, event.y, type, chan))
+        return;
+    
+    channelSelector->channelClicked(type, chan, event.mods.isShiftDown());
+    
+    // dragging applies the state of the clicked channel to every channel it crosses
+    if (channelSelector->isTypeActive(type)
+        && !(type == ChannelSelector::PARAMETER && channelSelector->radioStatus))
+    {
+        dragType = type;
+        dragState = channelSelector->getSelectionReference(type)[chan];
+    }
+}
+
+void ChannelSelectorRegion::mouseDrag(const MouseEvent& event)
+{
+    int type, chan;
+    
+    if (dragType < 0 || !getCellAt(event.x, event.y, type, chan) || type != dragType)
+        return;
+    
+    if (channelSelector->getSelectionReference(type)[chan] != dragState)
+        channelSelector->setRangeStatus((ChannelSelector::SelectionType) type, chan, 1, dragState, true);
+}
+
 void ChannelSelectorRegion::paint(Graphics& g)
 {
-    // g.fillAll(Colours::white);
+    int numChannels = channelSelector->numChannels;
+    
+    if (numChannels == 0)
+        return;
+    
+    g.setFont(buttonFont);
+    
+    // only the rows in view are drawn
+    int top = -(int) channelSelector->offsetUD;
+    int firstRow = jmax(0, top / ROW_HEIGHT);
+    int lastRow = jmin(getRow(numChannels - 1), (top + getHeight()) / ROW_HEIGHT);
+    int panelWidth = channelSelector->getDesiredWidth();
+    
+    const int types[3] = {ChannelSelector::PARAMETER, ChannelSelector::RECORD, ChannelSelector::AUDIO};
+    
+    for (int t = 0; t < 3; t++)
+    {
+        int type = types[t];
+        
+        if (type != ChannelSelector::PARAMETER && !channelSelector->isNotSink)
+            continue;
+        
+        int origin = getPanelOrigin(type);
+        
+        if (origin <= -panelWidth || origin >= getWidth())
+            continue;
+        
+        const BigInteger& selection = channelSelector->getSelectionReference(type);
+        bool isActive = channelSelector->isTypeActive(type);
+        
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            int first = getFirstChannelInRow(row);
+            int last = jmin(first + getNumColumnsInRow(row), numChannels);
+            
+            for (int chan = first; chan < last; chan++)
+            {
+                Rectangle<int> bounds = getCellBounds(type, chan);
+                bool isOn = selection[chan];
+                
+                if (isActive)
+                {
+                    if (isOn)
+                        g.setColour(Colours::orange);
+                    else
+                        g.setColour(Colours::darkgrey);
+                    
+                    if (type == hoverType && chan == hoverChannel)
+                        g.setColour(Colours::white);
+                }
+                else
+                {
+                    if (isOn)
+                        g.setColour(Colours::yellow);
+                    else
+                        g.setColour(Colours::lightgrey);
+                }
+                
+                g.drawText(String(channelSelector->displayNumbers[chan]), bounds, Justification::centred, true);
+                
+                if (chan == highlightedChannel)
+                {
+                    g.setColour(Colours::white);
+                    g.drawRect(bounds, 1);
+                }
+            }
+        }
+    }
 }
\ No newline at end of file
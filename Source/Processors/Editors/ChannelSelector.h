@@ -32,7 +32,6 @@
 #include <stdio.h>
 
 class ChannelSelectorRegion;
-class ChannelSelectorButton;
 class EditorButton;
 
 /**
@@ -42,6 +41,12 @@ class EditorButton;
  Contains tabs for "Params", "Audio", and "Record", which allow
  channels to be selected for different purposes.
  
+ The selections are kept as one bit per channel, and only the rows
+ currently in view are drawn, so opening and refreshing an editor costs
+ the same for 16 or 1024 channels. Shift-click or drag selects a range of
+ channels; the search box jumps to a channel ("129") or selects a list of
+ channels in the current tab ("1-64, 100").
+ 
  @see GenericEditor
  
  */
@@ -49,10 +54,14 @@ class EditorButton;
 
 class PLUGIN_API ChannelSelector : public Component,
 public Button::Listener,
+public TextEditor::Listener,
 public Timer
 {
 public:
     
+    /** The three selections a channel belongs to. */
+    enum SelectionType {AUDIO, RECORD, PARAMETER};
+    
     /** constructor */
     ChannelSelector(bool createButtons, Font& titleFont);
     
@@ -62,6 +71,9 @@ public:
     /** button callback */
     void buttonClicked(Button* button);
     
+    /** search box callback */
+    void textEditorReturnKeyPressed(TextEditor& editor);
+    
     /** Return an array of selected channels. */
     Array<int> getActiveChannels();
     
@@ -95,6 +107,17 @@ public:
     /** Set whether a particular channel is selected for editing parameters. */
     void setParamStatus(int, bool);
     
+    /** Returns a whole selection at once, one bit per channel. */
+    BigInteger getSelection(SelectionType type);
+    
+    /** Replaces a whole selection at once. If notify is true, every channel whose
+     state changes is handled as if it had been clicked, but the parameter colors
+     are refreshed only once. */
+    void setSelection(SelectionType type, const BigInteger& selection, bool notify);
+    
+    /** Sets numChannels channels starting at firstChannel in one selection. */
+    void setRangeStatus(SelectionType type, int firstChannel, int numChannels, bool state, bool notify);
+    
     /** Return component's desired width. */
     int getDesiredWidth();
     
@@ -104,22 +127,22 @@ public:
     /** Called immediately after data acquisition ends.*/
     void stopAcquisition();
     
-    /** Inactivates all the ChannelSelectorButtons under the "param" tab.*/
+    /** Inactivates all the channels under the "param" tab.*/
     void inactivateButtons();
     
-    /** Activates all the ChannelSelectorButtons under the "param" tab.*/
+    /** Activates all the channels under the "param" tab.*/
     void activateButtons();
     
-    /** Inactivates all the ChannelSelectorButtons under the "rec" tab.*/
+    /** Inactivates all the channels under the "rec" tab.*/
     void inactivateRecButtons();
     
-    /** Activates all the ChannelSelectorButtons under the "rec" tab.*/
+    /** Activates all the channels under the "rec" tab.*/
     void activateRecButtons();
     
     /** Refreshes Parameter Colors on change*/
     void refreshParameterColors();
     
-    /** Controls the behavior of ChannelSelectorButtons; they can either behave
+    /** Controls the behavior of the parameter channels; they can either behave
      like radio buttons (only one selected at a time) or like toggle buttons (an
      arbitrary number can be selected at once).*/
     void setRadioStatus(bool);
@@ -130,27 +153,35 @@ public:
     /** Used to scroll channels */
     void shiftChannelsVertical(float amount);
     
+    /** Scrolls the channel grid so that a channel is in view. */
+    void scrollToChannel(int chan);
+    
     bool eventsOnly;
     
 private:
     
+    friend class ChannelSelectorRegion;
+    
     EditorButton* audioButton;
     EditorButton* recordButton;
     EditorButton* paramsButton;
     EditorButton* allButton;
     EditorButton* noneButton;
+    TextEditor* searchBox;
+    
+    /** Channels that will be updated when a parameter is changed. */
+    BigInteger parameterSelection;
+    
+    /** Channels that are sent to the audio monitor. */
+    BigInteger audioSelection;
     
-    /** An array of ChannelSelectorButtons used to select the channels that
-     will be updated when a parameter is changed. */
-    Array<ChannelSelectorButton*> parameterButtons;
+    /** Channels that will be written to disk when the record button is pressed. */
+    BigInteger recordSelection;
     
-    /** An array of ChannelSelectorButtons used to select the channels that
-     are sent to the audio monitor. */
-    Array<ChannelSelectorButton*> audioButtons;
+    /** Channel numbers shown in the grid (useful for channel mapper) */
+    Array<int> displayNumbers;
     
-    /** An array of ChannelSelectorButtons used to select the channels that
-     will be written to disk when the record button is pressed. */
-    Array<ChannelSelectorButton*> recordButtons;
+    int numChannels;
     
     bool paramsToggled;
     bool paramsActive;
@@ -176,10 +207,21 @@ private:
     
     void resized();
     
-    void addButton();
-    void removeButton();
     void refreshButtonBoundaries();
     
+    BigInteger& getSelectionReference(int type);
+    bool isTypeActive(int type);
+    int getCurrentType();
+    
+    /** Handles a click on a channel of the grid */
+    void channelClicked(int type, int chan, bool shiftDown);
+    
+    /** Sets a channel without any side effects; returns true if it changed */
+    bool setChannelState(int type, int chan, bool state);
+    
+    /** Informs the rest of the application that a channel changed */
+    void handleChannelChange(int type, int chan);
+    
     /** Controls the speed of animations. */
     void timerCallback();
     
@@ -188,10 +230,10 @@ private:
     
     Font& titleFont;
     
-    enum {AUDIO, RECORD, PARAMETER};
-    
     bool acquisitionIsActive;
     
+    int lastClickedChannel;
+    
     ChannelSelectorRegion* channelSelectorRegion;
     
 };
@@ -232,7 +274,10 @@ private:
 
 /**
  
- Holds the ChannelSelector buttons.
+ Draws the channel grid of the ChannelSelector.
+ 
+ Only the rows in view are painted, straight from the selections of the
+ ChannelSelector; no component is created per channel.
  
  @see ChannelSelector
  
@@ -242,49 +287,49 @@ class ChannelSelectorRegion : public Component
 {
     
 public:
-    ChannelSelectorRegion(ChannelSelector* cs);
+    ChannelSelectorRegion(ChannelSelector* cs, Font& f);
     ~ChannelSelectorRegion();
     
     /** Allows the user to scroll the channels if they are not all visible.*/
     void mouseWheelMove(const MouseEvent& event, const MouseWheelDetails& wheel);
+    void mouseMove(const MouseEvent& event);
+    void mouseExit(const MouseEvent& event);
+    void mouseDown(const MouseEvent& event);
+    void mouseDrag(const MouseEvent& event);
     void paint(Graphics& g);
     
-private:
-    ChannelSelector* channelSelector;
+    /** Outlines a channel, e.g. the result of a search; -1 for none */
+    void setHighlightedChannel(int chan);
     
-};
-
-/**
- 
- A button within the ChannelSelector representing an individual channel.
- 
- @see ChannelSelector
- 
- */
-
-class ChannelSelectorButton : public Button
-{
-public:
-    ChannelSelectorButton(int num, int type, Font& f);
-    ~ChannelSelectorButton();
+    /** Bounds of a channel cell for a given tab, in region coordinates */
+    Rectangle<int> getCellBounds(int type, int chan);
+    
+    /** Total height of the grid */
+    int getGridHeight();
     
-    int getType();
-    int getChannel();
-    //Channel* getChannel() {return ch;}
-    void setActive(bool t);
-    void setChannel(int n);
-    void setChannel(int n, int d);
+    /** Row of the grid holding a channel */
+    int getRow(int chan);
     
 private:
-    void paintButton(Graphics& g, bool isMouseOver, bool isButtonDown);
+    /** Finds the cell under a point; returns false if there is none */
+    bool getCellAt(int x, int y, int& type, int& chan);
     
-    //Channel* ch;
+    int getFirstChannelInRow(int row);
+    int getNumColumnsInRow(int row);
+    int getColumnWidth(int nColumns);
+    int getPanelOrigin(int type);
     
-    int type;
-    int num;
-    int displayNum;
+    ChannelSelector* channelSelector;
     Font buttonFont;
-    bool isActive;
+    
+    int hoverType;
+    int hoverChannel;
+    int highlightedChannel;
+    
+    /** Drag selection: the tab, and the state applied to every channel dragged over */
+    int dragType;
+    bool dragState;
+    
 };
 
 
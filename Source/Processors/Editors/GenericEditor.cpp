@@ -497,11 +497,16 @@ void GenericEditor::update()
 
         channelSelector->setNumChannels(numChannels);
 
+        // the channels already hold these states, so there is nothing to notify
+        BigInteger recordStates;
+
         for (int i = 0; i < numChannels; i++)
         {
             // std::cout << p->channels[i]->getRecordState() << std::endl;
-            channelSelector->setRecordStatus(i, p->channels[i]->getRecordState());
+            recordStates.setBit(i, p->channels[i]->getRecordState());
         }
+
+        channelSelector->setSelection(ChannelSelector::RECORD, recordStates, false);
     }
 
     if (numChannels == 0)
@@ -27,9 +27,21 @@
 #include "FPGAOutput.h"
 #include "../SourceNode/SourceNode.h"
 
+// width of a single pulse, in ms
+#define PULSE_WIDTH 5.0
+
+void FPGAOutputDevice::sendCommands(const OutputCommand* commands, int numCommands)
+{
+    if (sourceNode == nullptr)
+        return;
+
+    for (int i = 0; i < numCommands; i++)
+        sourceNode->actionListenerCallback(commands[i].value ? "HI" : "LO");
+}
+
 FPGAOutput::FPGAOutput()
     : GenericProcessor("FPGA Output"), TTLchannel(3),
-      isEnabled(true),  continuousStim(false)
+      isEnabled(true), pulseEndTicks(0), continuousStim(false)
 {
 
     Array<var> channelNumbers;
@@ -48,11 +60,13 @@ FPGAOutput::FPGAOutput()
 
     parameters.add(Parameter("Stim Type",stimType, 0, 1));
 
+    dispatcher = new OutputDispatcher("FPGA Output", &outputDevice);
+
 }
 
 FPGAOutput::~FPGAOutput()
 {
-
+    dispatcher = nullptr;
 }
 
 AudioProcessorEditor* FPGAOutput::createEditor()
@@ -63,6 +77,10 @@ AudioProcessorEditor* FPGAOutput::createEditor()
 
 void FPGAOutput::handleEvent(int eventType, MidiMessage& event, int sampleNum)
 {
+    // the end of the last pulse has already been scheduled
+    if (!isEnabled && !continuousStim && Time::getHighResolutionTicks() >= pulseEndTicks)
+        isEnabled = true;
+
     if (eventType == TTL && isEnabled)
     {
 
@@ -76,21 +94,23 @@ void FPGAOutput::handleEvent(int eventType, MidiMessage& event, int sampleNum)
 
         if (eventId == 1 && eventChannel == TTLchannel) // channel 3 only at the moment
         {
-            sendActionMessage("HI");
+            dispatcher->addCommand(0, 1, 0.0, getEventAcquisitionTicks(event));
             isEnabled = false;
 
             if (!continuousStim)
-                startTimer(5); // pulse width
-            // else
-            //    startTimer(25); // pulse width
+            {
+                // pulse width
+                dispatcher->addCommand(0, 0, PULSE_WIDTH);
+                pulseEndTicks = Time::getHighResolutionTicks()
+                                + Time::secondsToHighResolutionTicks(PULSE_WIDTH / 1000.0);
+            }
 
         }
         else if (eventId == 0 && eventChannel == TTLchannel)  // && eventChannel == TTLchannel)
         {
             if (continuousStim)
             {
-                /// this isn't working
-                sendActionMessage("LO");
+                dispatcher->addCommand(0, 0, 0.0, getEventAcquisitionTicks(event));
                 isEnabled = true;
                 //   stopTimer();
             }
@@ -103,7 +123,7 @@ void FPGAOutput::handleEvent(int eventType, MidiMessage& event, int sampleNum)
 
 void FPGAOutput::updateSettings()
 {
-    removeAllActionListeners();
+    outputDevice.setSourceNode(nullptr);
 
     GenericProcessor* src;
     GenericProcessor* lastSrc;
@@ -120,7 +140,7 @@ void FPGAOutput::updateSettings()
     if (lastSrc != 0)
     {
         SourceNode* s = (SourceNode*) lastSrc;
-        addActionListener(s);
+        outputDevice.setSourceNode(s);
         std::cout << "FPGA Output node communicating with " << lastSrc->getName() << std::endl;
     }
     else
@@ -132,6 +152,24 @@ void FPGAOutput::updateSettings()
     //dataThread = (FPGAThread*) s->getThread();
 }
 
+bool FPGAOutput::enable()
+{
+    isEnabled = true;
+    dispatcher->resetLatencyStats();
+    dispatcher->start();
+    return true;
+}
+
+bool FPGAOutput::disable()
+{
+    // sends any pending pulse ends before the source node stops
+    dispatcher->stop();
+
+    std::cout << "FPGA output: " << dispatcher->getLatencyReport() << std::endl;
+
+    return true;
+}
+
 void FPGAOutput::setParameter(int parameterIndex, float newValue)
 {
     editor->updateParameterButtons(parameterIndex);
@@ -162,34 +200,3 @@ void FPGAOutput::process(AudioSampleBuffer& buffer,
 
     checkForEvents(events);
 }
-
-void FPGAOutput::timerCallback()
-{
-    //dataThread->setOutputLow();
-
-    if (!continuousStim)
-    {
-        sendActionMessage("LO");
-
-        isEnabled = true;
-        stopTimer();
-
-    }
-    else
-    {
-
-        if (isEnabled)
-        {
-            sendActionMessage("HI");
-            isEnabled = false;
-        }
-        else
-        {
-            sendActionMessage("LO");
-            isEnabled = true;
-        }
-
-
-    }
-
-}
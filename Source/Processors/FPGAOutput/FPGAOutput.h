@@ -28,20 +28,45 @@
 #include "../GenericProcessor/GenericProcessor.h"
 #include "FPGAOutputEditor.h"
 #include "../DataThreads/FPGAThread.h"
+#include "../Serial/OutputDispatcher.h"
 
+class SourceNode;
+
+/**
+
+  Sets the TTL output state of the source node from the OutputDispatcher thread.
+
+*/
+
+class FPGAOutputDevice : public OutputDevice
+{
+public:
+    FPGAOutputDevice() : sourceNode(nullptr) {}
+
+    void setSourceNode(SourceNode* node)
+    {
+        sourceNode = node;
+    }
+
+    void sendCommands(const OutputCommand* commands, int numCommands);
+
+private:
+    SourceNode* sourceNode;
+};
 
 /**
 
   Allows the signal chain to send outputs to the Open Ephys acquisition board.
 
-  @see GenericProcessor, FPGAOutputEditor
+  Output changes, including the end of each pulse, are scheduled on an
+  OutputDispatcher instead of a message thread timer.
+
+  @see GenericProcessor, FPGAOutputEditor, OutputDispatcher
 
 */
 
 
-class FPGAOutput : public GenericProcessor,
-    public Timer
-    //public ActionBroadcaster
+class FPGAOutput : public GenericProcessor
 
 {
 public:
@@ -63,18 +88,25 @@ public:
 
     void updateSettings();
 
+    bool enable();
+    bool disable();
+
 private:
 
     int TTLchannel;
 
-    void timerCallback();
-
     bool isEnabled;
 
+    /** High resolution ticks at which the current pulse ends */
+    int64 pulseEndTicks;
+
     bool continuousStim;
 
     FPGAThread* dataThread;
 
+    FPGAOutputDevice outputDevice;
+    ScopedPointer<OutputDispatcher> dispatcher;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FPGAOutput);
 
 
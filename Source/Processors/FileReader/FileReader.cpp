@@ -153,6 +153,11 @@ bool FileReader::setFile (String fullpath)
     if (isExtensionSupported)
     {
         const int index = supportedExtensions[ext] - 1;
+        if (! AccessClass::getPluginManager()->ensurePluginLoaded (Plugin::FileSourcePlugin, index))
+        {
+            CoreServices::sendStatusMessage ("Could not load the file source plugin");
+            return false;
+        }
         Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo (index);
         input = sourceInfo.creator();
     }
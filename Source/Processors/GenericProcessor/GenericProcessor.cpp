@@ -550,15 +550,11 @@ int GenericProcessor::getNumSamples(int channelNum)
 void GenericProcessor::setNumSamples(MidiBuffer& events, int sampleIndex)
 {
 
-    // This amounts to adding a "buffer size" flag at a particular sample number,
-    // and a new flag is added each time "setNumSamples" is called.
-    // Thus, if the number of samples changes somewhere in the processing pipeline,
-    // the old sample number will remain. This is a problem if the number of
-    // samples gets smaller.
-    // If we allow the sample rate to change (e.g., with a resampling node),
-    // this code will have to be updated. The easiest approach will be for each
-    // processor to ignore any buffer size events that don't come from its
-    // immediate source.
+    // This amounts to adding a "buffer size" flag for this node at sample 0.
+    // Sample counts are kept per source node, so a processor that changes the
+    // sample rate (e.g., the Decimator) must make itself the source of its
+    // output channels and call this every buffer; the counts of the
+    // original source are left untouched for the other branches.
     //
 
     uint8 data[4];
@@ -597,15 +593,41 @@ int64 GenericProcessor::getTimestamp(int channelNum)
     return ts;
 }
 
+/** Used to get the acquisition time of the current buffer, for a given channel. */
+int64 GenericProcessor::getAcquisitionTicks(int channelNum)
+{
+    if (channelNum < 0 || channelNum >= channels.size())
+        return 0;
+
+    std::map<uint8, int64>::const_iterator it = acquisitionTicks.find(channels[channelNum]->sourceNodeId);
+
+    return (it != acquisitionTicks.end()) ? it->second : 0;
+}
+
+/** Used to get the acquisition time of the buffer that produced an event. */
+int64 GenericProcessor::getEventAcquisitionTicks(const MidiMessage& event)
+{
+    if (event.getRawDataSize() < 6)
+        return 0;
+
+    // the sixth byte holds the source node of the event
+    std::map<uint8, int64>::const_iterator it = acquisitionTicks.find(*(event.getRawData() + 5));
+
+    return (it != acquisitionTicks.end()) ? it->second : 0;
+}
+
 /** Used to set the timestamp for a given buffer, for a given channel. */
-void GenericProcessor::setTimestamp(MidiBuffer& events, int64 timestamp)
+void GenericProcessor::setTimestamp(MidiBuffer& events, int64 timestamp, int64 ticks)
 {
 
     //std::cout << "Setting timestamp to " << timestamp << std:;endl;
     timestampSet = true;
 
-    uint8 data[8];
+    // the acquisition time follows the timestamp, so processors that only
+    // read the first 8 bytes are unaffected
+    uint8 data[16];
     memcpy(data, &timestamp, 8);
+    memcpy(data + 8, &ticks, 8);
 
     // generate timestamp
     addEvent(events,    // MidiBuffer
@@ -613,13 +635,14 @@ void GenericProcessor::setTimestamp(MidiBuffer& events, int64 timestamp)
              0,         // sampleNum
              nodeId,    // eventID
              0,      // eventChannel
-             8,         // numBytes
+             16,        // numBytes
              data,   // data
              true    // isTimestampEvent
             );
 
     //since the processor generating the timestamp won't get the event, add it to the map
     timestamps[nodeId] = timestamp;
+    acquisitionTicks[nodeId] = ticks;
 
     if (needsToSendTimestampMessage)
     {
@@ -644,11 +667,10 @@ int GenericProcessor::processEventBuffer(MidiBuffer& events)
 {
     //
     // This loops through all events in the buffer, and uses the BUFFER_SIZE
-    // events to determine the number of samples in the current buffer. If
-    // there are multiple such events, the one with the highest number of
-    // samples will be used.
-    // This approach is not ideal, as it will become a problem if we allow
-    // the sample rate to change at different points in the signal chain.
+    // and TIMESTAMP events to update the sample count and timestamp of each
+    // source node. Channels look these up through their sourceNodeId, so
+    // streams at different sample rates can share a buffer as long as each
+    // one has its own source. The return value is the last count read.
     //
 
     int numRead = 0;
@@ -699,6 +721,13 @@ int GenericProcessor::processEventBuffer(MidiBuffer& events)
 
                 timestamps[sourceNodeId] = ts;
 
+                if (dataSize >= 22)
+                {
+                    int64 ticks;
+                    memcpy(&ticks, dataptr+14, 8);
+                    acquisitionTicks[sourceNodeId] = ticks;
+                }
+
                 //if (nodeId < 900)
                 //    std::cout << nodeId << " got " << ts << " timestamp for " << (int) sourceNodeId << std::endl;
 
@@ -767,7 +796,7 @@ void GenericProcessor::addEvent(MidiBuffer& eventBuffer,
     add the timestamp of the first input channel so the event is properly timestamped. We avoid this step for
     source modules that must always provide a timestamp, even if they don't generate it*/
     if (!isTimestamp && !timestampSet && !isSource() && !generatesTimestamps())
-        setTimestamp(eventBuffer, getTimestamp(0));
+        setTimestamp(eventBuffer, getTimestamp(0), getAcquisitionTicks(0));
 
 	HeapBlock<uint8> data(static_cast<const size_t>(6 + numBytes));
     //uint8* data = new uint8[6+numBytes];
@@ -484,11 +484,22 @@ public:
     /** Used to get the timestamp for a given buffer, for a given channel. */
     int64 getTimestamp(int channelNumber);
 
-    /** Used to set the timestamp for a given buffer, for a given source node. */
-    void setTimestamp(MidiBuffer&, int64 timestamp);
+    /** Used to set the timestamp for a given buffer, for a given source node.
+        acquisitionTicks is the high resolution time at which the buffer's data
+        was acquired, or 0 if unknown. */
+    void setTimestamp(MidiBuffer&, int64 timestamp, int64 acquisitionTicks = 0);
+
+    /** Returns the high resolution time at which the current buffer of a given
+        channel was acquired, or 0 if unknown. */
+    int64 getAcquisitionTicks(int channelNumber);
+
+    /** Returns the high resolution time at which the buffer that produced an
+        event was acquired, or 0 if unknown. Used to measure closed-loop latency. */
+    int64 getEventAcquisitionTicks(const MidiMessage& event);
 
     std::map<uint8, int> numSamples;
     std::map<uint8, int64> timestamps;
+    std::map<uint8, int64> acquisitionTicks;
 
 private:
 
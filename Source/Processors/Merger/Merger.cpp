@@ -32,7 +32,11 @@ Merger::Merger()
     : GenericProcessor("Merger"),
       mergeEventsA(true), mergeContinuousA(true),
       mergeEventsB(true), mergeContinuousB(true),
-      sourceNodeA(0), sourceNodeB(0), activePath(0)
+      synchronize(false), syncChannelA(-1), syncChannelB(-1), maxLatencyMs(50),
+      sourceNodeA(0), sourceNodeB(0), activePath(0),
+      sourceIdA(0), sourceIdB(0), numChannelsA(0), numChannelsB(0),
+      sampleRateA(0), sampleRateB(0), mixedSources(false),
+      numPendingEvents(0)
 {
     sendSampleCount = false;
 }
@@ -121,6 +125,21 @@ bool Merger::sendEventsForSource(GenericProcessor* sourceNode)
     return false;
 }
 
+bool Merger::isSynchronizing() const
+{
+    return synchronize;
+}
+
+int Merger::getFirstInputChannel(GenericProcessor* sn)
+{
+    return (sn == sourceNodeB) ? numChannelsA : 0;
+}
+
+bool Merger::generatesTimestamps()
+{
+    return synchronize;
+}
+
 bool Merger::stillHasSource()
 {
     if (sourceNodeA == 0 || sourceNodeB == 0)
@@ -222,10 +241,228 @@ void Merger::updateSettings()
         //generateDefaultChannelNames(settings.outputChannelNames);
     }
 
+    numChannelsA = (sourceNodeA != 0 && mergeContinuousA) ? sourceNodeA->channels.size() : 0;
+    numChannelsB = (sourceNodeB != 0 && mergeContinuousB) ? sourceNodeB->channels.size() : 0;
+
+    if (synchronize && numChannelsA > 0 && numChannelsB > 0)
+    {
+        // input A sets the clock, and the merged channels come from this processor
+        mixedSources = false;
+        sourceIdA = uint8(channels[0]->sourceNodeId);
+        sourceIdB = uint8(channels[numChannelsA]->sourceNodeId);
+        sampleRateA = channels[0]->sampleRate;
+        sampleRateB = channels[numChannelsA]->sampleRate;
+
+        for (int i = 0; i < channels.size(); i++)
+        {
+            if (channels[i]->sourceNodeId != ((i < numChannelsA) ? sourceIdA : sourceIdB))
+                mixedSources = true;
+
+            channels[i]->sourceNodeId = nodeId;
+            channels[i]->sampleRate = sampleRateA;
+        }
+
+        for (int i = 0; i < eventChannels.size(); i++)
+        {
+            if (eventChannels[i]->sourceNodeId == sourceIdA || eventChannels[i]->sourceNodeId == sourceIdB)
+            {
+                eventChannels[i]->sourceNodeId = nodeId;
+                eventChannels[i]->sampleRate = sampleRateA;
+            }
+        }
+
+        settings.sampleRate = sampleRateA;
+    }
+
     std::cout << "Number of merger outputs: " << getNumInputs() << std::endl;
 
 }
 
+bool Merger::isReady()
+{
+    if (!synchronize)
+        return GenericProcessor::isReady();
+
+    if (numChannelsA == 0 || numChannelsB == 0)
+    {
+        CoreServices::sendStatusMessage("Both Merger inputs need continuous channels to be synchronized.");
+        return false;
+    }
+
+    if (mixedSources)
+    {
+        CoreServices::sendStatusMessage("Each synchronized Merger input must come from a single source.");
+        return false;
+    }
+
+    if ((syncChannelA < 0) != (syncChannelB < 0))
+    {
+        CoreServices::sendStatusMessage("Choose a sync pulse for both Merger inputs, or block timestamps for both.");
+        return false;
+    }
+
+    if (!(mergeEventsA && mergeEventsB))
+    {
+        CoreServices::sendStatusMessage("A synchronizing Merger needs the events of both inputs.");
+        return false;
+    }
+
+    return GenericProcessor::isReady();
+}
+
+bool Merger::enable()
+{
+    if (synchronize)
+    {
+        const bool usePulses = (syncChannelA >= 0 && syncChannelB >= 0);
+
+        synchronizer.prepare(numChannelsA, sampleRateA, numChannelsB, sampleRateB,
+                             roundToInt(maxLatencyMs * sampleRateA / 1000.0), usePulses);
+        numPendingEvents = 0;
+
+        // sized here so that process() never allocates
+        eventData.malloc(MERGER_MAX_WRITABLE_EVENT_SIZE);
+
+        std::cout << "Merger: aligning input B (" << sampleRateB << " Hz) with input A ("
+                  << sampleRateA << " Hz) using " << (usePulses ? "TTL sync pulses" : "block timestamps")
+                  << ", " << maxLatencyMs << " ms latency" << std::endl;
+    }
+
+    return GenericProcessor::enable();
+}
+
+bool Merger::disable()
+{
+    if (synchronize)
+    {
+        std::cout << "Merger: clock ratio " << synchronizer.getDriftPpm() << " ppm from nominal, "
+                  << synchronizer.getNumPulsePairs() << " pulse pairs, "
+                  << synchronizer.getNumUnderruns() << " samples of input B arrived too late" << std::endl;
+    }
+
+    return true;
+}
+
+void Merger::process(AudioSampleBuffer& buffer, MidiBuffer& events)
+{
+    if (!synchronize)
+        return;
+
+    const int nA = numSamples[sourceIdA];
+    const int nB = numSamples[sourceIdB];
+    const int64 tsA = timestamps[sourceIdA];
+    const int64 tsB = timestamps[sourceIdB];
+
+    const float** inputs = buffer.getArrayOfReadPointers();
+
+    synchronizer.addBlocks(inputs, nA, tsA, inputs + numChannelsA, nB, tsB);
+
+    MidiBuffer::Iterator i(events);
+    const uint8* dataptr;
+    int dataSize;
+    int samplePosition;
+
+    while (i.getNextEvent(dataptr, dataSize, samplePosition))
+    {
+        if (dataSize >= 6 && *dataptr == TTL && (*(dataptr+5) == sourceIdA || *(dataptr+5) == sourceIdB))
+        {
+            const bool fromA = (*(dataptr+5) == sourceIdA);
+            addSyncPulse(dataptr, (fromA ? tsA : tsB) + samplePosition, fromA);
+        }
+    }
+
+    int64 first;
+    const int nOut = synchronizer.getAlignedBlock(buffer.getArrayOfWritePointers(),
+                                                  buffer.getNumSamples(), first);
+    const int lastPosition = jmax(0, nOut - 1);
+
+    alignedEvents.clear();
+    i.setNextSamplePosition(0);
+
+    while (i.getNextEvent(dataptr, dataSize, samplePosition))
+    {
+        const bool fromInput = dataSize >= 6 && (*(dataptr+5) == sourceIdA || *(dataptr+5) == sourceIdB);
+
+        if (fromInput && isWritableEvent(*dataptr) && dataSize <= MERGER_MAX_WRITABLE_EVENT_SIZE)
+        {
+            memcpy(eventData, dataptr, dataSize);
+            eventData[5] = nodeId;
+
+            if (*dataptr == TTL)
+            {
+                int64 index = (*(dataptr+5) == sourceIdA)
+                              ? tsA + samplePosition
+                              : synchronizer.secondaryToReference(tsB + samplePosition);
+
+                if (index < 0)
+                    index = first;
+
+                if (addPendingEvent(eventData, dataSize, index))
+                    continue;
+            }
+
+            alignedEvents.addEvent(eventData, dataSize, jmin(samplePosition, lastPosition));
+        }
+        else
+        {
+            alignedEvents.addEvent(dataptr, dataSize, jmin(samplePosition, lastPosition));
+        }
+    }
+
+    // TTL events that the output has caught up with
+    int kept = 0;
+
+    for (int n = 0; n < numPendingEvents; n++)
+    {
+        const PendingEvent& ev = pendingEvents[n];
+
+        if (ev.index < first + nOut)
+            alignedEvents.addEvent(ev.data, ev.size, int(jlimit(int64(0), int64(lastPosition), ev.index - first)));
+        else
+            pendingEvents[kept++] = ev;
+    }
+
+    numPendingEvents = kept;
+
+    events.swapWith(alignedEvents);
+
+    setNumSamples(events, nOut);
+    numSamples[nodeId] = nOut;
+
+    // the output lags the input, so its first sample was acquired before this block of input A
+    const int64 ticks = acquisitionTicks[sourceIdA]
+                        - int64(double(tsA - first) * Time::getHighResolutionTicksPerSecond() / sampleRateA);
+
+    setTimestamp(events, first, ticks);
+}
+
+void Merger::addSyncPulse(const uint8* data, int64 sampleIndex, bool fromA)
+{
+    const int syncChannel = fromA ? syncChannelA : syncChannelB;
+
+    // rising edges only
+    if (syncChannel < 0 || *(data+2) != 1 || *(data+3) != syncChannel)
+        return;
+
+    if (fromA)
+        synchronizer.addReferencePulse(sampleIndex);
+    else
+        synchronizer.addSecondaryPulse(sampleIndex);
+}
+
+bool Merger::addPendingEvent(const uint8* data, int size, int64 referenceIndex)
+{
+    if (size > MERGER_MAX_EVENT_SIZE || numPendingEvents == MERGER_MAX_PENDING_EVENTS)
+        return false;
+
+    PendingEvent& ev = pendingEvents[numPendingEvents++];
+    ev.index = referenceIndex;
+    ev.size = size;
+    memcpy(ev.data, data, size);
+
+    return true;
+}
+
 void Merger::saveCustomParametersToXml(XmlElement* parentElement)
 {
     XmlElement* mainNode = parentElement->createNewChildElement("MERGER");
@@ -243,6 +480,11 @@ void Merger::saveCustomParametersToXml(XmlElement* parentElement)
     mainNode->setAttribute("MergeContinuousA", mergeContinuousA);
     mainNode->setAttribute("MergeEventsB", mergeEventsB);
     mainNode->setAttribute("MergeContinuousB", mergeContinuousB);
+
+    mainNode->setAttribute("Synchronize", synchronize);
+    mainNode->setAttribute("SyncChannelA", syncChannelA);
+    mainNode->setAttribute("SyncChannelB", syncChannelB);
+    mainNode->setAttribute("MaxLatencyMs", maxLatencyMs);
 }
 
 
@@ -283,6 +525,11 @@ void Merger::loadCustomParametersFromXml()
                     mergeContinuousA = mainNode->getBoolAttribute("MergeContinuousA");
                     mergeContinuousB = mainNode->getBoolAttribute("MergeContinuousB");
 
+                    synchronize = mainNode->getBoolAttribute("Synchronize", false);
+                    syncChannelA = mainNode->getIntAttribute("SyncChannelA", -1);
+                    syncChannelB = mainNode->getIntAttribute("SyncChannelB", -1);
+                    maxLatencyMs = mainNode->getIntAttribute("MaxLatencyMs", 50);
+
                     updateSettings();
                 }
             }
@@ -26,9 +26,16 @@
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../GenericProcessor/GenericProcessor.h"
+#include "StreamSynchronizer.h"
 
 #include <stdio.h>
 
+// TTL events waiting for the synchronized output to reach them
+#define MERGER_MAX_PENDING_EVENTS 256
+#define MERGER_MAX_EVENT_SIZE 32
+// largest event GenericProcessor::addEvent creates: 6 header bytes and up to 255 data bytes
+#define MERGER_MAX_WRITABLE_EVENT_SIZE 261
+
 
 /**
 
@@ -38,7 +45,13 @@
   it has no incoming or outgoing connections. It just allows the outputs from
   TWO source nodes to be connected to ONE destination.
 
-  @see GenericProcessor, ProcessorGraph
+  When its inputs are synchronized, the Merger becomes part of the graph:
+  input B is aligned with, and resampled to, the clock of input A by a
+  StreamSynchronizer, and the merged channels are output with timestamps
+  of their own, at most maxLatencyMs behind input A. TTL events are delayed
+  along with the data; other events are passed on in the buffer they arrive in.
+
+  @see GenericProcessor, ProcessorGraph, StreamSynchronizer
 
 */
 
@@ -51,8 +64,8 @@ public:
 
     AudioProcessorEditor* createEditor();
 
-    /** Nothing happens here, because Mergers are not part of the ProcessorGraph. */
-    void process(AudioSampleBuffer& buffer, MidiBuffer& midiMessages) {}
+    /** Only called while synchronizing; otherwise Mergers are not part of the ProcessorGraph. */
+    void process(AudioSampleBuffer& buffer, MidiBuffer& events);
 
     bool isMerger()
     {
@@ -74,15 +87,56 @@ public:
     bool sendContinuousForSource(GenericProcessor* sn);
     bool sendEventsForSource(GenericProcessor* sn);
 
+    /** True if input B is aligned with input A, which makes the Merger a graph node. */
+    bool isSynchronizing() const;
+
+    /** Input channel of a synchronizing Merger that receives the first channel of a source. */
+    int getFirstInputChannel(GenericProcessor* sn);
+
+    bool generatesTimestamps();
+
+    bool isReady();
+    bool enable();
+    bool disable();
+
     bool mergeEventsA, mergeContinuousA, mergeEventsB, mergeContinuousB;
 
+    /** Synchronization settings; a sync channel of -1 uses block timestamps
+        instead of a shared TTL pulse. */
+    bool synchronize;
+    int syncChannelA, syncChannelB;
+    int maxLatencyMs;
+
 private:
+    struct PendingEvent
+    {
+        int64 index;
+        int size;
+        uint8 data[MERGER_MAX_EVENT_SIZE];
+    };
+
+    /** Queues a TTL event until the output reaches referenceIndex */
+    bool addPendingEvent(const uint8* data, int size, int64 referenceIndex);
+
+    /** Passes a rising edge on an input's sync channel to the synchronizer */
+    void addSyncPulse(const uint8* data, int64 sampleIndex, bool fromA);
 
     GenericProcessor* sourceNodeA;
     GenericProcessor* sourceNodeB;
 
     int activePath;
 
+    StreamSynchronizer synchronizer;
+    uint8 sourceIdA, sourceIdB;
+    int numChannelsA, numChannelsB;
+    float sampleRateA, sampleRateB;
+    bool mixedSources;
+
+    PendingEvent pendingEvents[MERGER_MAX_PENDING_EVENTS];
+    int numPendingEvents;
+    MidiBuffer alignedEvents;
+    HeapBlock<uint8> eventData;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Merger);
 
 };
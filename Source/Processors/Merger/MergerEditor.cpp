@@ -156,21 +156,50 @@ void MergerEditor::mouseDown(const MouseEvent& e)
         int eventMerge = ++i;
         int continuousMerge = ++i;
 
+        int synchronizeInputs = ++i;
+        int firstSyncChannel = ++i; // block timestamps, then TTL 1 to 8
+        i += 8;
+        int firstLatency = ++i;
+
+        const int latencies[] = {10, 20, 50, 100, 200, 500};
+        const int numLatencies = sizeof(latencies) / sizeof(latencies[0]);
+
         bool* eventPtr;
         bool* continuousPtr;
+        int* syncChannelPtr;
 
         if (pipelineSelectorA->getToggleState())
         {
             eventPtr = &merger->mergeEventsA;
             continuousPtr = &merger->mergeContinuousA;   
+            syncChannelPtr = &merger->syncChannelA;
         } else {
             eventPtr = &merger->mergeEventsB;
             continuousPtr = &merger->mergeContinuousB;  
+            syncChannelPtr = &merger->syncChannelB;
         }
         
         m.addItem(eventMerge, "Events", !acquisitionIsActive, *eventPtr);
         m.addItem(continuousMerge, "Continuous", !acquisitionIsActive, *continuousPtr);
 
+        m.addSeparator();
+        m.addItem(synchronizeInputs, "Synchronize inputs", !acquisitionIsActive, merger->synchronize);
+
+        PopupMenu syncChannelMenu;
+        syncChannelMenu.addItem(firstSyncChannel, "Block timestamps", true, *syncChannelPtr < 0);
+
+        for (int ch = 0; ch < 8; ch++)
+            syncChannelMenu.addItem(firstSyncChannel + 1 + ch, "TTL " + String(ch + 1), true, *syncChannelPtr == ch);
+
+        m.addSubMenu("Sync pulse (this input)", syncChannelMenu, !acquisitionIsActive && merger->synchronize);
+
+        PopupMenu latencyMenu;
+
+        for (int n = 0; n < numLatencies; n++)
+            latencyMenu.addItem(firstLatency + n, String(latencies[n]) + " ms", true, merger->maxLatencyMs == latencies[n]);
+
+        m.addSubMenu("Maximum latency", latencyMenu, !acquisitionIsActive && merger->synchronize);
+
         const int result = m.show();
 
         if (result > 1 && result < eventMerge)
@@ -192,6 +221,17 @@ void MergerEditor::mouseDown(const MouseEvent& e)
         } else if (result == continuousMerge)
         {
             *continuousPtr = !(*continuousPtr);
+        } else if (result >= synchronizeInputs && result < firstLatency + numLatencies)
+        {
+            if (result == synchronizeInputs)
+                merger->synchronize = !merger->synchronize;
+            else if (result < firstLatency)
+                *syncChannelPtr = result - firstSyncChannel - 1;
+            else
+                merger->maxLatencyMs = latencies[result - firstLatency];
+
+            // the Merger joins or leaves the graph, and the channels downstream change
+            AccessClass::getEditorViewport()->makeEditorVisible(this, false, true);
         }
     }
 
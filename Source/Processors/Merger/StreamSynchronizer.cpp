@@ -0,0 +1,529 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "StreamSynchronizer.h"
+
+// observations from block arrivals are taken this often, in seconds
+#define BLOCK_OBSERVATION_INTERVAL 0.2
+
+// a pulse is paired with the one predicted within this many seconds
+#define PULSE_TOLERANCE 0.25
+
+// the fitted rate may differ from the nominal one by this fraction at most
+#define MAX_DRIFT 0.005
+
+namespace
+{
+void writeRing(float* ring, int capacity, int64 position, const float* data, int numSamples)
+{
+    const int start = int(position & (capacity - 1));
+    const int first = jmin(numSamples, capacity - start);
+
+    if (data != nullptr)
+    {
+        FloatVectorOperations::copy(ring + start, data, first);
+        FloatVectorOperations::copy(ring, data + first, numSamples - first);
+    }
+    else
+    {
+        FloatVectorOperations::clear(ring + start, first);
+        FloatVectorOperations::clear(ring, numSamples - first);
+    }
+}
+
+void readRing(const float* ring, int capacity, int64 position, float* data, int numSamples)
+{
+    const int start = int(position & (capacity - 1));
+    const int first = jmin(numSamples, capacity - start);
+
+    FloatVectorOperations::copy(data, ring + start, first);
+    FloatVectorOperations::copy(data + first, ring, numSamples - first);
+}
+}
+
+void StreamSynchronizer::ObservationRing::clear()
+{
+    next = 0;
+    count = 0;
+}
+
+void StreamSynchronizer::ObservationRing::add(double secondary, double reference)
+{
+    entries[next].secondary = secondary;
+    entries[next].reference = reference;
+    next = (next + 1) % SYNC_MAX_OBSERVATIONS;
+    count = jmin(count + 1, SYNC_MAX_OBSERVATIONS);
+}
+
+StreamSynchronizer::StreamSynchronizer()
+    : numReferenceChannels(0), numSecondaryChannels(0), referenceRate(0), secondaryRate(0),
+      latency(1), usePulses(false), referenceCapacity(0), secondaryCapacity(0),
+      resamplerLatency(0), nominalRatio(1.0)
+{
+    reset();
+}
+
+StreamSynchronizer::~StreamSynchronizer()
+{
+}
+
+void StreamSynchronizer::prepare(int numReferenceChannels_, double referenceRate_,
+                                 int numSecondaryChannels_, double secondaryRate_,
+                                 int latencySamples, bool usePulses_)
+{
+    numReferenceChannels = numReferenceChannels_;
+    numSecondaryChannels = numSecondaryChannels_;
+    referenceRate = referenceRate_;
+    secondaryRate = secondaryRate_;
+    latency = jmax(1, latencySamples);
+    usePulses = usePulses_;
+
+    nominalRatio = referenceRate / secondaryRate;
+
+    referenceCapacity = nextPowerOfTwo(latency + 2 * SYNC_MAX_BLOCK);
+    referenceRing.calloc(size_t(jmax(1, numReferenceChannels)) * referenceCapacity);
+
+    resampler.prepare(jmax(1, numSecondaryChannels), secondaryRate, referenceRate);
+    resamplerLatency = resampler.getLatency();
+
+    const int maxResampled = resampler.getMaxOutputSamples(SYNC_MAX_BLOCK);
+
+    resampled.calloc(size_t(jmax(1, numSecondaryChannels)) * maxResampled);
+    resampledPointers.malloc(jmax(1, numSecondaryChannels));
+    inputPointers.malloc(jmax(1, numSecondaryChannels));
+
+    for (int c = 0; c < jmax(1, numSecondaryChannels); c++)
+        resampledPointers[c] = resampled + size_t(c) * maxResampled;
+
+    secondaryCapacity = nextPowerOfTwo(latency + 2 * maxResampled);
+    secondaryRing.calloc(size_t(jmax(1, numSecondaryChannels)) * secondaryCapacity);
+
+    readIndex.malloc(SYNC_MAX_BLOCK);
+    readFraction.malloc(SYNC_MAX_BLOCK);
+
+    reset();
+}
+
+void StreamSynchronizer::reset()
+{
+    referenceEnd = 0;
+    referenceStarted = false;
+    nextOutput = 0;
+
+    resampler.reset();
+    resampledEnd = 0;
+    secondaryStart = 0;
+    secondaryEnd = 0;
+    secondaryStarted = false;
+
+    ratio = nominalRatio;
+    offset = 0.0;
+    modelValid = false;
+
+    blockObservations.clear();
+    pulsePairs.clear();
+    lastObservationReference = -1.0;
+
+    numReferencePulses = 0;
+    numSecondaryPulses = 0;
+
+    numUnderruns = 0;
+}
+
+void StreamSynchronizer::addReference(const float* const* data, int numSamples, int64 timestamp)
+{
+    if (numSamples <= 0)
+        return;
+
+    if (! referenceStarted || timestamp < referenceEnd || timestamp - referenceEnd > referenceCapacity)
+    {
+        // the reference clock started again, so the model no longer applies
+        if (referenceStarted)
+        {
+            modelValid = false;
+            blockObservations.clear();
+            pulsePairs.clear();
+            lastObservationReference = -1.0;
+        }
+
+        referenceEnd = timestamp;
+        nextOutput = timestamp;
+        referenceStarted = true;
+    }
+    else if (timestamp > referenceEnd)
+    {
+        // dropped samples become silence
+        for (int c = 0; c < numReferenceChannels; c++)
+            writeRing(referenceRing + size_t(c) * referenceCapacity, referenceCapacity,
+                      referenceEnd, nullptr, int(timestamp - referenceEnd));
+
+        referenceEnd = timestamp;
+    }
+
+    // only the newest part of a block longer than the ring is kept
+    const int skip = jmax(0, numSamples - referenceCapacity);
+
+    for (int c = 0; c < numReferenceChannels; c++)
+        writeRing(referenceRing + size_t(c) * referenceCapacity, referenceCapacity,
+                  referenceEnd + skip, data[c] + skip, numSamples - skip);
+
+    referenceEnd += numSamples;
+}
+
+void StreamSynchronizer::addSecondary(const float* const* data, int numSamples, int64 timestamp)
+{
+    if (numSamples <= 0 || numSecondaryChannels == 0)
+        return;
+
+    if (! secondaryStarted || timestamp != secondaryEnd)
+    {
+        // a gap doesn't change the clocks, only going back does
+        if (secondaryStarted && timestamp < secondaryEnd)
+        {
+            modelValid = false;
+            blockObservations.clear();
+            pulsePairs.clear();
+            lastObservationReference = -1.0;
+        }
+
+        resampler.reset();
+        secondaryStart = timestamp;
+        secondaryEnd = timestamp;
+        resampledEnd = 0;
+        secondaryStarted = true;
+    }
+
+    const float** chunk = inputPointers;
+
+    for (int done = 0; done < numSamples; done += SYNC_MAX_BLOCK)
+    {
+        const int n = jmin(SYNC_MAX_BLOCK, numSamples - done);
+
+        for (int c = 0; c < numSecondaryChannels; c++)
+            chunk[c] = data[c] + done;
+
+        const int numOut = resampler.process(chunk, n, resampledPointers);
+
+        for (int c = 0; c < numSecondaryChannels; c++)
+            writeRing(secondaryRing + size_t(c) * secondaryCapacity, secondaryCapacity,
+                      resampledEnd, resampledPointers[c], numOut);
+
+        resampledEnd += numOut;
+    }
+
+    secondaryEnd += numSamples;
+}
+
+void StreamSynchronizer::addBlocks(const float* const* reference, int numReferenceSamples, int64 referenceTimestamp,
+                                   const float* const* secondary, int numSecondarySamples, int64 secondaryTimestamp)
+{
+    addReference(reference, numReferenceSamples, referenceTimestamp);
+    addSecondary(secondary, numSecondarySamples, secondaryTimestamp);
+
+    if (numReferenceSamples > 0 && numSecondarySamples > 0)
+    {
+        const double end = double(referenceEnd);
+
+        if (lastObservationReference < 0.0
+            || end - lastObservationReference >= BLOCK_OBSERVATION_INTERVAL * referenceRate)
+        {
+            blockObservations.add(double(secondaryEnd), end);
+            lastObservationReference = end;
+            updateModel();
+        }
+    }
+}
+
+void StreamSynchronizer::addReferencePulse(int64 sampleIndex)
+{
+    if (! usePulses)
+        return;
+
+    if (numReferencePulses == SYNC_MAX_PULSES)
+    {
+        memmove(referencePulses, referencePulses + 1, (SYNC_MAX_PULSES - 1) * sizeof(int64));
+        numReferencePulses--;
+    }
+
+    referencePulses[numReferencePulses++] = sampleIndex;
+
+    matchPulses();
+}
+
+void StreamSynchronizer::addSecondaryPulse(int64 sampleIndex)
+{
+    if (! usePulses)
+        return;
+
+    if (numSecondaryPulses == SYNC_MAX_PULSES)
+    {
+        memmove(secondaryPulses, secondaryPulses + 1, (SYNC_MAX_PULSES - 1) * sizeof(int64));
+        numSecondaryPulses--;
+    }
+
+    secondaryPulses[numSecondaryPulses++] = sampleIndex;
+
+    matchPulses();
+}
+
+void StreamSynchronizer::matchPulses()
+{
+    // the current model, from block arrivals at first, predicts where each pulse should be
+    if (! modelValid)
+        return;
+
+    const double tolerance = PULSE_TOLERANCE * referenceRate;
+    bool paired = false;
+    int s = 0;
+
+    while (s < numSecondaryPulses)
+    {
+        const double predicted = offset + ratio * double(secondaryPulses[s]);
+
+        int best = -1;
+        double bestDistance = tolerance;
+
+        for (int r = 0; r < numReferencePulses; r++)
+        {
+            double distance = std::abs(double(referencePulses[r]) - predicted);
+
+            if (distance < bestDistance)
+            {
+                best = r;
+                bestDistance = distance;
+            }
+        }
+
+        if (best >= 0)
+        {
+            pulsePairs.add(double(secondaryPulses[s]), double(referencePulses[best]));
+            paired = true;
+
+            // earlier reference pulses can't be paired any more
+            numReferencePulses -= best + 1;
+            memmove(referencePulses, referencePulses + best + 1, numReferencePulses * sizeof(int64));
+
+            numSecondaryPulses--;
+            memmove(secondaryPulses + s, secondaryPulses + s + 1, (numSecondaryPulses - s) * sizeof(int64));
+        }
+        else if (predicted + tolerance < double(referenceEnd))
+        {
+            // its partner should have arrived by now
+            numSecondaryPulses--;
+            memmove(secondaryPulses + s, secondaryPulses + s + 1, (numSecondaryPulses - s) * sizeof(int64));
+        }
+        else
+        {
+            s++;
+        }
+    }
+
+    // reference pulses that no secondary pulse still to come can match
+    const double secondaryHorizon = offset + ratio * double(secondaryEnd) - tolerance;
+    int stale = 0;
+
+    while (stale < numReferencePulses && double(referencePulses[stale]) < secondaryHorizon)
+        stale++;
+
+    if (stale > 0)
+    {
+        numReferencePulses -= stale;
+        memmove(referencePulses, referencePulses + stale, numReferencePulses * sizeof(int64));
+    }
+
+    if (paired)
+        updateModel();
+}
+
+void StreamSynchronizer::updateModel()
+{
+    if (pulsePairs.count == 1)
+    {
+        // one pair only fixes the offset; the rate still comes from the block arrivals
+        double blockOffset;
+        fitLine(blockObservations, nominalRatio, ratio, blockOffset);
+
+        const Observation& pair = pulsePairs.entries[0];
+        offset = pair.reference - ratio * pair.secondary;
+        modelValid = true;
+    }
+    else if (fitLine(pulsePairs.count > 1 ? pulsePairs : blockObservations, nominalRatio, ratio, offset))
+    {
+        modelValid = true;
+    }
+}
+
+bool StreamSynchronizer::fitLine(const ObservationRing& observations, double nominal,
+                                 double& ratio, double& offset)
+{
+    const int n = observations.count;
+
+    if (n == 0)
+        return false;
+
+    double meanSecondary = 0.0, meanReference = 0.0;
+
+    for (int i = 0; i < n; i++)
+    {
+        meanSecondary += observations.entries[i].secondary;
+        meanReference += observations.entries[i].reference;
+    }
+
+    meanSecondary /= n;
+    meanReference /= n;
+
+    // centred sums keep the precision of sample numbers in the billions
+    double sxx = 0.0, sxy = 0.0;
+
+    for (int i = 0; i < n; i++)
+    {
+        double ds = observations.entries[i].secondary - meanSecondary;
+        sxx += ds * ds;
+        sxy += ds * (observations.entries[i].reference - meanReference);
+    }
+
+    double slope = (n > 1 && sxx > 0.0) ? sxy / sxx : nominal;
+
+    ratio = jlimit(nominal * (1.0 - MAX_DRIFT), nominal * (1.0 + MAX_DRIFT), slope);
+    offset = meanReference - ratio * meanSecondary;
+
+    return true;
+}
+
+int StreamSynchronizer::getAlignedBlock(float* const* outputs, int maxSamples, int64& firstIndex)
+{
+    firstIndex = nextOutput;
+
+    if (! referenceStarted)
+        return 0;
+
+    // anything older than the ring is gone
+    if (referenceEnd - nextOutput > referenceCapacity)
+        nextOutput = referenceEnd - latency;
+
+    const int64 available = referenceEnd - latency - nextOutput;
+    const int numSamples = int(jmin(available, int64(jmin(maxSamples, SYNC_MAX_BLOCK))));
+
+    firstIndex = nextOutput;
+
+    if (numSamples <= 0)
+        return 0;
+
+    for (int c = 0; c < numReferenceChannels; c++)
+        readRing(referenceRing + size_t(c) * referenceCapacity, referenceCapacity,
+                 nextOutput, outputs[c], numSamples);
+
+    if (numSecondaryChannels > 0)
+    {
+        // where each output sample falls in the resampled secondary stream
+        const double resampledPerSecondary = double(resampler.getUpFactor()) / double(resampler.getDownFactor());
+        const int64 oldest = jmax(int64(0), resampledEnd - secondaryCapacity);
+        const int mask = secondaryCapacity - 1;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            readIndex[i] = -1;
+
+            if (! modelValid || ! secondaryStarted)
+                continue;
+
+            double secondary = (double(nextOutput + i) - offset) / ratio;
+            double position = (secondary - double(secondaryStart) + resamplerLatency) * resampledPerSecondary;
+            int64 whole = int64(std::floor(position));
+
+            if (whole - 1 < oldest || whole + 2 >= resampledEnd)
+            {
+                numUnderruns++;
+                continue;
+            }
+
+            readIndex[i] = int(whole & mask);
+            readFraction[i] = float(position - double(whole));
+        }
+
+        for (int c = 0; c < numSecondaryChannels; c++)
+        {
+            const float* ring = secondaryRing + size_t(c) * secondaryCapacity;
+            float* out = outputs[numReferenceChannels + c];
+
+            for (int i = 0; i < numSamples; i++)
+            {
+                const int k = readIndex[i];
+
+                if (k < 0)
+                {
+                    out[i] = 0.0f;
+                    continue;
+                }
+
+                // Catmull-Rom spline through the four nearest samples
+                const float y0 = ring[(k - 1) & mask];
+                const float y1 = ring[k];
+                const float y2 = ring[(k + 1) & mask];
+                const float y3 = ring[(k + 2) & mask];
+                const float t = readFraction[i];
+
+                out[i] = y1 + 0.5f * t * ((y2 - y0)
+                                          + t * ((2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3)
+                                                 + t * (3.0f * (y1 - y2) + y3 - y0)));
+            }
+        }
+    }
+
+    nextOutput += numSamples;
+
+    return numSamples;
+}
+
+int64 StreamSynchronizer::secondaryToReference(int64 secondaryIndex) const
+{
+    if (! modelValid)
+        return -1;
+
+    return int64(std::floor(offset + ratio * double(secondaryIndex) + 0.5));
+}
+
+int64 StreamSynchronizer::getNextOutputIndex() const
+{
+    return nextOutput;
+}
+
+bool StreamSynchronizer::hasClockModel() const
+{
+    return modelValid;
+}
+
+double StreamSynchronizer::getDriftPpm() const
+{
+    return (ratio / nominalRatio - 1.0) * 1.0e6;
+}
+
+int StreamSynchronizer::getNumPulsePairs() const
+{
+    return pulsePairs.count;
+}
+
+int64 StreamSynchronizer::getNumUnderruns() const
+{
+    return numUnderruns;
+}
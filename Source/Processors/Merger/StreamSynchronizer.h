@@ -0,0 +1,195 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __STREAMSYNCHRONIZER_H_5B2E9C41__
+#define __STREAMSYNCHRONIZER_H_5B2E9C41__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../AudioNode/PolyphaseResampler.h"
+
+// largest block accepted from either stream in one call
+#define SYNC_MAX_BLOCK 8192
+#define SYNC_MAX_OBSERVATIONS 128
+#define SYNC_MAX_PULSES 64
+
+/**
+
+  Aligns a secondary stream with a reference stream that runs on another clock.
+
+  Both streams are kept in rings indexed by their own sample numbers (the
+  timestamps of their sources). A linear clock model maps secondary sample
+  numbers to reference sample numbers, and is fitted by least squares to one
+  of two kinds of observations:
+
+  - pairs of rising edges of a sync pulse that both devices record on a TTL
+    input; pulses must be at least half a second apart, so that each edge
+    can be paired with the one predicted by the current model.
+  - the ends of the blocks that arrive in the same callback. These only
+    bound the offset to about a block, but need no wiring.
+
+  Pulse pairs are used as soon as there are two of them.
+
+  The output runs on the reference clock, a fixed number of samples behind
+  the newest reference sample. For each output sample the secondary stream
+  is brought to the reference rate by a PolyphaseResampler (when the nominal
+  rates differ) and read at the position given by the clock model with cubic
+  interpolation, which absorbs the drift. Secondary samples that haven't
+  arrived within the latency are output as zeros and counted as underruns.
+
+  All methods but prepare() are meant for the audio thread and don't allocate.
+
+  @see Merger, PolyphaseResampler
+
+*/
+
+class StreamSynchronizer
+{
+public:
+    StreamSynchronizer();
+    ~StreamSynchronizer();
+
+    /** Allocates the rings and designs the resampler. The output lags the
+        newest reference sample by latencySamples. If usePulses is false the
+        clock model only uses block arrival times. */
+    void prepare(int numReferenceChannels, double referenceRate,
+                 int numSecondaryChannels, double secondaryRate,
+                 int latencySamples, bool usePulses);
+
+    /** Forgets all data and the clock model. */
+    void reset();
+
+    /** A rising edge of the sync pulse, in sample numbers of each stream. */
+    void addReferencePulse(int64 sampleIndex);
+    void addSecondaryPulse(int64 sampleIndex);
+
+    /** Adds the blocks both streams delivered in one callback. A block whose
+        timestamp doesn't follow the previous one restarts that stream. */
+    void addBlocks(const float* const* reference, int numReferenceSamples, int64 referenceTimestamp,
+                   const float* const* secondary, int numSecondarySamples, int64 secondaryTimestamp);
+
+    /** Writes the next aligned samples, reference channels first; returns their
+        number and sets firstIndex to the reference sample number of the first. */
+    int getAlignedBlock(float* const* outputs, int maxSamples, int64& firstIndex);
+
+    /** Reference sample number of a secondary sample, or -1 without a clock model. */
+    int64 secondaryToReference(int64 secondaryIndex) const;
+
+    /** Reference sample number of the next sample getAlignedBlock will write. */
+    int64 getNextOutputIndex() const;
+
+    bool hasClockModel() const;
+
+    /** Difference between the fitted and the nominal rate ratio, in parts per million */
+    double getDriftPpm() const;
+
+    int getNumPulsePairs() const;
+
+    /** Output samples whose secondary data arrived too late */
+    int64 getNumUnderruns() const;
+
+private:
+    struct Observation
+    {
+        double secondary;
+        double reference;
+    };
+
+    /** Up to SYNC_MAX_OBSERVATIONS recent observations */
+    struct ObservationRing
+    {
+        Observation entries[SYNC_MAX_OBSERVATIONS];
+        int next;
+        int count;
+
+        void clear();
+        void add(double secondary, double reference);
+    };
+
+    void addReference(const float* const* data, int numSamples, int64 timestamp);
+    void addSecondary(const float* const* data, int numSamples, int64 timestamp);
+
+    /** Pairs the pending pulses of the two streams */
+    void matchPulses();
+
+    /** Fits the clock model to the pulse pairs, or to the block observations
+        while there are fewer than two pairs */
+    void updateModel();
+
+    /** Least-squares line through the observations; the slope stays close to
+        nominal, and a single observation only sets the offset */
+    static bool fitLine(const ObservationRing& observations, double nominal,
+                        double& ratio, double& offset);
+
+    int numReferenceChannels;
+    int numSecondaryChannels;
+    double referenceRate;
+    double secondaryRate;
+    int latency;
+    bool usePulses;
+
+    /** Reference samples by sample number; referenceEnd follows the newest */
+    HeapBlock<float> referenceRing;
+    int referenceCapacity;
+    int64 referenceEnd;
+    bool referenceStarted;
+    int64 nextOutput;
+
+    /** The secondary stream at the reference rate. Resampled sample j holds
+        the secondary stream at secondaryStart + j * downFactor / upFactor - resamplerLatency. */
+    PolyphaseResampler resampler;
+    HeapBlock<const float*> inputPointers;
+    HeapBlock<float> resampled;
+    HeapBlock<float*> resampledPointers;
+    HeapBlock<float> secondaryRing;
+    int secondaryCapacity;
+    int64 resampledEnd;
+    int64 secondaryStart;
+    int64 secondaryEnd;
+    bool secondaryStarted;
+    double resamplerLatency;
+
+    /** Clock model: reference = offset + ratio * secondary */
+    double nominalRatio;
+    double ratio;
+    double offset;
+    bool modelValid;
+
+    ObservationRing blockObservations;
+    ObservationRing pulsePairs;
+    double lastObservationReference;
+
+    int64 referencePulses[SYNC_MAX_PULSES];
+    int64 secondaryPulses[SYNC_MAX_PULSES];
+    int numReferencePulses;
+    int numSecondaryPulses;
+
+    /** Read positions of one output block */
+    HeapBlock<int> readIndex;
+    HeapBlock<float> readFraction;
+
+    int64 numUnderruns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StreamSynchronizer);
+};
+
+#endif  // __STREAMSYNCHRONIZER_H_5B2E9C41__
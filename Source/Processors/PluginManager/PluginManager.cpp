@@ -50,6 +50,41 @@ static const char* dlerror(void)
 #define ERROR_MSG(fmt,args...) do{fprintf(stderr,"%s:%d:",__FILE__,__LINE__); fprintf(stderr,fmt,## args);} while(0)
 #endif
 
+#define MANIFEST_FILE_NAME "pluginManifest.xml"
+
+namespace
+{
+	/** Loads one plugin library on a worker thread during startup */
+	class LibraryLoadJob : public ThreadPoolJob
+	{
+	public:
+		LibraryLoadJob(const String& p, bool (*f)(const String&, LibraryHandle&, Plugin::LibraryInfo&, PluginInfoFunction&))
+			: ThreadPoolJob("Plugin loader"), path(p), openFunction(f), handle(0), piFunction(0), loaded(false)
+		{
+		}
+
+		JobStatus runJob()
+		{
+			loaded = openFunction(path, handle, libInfo, piFunction);
+			return jobHasFinished;
+		}
+
+		String path;
+		bool (*openFunction)(const String&, LibraryHandle&, Plugin::LibraryInfo&, PluginInfoFunction&);
+		LibraryHandle handle;
+		Plugin::LibraryInfo libInfo;
+		PluginInfoFunction piFunction;
+		bool loaded;
+	};
+
+	bool manifestEntryIsValid(const XmlElement* libXml, const File& file)
+	{
+		return libXml != nullptr
+			&& libXml->getStringAttribute("modified").getLargeIntValue() == file.getLastModificationTime().toMilliseconds()
+			&& libXml->getStringAttribute("size").getLargeIntValue() == file.getSize();
+	}
+}
+
 PluginManager::PluginManager()
 {
 }
@@ -62,6 +97,7 @@ PluginManager::~PluginManager()
 void PluginManager::loadAllPlugins()
 {
 	Array<File> foundDLLs;
+	double startTime = Time::getMillisecondCounterHiRes();
 
 #ifdef WIN32
 	File pluginPath = File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getChildFile("plugins");
@@ -79,20 +115,94 @@ void PluginManager::loadAllPlugins()
 	}
 	
 	pluginPath.findChildFiles(foundDLLs, File::findFiles, true, pluginExt);
+	double scanTime = Time::getMillisecondCounterHiRes();
+
+	// Libraries whose path, modification time, size and API version match the manifest
+	// are listed without loading them. The rest are loaded in parallel.
+	ScopedPointer<XmlElement> manifest = XmlDocument::parse(getManifestFile());
+	HashMap<String, XmlElement*> cachedLibs;
+	if (manifest != nullptr && manifest->hasTagName("PLUGINMANIFEST") && manifest->getIntAttribute("apiVersion") == PLUGIN_API_VER)
+	{
+		forEachXmlChildElementWithTagName(*manifest, libXml, "LIBRARY")
+			cachedLibs.set(libXml->getStringAttribute("path"), libXml);
+	}
 
+	OwnedArray<LibraryLoadJob> jobs;
+	Array<LibraryLoadJob*> jobForDLL;
+	int numValidEntries = 0;
+	for (int i = 0; i < foundDLLs.size(); i++)
+	{
+		String path = foundDLLs[i].getFullPathName();
+		XmlElement* libXml = cachedLibs.contains(path) ? cachedLibs[path] : nullptr;
+		bool isValid = manifestEntryIsValid(libXml, foundDLLs[i]);
+		if (isValid)
+			numValidEntries++;
+
+		// record engines are instantiated by the control panel at startup, so there's no point deferring them
+		if (isValid && libXml->getChildByAttribute("type", String(Plugin::RecordEnginePlugin)) == nullptr)
+		{
+			jobForDLL.add(nullptr);
+		}
+		else
+		{
+			LibraryLoadJob* job = new LibraryLoadJob(path, &PluginManager::openLibrary);
+			jobs.add(job);
+			jobForDLL.add(job);
+		}
+	}
+	double manifestTime = Time::getMillisecondCounterHiRes();
+
+	if (jobs.size() > 0)
+	{
+		ThreadPool pool(jmin(jobs.size(), SystemStats::getNumCpus()));
+		for (int i = 0; i < jobs.size(); i++)
+			pool.addJob(jobs[i], false);
+		for (int i = 0; i < jobs.size(); i++)
+			pool.waitForJobToFinish(jobs[i], -1);
+	}
+	double loadTime = Time::getMillisecondCounterHiRes();
+
+	// plugins are registered in directory order so that their indices don't depend on the manifest
+	int numCached = 0;
 	for (int i = 0; i < foundDLLs.size(); i++)
 	{
 		std::cout << "Loading Plugin: " << foundDLLs[i].getFileNameWithoutExtension() << "... " << std::flush;
-		int res = loadPlugin(foundDLLs[i].getFullPathName());
+		int res;
+		if (jobForDLL[i] == nullptr)
+		{
+			res = registerCachedLibrary(foundDLLs[i], cachedLibs[foundDLLs[i].getFullPathName()]);
+			numCached++;
+		}
+		else if (jobForDLL[i]->loaded)
+		{
+			res = registerLibrary(foundDLLs[i], jobForDLL[i]->handle, jobForDLL[i]->libInfo, jobForDLL[i]->piFunction);
+		}
+		else
+		{
+			res = -1;
+		}
+
 		if (res < 0)
 		{
 			std::cout << " DLL Load FAILED" << std::endl;
 		}
 		else
 		{
-			std::cout << "Loaded with " << res << " plugins" << std::endl;
+			std::cout << (jobForDLL[i] == nullptr ? "Listed from manifest with " : "Loaded with ") << res << " plugins" << std::endl;
 		}
 	}
+
+	if (numValidEntries != foundDLLs.size() || numValidEntries != cachedLibs.size())
+	{
+		ScopedPointer<XmlElement> newManifest = createManifest();
+		if (!newManifest->writeToFile(getManifestFile(), String::empty))
+			std::cout << "Could not write the plugin manifest" << std::endl;
+	}
+	double endTime = Time::getMillisecondCounterHiRes();
+
+	std::cout << "Plugin startup: scan " << scanTime - startTime << " ms, manifest " << manifestTime - scanTime
+		<< " ms, loading " << jobs.size() << " libraries " << loadTime - manifestTime << " ms, registering "
+		<< endTime - loadTime << " ms (" << numCached << " deferred), total " << endTime - startTime << " ms" << std::endl;
 }
 
 /*
@@ -104,6 +214,23 @@ void PluginManager::loadAllPlugins()
  */
 
 int PluginManager::loadPlugin(const String& pluginLoc) {
+	LibraryHandle handle;
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction;
+
+	if (!openLibrary(pluginLoc, handle, libInfo, piFunction))
+		return -1;
+
+	return registerLibrary(File(pluginLoc), handle, libInfo, piFunction);
+}
+
+/*
+	 Opens a library and checks its interface. Doesn't touch the
+	 manager, so it can be called from the loader threads.
+ */
+
+bool PluginManager::openLibrary(const String& pluginLoc, LibraryHandle& handle, Plugin::LibraryInfo& libInfo, PluginInfoFunction& piFunction)
+{
 	/*
 	Load in the selected processor. This takes the
 	dynamic object (.so) and copies it into RAM
@@ -122,17 +249,14 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	processor stability and to ensure that it doesn't crash due
 	to memory mishaps.
 	*/
-	void *handle = 0;
 	handle = dlopen(processorLocCString,RTLD_GLOBAL|RTLD_NOW);
 #else
-	HINSTANCE handle;
 	handle = LoadLibrary(processorLocCString);
 #endif
 
 	if (!handle) {
 		ERROR_MSG("%s\n", dlerror());
-		dlclose(handle);
-		return -1;
+		return false;
 	}
 	dlerror();
 
@@ -147,21 +271,20 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	{
 		ERROR_MSG("%s\n", dlerror());
 		dlclose(handle);
-		return -1;
+		return false;
 	}
 	dlerror();
 
-	Plugin::LibraryInfo libInfo;
 	infoFunction(&libInfo);
 
 	if (libInfo.apiVersion != PLUGIN_API_VER)
 	{
 		std::cerr << pluginLoc << " invalid version" << std::endl;
 		dlclose(handle);
-		return -1;
+		return false;
 	}
 
-	PluginInfoFunction piFunction = 0;
+	piFunction = 0;
 #ifdef WIN32
 	piFunction = (PluginInfoFunction)GetProcAddress(handle, "getPluginInfo");
 #else
@@ -172,18 +295,27 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	{
 		ERROR_MSG("%s\n", dlerror());
 		dlclose(handle);
-		return -1;
+		return false;
 	}
 	dlerror();
 
+	return true;
+}
+
+int PluginManager::registerLibrary(const File& file, LibraryHandle handle, const Plugin::LibraryInfo& libInfo, PluginInfoFunction piFunction)
+{
 	LoadedLibInfo lib;
 	lib.apiVersion = libInfo.apiVersion;
 	lib.name = libInfo.name;
 	lib.libVersion = libInfo.libVersion;
 	lib.numPlugins = libInfo.numPlugins;
 	lib.handle = handle;
+	lib.path = file.getFullPathName();
+	lib.modificationTime = file.getLastModificationTime().toMilliseconds();
+	lib.fileSize = file.getSize();
 
 	libArray.add(lib);
+	int libIndex = libArray.size() - 1;
 
 	Plugin::PluginInfo pInfo;
 	for (int i = 0; i < lib.numPlugins; i++)
@@ -198,7 +330,7 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.creator = pInfo.processor.creator;
 			info.name = pInfo.processor.name;
 			info.type = pInfo.processor.type;
-			info.libIndex = libArray.size()-1;
+			info.libIndex = libIndex;
 			processorPlugins.add(info);
 			break;
 		}
@@ -207,7 +339,7 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
 			info.creator = pInfo.recordEngine.creator;
 			info.name = pInfo.recordEngine.name;
-			info.libIndex = libArray.size();
+			info.libIndex = libIndex;
 			recordEnginePlugins.add(info);
 			break;
 		}
@@ -216,7 +348,7 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			LoadedPluginInfo<Plugin::DataThreadInfo> info;
 			info.creator = pInfo.dataThread.creator;
 			info.name = pInfo.dataThread.name;
-			info.libIndex = libArray.size();
+			info.libIndex = libIndex;
 			dataThreadPlugins.add(info);
 			break;
 		}
@@ -226,7 +358,75 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 			info.creator = pInfo.fileSource.creator;
 			info.name = pInfo.fileSource.name;
 			info.extensions = pInfo.fileSource.extensions;
-			info.libIndex = libArray.size();
+			info.libIndex = libIndex;
+			fileSourcePlugins.add(info);
+			break;
+		}
+		}
+	}
+	return lib.numPlugins;
+}
+
+/*
+	 Lists the plugins of a library from its manifest entry. The
+	 creators stay null until ensurePluginLoaded opens the library.
+ */
+
+int PluginManager::registerCachedLibrary(const File& file, const XmlElement* libXml)
+{
+	LoadedLibInfo lib;
+	lib.apiVersion = PLUGIN_API_VER;
+	lib.name = namePool.getPooledString(libXml->getStringAttribute("name")).toRawUTF8();
+	lib.libVersion = libXml->getIntAttribute("version");
+	lib.numPlugins = libXml->getIntAttribute("numPlugins");
+	lib.handle = 0;
+	lib.path = file.getFullPathName();
+	lib.modificationTime = file.getLastModificationTime().toMilliseconds();
+	lib.fileSize = file.getSize();
+
+	libArray.add(lib);
+	int libIndex = libArray.size() - 1;
+
+	forEachXmlChildElementWithTagName(*libXml, pluginXml, "PLUGIN")
+	{
+		const char* name = namePool.getPooledString(pluginXml->getStringAttribute("name")).toRawUTF8();
+		switch (pluginXml->getIntAttribute("type", Plugin::NotAPlugin))
+		{
+		case Plugin::ProcessorPlugin:
+		{
+			LoadedPluginInfo<Plugin::ProcessorInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.type = (Plugin::ProcessorType) pluginXml->getIntAttribute("processorType", Plugin::InvalidProcessor);
+			info.libIndex = libIndex;
+			processorPlugins.add(info);
+			break;
+		}
+		case Plugin::RecordEnginePlugin:
+		{
+			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.libIndex = libIndex;
+			recordEnginePlugins.add(info);
+			break;
+		}
+		case Plugin::DatathreadPlugin:
+		{
+			LoadedPluginInfo<Plugin::DataThreadInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.libIndex = libIndex;
+			dataThreadPlugins.add(info);
+			break;
+		}
+		case Plugin::FileSourcePlugin:
+		{
+			LoadedPluginInfo<Plugin::FileSourceInfo> info;
+			info.creator = nullptr;
+			info.name = name;
+			info.extensions = namePool.getPooledString(pluginXml->getStringAttribute("extensions")).toRawUTF8();
+			info.libIndex = libIndex;
 			fileSourcePlugins.add(info);
 			break;
 		}
@@ -235,6 +435,130 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	return lib.numPlugins;
 }
 
+bool PluginManager::ensurePluginLoaded(Plugin::PluginType type, int index)
+{
+	int libIndex = getLibraryIndexFromPlugin(type, index);
+	if (libIndex < 0 || libIndex >= libArray.size())
+		return false;
+
+	return loadLibrary(libIndex);
+}
+
+bool PluginManager::loadLibrary(int libIndex)
+{
+	if (libArray.getReference(libIndex).handle)
+		return true;
+
+	double startTime = Time::getMillisecondCounterHiRes();
+
+	LibraryHandle handle;
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction;
+	String path = libArray.getReference(libIndex).path;
+
+	if (!openLibrary(path, handle, libInfo, piFunction))
+	{
+		std::cout << "Deferred load of " << path << " FAILED" << std::endl;
+		return false;
+	}
+
+	libArray.getReference(libIndex).handle = handle;
+
+	Plugin::PluginInfo pInfo;
+	for (int i = 0; i < libInfo.numPlugins; i++)
+	{
+		if (piFunction(i, &pInfo))
+			break;
+		switch (pInfo.type)
+		{
+		case Plugin::ProcessorPlugin:
+			setCreator(processorPlugins, libIndex, pInfo.processor.name, pInfo.processor.creator);
+			break;
+		case Plugin::RecordEnginePlugin:
+			setCreator(recordEnginePlugins, libIndex, pInfo.recordEngine.name, pInfo.recordEngine.creator);
+			break;
+		case Plugin::DatathreadPlugin:
+			setCreator(dataThreadPlugins, libIndex, pInfo.dataThread.name, pInfo.dataThread.creator);
+			break;
+		case Plugin::FileSourcePlugin:
+			setCreator(fileSourcePlugins, libIndex, pInfo.fileSource.name, pInfo.fileSource.creator);
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::cout << "Loaded deferred plugin library " << libArray.getReference(libIndex).name << " in "
+		<< Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+	return true;
+}
+
+template<class T, class C>
+void PluginManager::setCreator(Array<LoadedPluginInfo<T>>& pluginArray, int libIndex, const char* name, C creator)
+{
+	for (int i = 0; i < pluginArray.size(); i++)
+	{
+		LoadedPluginInfo<T>& info = pluginArray.getReference(i);
+		if (info.libIndex == libIndex && String(info.name) == String(name))
+			info.creator = creator;
+	}
+}
+
+XmlElement* PluginManager::createManifest() const
+{
+	XmlElement* manifest = new XmlElement("PLUGINMANIFEST");
+	manifest->setAttribute("apiVersion", PLUGIN_API_VER);
+
+	for (int l = 0; l < libArray.size(); l++)
+	{
+		const LoadedLibInfo& lib = libArray.getReference(l);
+		XmlElement* libXml = manifest->createNewChildElement("LIBRARY");
+		libXml->setAttribute("path", lib.path);
+		libXml->setAttribute("modified", String(lib.modificationTime));
+		libXml->setAttribute("size", String(lib.fileSize));
+		libXml->setAttribute("name", lib.name);
+		libXml->setAttribute("version", lib.libVersion);
+		libXml->setAttribute("numPlugins", lib.numPlugins);
+
+		for (int i = 0; i < processorPlugins.size(); i++)
+		{
+			if (processorPlugins[i].libIndex != l) continue;
+			XmlElement* pluginXml = libXml->createNewChildElement("PLUGIN");
+			pluginXml->setAttribute("type", Plugin::ProcessorPlugin);
+			pluginXml->setAttribute("name", processorPlugins[i].name);
+			pluginXml->setAttribute("processorType", processorPlugins[i].type);
+		}
+		for (int i = 0; i < recordEnginePlugins.size(); i++)
+		{
+			if (recordEnginePlugins[i].libIndex != l) continue;
+			XmlElement* pluginXml = libXml->createNewChildElement("PLUGIN");
+			pluginXml->setAttribute("type", Plugin::RecordEnginePlugin);
+			pluginXml->setAttribute("name", recordEnginePlugins[i].name);
+		}
+		for (int i = 0; i < dataThreadPlugins.size(); i++)
+		{
+			if (dataThreadPlugins[i].libIndex != l) continue;
+			XmlElement* pluginXml = libXml->createNewChildElement("PLUGIN");
+			pluginXml->setAttribute("type", Plugin::DatathreadPlugin);
+			pluginXml->setAttribute("name", dataThreadPlugins[i].name);
+		}
+		for (int i = 0; i < fileSourcePlugins.size(); i++)
+		{
+			if (fileSourcePlugins[i].libIndex != l) continue;
+			XmlElement* pluginXml = libXml->createNewChildElement("PLUGIN");
+			pluginXml->setAttribute("type", Plugin::FileSourcePlugin);
+			pluginXml->setAttribute("name", fileSourcePlugins[i].name);
+			pluginXml->setAttribute("extensions", fileSourcePlugins[i].extensions);
+		}
+	}
+	return manifest;
+}
+
+File PluginManager::getManifestFile()
+{
+	return File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getChildFile(MANIFEST_FILE_NAME);
+}
+
 int PluginManager::getNumProcessors() const
 {
 	return processorPlugins.size();
@@ -35,13 +35,19 @@
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "OpenEphysPlugin.h"
 
-struct LoadedLibInfo : public Plugin::LibraryInfo
-{
 #ifdef WIN32
-	HINSTANCE handle;
+typedef HINSTANCE LibraryHandle;
 #else
-	void* handle;
+typedef void* LibraryHandle;
 #endif
+
+struct LoadedLibInfo : public Plugin::LibraryInfo
+{
+	/** Null while the library is only known from the manifest */
+	LibraryHandle handle;
+	String path;
+	int64 modificationTime;
+	int64 fileSize;
 };
 
 template<class T>
@@ -60,6 +66,9 @@ public:
 	~PluginManager();
 	void loadAllPlugins();
 	int loadPlugin(const String&);
+	/** Loads the library of a plugin that was listed from the manifest, so that
+	its creator can be used. Returns false if the library cannot be loaded. */
+	bool ensurePluginLoaded(Plugin::PluginType type, int index);
 	//void unloadPlugin(Plugin *);
 	void removeAllPlugins();
 	int getNumProcessors() const;
@@ -79,12 +88,26 @@ public:
 	int getLibraryIndexFromPlugin(Plugin::PluginType type, int index);
 
 private:
+	static bool openLibrary(const String& path, LibraryHandle& handle, Plugin::LibraryInfo& libInfo, PluginInfoFunction& piFunction);
+	int registerLibrary(const File& file, LibraryHandle handle, const Plugin::LibraryInfo& libInfo, PluginInfoFunction piFunction);
+	int registerCachedLibrary(const File& file, const XmlElement* libXml);
+	bool loadLibrary(int libIndex);
+
+	XmlElement* createManifest() const;
+	static File getManifestFile();
+
+	template<class T, class C>
+	static void setCreator(Array<LoadedPluginInfo<T>>& pluginArray, int libIndex, const char* name, C creator);
+
 	Array<LoadedLibInfo> libArray;
 	Array<LoadedPluginInfo<Plugin::ProcessorInfo>> processorPlugins;
 	Array<LoadedPluginInfo<Plugin::DataThreadInfo>> dataThreadPlugins;
 	Array<LoadedPluginInfo<Plugin::RecordEngineInfo>> recordEnginePlugins;
 	Array<LoadedPluginInfo<Plugin::FileSourceInfo>> fileSourcePlugins;
 
+	/** Keeps the names read from the manifest alive for the info structures */
+	StringPool namePool;
+
 	template<class T>
 	bool findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const;
 
@@ -215,6 +215,9 @@ Array<GenericProcessor*> ProcessorGraph::getListOfProcessors()
 void ProcessorGraph::clearConnections()
 {
 
+    // the graph itself keeps its connections until applyPlannedConnections
+    plannedConnections.clearQuick();
+
     for (int i = 0; i < getNumNodes(); i++)
     {
         Node* node = getNode(i);
@@ -222,15 +225,8 @@ void ProcessorGraph::clearConnections()
 
         if (nodeId != OUTPUT_NODE_ID)
         {
-
-            if (nodeId != RECORD_NODE_ID && nodeId != AUDIO_NODE_ID)
-            {
-                disconnectNode(node->nodeId);
-            }
-
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
             p->resetConnections();
-
         }
     }
 
@@ -238,19 +234,112 @@ void ProcessorGraph::clearConnections()
     for (int n = 0; n < 2; n++)
     {
 
-        addConnection(AUDIO_NODE_ID, n,
-                      OUTPUT_NODE_ID, n);
+        planConnection(AUDIO_NODE_ID, n,
+                       OUTPUT_NODE_ID, n);
+
+    }
+
+    planConnection(MESSAGE_CENTER_ID, midiChannelIndex,
+                   RECORD_NODE_ID, midiChannelIndex);
+}
+
+void ProcessorGraph::planConnection(uint32 sourceNodeId, int sourceChannelIndex,
+                                    uint32 destNodeId, int destChannelIndex)
+{
+    plannedConnections.add(Connection(sourceNodeId, sourceChannelIndex, destNodeId, destChannelIndex));
+}
+
+/** Same order as the graph keeps its connections in */
+struct ConnectionOrder
+{
+    static int compareElements(const AudioProcessorGraph::Connection& first,
+                               const AudioProcessorGraph::Connection& second)
+    {
+        if (first.sourceNodeId != second.sourceNodeId)
+            return first.sourceNodeId < second.sourceNodeId ? -1 : 1;
+        if (first.destNodeId != second.destNodeId)
+            return first.destNodeId < second.destNodeId ? -1 : 1;
+        if (first.sourceChannelIndex != second.sourceChannelIndex)
+            return first.sourceChannelIndex < second.sourceChannelIndex ? -1 : 1;
+        if (first.destChannelIndex != second.destChannelIndex)
+            return first.destChannelIndex < second.destChannelIndex ? -1 : 1;
+        return 0;
+    }
+};
+
+void ProcessorGraph::applyPlannedConnections()
+{
+    ConnectionOrder order;
+    plannedConnections.sort(order);
+
+    // both lists are sorted, so one pass finds what to remove and what to add
+    Array<int> toRemove;
+    Array<Connection> toAdd;
+
+    int i = 0, j = 0;
+    int numKept = 0;
+
+    while (i < getNumConnections() || j < plannedConnections.size())
+    {
+        if (j > 0 && j < plannedConnections.size()
+            && order.compareElements(plannedConnections.getReference(j), plannedConnections.getReference(j - 1)) == 0)
+        {
+            j++; // planned twice
+            continue;
+        }
+
+        int cmp;
+
+        if (i >= getNumConnections())
+            cmp = 1;
+        else if (j >= plannedConnections.size())
+            cmp = -1;
+        else
+            cmp = order.compareElements(*getConnection(i), plannedConnections.getReference(j));
+
+        if (cmp < 0)
+        {
+            toRemove.add(i++);
+        }
+        else if (cmp > 0)
+        {
+            toAdd.add(plannedConnections.getReference(j++));
+        }
+        else
+        {
+            // a processor's channel count may have changed since it was made
+            if (isConnectionLegal(getConnection(i)))
+                numKept++;
+            else
+                toRemove.add(i);
+            i++;
+            j++;
+        }
+    }
+
+    for (int n = toRemove.size(); --n >= 0;)
+        removeConnection(toRemove[n]);
+
+    int numAdded = 0;
+
+    for (int n = 0; n < toAdd.size(); n++)
+    {
+        const Connection& c = toAdd.getReference(n);
 
+        if (addConnection(c.sourceNodeId, c.sourceChannelIndex, c.destNodeId, c.destChannelIndex))
+            numAdded++;
     }
 
-    addConnection(MESSAGE_CENTER_ID, midiChannelIndex,
-                  RECORD_NODE_ID, midiChannelIndex);
+    std::cout << "Connections: " << numAdded << " added, " << toRemove.size() << " removed, "
+              << numKept << " unchanged." << std::endl;
 }
 
 
 void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSection> tabs)
 {
-    clearConnections(); // clear processor graph
+    const double startTime = Time::getMillisecondCounterHiRes();
+
+    clearConnections(); // start a new connection plan
 
     std::cout << "Updating connections:" << std::endl;
     std::cout << std::endl;
@@ -277,7 +366,7 @@ void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSect
                 // add the connections to audio and record nodes if necessary
                 if (!(source->isSink()     ||
                       source->isSplitter() ||
-                      source->isMerger()   ||
+                      (source->isMerger() && !((Merger*) source)->isSynchronizing()) ||
                       source->isUtility())
                     && !(source->wasConnected))
                 {
@@ -292,7 +381,9 @@ void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSect
                 if (dest != nullptr)
                 {
 
-                    while (dest->isMerger()) // find the next dest that's not a merger
+                    // find the next dest that's not a merger; synchronizing
+                    // mergers process their inputs, so they are connected
+                    while (dest->isMerger() && !((Merger*) dest)->isSynchronizing())
                     {
                         dest = dest->getDestNode();
 
@@ -333,6 +424,11 @@ void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSect
                             {
                                 connectProcessors(source, dest);
                             }
+
+                            // a synchronizing merger's output was connected
+                            // when its other input came through
+                            if (dest->isMerger() && dest->wasConnected)
+                                dest = nullptr;
                         }
 
                     }
@@ -371,6 +467,11 @@ void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSect
         } // end while source != 0
     } // end "tabs" for loop
 
+    applyPlannedConnections();
+
+    std::cout << "Updated connections in " << Time::getMillisecondCounterHiRes() - startTime
+              << " ms." << std::endl;
+
 } // end method
 
 void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcessor* dest)
@@ -384,6 +485,7 @@ void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcesso
 
     bool connectContinuous = true;
     bool connectEvents = true;
+    int firstDestChannel = -1;
 
     if (source->getDestNode() != nullptr)
     {
@@ -392,6 +494,10 @@ void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcesso
             Merger* merger = (Merger*) source->getDestNode();
             connectContinuous = merger->sendContinuousForSource(source);
             connectEvents = merger->sendEventsForSource(source);
+
+            // input B follows input A whichever chain is walked first
+            if (merger == dest)
+                firstDestChannel = merger->getFirstInputChannel(source);
         }
     }
 
@@ -402,20 +508,21 @@ void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcesso
         {
             //std::cout << chan << " ";
 
-            addConnection(source->getNodeId(),         // sourceNodeID
-                          chan,                        // sourceNodeChannelIndex
-                          dest->getNodeId(),           // destNodeID
-                          dest->getNextChannel(true)); // destNodeChannelIndex
+            planConnection(source->getNodeId(),         // sourceNodeID
+                           chan,                        // sourceNodeChannelIndex
+                           dest->getNodeId(),           // destNodeID
+                           (firstDestChannel >= 0) ? firstDestChannel + chan
+                                                   : dest->getNextChannel(true)); // destNodeChannelIndex
         }
     }
 
     // 2. connect event channel
     if (connectEvents)
     {
-        addConnection(source->getNodeId(),    // sourceNodeID
-                      midiChannelIndex,       // sourceNodeChannelIndex
-                      dest->getNodeId(),      // destNodeID
-                      midiChannelIndex);      // destNodeChannelIndex
+        planConnection(source->getNodeId(),    // sourceNodeID
+                       midiChannelIndex,       // sourceNodeChannelIndex
+                       dest->getNodeId(),      // destNodeID
+                       midiChannelIndex);      // destNodeChannelIndex
     }
 
 }
@@ -437,31 +544,31 @@ void ProcessorGraph::connectProcessorToAudioAndRecordNodes(GenericProcessor* sou
         // IT CAN CAUSE PROBLEMS IF THE SAMPLE RATE VARIES ACROSS PROCESSORS
         getAudioNode()->settings.sampleRate = source->getSampleRate();
 
-        addConnection(source->getNodeId(),                   // sourceNodeID
-                      chan,                                  // sourceNodeChannelIndex
-                      AUDIO_NODE_ID,                         // destNodeID
-                      getAudioNode()->getNextChannel(true)); // destNodeChannelIndex
+        planConnection(source->getNodeId(),                   // sourceNodeID
+                       chan,                                  // sourceNodeChannelIndex
+                       AUDIO_NODE_ID,                         // destNodeID
+                       getAudioNode()->getNextChannel(true)); // destNodeChannelIndex
 
         getRecordNode()->addInputChannel(source, chan);
 
-        addConnection(source->getNodeId(),                    // sourceNodeID
-                      chan,                                   // sourceNodeChannelIndex
-                      RECORD_NODE_ID,                         // destNodeID
-                      getRecordNode()->getNextChannel(true)); // destNodeChannelIndex
+        planConnection(source->getNodeId(),                    // sourceNodeID
+                       chan,                                   // sourceNodeChannelIndex
+                       RECORD_NODE_ID,                         // destNodeID
+                       getRecordNode()->getNextChannel(true)); // destNodeChannelIndex
 
     }
 
     // connect event channel
-    addConnection(source->getNodeId(),    // sourceNodeID
-                  midiChannelIndex,       // sourceNodeChannelIndex
-                  RECORD_NODE_ID,         // destNodeID
-                  midiChannelIndex);      // destNodeChannelIndex
+    planConnection(source->getNodeId(),    // sourceNodeID
+                   midiChannelIndex,       // sourceNodeChannelIndex
+                   RECORD_NODE_ID,         // destNodeID
+                   midiChannelIndex);      // destNodeChannelIndex
 
     // connect event channel
-    addConnection(source->getNodeId(),    // sourceNodeID
-                  midiChannelIndex,       // sourceNodeChannelIndex
-                  AUDIO_NODE_ID,          // destNodeID
-                  midiChannelIndex);      // destNodeChannelIndex
+    planConnection(source->getNodeId(),    // sourceNodeID
+                   midiChannelIndex,       // sourceNodeChannelIndex
+                   AUDIO_NODE_ID,          // destNodeID
+                   midiChannelIndex);      // destNodeChannelIndex
 
 
     getRecordNode()->addInputChannel(source, midiChannelIndex);
@@ -45,6 +45,11 @@ class SignalChainTabButton;
 
   The user is able to modify the ProcessGraph through the EditorViewport
 
+  updateConnections works out every connection the signal chain needs and
+  then only adds and removes the ones that differ from the current graph, so
+  an edit that leaves most of the chain alone (or starting acquisition again
+  without any edit) doesn't tear down and rebuild every connection.
+
   @see EditorViewport, GenericProcessor, GenericEditor, RecordNode,
        AudioNode, Configuration, MessageCenter
 
@@ -103,6 +108,16 @@ private:
     void connectProcessors(GenericProcessor* source, GenericProcessor* dest);
     void connectProcessorToAudioAndRecordNodes(GenericProcessor* source);
 
+    /** Adds a connection to the ones the next applyPlannedConnections will leave in the graph */
+    void planConnection(uint32 sourceNodeId, int sourceChannelIndex,
+                        uint32 destNodeId, int destChannelIndex);
+
+    /** Makes the graph's connections match the planned ones */
+    void applyPlannedConnections();
+
+    /** Connections collected by updateConnections */
+    Array<Connection> plannedConnections;
+
 };
 
 
@@ -156,6 +156,8 @@ namespace ProcessorManager
 			break;
 		case PluginProcessor:
 			{
+				if (!AccessClass::getPluginManager()->ensurePluginLoaded(Plugin::ProcessorPlugin, index))
+					return nullptr;
 				Plugin::ProcessorInfo info = AccessClass::getPluginManager()->getProcessorInfo(index);
 				GenericProcessor* proc = info.creator();
 				proc->setPluginData(Plugin::ProcessorPlugin, index);
@@ -164,6 +166,8 @@ namespace ProcessorManager
 			}
 		case DataThreadProcessor:
 		{
+			if (!AccessClass::getPluginManager()->ensurePluginLoaded(Plugin::DatathreadPlugin, index))
+				return nullptr;
 			Plugin::DataThreadInfo info = AccessClass::getPluginManager()->getDataThreadInfo(index);
 			GenericProcessor* proc = new SourceNode(info.name, info.creator);
 			proc->setPluginData(Plugin::DatathreadPlugin, index);
@@ -194,8 +198,10 @@ namespace ProcessorManager
 					if (procName.equalsIgnoreCase(info.name))
 					{
 						int libIndex = pm->getLibraryIndexFromPlugin(Plugin::ProcessorPlugin, i);
-						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex))
+						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex)
+							&& pm->ensurePluginLoaded(Plugin::ProcessorPlugin, i))
 						{
+							info = pm->getProcessorInfo(i);
 							proc = info.creator();
 							proc->setPluginData(Plugin::ProcessorPlugin, i);
 							return proc;
@@ -211,8 +217,10 @@ namespace ProcessorManager
 					if (procName.equalsIgnoreCase(info.name))
 					{
 						int libIndex = pm->getLibraryIndexFromPlugin(Plugin::DatathreadPlugin, i);
-						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex))
+						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex)
+							&& pm->ensurePluginLoaded(Plugin::DatathreadPlugin, i))
 						{
+							info = pm->getDataThreadInfo(i);
 							proc = new SourceNode(info.name, info.creator);
 							proc->setPluginData(Plugin::DatathreadPlugin, i);
 							return proc;
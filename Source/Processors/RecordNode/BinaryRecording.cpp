@@ -0,0 +1,654 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2014 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BinaryRecording.h"
+
+#if JUCE_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// O_DIRECT requires buffers, sizes and file offsets aligned to the logical block size
+#define DISK_ALIGNMENT 4096
+#define TIMESTAMP_RECORD_SIZE 16
+
+BinaryRecording::VolumeWriter::VolumeWriter(BinaryRecording* o, const File& dir, int index)
+    : Thread("Binary Recording Writer " + String(index)), owner(o), directory(dir)
+{
+}
+
+BinaryRecording::VolumeWriter::~VolumeWriter()
+{
+    stopThread(2000);
+}
+
+void BinaryRecording::VolumeWriter::run()
+{
+    while (true)
+    {
+        bool exiting = threadShouldExit();
+
+        for (int i = 0; i < files.size(); i++)
+            owner->writePendingBuffers(files[i]);
+
+        if (exiting)
+            break;
+
+        wait(100);
+    }
+}
+
+BinaryRecording::BinaryRecording() :
+    scaledSize(0), interleavedSize(0),
+    recordingNumber(0), experimentNumber(0), bufferSizeKiB(4096),
+    bufferSize(0), useDirectIO(false), channelsPerFile(0), rotateMinutes(0), rotateMiB(0)
+{
+}
+
+BinaryRecording::~BinaryRecording()
+{
+    //Cleanup just in case
+    for (int i = 0; i < volumes.size(); i++)
+        volumes[i]->stopThread(2000);
+    for (int i = 0; i < datFiles.size(); i++)
+        closeDatFile(datFiles[i]);
+}
+
+String BinaryRecording::getEngineID()
+{
+    return "RAWBINARY";
+}
+
+void BinaryRecording::registerProcessor(GenericProcessor* processor)
+{
+    ProcessorInfo info;
+    info.nodeId = processor->getNodeId();
+    info.sampleRate = processor->getSampleRate();
+    processors.add(info);
+}
+
+void BinaryRecording::addChannel(int index, Channel* chan)
+{
+    processorMap.add(processors.size() - 1);
+}
+
+void BinaryRecording::addSpikeElectrode(int index, SpikeRecordInfo* elec)
+{
+    eventSpikeFiles.addSpikeElectrode();
+}
+
+void BinaryRecording::resetChannels()
+{
+    datFiles.clear();
+    processors.clear();
+    processorMap.clear();
+    eventSpikeFiles.resetSpikeElectrodes();
+}
+
+void BinaryRecording::createDatFiles()
+{
+    datFiles.clear();
+
+    for (int p = 0; p < processors.size(); p++)
+    {
+        Array<int> recorded;
+
+        for (int i = 0; i < processorMap.size(); i++)
+        {
+            if (processorMap[i] == p && getChannel(i)->getRecordState())
+                recorded.add(i);
+        }
+
+        if (recorded.size() == 0)
+            continue;
+
+        const int groupSize = (channelsPerFile > 0) ? channelsPerFile : recorded.size();
+        const int numGroups = (recorded.size() + groupSize - 1) / groupSize;
+
+        for (int g = 0; g < numGroups; g++)
+        {
+            DatFile* file = new DatFile();
+            file->nodeId = processors[p].nodeId;
+            file->sampleRate = processors[p].sampleRate;
+            file->fileName = String(file->nodeId) + (numGroups > 1 ? "_group" + String(g) : String::empty);
+            file->volume = nullptr;
+            file->dataFile = nullptr;
+            file->timestampFile = nullptr;
+            file->directIO = false;
+            file->buffers[0] = file->buffers[1] = nullptr;
+            file->activeBuffer = 0;
+            file->bufferUsed = 0;
+            file->writerBuffer = 0;
+            file->writerSegment = 0;
+            file->segmentBytes = 0;
+
+            for (int c = g * groupSize; c < jmin(recorded.size(), (g + 1) * groupSize); c++)
+            {
+                Channel* ch = getChannel(recorded[c]);
+                file->channels.add(recorded[c]);
+                file->scaleFactors.add(1.0f / (float(0x7fff) * ch->bitVolts));
+            }
+
+            datFiles.add(file);
+        }
+    }
+}
+
+void BinaryRecording::createVolumes(File root)
+{
+    volumes.clear();
+    volumes.add(new VolumeWriter(this, root, 0));
+
+    StringArray paths;
+    paths.addTokens(extraDirectories, ";", "\"");
+    paths.trim();
+    paths.removeEmptyStrings();
+
+    for (int i = 0; i < paths.size(); i++)
+    {
+        // the same session folder name on every disk
+        File dir = File(paths[i]).getChildFile(root.getFileName());
+
+        if (! dir.isDirectory() && dir.createDirectory().failed())
+        {
+            std::cout << "Can't create " << dir.getFullPathName() << ", not striping to it." << std::endl;
+            continue;
+        }
+
+        volumes.add(new VolumeWriter(this, dir, volumes.size()));
+    }
+
+    // the files with the highest data rates go first, each to the directory with the least so far
+    Array<DatFile*> order;
+    for (int i = 0; i < datFiles.size(); i++)
+    {
+        int j = 0;
+        while (j < order.size() && order[j]->channels.size() * order[j]->sampleRate
+               >= datFiles[i]->channels.size() * datFiles[i]->sampleRate)
+            j++;
+        order.insert(j, datFiles[i]);
+    }
+
+    Array<double> load;
+    load.insertMultiple(0, 0.0, volumes.size());
+
+    for (int i = 0; i < order.size(); i++)
+    {
+        int best = 0;
+        for (int v = 1; v < volumes.size(); v++)
+        {
+            if (load[v] < load[best])
+                best = v;
+        }
+
+        order[i]->volume = volumes[best];
+        volumes[best]->files.add(order[i]);
+        load.set(best, load[best] + order[i]->channels.size() * order[i]->sampleRate);
+    }
+}
+
+void BinaryRecording::openFiles(File root, int experimentNumber, int recordingNumber)
+{
+    this->recordingNumber = recordingNumber;
+    this->experimentNumber = experimentNumber;
+    rootFolder = root;
+
+    bufferSize = (size_t(bufferSizeKiB) * 1024 + DISK_ALIGNMENT - 1) & ~size_t(DISK_ALIGNMENT - 1);
+
+    String suffix = "_experiment" + String(experimentNumber) + "_recording" + String(recordingNumber);
+    String basePath = rootFolder.getFullPathName() + rootFolder.separatorString;
+
+    createDatFiles();
+    createVolumes(rootFolder);
+
+    for (int i = 0; i < datFiles.size(); i++)
+    {
+        datFiles[i]->fileName += suffix;
+        openDatFile(datFiles[i]);
+    }
+
+    eventSpikeFiles.openFiles(basePath, suffix, recordingNumber);
+
+    for (int i = 0; i < eventSpikeFiles.getNumSpikeElectrodes(); i++)
+    {
+        SpikeRecordInfo* elec = getSpikeElectrode(i);
+        String path = basePath + elec->name.removeCharacters(" ") + suffix + ".spikes";
+        eventSpikeFiles.openSpikeFile(elec->recordIndex, path);
+    }
+
+    writeXml(rootFolder, false);
+
+    for (int v = 0; v < volumes.size(); v++)
+        volumes[v]->startThread();
+}
+
+String BinaryRecording::getSegmentFileName(DatFile* file, int segment)
+{
+    if (rotateMinutes <= 0 && rotateMiB <= 0)
+        return file->fileName + ".dat";
+
+    return file->fileName + "_" + String(segment).paddedLeft('0', 4) + ".dat";
+}
+
+void BinaryRecording::openSegment(DatFile* file, int segment)
+{
+    String path = file->volume->directory.getFullPathName() + File::separatorString
+                  + getSegmentFileName(file, segment);
+
+    std::cout << "OPENING FILE: " << path << std::endl;
+
+    file->dataFile = nullptr;
+    file->directIO = false;
+
+#if JUCE_LINUX
+    if (useDirectIO)
+    {
+        int fd = ::open(path.toUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (fd >= 0)
+        {
+            file->dataFile = fdopen(fd, "wb");
+            file->directIO = true;
+        }
+        else
+        {
+            std::cout << "O_DIRECT not supported for " << path << ", using buffered writes." << std::endl;
+        }
+    }
+#endif
+
+    if (file->dataFile == nullptr)
+        file->dataFile = fopen(path.toUTF8(), "wb");
+
+    // all writes are already large and aligned, so bypass the stdio buffer
+    if (file->dataFile != nullptr)
+        setvbuf(file->dataFile, nullptr, _IONBF, 0);
+
+    file->writerSegment = segment;
+}
+
+void BinaryRecording::openDatFile(DatFile* file)
+{
+    openSegment(file, 0);
+
+    String path = file->volume->directory.getFullPathName() + File::separatorString + file->fileName;
+    file->timestampFile = fopen((path + ".timestamps").toUTF8(), "wb");
+
+    file->storage.malloc(2 * bufferSize + DISK_ALIGNMENT);
+    char* aligned = (char*)(((pointer_sized_int) file->storage.getData() + DISK_ALIGNMENT - 1) & ~pointer_sized_int(DISK_ALIGNMENT - 1));
+    file->buffers[0] = aligned;
+    file->buffers[1] = aligned + bufferSize;
+    file->activeBuffer = 0;
+    file->bufferUsed = 0;
+    file->writerBuffer = 0;
+
+    for (int b = 0; b < 2; b++)
+    {
+        file->pending[b].set(0);
+        file->pendingBytes[b] = 0;
+        file->endsSegment[b] = false;
+    }
+
+    // rotating every minute for a day stays within this
+    file->segments.clearQuick();
+    file->segments.ensureStorageAllocated(2048);
+    file->segmentBytes = 0;
+}
+
+/** Takes the tail of a file off O_DIRECT, since it isn't block-sized */
+static void clearDirectIO(FILE* f)
+{
+#if JUCE_LINUX
+    int fd = fileno(f);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+}
+
+void BinaryRecording::closeDatFile(DatFile* file)
+{
+    if (file->dataFile != nullptr)
+    {
+        if (file->bufferUsed > 0)
+        {
+            if (file->directIO)
+                clearDirectIO(file->dataFile);
+
+            fwrite(file->buffers[file->activeBuffer], 1, file->bufferUsed, file->dataFile);
+            file->volume->bytesWritten += int64(file->bufferUsed);
+            file->bufferUsed = 0;
+        }
+        fclose(file->dataFile);
+        file->dataFile = nullptr;
+    }
+    if (file->timestampFile != nullptr)
+    {
+        fclose(file->timestampFile);
+        file->timestampFile = nullptr;
+    }
+    file->storage.free();
+    file->buffers[0] = file->buffers[1] = nullptr;
+}
+
+void BinaryRecording::closeFiles()
+{
+    // let the writer threads drain every full buffer before closing
+    for (int v = 0; v < volumes.size(); v++)
+    {
+        volumes[v]->signalThreadShouldExit();
+        volumes[v]->notify();
+    }
+    for (int v = 0; v < volumes.size(); v++)
+        volumes[v]->stopThread(-1);
+
+    for (int i = 0; i < datFiles.size(); i++)
+        closeDatFile(datFiles[i]);
+
+    writeXml(rootFolder, true);
+
+    eventSpikeFiles.closeFiles();
+}
+
+void BinaryRecording::writePendingBuffers(DatFile* file)
+{
+    while (file->pending[file->writerBuffer].get() != 0)
+    {
+        const int b = file->writerBuffer;
+        const size_t numBytes = file->pendingBytes[b];
+
+        if (numBytes > 0 && file->dataFile != nullptr)
+        {
+            if (file->directIO && (numBytes % DISK_ALIGNMENT) != 0)
+                clearDirectIO(file->dataFile);
+
+            size_t count = fwrite(file->buffers[b], 1, numBytes, file->dataFile);
+
+            jassert(count == numBytes); // make sure all the data was written
+
+            file->volume->bytesWritten += int64(count);
+        }
+
+        if (file->endsSegment[b])
+        {
+            if (file->dataFile != nullptr)
+                fclose(file->dataFile);
+
+            openSegment(file, file->writerSegment + 1);
+        }
+
+        file->pending[b].set(0);
+        file->writerBuffer ^= 1;
+        file->volume->bufferFreed.signal();
+    }
+}
+
+void BinaryRecording::handOverBuffer(DatFile* file, bool endsSegment)
+{
+    const int b = file->activeBuffer;
+
+    file->pendingBytes[b] = file->bufferUsed;
+    file->endsSegment[b] = endsSegment;
+    file->pending[b].set(1);
+    file->volume->notify();
+
+    file->activeBuffer ^= 1;
+    file->bufferUsed = 0;
+
+    // only blocks if the disk can't keep up with a whole buffer's worth of data
+    while (file->pending[file->activeBuffer].get() != 0)
+        file->volume->bufferFreed.wait(10);
+}
+
+void BinaryRecording::appendToDatFile(DatFile* file, const char* data, size_t numBytes)
+{
+    while (numBytes > 0)
+    {
+        size_t toCopy = jmin(numBytes, bufferSize - file->bufferUsed);
+        memcpy(file->buffers[file->activeBuffer] + file->bufferUsed, data, toCopy);
+        file->bufferUsed += toCopy;
+        data += toCopy;
+        numBytes -= toCopy;
+
+        // hand the full buffer over to the writer thread and switch to the other one
+        if (file->bufferUsed == bufferSize)
+            handOverBuffer(file, false);
+    }
+}
+
+void BinaryRecording::startNewSegment(DatFile* file, int64 timestamp)
+{
+    // the writer closes the current segment after the data handed over here
+    if (file->segments.size() > 0)
+        handOverBuffer(file, true);
+
+    SegmentInfo segment;
+    segment.timestamp = timestamp;
+    segment.numSamples = 0;
+    file->segments.add(segment);
+    file->segmentBytes = 0;
+}
+
+void BinaryRecording::writeData(AudioSampleBuffer& buffer)
+{
+    for (int i = 0; i < datFiles.size(); i++)
+    {
+        DatFile* file = datFiles[i];
+
+        if (file->buffers[0] == nullptr)
+            continue;
+
+        int numChannels = file->channels.size();
+        int sourceNodeId = getChannel(file->channels[0])->sourceNodeId;
+        int nSamples = (*numSamples)[sourceNodeId];
+
+        if (nSamples <= 0)
+            continue;
+
+        const int64 ts = (*timestamps)[sourceNodeId];
+        const size_t blockBytes = size_t(nSamples) * numChannels * 2;
+
+        // segments change between blocks, so each one holds whole blocks
+        if (file->segments.size() == 0)
+        {
+            startNewSegment(file, ts);
+        }
+        else if (file->segmentBytes > 0)
+        {
+            const SegmentInfo& current = file->segments.getReference(file->segments.size() - 1);
+
+            if ((rotateMinutes > 0 && current.numSamples >= int64(rotateMinutes) * 60 * int64(file->sampleRate))
+                || (rotateMiB > 0 && file->segmentBytes + int64(blockBytes) > int64(rotateMiB) << 20))
+            {
+                startNewSegment(file, ts);
+            }
+        }
+
+        if (scaledSize < nSamples)
+        {
+            scaledBuffer.malloc(nSamples);
+            scaledSize = nSamples;
+        }
+        if (interleavedSize < nSamples * numChannels)
+        {
+            interleavedBuffer.malloc(nSamples * numChannels);
+            interleavedSize = nSamples * numChannels;
+        }
+
+        for (int c = 0; c < numChannels; c++)
+        {
+            FloatVectorOperations::copyWithMultiply(scaledBuffer,
+                                                    buffer.getReadPointer(file->channels[c], 0),
+                                                    file->scaleFactors[c],
+                                                    nSamples);
+            // strided conversion writes straight into the interleaved frame
+            AudioDataConverters::convertFloatToInt16LE(scaledBuffer,
+                                                       interleavedBuffer + c,
+                                                       nSamples,
+                                                       2 * numChannels);
+        }
+
+        appendToDatFile(file, (const char*) interleavedBuffer.getData(), blockBytes);
+
+        file->segmentBytes += int64(blockBytes);
+        file->segments.getReference(file->segments.size() - 1).numSamples += nSamples;
+
+        if (file->timestampFile != nullptr)
+        {
+            uint8 record[TIMESTAMP_RECORD_SIZE];
+            uint64 tsLE = ByteOrder::swapIfBigEndian((uint64) ts);
+            uint32 countLE = ByteOrder::swapIfBigEndian((uint32) nSamples);
+            uint16 recLE = ByteOrder::swapIfBigEndian((uint16) recordingNumber);
+            uint16 segLE = ByteOrder::swapIfBigEndian((uint16) (file->segments.size() - 1));
+            memcpy(record, &tsLE, 8);
+            memcpy(record + 8, &countLE, 4);
+            memcpy(record + 12, &recLE, 2);
+            memcpy(record + 14, &segLE, 2);
+            fwrite(record, 1, TIMESTAMP_RECORD_SIZE, file->timestampFile);
+        }
+    }
+}
+
+void BinaryRecording::writeEvent(int eventType, MidiMessage& event, int samplePosition)
+{
+    uint8 sourceNodeId = event.getNoteNumber();
+    int64 eventTimestamp = (*timestamps)[sourceNodeId] + samplePosition;
+
+    eventSpikeFiles.writeEvent(eventType, event, eventTimestamp, samplePosition);
+}
+
+void BinaryRecording::writeSpike(const SpikeObject& spike, int electrodeIndex)
+{
+    eventSpikeFiles.writeSpike(spike, electrodeIndex);
+}
+
+void BinaryRecording::writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex)
+{
+    eventSpikeFiles.writeSpikeRecord(spike, electrodeIndex);
+}
+
+void BinaryRecording::writeXml(File rootFolder, bool withSegments)
+{
+    String name = rootFolder.getFullPathName() + rootFolder.separatorString
+                  + "binary_experiment" + String(experimentNumber) + ".xml";
+
+    File file(name);
+    XmlDocument doc(file);
+    ScopedPointer<XmlElement> xml = doc.getDocumentElement();
+    if (!xml || ! xml->hasTagName("EXPERIMENT"))
+    {
+        xml = new XmlElement("EXPERIMENT");
+        xml->setAttribute("number", experimentNumber);
+        xml->setAttribute("format", "int16 little-endian, interleaved");
+    }
+    xml->setAttribute("timestamprecord", "int64 timestamp, uint32 samples, uint16 recording, uint16 segment");
+
+    // written again at close with the segment list
+    forEachXmlChildElementWithTagName(*xml, old, "RECORDING")
+    {
+        if (old->getIntAttribute("number", -1) == recordingNumber)
+        {
+            xml->removeChildElement(old, true);
+            break;
+        }
+    }
+
+    XmlElement* rec = new XmlElement("RECORDING");
+    rec->setAttribute("number", recordingNumber);
+    for (int i = 0; i < datFiles.size(); i++)
+    {
+        DatFile* f = datFiles[i];
+
+        XmlElement* proc = new XmlElement("PROCESSOR");
+        proc->setAttribute("id", f->nodeId);
+        proc->setAttribute("samplerate", f->sampleRate);
+        proc->setAttribute("filename", getSegmentFileName(f, 0));
+        proc->setAttribute("timestamps", f->fileName + ".timestamps");
+        if (f->volume->directory != rootFolder)
+            proc->setAttribute("directory", f->volume->directory.getFullPathName());
+        proc->setAttribute("channels", f->channels.size());
+        for (int j = 0; j < f->channels.size(); j++)
+        {
+            Channel* ch = getChannel(f->channels[j]);
+            XmlElement* chan = new XmlElement("CHANNEL");
+            chan->setAttribute("name", ch->name);
+            chan->setAttribute("bitVolts", ch->bitVolts);
+            proc->addChildElement(chan);
+        }
+        if (withSegments)
+        {
+            for (int s = 0; s < f->segments.size(); s++)
+            {
+                XmlElement* seg = new XmlElement("SEGMENT");
+                seg->setAttribute("index", s);
+                seg->setAttribute("filename", getSegmentFileName(f, s));
+                seg->setAttribute("timestamp", String(f->segments[s].timestamp));
+                seg->setAttribute("samples", String(f->segments[s].numSamples));
+                proc->addChildElement(seg);
+            }
+        }
+        rec->addChildElement(proc);
+    }
+    xml->addChildElement(rec);
+    xml->writeToFile(file, String::empty);
+}
+
+void BinaryRecording::getVolumeStatus(Array<RecordVolumeStatus>& status)
+{
+    for (int i = 0; i < volumes.size(); i++)
+    {
+        RecordVolumeStatus v;
+        v.directory = volumes[i]->directory;
+        v.bytesWritten = volumes[i]->bytesWritten.get();
+        v.bytesPerSecond = 0;
+        v.bytesFree = 0;
+        v.totalBytes = 0;
+        status.add(v);
+    }
+}
+
+void BinaryRecording::setParameter(EngineParameter& parameter)
+{
+    boolParameter(0, useDirectIO);
+    intParameter(1, bufferSizeKiB);
+    strParameter(2, extraDirectories);
+    intParameter(3, channelsPerFile);
+    intParameter(4, rotateMinutes);
+    intParameter(5, rotateMiB);
+}
+
+RecordEngineManager* BinaryRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager("RAWBINARY", "Binary", &(engineFactory<BinaryRecording>));
+    EngineParameter* param;
+    param = new EngineParameter(EngineParameter::BOOL, 0, "Unbuffered disk writes (O_DIRECT, Linux only)", false);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 1, "Write buffer size (KiB)", 4096, 64, 65536);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::STR, 2, "Additional data directories (separated by ;)", "");
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 3, "Channels per file (0 = one file per processor)", 0, 0, 4096);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 4, "New file every (minutes, 0 = never)", 0, 0, 1440);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 5, "New file at (MiB, 0 = no limit)", 0, 0, 1048576);
+    man->addParameter(param);
+    return man;
+}
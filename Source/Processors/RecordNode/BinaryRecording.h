@@ -0,0 +1,205 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2014 Open Ephys
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef BINARYRECORDING_H_INCLUDED
+#define BINARYRECORDING_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+#include "RecordEngine.h"
+#include <stdio.h>
+
+/**
+
+  Writes the continuous data of every source processor as a single flat
+  .dat stream of interleaved little-endian int16 samples (sample-major,
+  channel-minor), the layout expected by most offline spike sorters.
+
+  Samples are staged in page-aligned double buffers which are handed to a
+  background writer thread once full, so the disk only ever sees large
+  sequential writes. On Linux the files can optionally be opened with
+  O_DIRECT to bypass the page cache.
+
+  A processor's channels can be split into groups of a fixed size, each with
+  its own file, and the files can be striped across additional data
+  directories (one per disk). Every directory has its own writer thread, and
+  files are spread so that each directory gets about the same data rate.
+  Events, spikes and the XML description stay in the main directory.
+
+  Files can also be rotated after a number of minutes or MiB. A new segment
+  always starts on a block boundary, so concatenating the segments in order
+  gives the same stream as a single file.
+
+  For each block of samples a 16-byte record (int64 timestamp, uint32 sample
+  count, uint16 recording number, uint16 segment) is appended to a
+  .timestamps sidecar file next to the first segment. When the files close,
+  binary_experimentN.xml lists the segments of every file with their
+  directory, first timestamp and number of samples. Events and spikes are
+  stored using the same record layouts as the Open Ephys format.
+
+  @see RecordEngine, OriginalRecording
+
+*/
+
+class BinaryRecording : public RecordEngine
+{
+public:
+    BinaryRecording();
+    ~BinaryRecording();
+
+    void setParameter(EngineParameter& parameter);
+    String getEngineID();
+    void openFiles(File rootFolder, int experimentNumber, int recordingNumber);
+    void closeFiles();
+    void writeData(AudioSampleBuffer& buffer);
+    void writeEvent(int eventType, MidiMessage& event, int samplePosition);
+    void registerProcessor(GenericProcessor* processor);
+    void addChannel(int index, Channel* chan);
+    void resetChannels();
+    void addSpikeElectrode(int index, SpikeRecordInfo* elec);
+    void writeSpike(const SpikeObject& spike, int electrodeIndex);
+    void writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex);
+    void getVolumeStatus(Array<RecordVolumeStatus>& volumes);
+
+    static RecordEngineManager* getEngineManager();
+
+private:
+
+    struct DatFile;
+
+    /** Writes the buffers of the files in one data directory */
+    class VolumeWriter : public Thread
+    {
+    public:
+        VolumeWriter(BinaryRecording* owner, const File& directory, int index);
+        ~VolumeWriter();
+
+        void run();
+
+        BinaryRecording* owner;
+        File directory;
+        Array<DatFile*> files;
+
+        /** Data written so far, for the ControlPanel */
+        Atomic<int64> bytesWritten;
+
+        WaitableEvent bufferFreed;
+    };
+
+    struct SegmentInfo
+    {
+        int64 timestamp;
+        int64 numSamples;
+    };
+
+    /** One interleaved .dat stream, holding a group of recorded channels of a processor */
+    struct DatFile
+    {
+        int nodeId;
+        float sampleRate;
+        String fileName;
+
+        /** Record indices and int16 scale factors of the channels in this file */
+        Array<int> channels;
+        Array<float> scaleFactors;
+
+        VolumeWriter* volume;
+
+        FILE* dataFile;
+        FILE* timestampFile;
+        bool directIO;
+
+        HeapBlock<char> storage;
+        char* buffers[2];
+        int activeBuffer;
+        size_t bufferUsed;
+
+        /** A buffer belongs to the writer while pending is set; pendingBytes
+            may be less than a full buffer when it ends a segment */
+        Atomic<int> pending[2];
+        size_t pendingBytes[2];
+        bool endsSegment[2];
+
+        /** Next buffer the writer takes, so buffers are written in the order they were filled */
+        int writerBuffer;
+        /** Segment of the open data file; writer thread only */
+        int writerSegment;
+
+        /** Segments started so far; audio thread only */
+        Array<SegmentInfo> segments;
+        int64 segmentBytes;
+    };
+
+    /** Processors registered for the current acquisition */
+    struct ProcessorInfo
+    {
+        int nodeId;
+        float sampleRate;
+    };
+
+    void createDatFiles();
+    void createVolumes(File rootFolder);
+    void openDatFile(DatFile* file);
+    void openSegment(DatFile* file, int segment);
+    void closeDatFile(DatFile* file);
+    String getSegmentFileName(DatFile* file, int segment);
+    void appendToDatFile(DatFile* file, const char* data, size_t numBytes);
+    void handOverBuffer(DatFile* file, bool endsSegment);
+    void startNewSegment(DatFile* file, int64 timestamp);
+    void writePendingBuffers(DatFile* file);
+    void writeXml(File rootFolder, bool withSegments);
+
+    OwnedArray<DatFile> datFiles;
+    OwnedArray<VolumeWriter> volumes;
+
+    Array<ProcessorInfo> processors;
+
+    /** For every registered channel, the index of its processor in processors */
+    Array<int> processorMap;
+
+    File rootFolder;
+
+    EventSpikeFiles eventSpikeFiles;
+
+    /** Scratch buffers for scaling and interleaving one block */
+    HeapBlock<float> scaledBuffer;
+    HeapBlock<int16> interleavedBuffer;
+    int scaledSize;
+    int interleavedSize;
+
+    int recordingNumber;
+    int experimentNumber;
+
+    int bufferSizeKiB;
+    size_t bufferSize;
+    bool useDirectIO;
+
+    String extraDirectories;
+    int channelsPerFile;
+    int rotateMinutes;
+    int rotateMiB;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BinaryRecording);
+};
+
+#endif  // BINARYRECORDING_H_INCLUDED
@@ -27,7 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 OriginalRecording::OriginalRecording() : separateFiles(false),
     recordingNumber(0), experimentNumber(0),  zeroBuffer(1, 50000),
-    eventFile(nullptr), messageFile(nullptr), lastProcId(0)
+    eventFile(nullptr), messageFile(nullptr), spikeRecordBufferSize(0), lastProcId(0)
 {
     /*continuousDataIntegerBuffer = new int16[10000];
     continuousDataFloatBuffer = new float[10000];
@@ -669,6 +669,33 @@ void OriginalRecording::writeSpike(const SpikeObject& spike, int electrodeIndex)
     diskWriteLock.exit();
 }
 
+void OriginalRecording::writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex)
+{
+    if (spikeFileArray[electrodeIndex] == nullptr)
+        return;
+
+    const ScopedLock sl(diskWriteLock);
+
+    int packedSize = getPackedSpikeRecordSize(spike);
+
+    if (packedSize > spikeRecordBufferSize)
+    {
+        spikeRecordBuffer.malloc(packedSize);
+        spikeRecordBufferSize = packedSize;
+    }
+
+    packSpikeRecord(spike, spikeRecordBuffer, spikeRecordBufferSize);
+
+    // same record layout as writeSpike, for as many channels and samples as the spike has
+    int totalBytes = spike.nSamples * spike.nChannels * 2 + // account for samples
+                     spike.nChannels * 4 +            // acount for gain
+                     spike.nChannels * 2 +            // account for thresholds
+                     SPIKE_METADATA_SIZE;             // 42, from SpikeObject.h
+
+    fwrite(spikeRecordBuffer, 1, totalBytes, spikeFileArray[electrodeIndex]);
+    fwrite(&recordingNumber, 2, 1, spikeFileArray[electrodeIndex]);
+}
+
 void OriginalRecording::writeXml()
 {
     String name = recordPath + "Continuous_Data";
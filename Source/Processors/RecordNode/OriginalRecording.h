@@ -56,6 +56,7 @@ public:
     //void updateTimeStamp(int64 timestamp);
     void addSpikeElectrode(int index, SpikeRecordInfo* elec);
     void writeSpike(const SpikeObject& spike, int electrodeIndex);
+    void writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex);
 
     static RecordEngineManager* getEngineManager();
 
@@ -108,6 +109,10 @@ private:
     Array<FILE*> fileArray;
     Array<FILE*> spikeFileArray;
 
+    /** Spikes are packed here before writing; grows with the largest spike seen */
+    HeapBlock<uint8_t> spikeRecordBuffer;
+    int spikeRecordBufferSize;
+
     CriticalSection diskWriteLock;
 
     struct ChannelInfo
@@ -28,6 +28,7 @@
 
 #include "EngineConfigWindow.h"
 #include "OriginalRecording.h"
+#include "BinaryRecording.h"
 
 RecordEngine::RecordEngine()
     : manager(nullptr)
@@ -70,10 +71,19 @@ void RecordEngine::updateNumSamples(std::map<uint8, int>* ns)
 
 void RecordEngine::registerSpikeSource(GenericProcessor* processor) {}
 
+void RecordEngine::writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex)
+{
+    SpikeObject s;
+    spike.toSpikeObject(s);
+    writeSpike(s, electrodeIndex);
+}
+
 void RecordEngine::startAcquisition() {}
 
 void RecordEngine::directoryChanged() {}
 
+void RecordEngine::getVolumeStatus(Array<RecordVolumeStatus>& volumes) {}
+
 void RecordEngine::registerManager(RecordEngineManager* recordManager)
 {
     manager = recordManager;
@@ -146,7 +156,7 @@ void RecordEngineManager::addParameter(EngineParameter* param)
 
 int RecordEngineManager::getNumOfBuiltInEngines()
 {
-	return 1;
+	return 2;
 }
 
 RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
@@ -156,6 +166,9 @@ RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
 	case 0:
 		return OriginalRecording::getEngineManager();
 		break;
+	case 1:
+		return BinaryRecording::getEngineManager();
+		break;
 	default:
 		return nullptr;
 	}
@@ -263,4 +276,131 @@ void RecordEngineManager::loadParametersFromXml(XmlElement* xml)
     }
 }
 
+EventSpikeFiles::EventSpikeFiles()
+    : eventFile(nullptr), messageFile(nullptr), spikeRecordBufferSize(0), recordingNumber(0)
+{
+}
+
+EventSpikeFiles::~EventSpikeFiles()
+{
+    closeFiles();
+}
+
+void EventSpikeFiles::addSpikeElectrode()
+{
+    spikeFileArray.add(nullptr);
+}
+
+void EventSpikeFiles::resetSpikeElectrodes()
+{
+    closeFiles();
+    spikeFileArray.clear();
+}
+
+int EventSpikeFiles::getNumSpikeElectrodes() const
+{
+    return spikeFileArray.size();
+}
+
+void EventSpikeFiles::openFiles(const String& basePath, const String& suffix, int recNum)
+{
+    recordingNumber = recNum;
+
+    eventFile = fopen((basePath + "events" + suffix + ".events").toUTF8(), "wb");
+    messageFile = fopen((basePath + "messages" + suffix + ".events").toUTF8(), "wb");
+}
+
+void EventSpikeFiles::openSpikeFile(int electrodeIndex, const String& path)
+{
+    spikeFileArray.set(electrodeIndex, fopen(path.toUTF8(), "wb"));
+}
 
+void EventSpikeFiles::closeFiles()
+{
+    for (int i = 0; i < spikeFileArray.size(); i++)
+    {
+        if (spikeFileArray[i] != nullptr)
+        {
+            fclose(spikeFileArray[i]);
+            spikeFileArray.set(i, nullptr);
+        }
+    }
+    if (eventFile != nullptr)
+    {
+        fclose(eventFile);
+        eventFile = nullptr;
+    }
+    if (messageFile != nullptr)
+    {
+        fclose(messageFile);
+        messageFile = nullptr;
+    }
+}
+
+void EventSpikeFiles::writeEvent(int eventType, const MidiMessage& event, int64 timestamp, int samplePosition)
+{
+    const uint8* dataptr = event.getRawData();
+
+    if (eventType == GenericProcessor::TTL && eventFile != nullptr)
+    {
+        // same record as OriginalRecording: timestamp, sample position, type/node/id/channel, recording number
+        uint16 samplePos = (uint16) samplePosition;
+        uint16 recNum = (uint16) recordingNumber;
+        fwrite(&timestamp, 8, 1, eventFile);
+        fwrite(&samplePos, 2, 1, eventFile);
+        fwrite(dataptr, 1, 4, eventFile);
+        fwrite(&recNum, 2, 1, eventFile);
+    }
+    else if (eventType == GenericProcessor::MESSAGE && messageFile != nullptr)
+    {
+        String timestampText(timestamp);
+        fwrite(timestampText.toUTF8(), 1, timestampText.length(), messageFile);
+        fwrite(" ", 1, 1, messageFile);
+        fwrite(dataptr + 6, 1, event.getRawDataSize() - 6, messageFile);
+        fwrite("\n", 1, 1, messageFile);
+    }
+}
+
+void EventSpikeFiles::writeSpike(const SpikeObject& spike, int electrodeIndex)
+{
+    uint8_t spikeBuffer[MAX_SPIKE_BUFFER_LEN];
+
+    if (spikeFileArray[electrodeIndex] == nullptr)
+        return;
+
+    packSpike(&spike, spikeBuffer, MAX_SPIKE_BUFFER_LEN);
+
+    int totalBytes = spike.nSamples * spike.nChannels * 2 + // account for samples
+                     spike.nChannels * 4 +            // acount for gain
+                     spike.nChannels * 2 +            // account for thresholds
+                     SPIKE_METADATA_SIZE;             // 42, from SpikeObject.h
+
+    uint16 recNum = (uint16) recordingNumber;
+    fwrite(spikeBuffer, 1, totalBytes, spikeFileArray[electrodeIndex]);
+    fwrite(&recNum, 2, 1, spikeFileArray[electrodeIndex]);
+}
+
+void EventSpikeFiles::writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex)
+{
+    if (spikeFileArray[electrodeIndex] == nullptr)
+        return;
+
+    int packedSize = getPackedSpikeRecordSize(spike);
+
+    if (packedSize > spikeRecordBufferSize)
+    {
+        spikeRecordBuffer.malloc(packedSize);
+        spikeRecordBufferSize = packedSize;
+    }
+
+    packSpikeRecord(spike, spikeRecordBuffer, spikeRecordBufferSize);
+
+    int totalBytes = spike.nSamples * spike.nChannels * 2 + // account for samples
+                     spike.nChannels * 4 +            // acount for gain
+                     spike.nChannels * 2 +            // account for thresholds
+                     SPIKE_METADATA_SIZE;             // 42, from SpikeObject.h
+
+    uint16 recNum = (uint16) recordingNumber;
+    fwrite(spikeRecordBuffer, 1, totalBytes, spikeFileArray[electrodeIndex]);
+    fwrite(&recNum, 2, 1, spikeFileArray[electrodeIndex]);
+}
@@ -28,8 +28,10 @@
 #include "../Channel/Channel.h"
 #include "../GenericProcessor/GenericProcessor.h"
 #include "../Visualization/SpikeObject.h"
+#include "../Visualization/SpikeRecord.h"
 
 #include <map>
+#include <stdio.h>
 
 //Handy macros for setParameter
 #define boolParameter(i,v) if ((parameter.id == i) && (parameter.type == EngineParameter::BOOL)) \
@@ -50,6 +52,19 @@ struct SpikeRecordInfo
     int recordIndex;
 };
 
+/** A directory an engine writes continuous data to, as shown in the ControlPanel */
+struct RecordVolumeStatus
+{
+    File directory;
+    /** Written since the files were opened */
+    int64 bytesWritten;
+
+    // filled in by RecordNode::getVolumeStatus
+    double bytesPerSecond;
+    int64 bytesFree;
+    int64 totalBytes;
+};
+
 struct EngineParameter;
 class RecordNode;
 class RecordEngineManager;
@@ -123,6 +138,11 @@ public:
     */
     virtual void writeSpike(const SpikeObject& spike, int electrodeIndex) = 0;
 
+    /** Write a spike of any size to disk. By default it is passed to writeSpike
+    	as a SpikeObject, which keeps at most 4 channels of 80 samples
+    */
+    virtual void writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex);
+
     /** Called when a new acquisition starts, to clean all channel data
     	before registering the processors
     */
@@ -144,6 +164,11 @@ public:
     */
     virtual void directoryChanged();
 
+    /** Adds the directories the engine writes to, with the bytes written to
+    	each so far. Called from the message thread.
+    */
+    virtual void getVolumeStatus(Array<RecordVolumeStatus>& volumes);
+
 
     void registerManager(RecordEngineManager* engineManager);
     void configureEngine();
@@ -250,6 +275,63 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordEngineManager);
 };
 
+/**
+
+  Event, message and spike files in the record layouts of the Open Ephys
+  format, for engines that store continuous data in a format of their own.
+
+  TTL events go to events<suffix>.events, messages to
+  messages<suffix>.events and the spikes of every electrode to their own
+  .spikes file, all tagged with the recording number.
+
+  @see BinaryRecording
+
+*/
+
+class PLUGIN_API EventSpikeFiles
+{
+public:
+    EventSpikeFiles();
+    ~EventSpikeFiles();
+
+    /** Adds an electrode, with no file open; call from addSpikeElectrode() */
+    void addSpikeElectrode();
+
+    /** Forgets every electrode; call from resetChannels() */
+    void resetSpikeElectrodes();
+
+    int getNumSpikeElectrodes() const;
+
+    /** Opens the event and message files in basePath */
+    void openFiles(const String& basePath, const String& suffix, int recordingNumber);
+
+    /** Opens the spike file of an electrode */
+    void openSpikeFile(int electrodeIndex, const String& path);
+
+    void closeFiles();
+
+    /** Writes a TTL event or a message, which happened at timestamp */
+    void writeEvent(int eventType, const MidiMessage& event, int64 timestamp, int samplePosition);
+
+    void writeSpike(const SpikeObject& spike, int electrodeIndex);
+
+    /** Same record as writeSpike, for as many channels and samples as the spike has */
+    void writeSpikeRecord(const SpikeRecord& spike, int electrodeIndex);
+
+private:
+    Array<FILE*> spikeFileArray;
+    FILE* eventFile;
+    FILE* messageFile;
+
+    /** Spikes are packed here before writing; grows with the largest spike seen */
+    HeapBlock<uint8_t> spikeRecordBuffer;
+    int spikeRecordBufferSize;
+
+    int recordingNumber;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EventSpikeFiles);
+};
+
 template<class T>
 RecordEngine* engineFactory()
 {
@@ -58,6 +58,21 @@ RecordNode::RecordNode()
     hasRecorded = false;
     settingsNeeded = false;
 
+    lastVolumeTime = 0;
+
+    triggerChannel = -1;
+    triggerEdge = 1;
+    preTriggerSeconds = 0.0f;
+    postTriggerSeconds = 0.0f;
+    eventHead = 0;
+    eventCount = 0;
+    triggerClock = 0;
+    referenceRate = 0.0f;
+    windowOpen = false;
+    windowStarted = false;
+    windowStart = 0;
+    windowEnd = 0;
+
     // 128 inputs, 0 outputs
     setPlayConfigDetails(getNumInputs(),getNumOutputs(),44100.0,128);
 
@@ -416,6 +431,9 @@ bool RecordNode::disable()
 
     isProcessing = false;
 
+    // triggered recording has to be requested again for the next acquisition
+    setTriggeredRecording(-1, 1, 0.0f, 0.0f);
+
     return true;
 }
 
@@ -424,9 +442,84 @@ float RecordNode::getFreeSpace()
     return 1.0f - float(dataDirectory.getBytesFreeOnVolume())/float(dataDirectory.getVolumeTotalSize());
 }
 
+void RecordNode::getVolumeStatus(Array<RecordVolumeStatus>& volumes)
+{
+    volumes.clearQuick();
+
+    EVERY_ENGINE->getVolumeStatus(volumes);
+
+    if (volumes.size() == 0)
+    {
+        RecordVolumeStatus v;
+        v.directory = dataDirectory;
+        v.bytesWritten = 0;
+        volumes.add(v);
+    }
+
+    const double now = Time::getMillisecondCounterHiRes();
+    const double seconds = (now - lastVolumeTime) / 1000.0;
+
+    StringArray paths;
+    Array<int64> bytes;
+
+    for (int i = 0; i < volumes.size(); i++)
+    {
+        RecordVolumeStatus& v = volumes.getReference(i);
+        String path = v.directory.getFullPathName();
+
+        v.bytesFree = v.directory.getBytesFreeOnVolume();
+        v.totalBytes = v.directory.getVolumeTotalSize();
+
+        // a counter that went down belongs to files opened since the last call
+        int last = lastVolumePaths.indexOf(path);
+        if (last >= 0 && seconds > 0 && v.bytesWritten >= lastVolumeBytes[last])
+            v.bytesPerSecond = double(v.bytesWritten - lastVolumeBytes[last]) / seconds;
+        else
+            v.bytesPerSecond = 0;
+
+        paths.add(path);
+        bytes.add(v.bytesWritten);
+    }
+
+    lastVolumePaths = paths;
+    lastVolumeBytes = bytes;
+    lastVolumeTime = now;
+}
+
 
 void RecordNode::handleEvent(int eventType, MidiMessage& event, int samplePosition)
 {
+    if (triggerChannel >= 0)
+    {
+        const uint8* dataptr = event.getRawData();
+
+        // events are queued whether or not a window is open, so that the
+        // pre-trigger part of a window includes them
+        if (isWritableEvent(eventType) && *(dataptr+4) > 0)
+        {
+            if (eventCount == triggerEvents.size())
+            {
+                eventHead = (eventHead + 1) % triggerEvents.size();
+                eventCount--;
+            }
+
+            TriggerEvent& ev = triggerEvents.getReference((eventHead + eventCount) % triggerEvents.size());
+            ev.eventType = eventType;
+            ev.message = event;
+            ev.samplePosition = samplePosition;
+            ev.blockTimestamp = timestamps[event.getNoteNumber()];
+            ev.clock = triggerClock + samplePosition;
+            eventCount++;
+        }
+
+        if (eventType == TTL && *(dataptr+3) == triggerChannel)
+        {
+            handleTriggerEdge(*(dataptr+2) == triggerEdge, samplePosition);
+        }
+
+        return;
+    }
+
     if (isRecording && allFilesOpened)
     {
         if (isWritableEvent(eventType))
@@ -449,7 +542,14 @@ void RecordNode::process(AudioSampleBuffer& buffer,
 	// FIRST: cycle through events -- extract the TTLs and the timestamps
     checkForEvents(events);
 
-    if (isRecording && allFilesOpened)
+    if (triggerChannel >= 0)
+    {
+        processTriggeredBlock(buffer);
+
+        if (isRecording)
+            return;
+    }
+    else if (isRecording && allFilesOpened)
     {
         // SECOND: write channel data
         if (channelPointers.size() > 0)
@@ -503,9 +603,21 @@ int RecordNode::addSpikeElectrode(SpikeRecordInfo* elec)
 
 void RecordNode::writeSpike(SpikeObject& spike, int electrodeIndex)
 {
+    // spikes aren't kept in memory, so triggered recordings only get those inside the window
+    if (triggerChannel >= 0 && !windowOpen)
+        return;
+
     EVERY_ENGINE->writeSpike(spike,electrodeIndex);
 }
 
+void RecordNode::writeSpike(const SpikeRecord& spike, int electrodeIndex)
+{
+    if (triggerChannel >= 0 && !windowOpen)
+        return;
+
+    EVERY_ENGINE->writeSpikeRecord(spike,electrodeIndex);
+}
+
 SpikeRecordInfo* RecordNode::getSpikeElectrode(int index)
 {
     return spikeElectrodePointers[index];
@@ -515,3 +627,255 @@ void RecordNode::clearRecordEngines()
 {
     engineArray.clear();
 }
+
+void RecordNode::setTriggeredRecording(int eventChannel, int edge, float preSeconds, float postSeconds)
+{
+    triggerSources.clear();
+    triggerEvents.clear();
+    eventHead = 0;
+    eventCount = 0;
+    triggerClock = 0;
+    windowOpen = false;
+    triggerChannel = -1;
+
+    if (eventChannel < 0)
+        return;
+
+    preTriggerSeconds = jmax(0.0f, preSeconds);
+    postTriggerSeconds = jmax(0.0f, postSeconds);
+    triggerEdge = edge;
+
+    // one ring per source processor, since each has its own sample count and timestamps
+    int maxCapacity = 1;
+
+    for (int i = 0; i < channelPointers.size(); i++)
+    {
+        Channel* ch = channelPointers[i];
+        TriggerSource* source = nullptr;
+
+        for (int s = 0; s < triggerSources.size(); s++)
+        {
+            if (triggerSources[s]->nodeId == ch->sourceNodeId)
+                source = triggerSources[s];
+        }
+
+        if (source == nullptr)
+        {
+            source = new TriggerSource();
+            source->nodeId = ch->sourceNodeId;
+            source->sampleRate = ch->sampleRate;
+            source->writeIndex = 0;
+            source->numStored = 0;
+            source->endTimestamp = 0;
+            source->nextTimestamp = 0;
+            triggerSources.add(source);
+        }
+
+        source->channels.add(i);
+    }
+
+    for (int s = 0; s < triggerSources.size(); s++)
+    {
+        TriggerSource* source = triggerSources[s];
+        int capacity = int(std::ceil(preTriggerSeconds * source->sampleRate)) + MAX_TRIGGER_BLOCK;
+
+        source->ring.setSize(source->channels.size(), capacity);
+        source->ring.clear();
+        maxCapacity = jmax(maxCapacity, capacity);
+    }
+
+    triggerBuffer.setSize(jmax(1, channelPointers.size()), maxCapacity);
+    triggerBuffer.clear();
+
+    triggerEvents.resize(TRIGGER_EVENT_CAPACITY);
+
+    referenceRate = (triggerSources.size() > 0) ? triggerSources[0]->sampleRate : getSampleRate();
+    triggerChannel = eventChannel;
+
+    std::cout << "Triggered recording on event channel " << eventChannel + 1 << ", "
+              << preTriggerSeconds << " s before and "
+              << (postTriggerSeconds > 0 ? String(postTriggerSeconds) + " s after the trigger" : String("until the closing edge"))
+              << std::endl;
+}
+
+bool RecordNode::isTriggerWindowOpen()
+{
+    return windowOpen;
+}
+
+void RecordNode::handleTriggerEdge(bool opening, int samplePosition)
+{
+    int64 clock = triggerClock + samplePosition;
+
+    if (opening)
+    {
+        // edges inside an open window don't restart it
+        if (!windowOpen && isRecording && allFilesOpened)
+        {
+            windowOpen = true;
+            windowStarted = false;
+            windowStart = clock - int64(preTriggerSeconds * referenceRate);
+            windowEnd = (postTriggerSeconds > 0) ? clock + int64(postTriggerSeconds * referenceRate)
+                        : std::numeric_limits<int64>::max();
+        }
+    }
+    else if (windowOpen && postTriggerSeconds <= 0 && windowEnd == std::numeric_limits<int64>::max())
+    {
+        windowEnd = jmax(windowStart, clock);
+    }
+}
+
+int64 RecordNode::getSourceTimestamp(const TriggerSource* source, int64 clock, int64 blockEnd)
+{
+    double samplesBack = double(blockEnd - clock) * source->sampleRate / referenceRate;
+
+    int64 ts = source->endTimestamp - int64(std::floor(samplesBack + 0.5));
+
+    return jlimit(source->endTimestamp - source->numStored, source->endTimestamp, ts);
+}
+
+void RecordNode::writeTriggerEvents(int64 clock)
+{
+    bool written = false;
+
+    while (eventCount > 0)
+    {
+        TriggerEvent& ev = triggerEvents.getReference(eventHead);
+
+        if (ev.clock >= clock)
+            break;
+
+        if (windowOpen && ev.clock >= windowStart)
+        {
+            triggerTimestamps[ev.message.getNoteNumber()] = ev.blockTimestamp;
+            EVERY_ENGINE->updateTimestamps(&triggerTimestamps);
+            EVERY_ENGINE->writeEvent(ev.eventType, ev.message, ev.samplePosition);
+            written = true;
+        }
+
+        eventHead = (eventHead + 1) % triggerEvents.size();
+        eventCount--;
+    }
+
+    if (written)
+        EVERY_ENGINE->updateTimestamps(&timestamps);
+}
+
+void RecordNode::processTriggeredBlock(AudioSampleBuffer& buffer)
+{
+    int64 blockEnd = triggerClock;
+
+    // FIRST: keep the block
+    for (int s = 0; s < triggerSources.size(); s++)
+    {
+        TriggerSource* source = triggerSources[s];
+        int nSamples = jmin(numSamples[source->nodeId], source->ring.getNumSamples());
+        int capacity = source->ring.getNumSamples();
+
+        for (int c = 0; c < source->channels.size(); c++)
+        {
+            int chan = source->channels[c];
+
+            if (chan >= buffer.getNumChannels())
+                continue;
+
+            int firstPart = jmin(nSamples, capacity - source->writeIndex);
+            source->ring.copyFrom(c, source->writeIndex, buffer, chan, 0, firstPart);
+
+            if (firstPart < nSamples)
+                source->ring.copyFrom(c, 0, buffer, chan, firstPart, nSamples - firstPart);
+        }
+
+        source->writeIndex = (source->writeIndex + nSamples) % capacity;
+        source->numStored = jmin(capacity, source->numStored + nSamples);
+        source->endTimestamp = timestamps[source->nodeId] + numSamples[source->nodeId];
+
+        if (s == 0)
+            blockEnd = triggerClock + numSamples[source->nodeId];
+    }
+
+    // recording stopped in the middle of a window
+    if (windowOpen && !(isRecording && allFilesOpened))
+        windowOpen = false;
+
+    if (!windowOpen)
+    {
+        writeTriggerEvents(blockEnd - int64(preTriggerSeconds * referenceRate));
+        triggerClock = blockEnd;
+        return;
+    }
+
+    const int64 windowStop = jmin(windowEnd, blockEnd);
+
+    // SECOND: events come before the data, as when recording continuously;
+    // the closing edge itself is kept
+    writeTriggerEvents(windowEnd <= blockEnd ? windowStop + 1 : windowStop);
+
+    // THIRD: continuous data, straight from the buffer when the whole block is in the window
+    bool wholeBlock = windowStarted;
+
+    for (int s = 0; s < triggerSources.size(); s++)
+    {
+        TriggerSource* source = triggerSources[s];
+
+        if (!windowStarted)
+            source->nextTimestamp = getSourceTimestamp(source, windowStart, blockEnd);
+
+        source->nextTimestamp = jmax(source->nextTimestamp, source->endTimestamp - source->numStored);
+
+        int64 last = (windowEnd <= blockEnd) ? getSourceTimestamp(source, windowEnd, blockEnd)
+                     : source->endTimestamp;
+        int nSamples = int(jmax(int64(0), last - source->nextTimestamp));
+
+        if (source->nextTimestamp != timestamps[source->nodeId] || nSamples != numSamples[source->nodeId])
+            wholeBlock = false;
+
+        triggerNumSamples[source->nodeId] = nSamples;
+        triggerTimestamps[source->nodeId] = source->nextTimestamp;
+    }
+
+    if (channelPointers.size() > 0)
+    {
+        if (wholeBlock)
+        {
+            EVERY_ENGINE->writeData(buffer);
+        }
+        else
+        {
+            for (int s = 0; s < triggerSources.size(); s++)
+            {
+                TriggerSource* source = triggerSources[s];
+                int nSamples = triggerNumSamples[source->nodeId];
+                int capacity = source->ring.getNumSamples();
+                int start = (source->writeIndex - int(source->endTimestamp - source->nextTimestamp) + capacity) % capacity;
+                int firstPart = jmin(nSamples, capacity - start);
+
+                for (int c = 0; c < source->channels.size(); c++)
+                {
+                    int chan = source->channels[c];
+
+                    triggerBuffer.copyFrom(chan, 0, source->ring, c, start, firstPart);
+
+                    if (firstPart < nSamples)
+                        triggerBuffer.copyFrom(chan, firstPart, source->ring, c, 0, nSamples - firstPart);
+                }
+            }
+
+            EVERY_ENGINE->updateTimestamps(&triggerTimestamps);
+            EVERY_ENGINE->updateNumSamples(&triggerNumSamples);
+            EVERY_ENGINE->writeData(triggerBuffer);
+            EVERY_ENGINE->updateTimestamps(&timestamps);
+            EVERY_ENGINE->updateNumSamples(&numSamples);
+        }
+    }
+
+    for (int s = 0; s < triggerSources.size(); s++)
+        triggerSources[s]->nextTimestamp += triggerNumSamples[triggerSources[s]->nodeId];
+
+    windowStarted = true;
+
+    if (windowEnd <= blockEnd)
+        windowOpen = false;
+
+    triggerClock = blockEnd;
+}
@@ -35,8 +35,14 @@
 #define HEADER_SIZE 1024
 #define BLOCK_LENGTH 1024
 
+// largest block expected from a source, on top of the pre-trigger samples kept
+#define MAX_TRIGGER_BLOCK 8192
+#define TRIGGER_EVENT_CAPACITY 512
+
 struct SpikeRecordInfo;
 struct SpikeObject;
+struct SpikeRecord;
+struct RecordVolumeStatus;
 class RecordEngine;
 
 /**
@@ -46,6 +52,11 @@ class RecordEngine;
 
   Receives a signal from the ControlPanel to begin recording.
 
+  In triggered mode, recording only arms the node: data is written in windows
+  that open on an edge of a TTL channel, starting a configurable time before
+  the edge. The node keeps that much of every channel and of the events in
+  memory, and writes the window from the audio thread at the sample of the edge.
+
   @see GenericProcessor, ControlPanel
 
 */
@@ -104,6 +115,12 @@ public:
     */
     float getFreeSpace();
 
+    /** Called by the ControlPanel for the write rate and free space of every
+        directory the engines are writing to, or of the dataDirectory if
+        they don't report any. Message thread only.
+    */
+    void getVolumeStatus(Array<RecordVolumeStatus>& volumes);
+
     /** Selects a channel relative to a particular processor with ID = id
     */
     void setChannel(Channel* ch);
@@ -158,8 +175,25 @@ public:
     */
     void writeSpike(SpikeObject& spike, int electrodeIndex);
 
+    /** Called by a spike recording source to write a spike of any size to file
+    */
+    void writeSpike(const SpikeRecord& spike, int electrodeIndex);
+
     SpikeRecordInfo* getSpikeElectrode(int index);
 
+    /** Switches to triggered recording for the current acquisition.
+
+        Windows open on the given edge (1 = rising, 0 = falling) of eventChannel
+        and start preTriggerSeconds before it. They close postTriggerSeconds after
+        it, or on the opposite edge if postTriggerSeconds is 0. A negative channel
+        turns triggered recording off. Must be called before acquisition starts;
+        it is turned off again when acquisition stops.
+    */
+    void setTriggeredRecording(int eventChannel, int edge, float preTriggerSeconds, float postTriggerSeconds);
+
+    /** Returns true while a triggered recording window is being written */
+    bool isTriggerWindowOpen();
+
     /** Signals when to create a new data directory when recording starts.*/
     bool newDirectoryNeeded;
 
@@ -196,6 +230,11 @@ private:
     */
     Time timer;
 
+    /** Previous getVolumeStatus counters, for the write rates */
+    StringArray lastVolumePaths;
+    Array<int64> lastVolumeBytes;
+    double lastVolumeTime;
+
     /** Closes all open files after recording has finished.
     */
     void closeAllFiles();
@@ -248,6 +287,67 @@ private:
     /**RecordEngines loaded**/
     OwnedArray<RecordEngine> engineArray;
 
+    /** Recent data of the channels of one source processor, for triggered recording */
+    struct TriggerSource
+    {
+        int nodeId;
+        float sampleRate;
+        Array<int> channels;
+
+        AudioSampleBuffer ring;
+        int writeIndex;
+        int numStored;
+
+        /** Timestamp following the newest stored sample */
+        int64 endTimestamp;
+        /** First timestamp not yet written in the open window */
+        int64 nextTimestamp;
+    };
+
+    struct TriggerEvent
+    {
+        int eventType;
+        MidiMessage message;
+        int samplePosition;
+        int64 blockTimestamp;
+        int64 clock;
+    };
+
+    /** Stores the current block and writes the part of it inside a window */
+    void processTriggeredBlock(AudioSampleBuffer& buffer);
+
+    void handleTriggerEdge(bool opening, int samplePosition);
+
+    /** Writes the queued events up to clock, dropping those before the window */
+    void writeTriggerEvents(int64 clock);
+
+    /** Timestamp of a source at a position of the reference clock inside the stored data */
+    int64 getSourceTimestamp(const TriggerSource* source, int64 clock, int64 blockEnd);
+
+    int triggerChannel;
+    int triggerEdge;
+    float preTriggerSeconds;
+    float postTriggerSeconds;
+
+    OwnedArray<TriggerSource> triggerSources;
+    Array<TriggerEvent> triggerEvents;
+    int eventHead;
+    int eventCount;
+
+    /** Scratch buffer and sample counts handed to the engines when writing stored data */
+    AudioSampleBuffer triggerBuffer;
+    std::map<uint8, int> triggerNumSamples;
+    std::map<uint8, int64> triggerTimestamps;
+
+    /** Samples of the first source since acquisition started; windows are placed on this clock */
+    int64 triggerClock;
+    float referenceRate;
+
+    bool windowOpen;
+    bool windowStarted;
+    int64 windowStart;
+    int64 windowEnd;
+
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordNode);
 
@@ -28,12 +28,10 @@
 
 ResamplingNode::ResamplingNode()
     : GenericProcessor("Resampler"),
-      targetSampleRate(5000.0f), ratio(1.0)
+      targetSampleRate(5000.0f), sourceBufferSampleRate(30000.0),
+      inputSourceId(0), mixedSources(false), outputTimestamp(-1)
 {
 
-    filter = new Dsp::SmoothedFilterDesign
-    <Dsp::RBJ::Design::LowPass, 1> (1024);
-
     parameters.add(Parameter("Hz",500.0f, 10000.0f, targetSampleRate, 0, true));
 
     tempBuffer = new AudioSampleBuffer(16, TEMP_BUFFER_WIDTH);
@@ -42,7 +40,6 @@ ResamplingNode::ResamplingNode()
 
 ResamplingNode::~ResamplingNode()
 {
-    filter = 0;
 }
 
 AudioProcessorEditor* ResamplingNode::createEditor()
@@ -60,21 +57,24 @@ void ResamplingNode::setParameter(int parameterIndex, float newValue)
 
     if (parameterIndex == 0)
     {
+        if (newValue == targetSampleRate)
+            return;
+
+        // the resampler's filters are in use on the audio thread
+        if (CoreServices::getAcquisitionStatus())
+        {
+            CoreServices::sendStatusMessage("The Resampler's rate can't change during acquisition.");
+            return;
+        }
+
         Parameter& p =  parameters.getReference(parameterIndex);
         p.setValue(newValue, 0);
 
         targetSampleRate = newValue;
 
-        settings.sampleRate = targetSampleRate;
-
-        ratio = sourceBufferSampleRate / targetSampleRate;
-
-        for (int i = 0; i < channels.size(); i++)
-        {
-            channels[i]->sampleRate = targetSampleRate;
-        }
-
-        updateFilter();
+        // updateSettings() redesigns the filter, and the channels further
+        // down learn about the new rate
+        CoreServices::updateSignalChain(getEditor());
 
         //std::cout << "Got parameter update." << std::endl;
     }
@@ -83,14 +83,26 @@ void ResamplingNode::setParameter(int parameterIndex, float newValue)
 
 }
 
-bool ResamplingNode::enable()
+bool ResamplingNode::isReady()
 {
+    if (mixedSources)
+    {
+        CoreServices::sendStatusMessage("Resampler inputs must all come from the same source.");
+        return false;
+    }
 
+    return true;
+}
+
+bool ResamplingNode::enable()
+{
 
     tempBuffer->clear();
 
     updateFilter();
 
+    outputTimestamp = -1;
+
     return true;
 
 }
@@ -98,17 +110,28 @@ bool ResamplingNode::enable()
 void ResamplingNode::updateSettings()
 {
 
+    mixedSources = false;
     sourceBufferSampleRate = settings.sampleRate;
+
+    if (channels.size() > 0)
+    {
+        inputSourceId = channels[0]->sourceNodeId;
+        sourceBufferSampleRate = channels[0]->sampleRate;
+    }
+
     settings.sampleRate = targetSampleRate;
 
     if (getNumInputs() > 0)
         tempBuffer->setSize(getNumInputs(), TEMP_BUFFER_WIDTH);
 
-    ratio = sourceBufferSampleRate / targetSampleRate;
-
+    // the output channels come from this processor now
     for (int i = 0; i < channels.size(); i++)
     {
+        if (channels[i]->sourceNodeId != inputSourceId)
+            mixedSources = true;
+
         channels[i]->sampleRate = targetSampleRate;
+        channels[i]->sourceNodeId = nodeId;
     }
 
     updateFilter();
@@ -119,18 +142,7 @@ void ResamplingNode::updateSettings()
 void ResamplingNode::updateFilter()
 {
 
-    double cutoffFreq = (ratio > 1.0) ? 2 * targetSampleRate  // downsample
-                        : targetSampleRate / 2; // upsample
-
-    double sampleFreq = (ratio > 1.0) ? sourceBufferSampleRate // downsample
-                        : targetSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filter->setParams(params);
+    resampler.prepare(jmax(1, channels.size()), sourceBufferSampleRate, targetSampleRate);
 
 }
 
@@ -143,93 +155,39 @@ void ResamplingNode::process(AudioSampleBuffer& buffer,
                              MidiBuffer& midiMessages)
 {
 
-    //std::cout << "Resampling node sample count: " << nSamples << std::endl; ///buffer.getNumSamples() << std::endl;
+    const int numChannels = resampler.getNumChannels();
 
-    // save data at the beginning of each round of processing
-    //writeContinuousBuffer(buffer.getSampleData(0), nSamples, 0);
+    if (channels.size() == 0
+        || numChannels > buffer.getNumChannels()
+        || numChannels > tempBuffer->getNumChannels())
+        return;
 
-    int nSamples = 100; // SOME NUMBER
+    const int nSamples = numSamples[inputSourceId];
 
-    int nSamps = float(nSamples);
-    int valuesNeeded = int(nSamps / ratio);
-
-    if (ratio > 1.0001)
+    if (outputTimestamp < 0)
     {
-        // pre-apply filter before downsampling
-        filter->process(nSamples, buffer.getArrayOfWritePointers());
+        // the first output sample lines up with the first input sample
+        outputTimestamp = timestamps[inputSourceId] * resampler.getUpFactor() / resampler.getDownFactor();
     }
 
-    // initialize variables
-    tempBuffer->clear();
-    int sourceBufferPos = 0;
-    int sourceBufferSize = buffer.getNumSamples();
-    float subSampleOffset = 0.0;
-    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
+    int valuesNeeded = resampler.getNumOutputSamples(nSamples);
 
-    int tempBufferPos;
+    if (valuesNeeded > tempBuffer->getNumSamples())
+        tempBuffer->setSize(tempBuffer->getNumChannels(), valuesNeeded, false, false, true);
 
-    // code modified from "juce_ResamplingAudioSource.cpp":
+    resampler.process(buffer.getArrayOfReadPointers(), nSamples, tempBuffer->getArrayOfWritePointers());
 
-    for (tempBufferPos = 0; tempBufferPos < valuesNeeded; tempBufferPos++)
-    {
-        float gain = 1.0;
-        float alpha = (float) subSampleOffset;
-        float invAlpha = 1.0f - alpha;
-
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-        {
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,  // destSampleOffset
-                                buffer,			// source
-                                channel,		// sourceChannel
-                                sourceBufferPos,// sourceSampleOffset
-                                1,				// number of samples
-                                invAlpha*gain);      // gain to apply to source
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,   // destSampleOffset
-                                buffer,			// source
-                                channel,			// sourceChannel
-                                nextPos,		 	// sourceSampleOffset
-                                1,				// number of samples
-                                alpha*gain);     	 // gain to apply to source
-
-        }
-
-        subSampleOffset += ratio;
-
-        while (subSampleOffset >= 1.0)
-        {
-            if (++sourceBufferPos >= sourceBufferSize)
-                sourceBufferPos = 0;
+    // anything that doesn't fit in the buffer when upsampling is lost
+    jassert(valuesNeeded <= buffer.getNumSamples());
+    valuesNeeded = jmin(valuesNeeded, buffer.getNumSamples());
 
-            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-            subSampleOffset -= 1.0;
-        }
-    }
-
-    // std::cout << sourceBufferPos << " " << tempBufferPos << std::endl;
-
-
-    if (ratio < 0.9999)
-    {
-
-        filter->process(tempBufferPos, tempBuffer->getArrayOfWritePointers());
-        // apply the filter after upsampling
-        ///////filter->process (totalSamples, buffer.getArrayOfChannels());
-    }
-    else if (ratio <= 1.0001)
-    {
-
-        // no resampling is being applied, no need to filter, BUT...
-        // keep the filter stoked with samples to avoid discontinuities
-
-    }
+    for (int c = 0; c < numChannels; c++)
+        buffer.copyFrom(c, 0, *tempBuffer, c, 0, valuesNeeded);
 
-    // copy the tempBuffer back into the original buffer
-    buffer = AudioSampleBuffer(tempBuffer->getArrayOfWritePointers(), 2, tempBufferPos);//buffer.getNumSamples());
+    setNumSamples(midiMessages, valuesNeeded);
+    numSamples[nodeId] = valuesNeeded;
 
-    nSamples = valuesNeeded;
+    setTimestamp(midiMessages, outputTimestamp, acquisitionTicks[inputSourceId]);
+    outputTimestamp += valuesNeeded;
 
 }
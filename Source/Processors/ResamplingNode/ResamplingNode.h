@@ -26,7 +26,7 @@
 
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
-#include "../Dsp/Dsp.h"
+#include "../AudioNode/PolyphaseResampler.h"
 #include "../GenericProcessor/GenericProcessor.h"
 
 #define TEMP_BUFFER_WIDTH 5000
@@ -35,9 +35,11 @@
 
   Changes the sample rate of continuous data.
 
-  Code is based on Juce's ResamplingAudioSource class.
+  All channels are converted together by a PolyphaseResampler. The output
+  channels become a new stream with their own sample counts and timestamps,
+  so every input channel has to come from the same source.
 
-  @see GenericProcessor
+  @see GenericProcessor, PolyphaseResampler
 
 */
 
@@ -55,10 +57,19 @@ public:
 
     void updateSettings();
 
+    /** Prepares the resampler for the current rates and number of channels. */
     void updateFilter();
 
     bool enable();
 
+    bool isReady();
+
+    /** The output channels are a new stream with its own timestamps */
+    bool generatesTimestamps()
+    {
+        return true;
+    }
+
     AudioProcessorEditor* createEditor();
     bool hasEditor() const
     {
@@ -67,24 +78,18 @@ public:
 
 private:
 
-    // sample rate, timebase, and ratio info:
+    // sample rate info:
     double targetSampleRate;
-    double sourceBufferSampleRate; //, destBufferSampleRate;
-    double ratio; //, lastRatio;
-    //double destBufferTimebaseSecs;
-    //int destBufferWidth;
-
-    // major objects:
-    Dsp::Filter* filter;
-    //ScopedPointer<AudioSampleBuffer> destBuffer;
-    ScopedPointer<AudioSampleBuffer> tempBuffer;
+    double sourceBufferSampleRate;
 
-    // is the destBuffer a temp buffer or not?
-    //bool destBufferIsTempBuffer;
-    //bool isTransmitting;
+    int inputSourceId;
+    bool mixedSources;
+
+    PolyphaseResampler resampler;
+    ScopedPointer<AudioSampleBuffer> tempBuffer;
 
-    // indexing objects that persist between rounds:
-    //int destBufferPos;
+    /** Timestamp of the next output sample; negative until the first block */
+    int64 outputTimestamp;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResamplingNode);
 
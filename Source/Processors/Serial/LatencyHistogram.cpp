@@ -0,0 +1,118 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram(double binWidthMs, int numBins)
+    : binWidth(binWidthMs)
+{
+    bins.insertMultiple(0, 0, numBins + 1);
+    reset();
+}
+
+void LatencyHistogram::add(double latencyMs)
+{
+    int bin = jlimit(0, bins.size() - 1, int(latencyMs / binWidth));
+    bins.set(bin, bins[bin] + 1);
+
+    minimum = (count == 0) ? latencyMs : jmin(minimum, latencyMs);
+    maximum = (count == 0) ? latencyMs : jmax(maximum, latencyMs);
+    total += latencyMs;
+    count++;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < bins.size(); i++)
+        bins.set(i, 0);
+
+    count = 0;
+    total = 0;
+    minimum = 0;
+    maximum = 0;
+}
+
+int LatencyHistogram::getCount() const
+{
+    return count;
+}
+
+double LatencyHistogram::getMean() const
+{
+    return count > 0 ? total / count : 0.0;
+}
+
+double LatencyHistogram::getMin() const
+{
+    return minimum;
+}
+
+double LatencyHistogram::getMax() const
+{
+    return maximum;
+}
+
+double LatencyHistogram::getPercentile(double percentile) const
+{
+    if (count == 0)
+        return 0.0;
+
+    int target = jmax(1, roundToInt(count * percentile / 100.0));
+    int cumulative = 0;
+
+    for (int i = 0; i < bins.size() - 1; i++)
+    {
+        cumulative += bins[i];
+        if (cumulative >= target)
+            return jmin(maximum, (i + 1) * binWidth);
+    }
+
+    // the percentile falls in the overflow bin
+    return maximum;
+}
+
+double LatencyHistogram::getBinWidth() const
+{
+    return binWidth;
+}
+
+int LatencyHistogram::getNumBins() const
+{
+    return bins.size() - 1;
+}
+
+int LatencyHistogram::getBinCount(int bin) const
+{
+    return bins[bin];
+}
+
+String LatencyHistogram::getSummary() const
+{
+    if (count == 0)
+        return "no samples";
+
+    return String(count) + " samples, mean " + String(getMean(), 3)
+           + " ms, median " + String(getPercentile(50), 3)
+           + " ms, 99% " + String(getPercentile(99), 3)
+           + " ms, max " + String(maximum, 3) + " ms";
+}
@@ -0,0 +1,76 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __LATENCYHISTOGRAM_H__
+#define __LATENCYHISTOGRAM_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+
+/**
+
+  Fixed-width histogram of latencies in milliseconds.
+
+  Adding a value never allocates, so it can be updated from real-time
+  threads. Values beyond the last bin are counted in an overflow bin.
+
+  @see OutputDispatcher
+
+*/
+
+class PLUGIN_API LatencyHistogram
+{
+public:
+    LatencyHistogram(double binWidthMs = 0.25, int numBins = 400);
+
+    void add(double latencyMs);
+    void reset();
+
+    int getCount() const;
+    double getMean() const;
+    double getMin() const;
+    double getMax() const;
+
+    /** Returns the upper edge of the bin holding the given percentile (0-100) */
+    double getPercentile(double percentile) const;
+
+    double getBinWidth() const;
+    int getNumBins() const;
+
+    /** Number of values in a bin; bin getNumBins() holds the overflow */
+    int getBinCount(int bin) const;
+
+    /** One-line summary: count, mean, median, 99th percentile and maximum */
+    String getSummary() const;
+
+private:
+    double binWidth;
+    Array<int> bins;
+
+    int count;
+    double total;
+    double minimum;
+    double maximum;
+};
+
+#endif  // __LATENCYHISTOGRAM_H__
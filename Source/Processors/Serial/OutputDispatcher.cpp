@@ -0,0 +1,236 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "OutputDispatcher.h"
+
+// upper bound of the I/O thread sleep, in ms; the audio thread doesn't
+// wake the I/O thread, so this is also the longest a new command waits
+#define FIFO_POLL_INTERVAL 1
+
+OutputDispatcher::OutputDispatcher(const String& name, OutputDevice* d, int queueSize)
+    : Thread(name), device(d), fifo(queueSize), numSent(0), totalLatencyMs(0),
+      lastLatencyMs(0), maxLatencyMs(0)
+{
+    queue.malloc(queueSize);
+    pending.ensureStorageAllocated(queueSize);
+}
+
+OutputDispatcher::~OutputDispatcher()
+{
+    stop(false);
+}
+
+void OutputDispatcher::start()
+{
+    if (! isThreadRunning())
+        startThread(8);
+}
+
+void OutputDispatcher::stop(bool flush)
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+
+    collectCommands();
+
+    if (flush)
+        sendReadyCommands(true);
+
+    pending.clearQuick();
+}
+
+OutputCommand OutputDispatcher::createCommand(int channel, int value, double delayMs, int64 acquisitionTicks) const
+{
+    OutputCommand command;
+    command.channel = channel;
+    command.value = value;
+    command.queuedTicks = Time::getHighResolutionTicks();
+    command.dueTicks = command.queuedTicks + Time::secondsToHighResolutionTicks(delayMs / 1000.0);
+    command.acquisitionTicks = acquisitionTicks;
+    return command;
+}
+
+bool OutputDispatcher::addCommand(int channel, int value, double delayMs, int64 acquisitionTicks)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+    {
+        ++numDropped;
+        return false;
+    }
+
+    queue[size1 > 0 ? start1 : start2] = createCommand(channel, value, delayMs, acquisitionTicks);
+    fifo.finishedWrite(1);
+
+    // no notify(): signalling the thread takes a lock, and the I/O thread
+    // polls the FIFO every FIFO_POLL_INTERVAL ms anyway
+    return true;
+}
+
+void OutputDispatcher::addControlCommand(int channel, int value, double delayMs)
+{
+    OutputCommand command = createCommand(channel, value, delayMs, 0);
+
+    if (! isThreadRunning())
+    {
+        device->sendCommands(&command, 1);
+        return;
+    }
+
+    {
+        const ScopedLock sl(controlLock);
+        controlQueue.add(command);
+    }
+    notify();
+}
+
+void OutputDispatcher::insertPending(const OutputCommand& command)
+{
+    // keep commands that are due at the same time in the order they were queued
+    int index = pending.size();
+    while (index > 0 && pending.getReference(index - 1).dueTicks > command.dueTicks)
+        index--;
+
+    pending.insert(index, command);
+}
+
+void OutputDispatcher::collectCommands()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; i++)
+        insertPending(queue[start1 + i]);
+    for (int i = 0; i < size2; i++)
+        insertPending(queue[start2 + i]);
+
+    fifo.finishedRead(size1 + size2);
+
+    const ScopedLock sl(controlLock);
+    for (int i = 0; i < controlQueue.size(); i++)
+        insertPending(controlQueue.getReference(i));
+    controlQueue.clearQuick();
+}
+
+void OutputDispatcher::sendReadyCommands(bool sendAll)
+{
+    int64 now = Time::getHighResolutionTicks();
+
+    int numReady = 0;
+    while (numReady < pending.size() && (sendAll || pending.getReference(numReady).dueTicks <= now))
+        numReady++;
+
+    if (numReady == 0)
+        return;
+
+    device->sendCommands(pending.getRawDataPointer(), numReady);
+
+    int64 sentTicks = Time::getHighResolutionTicks();
+
+    {
+        const ScopedLock sl(statsLock);
+        for (int i = 0; i < numReady; i++)
+        {
+            const OutputCommand& command = pending.getReference(i);
+
+            double latencyMs = 1000.0 * Time::highResolutionTicksToSeconds(sentTicks - command.dueTicks);
+            lastLatencyMs = latencyMs;
+            totalLatencyMs += latencyMs;
+            maxLatencyMs = jmax(maxLatencyMs, latencyMs);
+            numSent++;
+
+            if (command.acquisitionTicks > 0)
+                endToEndLatency.add(1000.0 * Time::highResolutionTicksToSeconds(sentTicks - command.acquisitionTicks));
+        }
+    }
+
+    pending.removeRange(0, numReady);
+}
+
+void OutputDispatcher::run()
+{
+    while (! threadShouldExit())
+    {
+        collectCommands();
+        sendReadyCommands(false);
+
+        // sleep until the next delayed command is due, or until the next poll of the FIFO
+        int waitMs = FIFO_POLL_INTERVAL;
+        if (pending.size() > 0)
+        {
+            double secondsToNext = Time::highResolutionTicksToSeconds(pending.getReference(0).dueTicks - Time::getHighResolutionTicks());
+            waitMs = jlimit(0, FIFO_POLL_INTERVAL, roundToInt(secondsToNext * 1000.0));
+        }
+
+        if (waitMs > 0)
+            wait(waitMs);
+    }
+}
+
+OutputDispatcher::LatencyStats OutputDispatcher::getLatencyStats() const
+{
+    const ScopedLock sl(statsLock);
+
+    LatencyStats stats;
+    stats.numSent = numSent;
+    stats.numDropped = numDropped.get();
+    stats.lastMs = lastLatencyMs;
+    stats.meanMs = numSent > 0 ? totalLatencyMs / numSent : 0.0;
+    stats.maxMs = maxLatencyMs;
+    return stats;
+}
+
+LatencyHistogram OutputDispatcher::getEndToEndLatency() const
+{
+    const ScopedLock sl(statsLock);
+    return endToEndLatency;
+}
+
+void OutputDispatcher::resetLatencyStats()
+{
+    const ScopedLock sl(statsLock);
+    numSent = 0;
+    totalLatencyMs = 0;
+    lastLatencyMs = 0;
+    maxLatencyMs = 0;
+    numDropped.set(0);
+    endToEndLatency.reset();
+}
+
+String OutputDispatcher::getLatencyReport() const
+{
+    LatencyStats stats = getLatencyStats();
+
+    String report = String(stats.numSent) + " commands sent, " + String(stats.numDropped)
+                    + " dropped, send delay mean " + String(stats.meanMs, 3)
+                    + " ms, max " + String(stats.maxMs, 3) + " ms";
+
+    LatencyHistogram endToEnd = getEndToEndLatency();
+    if (endToEnd.getCount() > 0)
+        report << "; end-to-end latency " << endToEnd.getSummary();
+
+    return report;
+}
@@ -0,0 +1,155 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __OUTPUTDISPATCHER_H__
+#define __OUTPUTDISPATCHER_H__
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+#include "LatencyHistogram.h"
+
+/** A command for an output device, such as setting a digital line or firing a trigger.
+    The meaning of channel and value is up to the device. */
+struct OutputCommand
+{
+    int channel;
+    int value;
+    /** High resolution ticks at which the command was queued */
+    int64 queuedTicks;
+    /** High resolution ticks at which the command should be sent */
+    int64 dueTicks;
+    /** High resolution ticks at which the data that triggered the command
+        was acquired, or 0 if unknown */
+    int64 acquisitionTicks;
+};
+
+/**
+
+  Target of an OutputDispatcher. Wraps the blocking calls of a piece of
+  hardware (a serial stimulator, a board output line, ...).
+
+  @see OutputDispatcher
+
+*/
+
+class PLUGIN_API OutputDevice
+{
+public:
+    virtual ~OutputDevice() {}
+
+    /** Sends every command that is due, in order. Called on the dispatcher
+        thread while it is running, so implementations can merge commands
+        into fewer writes. */
+    virtual void sendCommands(const OutputCommand* commands, int numCommands) = 0;
+};
+
+/**
+
+  Takes output commands off the audio thread.
+
+  Commands queued with addCommand() go through a lock-free FIFO and are
+  sent by a dedicated I/O thread, so a slow device can't stall the signal
+  chain. The audio thread doesn't signal the I/O thread, which would take a
+  lock; the I/O thread polls the FIFO every millisecond instead. Commands
+  can be delayed (e.g. to end a pulse); everything that is due at the same
+  time is handed to the device in a single batch. The delay between the
+  time a command was due and the time it was actually sent is recorded for
+  every command. Commands that carry the acquisition time of the data that
+  triggered them also feed an end-to-end latency histogram.
+
+  @see OutputDevice
+
+*/
+
+class PLUGIN_API OutputDispatcher : public Thread
+{
+public:
+    OutputDispatcher(const String& name, OutputDevice* device, int queueSize = 1024);
+    ~OutputDispatcher();
+
+    /** Starts the I/O thread */
+    void start();
+
+    /** Stops the I/O thread. Commands still waiting are sent right away if flush is true. */
+    void stop(bool flush = true);
+
+    /** Queues a command from the audio thread. Never blocks; returns false if the queue is full.
+        acquisitionTicks is the acquisition time of the triggering data (see
+        GenericProcessor::getEventAcquisitionTicks()), or 0 to leave the command
+        out of the end-to-end latency histogram. */
+    bool addCommand(int channel, int value, double delayMs = 0.0, int64 acquisitionTicks = 0);
+
+    /** Queues a command from any other thread. Sent directly if the I/O thread isn't running. */
+    void addControlCommand(int channel, int value, double delayMs = 0.0);
+
+    struct LatencyStats
+    {
+        int numSent;
+        int numDropped;
+        double lastMs;
+        double meanMs;
+        double maxMs;
+    };
+
+    /** Send latencies (sent time minus due time) since the last reset */
+    LatencyStats getLatencyStats() const;
+
+    /** Latencies from the acquisition of the triggering data to the send */
+    LatencyHistogram getEndToEndLatency() const;
+
+    void resetLatencyStats();
+
+    /** Readable summary of the latency statistics */
+    String getLatencyReport() const;
+
+    void run();
+
+private:
+    OutputCommand createCommand(int channel, int value, double delayMs, int64 acquisitionTicks) const;
+    void collectCommands();
+    void insertPending(const OutputCommand& command);
+    void sendReadyCommands(bool sendAll);
+
+    OutputDevice* device;
+
+    AbstractFifo fifo;
+    HeapBlock<OutputCommand> queue;
+
+    CriticalSection controlLock;
+    Array<OutputCommand> controlQueue;
+
+    /** Commands waiting for their due time, sorted. Only used by the I/O thread. */
+    Array<OutputCommand> pending;
+
+    CriticalSection statsLock;
+    int numSent;
+    double totalLatencyMs;
+    double lastLatencyMs;
+    double maxLatencyMs;
+    Atomic<int> numDropped;
+    LatencyHistogram endToEndLatency;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputDispatcher);
+};
+
+#endif  // __OUTPUTDISPATCHER_H__
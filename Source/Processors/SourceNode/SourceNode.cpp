@@ -43,12 +43,8 @@ SourceNode::SourceNode(const String& name_, DataThreadCreator dt)
         }
 
         numEventChannels = dataThread->getNumEventChannels();
-        //eventChannelState = new int[numEventChannels];
-		eventChannelState.malloc(numEventChannels);
-        for (int i = 0; i < numEventChannels; i++)
-        {
-            eventChannelState[i] = 0;
-        }
+		edgeDetector.setNumChannels(numEventChannels);
+		edgeDetector.reset();
 
     }
     else
@@ -64,6 +60,7 @@ SourceNode::SourceNode(const String& name_, DataThreadCreator dt)
     timestamp = 0;
     //eventCodeBuffer = new uint64[10000]; //10000 samples per buffer max?
 	eventCodeBuffer.malloc(10000);
+	ttlEdges.ensureStorageAllocated(1024);
 
 
 }
@@ -338,10 +335,12 @@ void SourceNode::process(AudioSampleBuffer& buffer,
     events.clear();
     buffer.clear();
 
-    int nSamples = inputBuffer->readAllFromBuffer(buffer, &timestamp, eventCodeBuffer, buffer.getNumSamples());
+    // arrival time of the oldest sample, carried downstream for latency measurements
+    int64 arrivalTicks = 0;
+    int nSamples = inputBuffer->readAllFromBuffer(buffer, &timestamp, eventCodeBuffer, buffer.getNumSamples(), &arrivalTicks);
 
     setNumSamples(events, nSamples);
-    setTimestamp(events, timestamp);
+    setTimestamp(events, timestamp, arrivalTicks);
 
     //std::cout << *buffer.getReadPointer(0) << std::endl;
 
@@ -363,51 +362,22 @@ void SourceNode::process(AudioSampleBuffer& buffer,
 
 
     // fill event buffer
-    for (int i = 0; i < nSamples; i++)
-    {
-        for (int c = 0; c < numEventChannels; c++)
-        {
-            int state = eventCodeBuffer[i] & (1 << c);
-
-            if (eventChannelState[c] != state)
-            {
-                if (state == 0)
-                {
-
-                    //std::cout << "OFF" << std::endl;
-                    //std::cout << c << std::endl;
-                    // signal channel state is OFF
-                    addEvent(events, // MidiBuffer
-                             TTL,    // eventType
-                             i,      // sampleNum
-                             0,	     // eventID
-                             c,		 // eventChannel
-							 8,
-							 (uint8*)(&eventCodeBuffer[i])
-                            );
-                }
-                else
-                {
-
-                    // std::cout << "ON" << std::endl;
-                    // std::cout << c << std::endl;
-
-                    // signal channel state is ON
-                    addEvent(events, // MidiBuffer
-                             TTL,    // eventType
-                             i,      // sampleNum
-                             1,		 // eventID
-                             c,		 // eventChannel
-							 8,
-							 (uint8*)(&eventCodeBuffer[i])
-                            );
+    ttlEdges.clearQuick();
+    edgeDetector.findEdges(eventCodeBuffer, nSamples, ttlEdges);
 
-
-                }
-
-                eventChannelState[c] = state;
-            }
-        }
+    for (int i = 0; i < ttlEdges.size(); i++)
+    {
+        const TTLEdge& edge = ttlEdges.getReference(i);
+
+        // signal channel state is ON (eventID 1) or OFF (eventID 0)
+        addEvent(events,              // MidiBuffer
+                 TTL,                 // eventType
+                 edge.sample,         // sampleNum
+                 edge.rising ? 1 : 0, // eventID
+                 edge.channel,        // eventChannel
+                 8,
+                 (uint8*)(&eventCodeBuffer[edge.sample])
+                );
     }
 
 }
@@ -27,6 +27,7 @@
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include <stdio.h>
 #include "../DataThreads/DataThread.h"
+#include "../DataThreads/TTLEdgeDetector.h"
 #include "../GenericProcessor/GenericProcessor.h"
 #include "../../UI/UIComponent.h"
 
@@ -121,7 +122,8 @@ private:
     //uint64* eventCodeBuffer;
     //int* eventChannelState;
 	HeapBlock<uint64> eventCodeBuffer;
-	HeapBlock<int> eventChannelState;
+	TTLEdgeDetector edgeDetector;
+	Array<TTLEdge> ttlEdges;
 
     int ttlState;
 
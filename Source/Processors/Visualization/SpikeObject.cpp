@@ -22,6 +22,7 @@
 */
 
 #include "SpikeObject.h"
+#include "SpikeRecord.h"
 #include "memory.h"
 #include <stdlib.h>
 #include "time.h"
@@ -92,6 +93,12 @@ int packSpike(const SpikeObject* s, uint8_t* buffer, int bufferSize)
     memcpy(buffer+idx, &(s->threshold), s->nChannels * 2);
     idx += s->nChannels * 2;
 
+    if (idx + int(sizeof(float)) <= bufferSize)
+    {
+        memcpy(buffer+idx, &(s->matchScore), sizeof(float));
+        idx += sizeof(float);
+    }
+
     if (idx >= MAX_SPIKE_BUFFER_LEN)
     {
         std::cout << "Spike is larger than it should be. Size was: " << idx
@@ -111,6 +118,13 @@ bool unpackSpike(SpikeObject* s, const uint8_t* buffer, int bufferSize)
     //if (!isBufferValid(buffer, bufferSize))
     //  return false;
 
+    // spikes sent as SpikeRecord handles are copied, truncated to what a SpikeObject holds
+    if (SpikeRecord* record = getSpikeRecord(buffer, bufferSize))
+    {
+        record->toSpikeObject(*s);
+        return true;
+    }
+
     int idx = 0;
 
     memcpy(&(s->eventType), buffer+idx, 1);
@@ -193,6 +207,12 @@ bool unpackSpike(SpikeObject* s, const uint8_t* buffer, int bufferSize)
     memcpy(&(s->threshold), buffer+idx, s->nChannels *2);
     idx += s->nChannels * 2;
 
+    // buffers packed before the match score was added end here
+    if (idx + int(sizeof(float)) <= bufferSize)
+        memcpy(&(s->matchScore), buffer+idx, sizeof(float));
+    else
+        s->matchScore = 0;
+
     //if (idx >= bufferSize)
     //    std::cout << "Buffer Overrun! More data extracted than was given!" << std::endl;
 
@@ -328,6 +348,7 @@ void generateEmptySpike(SpikeObject* s, int nChannels, int numSamples)
     s->sortedId = 0;
     s->color[0] = s->color[1] = s->color[2] = 128;
     s->pcProj[0] = s->pcProj[1] = 0;
+    s->matchScore = 0;
 
 
     int idx = 0;
@@ -68,6 +68,9 @@ PLUGIN_API String generateSpikeElectrodeName(int numChannels, int index);
   IE. the first 2 bytes are the timestamp, the next two bytes are the source identifier, etc... with the last
   set of bytes corresponding to the thresholds of the different channels.
 
+  The match score is appended after the thresholds, when the buffer has room for it. Record engines
+  only store the bytes before it, so spike files keep their layout.
+
   Finally the buffer will have an additional byte on the end that is used to check the integerity of the entire package.
   The way this works is the buffer is divivded up into a series of 16 bit unsigned integers. The sum of all these integers
   (except the last 16 bit integer) is taken and the sum should equal that 16 bit integer. If not then the data is corrupted
@@ -93,6 +96,7 @@ struct SpikeObject
     uint16_t    data[MAX_NUMBER_OF_SPIKE_CHANNELS * MAX_NUMBER_OF_SPIKE_CHANNEL_SAMPLES];
     float       gain[MAX_NUMBER_OF_SPIKE_CHANNELS];
     uint16_t    threshold[MAX_NUMBER_OF_SPIKE_CHANNELS];
+    float       matchScore; // template match score (see the SpikeSorter's TemplateMatcher), 0 if not matched
 };
 
 
@@ -0,0 +1,459 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeRecord.h"
+
+// handle events: the spike event code, a tag, padding and the record address
+#define SPIKE_RECORD_TAG_0 'S'
+#define SPIKE_RECORD_TAG_1 'R'
+#define SPIKE_RECORD_TAG_2 'P'
+#define SPIKE_RECORD_POINTER_OFFSET 8
+
+#define SPIKE_RECORD_HEADER_SIZE ((sizeof(SpikeRecord) + 15) & ~size_t(15))
+#define SPIKE_RECORD_GROW_SIZE 16
+
+namespace
+{
+inline int align4(int n)
+{
+    return (n + 3) & ~3;
+}
+
+/** Bytes of waveform, gains and thresholds for a spike */
+inline int getWaveformSize(int numChannels, int numSamples)
+{
+    return align4(2 * numChannels * numSamples) + 4 * numChannels + 2 * numChannels;
+}
+
+/** Points the waveform, gain and threshold arrays into the payload after the header */
+void setPayloadPointers(SpikeRecord* record, int numChannels, int numSamples)
+{
+    char* payload = reinterpret_cast<char*>(record) + SPIKE_RECORD_HEADER_SIZE;
+    int dataSize = align4(2 * numChannels * numSamples);
+
+    record->data = reinterpret_cast<uint16_t*>(payload);
+    record->gain = reinterpret_cast<float*>(payload + dataSize);
+    record->threshold = reinterpret_cast<uint16_t*>(payload + dataSize + 4 * numChannels);
+}
+}
+
+void SpikeRecord::toSpikeObject(SpikeObject& spike) const
+{
+    int numChannels = jmin<int>(nChannels, MAX_NUMBER_OF_SPIKE_CHANNELS);
+    int numSamples = jmin<int>(nSamples, MAX_NUMBER_OF_SPIKE_CHANNEL_SAMPLES);
+
+    spike.eventType = eventType;
+    spike.timestamp = timestamp;
+    spike.timestamp_software = timestamp_software;
+    spike.source = source;
+    spike.nChannels = numChannels;
+    spike.nSamples = numSamples;
+    spike.sortedId = sortedId;
+    spike.electrodeID = electrodeID;
+    spike.channel = channel < numChannels ? channel : 0;
+    memcpy(spike.color, color, 3);
+    spike.pcProj[0] = pcProj[0];
+    spike.pcProj[1] = pcProj[1];
+    spike.matchScore = matchScore;
+    spike.samplingFrequencyHz = samplingFrequencyHz;
+
+    // keep the first samples of each channel, packed the way SpikeObject expects
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        memcpy(spike.data + ch * numSamples, data + ch * nSamples, 2 * numSamples);
+        spike.gain[ch] = gain[ch];
+        spike.threshold[ch] = threshold[ch];
+    }
+}
+
+void SpikeRecord::copyHeaderFrom(const SpikeRecord& other)
+{
+    eventType = other.eventType;
+    timestamp = other.timestamp;
+    timestamp_software = other.timestamp_software;
+    source = other.source;
+    sortedId = other.sortedId;
+    electrodeID = other.electrodeID;
+    channel = other.channel;
+    memcpy(color, other.color, 3);
+    pcProj[0] = other.pcProj[0];
+    pcProj[1] = other.pcProj[1];
+    matchScore = other.matchScore;
+    samplingFrequencyHz = other.samplingFrequencyHz;
+}
+
+void SpikeRecord::incReferenceCount() noexcept
+{
+    ++refCount;
+}
+
+bool SpikeRecord::decReferenceCountWithoutDeleting() noexcept
+{
+    jassert(refCount.get() > 0);
+    return --refCount == 0;
+}
+
+SpikeRecordPool::SpikeRecordPool() : maxSentRecords(256)
+{
+    for (int i = 0; i < SPIKE_RECORD_SIZE_CLASSES; i++)
+    {
+        freeLists[i] = nullptr;
+        numCarved[i] = 0;
+        numReserved[i] = 0;
+    }
+
+    sentRecords.ensureStorageAllocated(maxSentRecords);
+}
+
+SpikeRecordPool::~SpikeRecordPool()
+{
+    // every record holds a reference to the pool, so none can be outstanding here
+    jassert(sentRecords.size() == 0);
+}
+
+int SpikeRecordPool::getSizeClass(int numChannels, int numSamples)
+{
+    int size = getWaveformSize(numChannels, numSamples);
+
+    for (int c = 0; c < SPIKE_RECORD_SIZE_CLASSES; c++)
+    {
+        if (size <= getPayloadSize(c))
+            return c;
+    }
+
+    return -1;
+}
+
+int SpikeRecordPool::getPayloadSize(int sizeClass)
+{
+    return SPIKE_RECORD_MIN_PAYLOAD << sizeClass;
+}
+
+int SpikeRecordPool::getBlockSize(int sizeClass)
+{
+    return int(SPIKE_RECORD_HEADER_SIZE) + getPayloadSize(sizeClass);
+}
+
+void SpikeRecordPool::grow(int sizeClass, int numRecords)
+{
+    int blockSize = getBlockSize(sizeClass);
+
+    MemoryBlock* chunk = new MemoryBlock(size_t(blockSize) * numRecords);
+
+    SpikeRecord* first = nullptr;
+    SpikeRecord* last = nullptr;
+
+    for (int i = 0; i < numRecords; i++)
+    {
+        SpikeRecord* record = new (static_cast<char*>(chunk->getData()) + size_t(blockSize) * i) SpikeRecord();
+        record->pool = this;
+        record->sizeClass = sizeClass;
+        record->nextFree = first;
+
+        if (last == nullptr)
+            last = record;
+        first = record;
+    }
+
+    const SpinLock::ScopedLockType lock(freeListLock);
+
+    chunks.add(chunk);
+    last->nextFree = freeLists[sizeClass];
+    freeLists[sizeClass] = first;
+    numCarved[sizeClass] += numRecords;
+}
+
+void SpikeRecordPool::reserve(int numRecords, int numChannels, int numSamples)
+{
+    int sizeClass = getSizeClass(numChannels, numSamples);
+
+    if (sizeClass < 0 || numRecords <= 0)
+        return;
+
+    numReserved[sizeClass] += numRecords;
+
+    if (numCarved[sizeClass] < numReserved[sizeClass])
+        grow(sizeClass, numReserved[sizeClass] - numCarved[sizeClass]);
+
+    // every reserved record can be in an event of the same buffer
+    int total = 0;
+    for (int c = 0; c < SPIKE_RECORD_SIZE_CLASSES; c++)
+        total += numReserved[c];
+
+    if (total > maxSentRecords)
+    {
+        maxSentRecords = total;
+        sentRecords.ensureStorageAllocated(maxSentRecords);
+    }
+}
+
+void SpikeRecordPool::resetReservations()
+{
+    for (int c = 0; c < SPIKE_RECORD_SIZE_CLASSES; c++)
+        numReserved[c] = 0;
+}
+
+SpikeRecordPtr SpikeRecordPool::allocate(int numChannels, int numSamples)
+{
+    int sizeClass = getSizeClass(numChannels, numSamples);
+
+    // runs on the audio thread, so a spike that doesn't fit any size class is dropped silently
+    if (numChannels <= 0 || numSamples <= 0 || sizeClass < 0)
+        return nullptr;
+
+    SpikeRecord* record = nullptr;
+
+    while (record == nullptr)
+    {
+        {
+            const SpinLock::ScopedLockType lock(freeListLock);
+
+            record = freeLists[sizeClass];
+            if (record != nullptr)
+                freeLists[sizeClass] = record->nextFree;
+        }
+
+        // only happens when more spikes are in flight than were reserved
+        if (record == nullptr)
+            grow(sizeClass, SPIKE_RECORD_GROW_SIZE);
+    }
+
+    record->eventType = SPIKE_EVENT_CODE;
+    record->timestamp = 0;
+    record->timestamp_software = 0;
+    record->source = 0;
+    record->nChannels = numChannels;
+    record->nSamples = numSamples;
+    record->sortedId = 0;
+    record->electrodeID = 0;
+    record->channel = 0;
+    record->color[0] = record->color[1] = record->color[2] = 0;
+    record->pcProj[0] = record->pcProj[1] = 0;
+    record->matchScore = 0;
+    record->samplingFrequencyHz = 0;
+    record->nextFree = nullptr;
+
+    setPayloadPointers(record, numChannels, numSamples);
+    memset(record->data, 0, getWaveformSize(numChannels, numSamples));
+
+    record->refCount = 0;
+
+    // released in release(), so the pool outlives every record it handed out
+    incReferenceCount();
+
+    return record;
+}
+
+SpikeRecordPtr SpikeRecordPool::allocate(const SpikeObject& spike)
+{
+    SpikeRecordPtr record = allocate(spike.nChannels, spike.nSamples);
+
+    if (record != nullptr)
+    {
+        record->eventType = spike.eventType;
+        record->timestamp = spike.timestamp;
+        record->timestamp_software = spike.timestamp_software;
+        record->source = spike.source;
+        record->sortedId = spike.sortedId;
+        record->electrodeID = spike.electrodeID;
+        record->channel = spike.channel;
+        memcpy(record->color, spike.color, 3);
+        record->pcProj[0] = spike.pcProj[0];
+        record->pcProj[1] = spike.pcProj[1];
+        record->matchScore = spike.matchScore;
+        record->samplingFrequencyHz = spike.samplingFrequencyHz;
+
+        memcpy(record->data, spike.data, 2 * spike.nChannels * spike.nSamples);
+        memcpy(record->gain, spike.gain, 4 * spike.nChannels);
+        memcpy(record->threshold, spike.threshold, 2 * spike.nChannels);
+    }
+
+    return record;
+}
+
+bool SpikeRecordPool::addEvent(SpikeRecord* record, MidiBuffer& events, int sampleNum)
+{
+    jassert(record != nullptr && record->pool == this);
+
+    // sentRecords must not reallocate on the audio thread
+    if (sentRecords.size() >= maxSentRecords)
+        return false;
+
+    uint8_t buffer[SPIKE_RECORD_EVENT_SIZE];
+    memset(buffer, 0, SPIKE_RECORD_EVENT_SIZE);
+
+    buffer[0] = SPIKE_EVENT_CODE;
+    buffer[1] = SPIKE_RECORD_TAG_0;
+    buffer[2] = SPIKE_RECORD_TAG_1;
+    buffer[3] = SPIKE_RECORD_TAG_2;
+    memcpy(buffer + SPIKE_RECORD_POINTER_OFFSET, &record, sizeof(SpikeRecord*));
+
+    record->incReferenceCount();
+    sentRecords.add(record);
+
+    events.addEvent(buffer, SPIKE_RECORD_EVENT_SIZE, sampleNum);
+
+    return true;
+}
+
+void SpikeRecordPool::releaseSentRecords()
+{
+    // releasing the last record may delete the pool, so keep it alive until done
+    Ptr keepAlive = this;
+
+    for (int i = 0; i < sentRecords.size(); i++)
+    {
+        SpikeRecord* record = sentRecords.getUnchecked(i);
+
+        if (record->decReferenceCountWithoutDeleting())
+            release(record);
+    }
+
+    sentRecords.clearQuick();
+}
+
+void SpikeRecordPool::release(SpikeRecord* record)
+{
+    SpikeRecordPool* pool = record->pool;
+
+    {
+        const SpinLock::ScopedLockType lock(pool->freeListLock);
+
+        record->nextFree = pool->freeLists[record->sizeClass];
+        pool->freeLists[record->sizeClass] = record;
+    }
+
+    // may delete the pool
+    pool->decReferenceCount();
+}
+
+bool isSpikeRecordEvent(const uint8_t* buffer, int bufferLength)
+{
+    return bufferLength == SPIKE_RECORD_EVENT_SIZE
+           && buffer[1] == SPIKE_RECORD_TAG_0
+           && buffer[2] == SPIKE_RECORD_TAG_1
+           && buffer[3] == SPIKE_RECORD_TAG_2;
+}
+
+SpikeRecord* getSpikeRecord(const uint8_t* buffer, int bufferLength)
+{
+    if (!isSpikeRecordEvent(buffer, bufferLength))
+        return nullptr;
+
+    SpikeRecord* record;
+    memcpy(&record, buffer + SPIKE_RECORD_POINTER_OFFSET, sizeof(SpikeRecord*));
+    return record;
+}
+
+SpikeRecordPtr getSpikeRecord(const MidiMessage& event, SpikeRecordPool* fallbackPool)
+{
+    const uint8_t* buffer = event.getRawData();
+    int bufferLength = event.getRawDataSize();
+
+    if (isSpikeRecordEvent(buffer, bufferLength))
+        return getSpikeRecord(buffer, bufferLength);
+
+    if (fallbackPool == nullptr || bufferLength < SPIKE_METADATA_SIZE)
+        return nullptr;
+
+    // a packed spike from a processor that still sends SpikeObjects; these can be of
+    // any size too, so read the header first and copy the waveform straight into the record
+    uint16_t numChannels, numSamples;
+    memcpy(&numChannels, buffer + 19, 2);
+    memcpy(&numSamples, buffer + 21, 2);
+
+    int waveformBytes = numChannels * numSamples * 2 + numChannels * 4 + numChannels * 2;
+
+    if (numChannels == 0 || SPIKE_METADATA_SIZE + waveformBytes > bufferLength)
+    {
+        std::cout << "received invalid spike -- buffer too short" << std::endl;
+        return nullptr;
+    }
+
+    SpikeRecordPtr record = fallbackPool->allocate(numChannels, numSamples);
+
+    if (record == nullptr)
+        return nullptr;
+
+    int idx = 0;
+    memcpy(&record->eventType, buffer + idx, 1);            idx += 1;
+    memcpy(&record->timestamp, buffer + idx, 8);            idx += 8;
+    memcpy(&record->timestamp_software, buffer + idx, 8);   idx += 8;
+    memcpy(&record->source, buffer + idx, 2);               idx += 2;
+    idx += 4; // nChannels, nSamples
+    memcpy(&record->sortedId, buffer + idx, 2);             idx += 2;
+    memcpy(&record->electrodeID, buffer + idx, 2);          idx += 2;
+    memcpy(&record->channel, buffer + idx, 2);              idx += 2;
+    memcpy(record->color, buffer + idx, 3);                 idx += 3;
+    memcpy(record->pcProj, buffer + idx, 2 * sizeof(float)); idx += 2 * sizeof(float);
+    memcpy(&record->samplingFrequencyHz, buffer + idx, 2);  idx += 2;
+
+    memcpy(record->data, buffer + idx, numChannels * numSamples * 2);
+    idx += numChannels * numSamples * 2;
+    memcpy(record->gain, buffer + idx, numChannels * 4);
+    idx += numChannels * 4;
+    memcpy(record->threshold, buffer + idx, numChannels * 2);
+    idx += numChannels * 2;
+
+    if (idx + int(sizeof(float)) <= bufferLength)
+        memcpy(&record->matchScore, buffer + idx, sizeof(float));
+
+    return record;
+}
+
+int getPackedSpikeRecordSize(const SpikeRecord& spike)
+{
+    return SPIKE_METADATA_SIZE + spike.nChannels * spike.nSamples * 2
+           + spike.nChannels * 4 + spike.nChannels * 2 + sizeof(float);
+}
+
+int packSpikeRecord(const SpikeRecord& spike, uint8_t* buffer, int bufferLength)
+{
+    if (getPackedSpikeRecordSize(spike) > bufferLength)
+        return 0;
+
+    int idx = 0;
+    memcpy(buffer + idx, &spike.eventType, 1);             idx += 1;
+    memcpy(buffer + idx, &spike.timestamp, 8);             idx += 8;
+    memcpy(buffer + idx, &spike.timestamp_software, 8);    idx += 8;
+    memcpy(buffer + idx, &spike.source, 2);                idx += 2;
+    memcpy(buffer + idx, &spike.nChannels, 2);             idx += 2;
+    memcpy(buffer + idx, &spike.nSamples, 2);              idx += 2;
+    memcpy(buffer + idx, &spike.sortedId, 2);              idx += 2;
+    memcpy(buffer + idx, &spike.electrodeID, 2);           idx += 2;
+    memcpy(buffer + idx, &spike.channel, 2);               idx += 2;
+    memcpy(buffer + idx, spike.color, 3);                  idx += 3;
+    memcpy(buffer + idx, spike.pcProj, 2 * sizeof(float)); idx += 2 * sizeof(float);
+    memcpy(buffer + idx, &spike.samplingFrequencyHz, 2);   idx += 2;
+
+    memcpy(buffer + idx, spike.data, spike.nChannels * spike.nSamples * 2);
+    idx += spike.nChannels * spike.nSamples * 2;
+    memcpy(buffer + idx, spike.gain, spike.nChannels * 4);
+    idx += spike.nChannels * 4;
+    memcpy(buffer + idx, spike.threshold, spike.nChannels * 2);
+    idx += spike.nChannels * 2;
+    memcpy(buffer + idx, &spike.matchScore, sizeof(float));
+    idx += sizeof(float);
+
+    return idx;
+}
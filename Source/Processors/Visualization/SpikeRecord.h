@@ -0,0 +1,212 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2014 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SPIKERECORD_H_
+#define SPIKERECORD_H_
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "SpikeObject.h"
+
+#define SPIKE_RECORD_EVENT_SIZE 16 // packed spikes are always longer than this
+#define SPIKE_RECORD_SIZE_CLASSES 13 // payloads of 256 bytes to 1 MB
+#define SPIKE_RECORD_MIN_PAYLOAD 256
+#define SPIKE_DISPLAY_QUEUE_SIZE 256 // spikes per electrode a display can hold on to
+
+class SpikeRecordPool;
+
+/**
+
+  A spike of any number of channels and samples.
+
+  The header fields mirror SpikeObject; the waveform, gains and thresholds
+  are stored right after the header, in a block sized for this spike, so a
+  single channel spike takes a few hundred bytes and a 32 channel one is
+  not truncated.
+
+  Records are allocated from a SpikeRecordPool and shared through
+  SpikeRecordPtr handles. When the last handle goes away the record returns
+  to its pool, from whichever thread that happens on.
+
+  @see SpikeRecordPool, SpikeObject
+
+*/
+
+struct PLUGIN_API SpikeRecord
+{
+    uint8_t     eventType;
+    int64_t     timestamp;
+    int64_t     timestamp_software;
+    uint16_t    source; // used internally, the index of the electrode in the electrode array
+    uint16_t    nChannels;
+    uint16_t    nSamples;
+    uint16_t    sortedId;   // sorted unit ID (or 0 if unsorted)
+    uint16_t    electrodeID; // unique electrode ID (regardless electrode position in the array)
+    uint16_t    channel; // the channel in which threshold crossing was detected
+    uint8_t     color[3];
+    float       pcProj[2];
+    uint16_t    samplingFrequencyHz;
+
+    uint16_t*   data;      // nChannels * nSamples, one channel after the other
+    float*      gain;      // nChannels
+    uint16_t*   threshold; // nChannels
+
+    float       matchScore;
+
+    /** Copies the header and as much of the waveform as fits into a SpikeObject
+        (MAX_NUMBER_OF_SPIKE_CHANNELS channels of MAX_NUMBER_OF_SPIKE_CHANNEL_SAMPLES
+        samples), for code that still works on SpikeObjects. */
+    void toSpikeObject(SpikeObject& spike) const;
+
+    /** Copies the header fields of another record, leaving the waveform alone. */
+    void copyHeaderFrom(const SpikeRecord& other);
+
+    void incReferenceCount() noexcept;
+    bool decReferenceCountWithoutDeleting() noexcept;
+
+private:
+    friend class SpikeRecordPool;
+
+    SpikeRecordPool* pool;
+    SpikeRecord* nextFree;
+    int sizeClass;
+    Atomic<int> refCount;
+};
+
+// the last handle hands the record back to its pool instead of deleting it
+namespace juce
+{
+template <>
+struct ContainerDeletePolicy<SpikeRecord>
+{
+    static void destroy(SpikeRecord* record);
+};
+}
+
+/** Handle to a pooled spike; copying it shares the record. */
+typedef ReferenceCountedObjectPtr<SpikeRecord> SpikeRecordPtr;
+
+/**
+
+  Allocates SpikeRecords for one spike source.
+
+  Memory comes from chunks that are kept until the pool is deleted; released
+  records go back on a free list for their size class, so once the pool has
+  been reserved, spikes are created without touching the heap. Reservations
+  add up, so electrodes that share a size class each get their own records.
+  Every record holds a reference to its pool, so a display that keeps spikes
+  around remains valid after the processor that made them is gone.
+
+  Spikes travel to downstream processors as small events holding a handle
+  (see addEvent). The event keeps its record alive until the producer calls
+  releaseSentRecords, normally at the start of its next process() call, by
+  which time every processor downstream has seen the buffer. Consumers that
+  need a spike for longer keep their own SpikeRecordPtr.
+
+*/
+
+class PLUGIN_API SpikeRecordPool : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<SpikeRecordPool> Ptr;
+
+    SpikeRecordPool();
+    ~SpikeRecordPool();
+
+    /** Adds numRecords spikes of numChannels x numSamples to the records that
+        can be in use at once without growing the pool, and makes room for as
+        many events in flight. Call from the message thread, e.g. in enable(). */
+    void reserve(int numRecords, int numChannels, int numSamples);
+
+    /** Forgets the reservations, so the next enable() starts from zero. The
+        memory is kept for the next reservations. */
+    void resetReservations();
+
+    /** Returns a cleared record with room for numChannels x numSamples. */
+    SpikeRecordPtr allocate(int numChannels, int numSamples);
+
+    /** Returns a record holding a copy of a SpikeObject. */
+    SpikeRecordPtr allocate(const SpikeObject& spike);
+
+    /** Adds an event carrying the record at sampleNum. Returns false, without
+        adding it, if more events are in flight than were reserved. */
+    bool addEvent(SpikeRecord* record, MidiBuffer& events, int sampleNum);
+
+    /** Drops the references held by the events sent since the last call. */
+    void releaseSentRecords();
+
+    /** Puts a record whose last handle is gone back on its free list. */
+    static void release(SpikeRecord* record);
+
+private:
+    static int getSizeClass(int numChannels, int numSamples);
+    static int getPayloadSize(int sizeClass);
+    static int getBlockSize(int sizeClass);
+
+    /** Carves a new chunk of records of one size class. */
+    void grow(int sizeClass, int numRecords);
+
+    SpinLock freeListLock;
+    SpikeRecord* freeLists[SPIKE_RECORD_SIZE_CLASSES];
+
+    /** Records carved and records reserved, per size class */
+    int numCarved[SPIKE_RECORD_SIZE_CLASSES];
+    int numReserved[SPIKE_RECORD_SIZE_CLASSES];
+
+    OwnedArray<MemoryBlock> chunks;
+
+    /** References held by events of the current buffer; audio thread only */
+    Array<SpikeRecord*> sentRecords;
+    int maxSentRecords;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeRecordPool);
+};
+
+/** True if the event carries a SpikeRecord handle rather than a packed spike. */
+PLUGIN_API bool isSpikeRecordEvent(const uint8_t* buffer, int bufferLength);
+
+/** Returns the record a handle event points to, or nullptr for any other buffer.
+    The record is only guaranteed to live while the event's buffer is processed. */
+PLUGIN_API SpikeRecord* getSpikeRecord(const uint8_t* buffer, int bufferLength);
+
+/** Returns the spike carried by an event. Events with a packed SpikeObject are
+    unpacked into a record from fallbackPool; returns a null handle if the
+    event isn't a valid spike. */
+PLUGIN_API SpikeRecordPtr getSpikeRecord(const MidiMessage& event, SpikeRecordPool* fallbackPool);
+
+/** Number of bytes packSpikeRecord writes for this spike. */
+PLUGIN_API int getPackedSpikeRecordSize(const SpikeRecord& spike);
+
+/** Serializes a spike in the packSpike layout, sized for its actual channels and
+    samples, so spike files keep their format. Returns the number of bytes written,
+    or 0 if the buffer is too small. */
+PLUGIN_API int packSpikeRecord(const SpikeRecord& spike, uint8_t* buffer, int bufferLength);
+
+namespace juce
+{
+inline void ContainerDeletePolicy<SpikeRecord>::destroy(SpikeRecord* record)
+{
+    SpikeRecordPool::release(record);
+}
+}
+
+#endif  // SPIKERECORD_H_
@@ -154,13 +154,51 @@ void DiskSpaceMeter::updateDiskSpace(float percent)
     diskFree = percent;
 }
 
+void DiskSpaceMeter::updateVolumes(const Array<RecordVolumeStatus>& volumes)
+{
+    volumeUsed.clearQuick();
+
+    String tip;
+
+    for (int i = 0; i < volumes.size(); i++)
+    {
+        const RecordVolumeStatus& v = volumes.getReference(i);
+
+        float used = (v.totalBytes > 0) ? 1.0f - float(v.bytesFree) / float(v.totalBytes) : 0.0f;
+        volumeUsed.add(used);
+
+        if (i == 0)
+            diskFree = used;
+        else
+            tip += "\n";
+
+        tip += v.directory.getFullPathName() + ": "
+               + String(v.bytesPerSecond / (1024.0 * 1024.0), 1) + " MB/s, "
+               + String(double(v.bytesFree) / (1024.0 * 1024.0 * 1024.0), 1) + " GB free";
+    }
+
+    if (volumeUsed.size() < 2)
+        volumeUsed.clearQuick();
+
+    setTooltip(tip.isEmpty() ? "Disk space available" : tip);
+}
+
 void DiskSpaceMeter::paint(Graphics& g)
 {
 
     g.fillAll(Colours::grey);
 
     g.setColour(Colours::lightgrey);
-    if (diskFree > 0)
+    if (volumeUsed.size() > 1)
+    {
+        float barHeight = float(getHeight()) / volumeUsed.size();
+        for (int i = 0; i < volumeUsed.size(); i++)
+        {
+            if (volumeUsed[i] > 0)
+                g.fillRect(0.0f,barHeight*i,getWidth()*volumeUsed[i],barHeight);
+        }
+    }
+    else if (diskFree > 0)
         g.fillRect(0.0f,0.0f,getWidth()*diskFree,float(getHeight()));
 
     g.setColour(Colours::black);
@@ -536,6 +574,8 @@ void ControlPanel::updateRecordEngineList()
 	}
 	for (int i = 0; i < AccessClass::getPluginManager()->getNumRecordEngines(); i++)
 	{
+		if (!AccessClass::getPluginManager()->ensurePluginLoaded(Plugin::RecordEnginePlugin, i))
+			continue;
 		Plugin::RecordEngineInfo info;
 		info = AccessClass::getPluginManager()->getRecordEngineInfo(i);
 		recordSelector->addItem(info.name, id++);
@@ -966,7 +1006,9 @@ void ControlPanel::refreshMeters()
 
     masterClock->repaint();
 
-    diskMeter->updateDiskSpace(graph->getRecordNode()->getFreeSpace());
+    Array<RecordVolumeStatus> volumes;
+    graph->getRecordNode()->getVolumeStatus(volumes);
+    diskMeter->updateVolumes(volumes);
     diskMeter->repaint();
 
     if (initialize)
@@ -126,6 +126,8 @@ private:
   is changed), a built-in JUCE method is used to find the amount of free space.
 
   Note that the DiskSpaceMeter currently displays only relative, not absolute disk space.
+  When the record engine writes to several directories, each one gets its own bar, and the
+  tooltip lists the write rate and free space of each.
 
   @see ControlPanel
 
@@ -141,6 +143,10 @@ public:
     	the ControlPanel. */
     void updateDiskSpace(float percent);
 
+    /** Updates the bars and the tooltip from the RecordNode's volume status. Called by
+        the ControlPanel. */
+    void updateVolumes(const Array<RecordVolumeStatus>& volumes);
+
     /** Draws the DiskSpaceMeter. */
     void paint(Graphics& g);
 
@@ -150,6 +156,9 @@ private:
 
     float diskFree;
 
+    /** Used fraction of every volume, when there is more than one */
+    Array<float> volumeUsed;
+
 };
 
 /**
@@ -1565,7 +1565,7 @@ const String EditorViewport::loadState(File fileToLoad)
                         splitPoints.add(p);
                     }
 
-                    signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE);
+                    signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE, true);
 
                 }
                 else if (processor->hasTagName("SWITCH"))
@@ -1600,7 +1600,7 @@ const String EditorViewport::loadState(File fileToLoad)
                         }
                     }
 
-                    signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE);
+                    signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE, true);
 
                 }
 
@@ -1629,7 +1629,7 @@ const String EditorViewport::loadState(File fileToLoad)
     AccessClass::getUIComponent()->loadStateFromXml(xml);  // save the UI settings
 
     if (editorArray.size() > 0)
-        signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE);
+        signalChainManager->updateVisibleEditors(editorArray[0], 0, 0, UPDATE, true);
 
     refreshEditors();
 
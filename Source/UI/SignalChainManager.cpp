@@ -159,18 +159,26 @@ void SignalChainManager::refreshTabs()
 
 
 void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
-                                              int index, int insertionPoint, int action)
+                                              int index, int insertionPoint, int action,
+                                              bool updateAllChains)
 
 {
 
     enum actions {ADD, MOVE, REMOVE, ACTIVATE, UPDATE};
 
+    const double startTime = Time::getMillisecondCounterHiRes();
+
+    // processors whose input changes; they and everything downstream get new settings
+    Array<GenericProcessor*> changedProcessors;
+
     // Step 1: update the editor array
     if (action == ADD)
     {
         //std::cout << "    Adding editor." << std::endl;
         editorArray.insert(insertionPoint, activeEditor);
 
+        changedProcessors.add(activeEditor->getProcessor());
+
     }
     else if (action == MOVE)
     {
@@ -180,6 +188,11 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
         else if (insertionPoint > index)
             editorArray.move(index, insertionPoint-1);
 
+        // everything from the first moved position on gets a new source
+        int firstMoved = jmin(index, insertionPoint);
+        if (firstMoved < editorArray.size())
+            changedProcessors.add(editorArray[firstMoved]->getProcessor());
+
     }
     else if (action == REMOVE)
     {
@@ -210,6 +223,7 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
             if (p->getDestNode() != nullptr)
             {
                 //   std::cout << "Found an orphaned signal chain" << std::endl;
+                changedProcessors.add(p->getDestNode());
                 p->getDestNode()->setSourceNode(nullptr);
                 createNewTab(p->getDestNode()->getEditor());
             }
@@ -218,6 +232,7 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
             if (p->getDestNode() != nullptr)
             {
                 //   std::cout << "Found an orphaned signal chain" << std::endl;
+                changedProcessors.add(p->getDestNode());
                 p->getDestNode()->setSourceNode(nullptr);
                 createNewTab(p->getDestNode()->getEditor());
             }
@@ -225,6 +240,10 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
 
         editorArray.remove(index);
 
+        // the processor that took its place gets a new source
+        if (index < editorArray.size())
+            changedProcessors.add(editorArray[index]->getProcessor());
+
         int t = activeEditor->tabNumber();
 
         // std::cout << editorArray.size() << " " << t << std::endl;
@@ -289,6 +308,16 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
     {
 
         // std::cout << "Activating editor" << std::endl;
+
+        if (action == UPDATE && activeEditor != nullptr)
+            changedProcessors.add(activeEditor->getProcessor());
+    }
+
+    // updating the head of every chain updates everything fed by it
+    if (updateAllChains)
+    {
+        for (int n = 0; n < signalChainArray.size(); n++)
+            changedProcessors.addIfNotAlreadyThere(signalChainArray[n]->getEditor()->getProcessor());
     }
 
     // Step 2: update connections
@@ -504,13 +533,15 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
         }
     }
 
-    // Step 7: update all settings
+    // Step 7: update the settings downstream of the change
     if (action != ACTIVATE)
     {
 
         // std::cout << "Updating settings." << std::endl;
 
         Array<GenericProcessor*> splitters;
+        Array<GenericProcessor*> updated;
+        int numVisited = 0;
 
         for (int n = 0; n < signalChainArray.size(); n++)
         {
@@ -518,6 +549,7 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
 
             GenericEditor* source = signalChainArray[n]->getEditor();
             GenericProcessor* p = source->getProcessor();
+            GenericProcessor* previous = nullptr;
 
             //  p->update();
 
@@ -525,14 +557,22 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
 
             while (p != 0)
             {
-                // iterate through processors
-                p->update();
+                // iterate through processors; a processor only needs new settings
+                // if it changed or the processor feeding it has just been updated
+                numVisited++;
+
+                if (changedProcessors.contains(p) || (previous != nullptr && updated.contains(previous)))
+                {
+                    p->update();
+                    updated.addIfNotAlreadyThere(p);
+                }
 
                 if (p->isSplitter())
                 {
                     splitters.add(p);
                 }
 
+                previous = p;
                 p = p->getDestNode();
 
                 if (p == 0 && splitters.size() > 0)
@@ -540,10 +580,15 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
                     splitters.getFirst()->switchIO(); // switch the signal chain
                     p = splitters[0]->getDestNode();
                     splitters.getFirst()->switchIO(); // switch it back
+                    previous = splitters[0];
                     splitters.remove(0);
                 }
             }
         }
+
+        std::cout << "Updated settings of " << updated.size() << " of " << numVisited
+                  << " processors in " << Time::getMillisecondCounterHiRes() - startTime
+                  << " ms." << std::endl;
     }
 
 
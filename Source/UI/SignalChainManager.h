@@ -49,8 +49,12 @@ public:
                        Array<SignalChainTabButton*, CriticalSection>&);
     ~SignalChainManager();
 
-    /** Updates the editors currently displayed by the EditorViewport.*/
-    void updateVisibleEditors(GenericEditor* activeEditor, int index, int insertionPoint, int action);
+    /** Updates the editors currently displayed by the EditorViewport, and the
+    settings of the processors downstream of the change. If updateAllChains is
+    true, every processor of every signal chain gets new settings, as when a
+    saved configuration is loaded.*/
+    void updateVisibleEditors(GenericEditor* activeEditor, int index, int insertionPoint, int action,
+                              bool updateAllChains = false);
 
     /** Creates a tab button for a new signal chain. */
     void createNewTab(GenericEditor* editor);